@@ -1,9 +1,11 @@
 #include "ASTAPI.h"
 #include "ASTNode.h"
 #include "../Exit.h"
+#include "../Utils.h"
+#include "../profiling/MemoryAccounting.h"
 #include <cassert>
 
-AST::Node* AST::MakeIntNode(i32 n)
+AST::Node* AST::MakeIntNode(i64 n)
 {
     IntNode* node = new IntNode();
     assert(node && "Failed to allocate int node");
@@ -16,6 +18,7 @@ AST::Node* AST::MakeSymNode(std::wstring* s)
 {
     SymNode* node = new SymNode();
     assert(node && "Failed to allocate sym node");
+    Memory::CategoryScope identifierScope(Memory::Category::identifiers);
     node->c = *s;
     node->kind = Node_k::SymNode;
     node->entry = nullptr;
@@ -59,6 +62,7 @@ AST::Node* AST::MakeDeclNode(std::wstring* s, const PrimitiveType type, const Pr
 {
     DeclNode* node = new DeclNode();
     assert(node && "Failed to allocate decl node");
+    Memory::CategoryScope identifierScope(Memory::Category::identifiers);
     node->c = *s;
     node->t = type;
     node->pointeeType = pointeeType;
@@ -133,6 +137,7 @@ AST::Node* AST::MakeFunctionNode(PrimitiveType retType, std::wstring* s, Node* a
     FunctionNode* node = new FunctionNode();
     assert(node && "Failed to allocate function node");
     node->kind = Node_k::FunctionNode;
+    Memory::CategoryScope identifierScope(Memory::Category::identifiers);
     node->name = *s;
     node->retType = retType;
 
@@ -151,6 +156,7 @@ AST::Node* AST::MakeArgNode(std::wstring* s, const PrimitiveType type, const Pri
 {
     ArgNode* node = new ArgNode();
     assert(node && "Failed to allocate arg node");
+    Memory::CategoryScope identifierScope(Memory::Category::identifiers);
     node->c = *s;
     node->kind = Node_k::ArgNode;
     node->pointeeType = pointeeType;
@@ -167,6 +173,7 @@ AST::Node* AST::MakeFunctionCallNode(std::wstring* s, Node* args)
 {
     FunctionCallNode* node = new FunctionCallNode();
     assert(node && "Failed to allocate function call node");
+    Memory::CategoryScope identifierScope(Memory::Category::identifiers);
     node->c = *s;
     node->kind = Node_k::FunctionCallNode;
     node->args = args;
@@ -182,6 +189,7 @@ AST::Node* AST::MakeFwdDeclNode(PrimitiveType retType, std::wstring* s, Node* ar
     FwdDeclNode* node = new FwdDeclNode();
     assert(node && "Failed to allocate fwd decl node");
     node->kind = Node_k::FwdDeclNode;
+    Memory::CategoryScope identifierScope(Memory::Category::identifiers);
     node->name = *s;
     node->retType = retType;
 
@@ -211,6 +219,7 @@ AST::Node* AST::MakeAddrOfNode(std::wstring* name)
   AddrOfNode* node = new AddrOfNode();
   assert(node && "Failed to allocate addr of node");
   node->kind = Node_k::AddrOfNode;
+  Memory::CategoryScope identifierScope(Memory::Category::identifiers);
   node->name = *name;
   node->entry = nullptr;
 
@@ -309,3 +318,193 @@ std::vector<AST::Node*> AST::GetAllChildNodesOfType(Node* parent, const Node_k k
 
   return childrenOfKind;
 }
+
+
+std::unordered_set<SymTabEntry*> AST::GetAddressTakenLocals(Node* parent)
+{
+  std::unordered_set<SymTabEntry*> addressTaken;
+  for (Node* addrOfNode : GetAllChildNodesOfType(parent, Node_k::AddrOfNode))
+  {
+    addressTaken.insert(((AddrOfNode*)addrOfNode)->GetSymTabEntry());
+  }
+
+  if (addressTaken.empty())
+  {
+    return addressTaken;
+  }
+
+  for (Node* n : GetAllChildrenRecursively(parent))
+  {
+    // Runs of declarations are siblings with nothing else between them.
+    std::vector<SymTabEntry*> run;
+    bool isRunAddressTaken = false;
+
+    const std::vector<Node*> children = n->GetChildren();
+    for (ui64 i = 0; i <= children.size(); i++)
+    {
+      if (i < children.size() && children[i]->GetNodeKind() == Node_k::DeclNode)
+      {
+        SymTabEntry* entry = ((DeclNode*)children[i])->GetSymTabEntry();
+        run.push_back(entry);
+        isRunAddressTaken = isRunAddressTaken || addressTaken.count(entry) != 0;
+        continue;
+      }
+
+      if (isRunAddressTaken)
+      {
+        addressTaken.insert(run.begin(), run.end());
+      }
+      run.clear();
+      isRunAddressTaken = false;
+    }
+  }
+
+  return addressTaken;
+}
+
+PrimitiveType AST::GetExpressionType(Node* node)
+{
+  switch (node->GetNodeKind())
+  {
+    case Node_k::OpNode:
+    {
+      return GetExpressionType(((OpNode*)node)->GetLHS());
+    }
+    case Node_k::IntNode:
+    {
+      return IntNode::s_defaultIntLiteralType;
+    }
+    case Node_k::SymNode:
+    {
+      return ((SymNode*)node)->GetSymTabEntry()->asVar.type;
+    }
+    case Node_k::FunctionCallNode:
+    {
+      return ((FunctionCallNode*)node)->GetSymTabEntry()->asFunction.retType;
+    }
+    default:
+    {
+      return PrimitiveType::pointer;
+    }
+  }
+}
+
+PrimitiveType AST::GetPointeeTypeFromDerefNode(Node* derefNode)
+{
+  /*
+      Hunt through the subexpr until we find a pointer node.
+      Most sane dereference operations evolve from a single pointer, e.g.
+        (pointer + 1) = 200
+      and not typically
+        (pointer + **another pointer**) = 200
+
+      in fact(just checked this in compiler explorer), adding a pointer to another pointer in C++ raises an error,
+      so we can safely look for only 1 pointer in the subexpression, and take it's pointeeType.
+
+      There's a safety check in the semantics pass which checks for more than 1 pointer in a subexpression,
+      which raises an error if several are found, so we can happily pick the first pointee type here and call it a day.
+  */
+  for (Node* symNode : GetAllChildNodesOfType(derefNode, Node_k::SymNode))
+  {
+    SymTabEntry* entry = ((SymNode*)symNode)->GetSymTabEntry();
+    if (entry->asVar.type == PrimitiveType::pointer)
+    {
+      return entry->asVar.pointeeType;
+    }
+  }
+
+  wprintf(L"ERROR: couldn't find pointee type in " __FUNCTION__ "\n");
+  Exit(ErrCodes::internal_compiler_error);
+}
+
+// Mixes the contents of one node, not its children, into hash.
+static ui64 HashNodeContents(AST::Node* n, ui64 hash)
+{
+  const Node_k kind = n->GetNodeKind();
+  hash = Utils::HashFNV1a(&kind, sizeof(kind), hash);
+
+  const std::wstring* name = nullptr;
+  PrimitiveType types[2] = { PrimitiveType::invalid, PrimitiveType::invalid };
+  i64 value = 0;
+
+  switch (kind)
+  {
+    case Node_k::IntNode:          value = (i64)((AST::IntNode*)n)->Get(); break;
+    case Node_k::SymNode:          name = &((AST::SymNode*)n)->GetName(); break;
+    case Node_k::OpNode:           value = (i64)((AST::OpNode*)n)->GetOp(); break;
+    case Node_k::AddrOfNode:       name = &((AST::AddrOfNode*)n)->GetName(); break;
+    case Node_k::FunctionCallNode: name = &((AST::FunctionCallNode*)n)->GetName(); break;
+
+    case Node_k::DeclNode:
+    {
+      AST::DeclNode* asDeclNode = (AST::DeclNode*)n;
+      name = &asDeclNode->GetName();
+      types[0] = asDeclNode->GetType();
+      types[1] = asDeclNode->GetPointeeType();
+      value = asDeclNode->GetSize();
+      break;
+    }
+
+    case Node_k::ArgNode:
+    {
+      AST::ArgNode* asArgNode = (AST::ArgNode*)n;
+      name = &asArgNode->GetName();
+      types[0] = asArgNode->GetType();
+      types[1] = asArgNode->GetPointeeType();
+      break;
+    }
+
+    case Node_k::FunctionNode:
+    {
+      AST::FunctionNode* asFunctionNode = (AST::FunctionNode*)n;
+      name = &asFunctionNode->GetName();
+      types[0] = asFunctionNode->GetRetType();
+      break;
+    }
+
+    case Node_k::FwdDeclNode:
+    {
+      AST::FwdDeclNode* asFwdDeclNode = (AST::FwdDeclNode*)n;
+      name = &asFwdDeclNode->GetName();
+      types[0] = asFwdDeclNode->GetRetType();
+
+      // The argument list isn't among the children of a forward declaration.
+      for (AST::Node* arg = asFwdDeclNode->GetArgsList(); arg != nullptr; arg = arg->GetRightSibling())
+      {
+        hash = HashNodeContents(arg, hash);
+      }
+      break;
+    }
+  }
+
+  if (name != nullptr)
+  {
+    hash = Utils::HashFNV1a(name->c_str(), (name->length() + 1) * sizeof(wchar_t), hash);
+  }
+  hash = Utils::HashFNV1a(types, sizeof(types), hash);
+  hash = Utils::HashFNV1a(&value, sizeof(value), hash);
+
+  return hash;
+}
+
+static ui64 HashSubtreeRecursive(AST::Node* n, ui64 hash)
+{
+  hash = HashNodeContents(n, hash);
+
+  // The child count keeps differently shaped trees with the same nodes in the same order apart.
+  const std::vector<AST::Node*> children = n->GetChildren();
+  const ui64 childCount = children.size();
+  hash = Utils::HashFNV1a(&childCount, sizeof(childCount), hash);
+
+  for (AST::Node* child : children)
+  {
+    hash = HashSubtreeRecursive(child, hash);
+  }
+
+  return hash;
+}
+
+ui64 AST::HashSubtree(Node* parent)
+{
+  return HashSubtreeRecursive(parent, Utils::s_fnvOffsetBasis);
+}
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "../BongusTable.h"
 #include <string>
 #include <vector>
+#include <unordered_set>
+
+struct SymTabEntry;
 
 /*
 	API is implemented from specification on page 252 an onward.
@@ -16,7 +19,7 @@ namespace AST
 	
 	// makeIntNode(int n) instantiates a node that represents the constant integer n and that offers
 	// an accessor method that returns n.
-	Node* MakeIntNode(i32 n);
+	Node* MakeIntNode(i64 n);
 
 	// makeSymNode(Symbol s) instantiates a node for a symbol s.
 	// Methods must	be included to set and get the symbol table entry for s,
@@ -81,4 +84,20 @@ namespace AST
 	
 	// Returns a list of all nodes of a given kind found among children.
 	std::vector<Node*> GetAllChildNodesOfType(Node* parent, const Node_k kind);
+
+	// Returns the locals whose address is taken(&x) anywhere under parent, along with every local declared in the same run of
+	// declarations as one of them. Locals are laid out in the order they're declared, and a pointer to the first of a run of
+	// them is used like a pointer into an array of them, so none of them may be moved or have its stores dropped.
+	std::unordered_set<SymTabEntry*> GetAddressTakenLocals(Node* parent);
+
+	// The type an expression's value has as an operand, its leftmost operand's for operations. Dereferences and addresses are
+	// pointer wide.
+	PrimitiveType GetExpressionType(Node* node);
+
+	// The type a dereference reads or writes, the pointee type of the first pointer in its subexpression.
+	PrimitiveType GetPointeeTypeFromDerefNode(Node* derefNode);
+
+	// Hashes the structure and contents(names, types, constants, operators) of the subtree under parent, including parent itself.
+	// Two subtrees hash the same when they'd compile the same, no matter where they came from.
+	ui64 HashSubtree(Node* parent);
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "ASTNode.h"
+#include "../profiling/MemoryAccounting.h"
 #include <cassert>
 
 AST::Node::Node(Node* c_rSibling, Node* c_lmostChild, Node* c_parent)
@@ -8,11 +9,29 @@ AST::Node::Node(Node* c_rSibling, Node* c_lmostChild, Node* c_parent)
     , parent(c_parent)
 {
     // Register ourselves on the disaster list.
-    g_disasterHandle.push_back(this);
+    Memory::CategoryScope nodeScope(Memory::Category::astNodes);
+    std::lock_guard<std::mutex> lock(g_disasterHandleMutex);
+    g_disasterHandle.insert(this);
+}
+
+void* AST::Node::operator new(const size_t size)
+{
+    Memory::CategoryScope nodeScope(Memory::Category::astNodes);
+    return ::operator new(size);
+}
+
+void AST::Node::operator delete(void* memory)
+{
+    ::operator delete(memory);
 }
 
 AST::Node::~Node()
 {
+    {
+        std::lock_guard<std::mutex> lock(g_disasterHandleMutex);
+        g_disasterHandle.erase(this);
+    }
+
     delete rSibling;
     delete lmostChild;
 }
@@ -156,6 +175,12 @@ std::vector<AST::Node*> AST::ReturnNode::GetChildren(void)
     return res;
 }
 
+AST::FunctionNode::~FunctionNode()
+{
+    // Deletes the whole list of args through their rSiblings.
+    delete argsList;
+}
+
 std::vector<AST::Node*> AST::FunctionNode::GetChildren(void)
 {
     // Run base implementation first.
@@ -174,6 +199,11 @@ std::vector<AST::Node*> AST::FunctionNode::GetChildren(void)
     return res;
 }
 
+AST::FunctionCallNode::~FunctionCallNode()
+{
+  delete args;
+}
+
 std::vector<AST::Node*> AST::FunctionCallNode::GetChildren(void)
 {
   // Run base implementation first.
@@ -192,6 +222,16 @@ std::vector<AST::Node*> AST::FunctionCallNode::GetChildren(void)
   return res;
 }
 
+AST::FwdDeclNode::~FwdDeclNode()
+{
+  delete argsList;
+}
+
+AST::ExternFwdDeclNode::~ExternFwdDeclNode()
+{
+  delete fwdDeclNode;
+}
+
 std::vector<AST::Node*> AST::ExternFwdDeclNode::GetChildren(void)
 {
   // Run base implementation first.
@@ -202,6 +242,11 @@ std::vector<AST::Node*> AST::ExternFwdDeclNode::GetChildren(void)
   return res;
 }
 
+AST::DerefNode::~DerefNode()
+{
+  delete expr;
+}
+
 std::vector<AST::Node*> AST::DerefNode::GetChildren(void)
 {
   // Run base implementation first.
@@ -220,6 +265,12 @@ std::vector<AST::Node*> AST::DerefNode::GetChildren(void)
   return res;
 }
 
+AST::ForLoopNode::~ForLoopNode()
+{
+  delete head;
+  delete body;
+}
+
 std::vector<AST::Node*> AST::ForLoopNode::GetChildren(void)
 {
   // Run base implementation first.
@@ -231,6 +282,12 @@ std::vector<AST::Node*> AST::ForLoopNode::GetChildren(void)
   return res;
 }
 
+AST::ForLoopHeadNode::~ForLoopHeadNode()
+{
+  delete upperBound;
+  delete lowerBound;
+}
+
 std::vector<AST::Node*> AST::ForLoopHeadNode::GetChildren(void)
 {
   // Run base implementation first.
@@ -243,3 +300,40 @@ std::vector<AST::Node*> AST::ForLoopHeadNode::GetChildren(void)
 }
 
 
+
+
+void AST::FreeAllNodes(void)
+{
+  // Only the roots may be deleted directly, as deleting a node deletes its children and right siblings along with it.
+  // Anything that is reachable from another node is owned by that node.
+  std::unordered_set<Node*> ownedNodes;
+  for (Node* node : g_disasterHandle)
+  {
+    for (Node* child : node->GetChildren())
+    {
+      ownedNodes.insert(child);
+    }
+
+    ownedNodes.insert(node->GetRightSibling());
+
+    // Forward declarations own their argument list without listing it as children.
+    if (node->GetNodeKind() == Node_k::FwdDeclNode)
+    {
+      ownedNodes.insert(((FwdDeclNode*)node)->GetArgsList());
+    }
+  }
+
+  std::vector<Node*> roots;
+  for (Node* node : g_disasterHandle)
+  {
+    if (ownedNodes.find(node) == ownedNodes.end())
+    {
+      roots.push_back(node);
+    }
+  }
+
+  for (Node* root : roots)
+  {
+    delete root;
+  }
+}
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "ASTAPI.h"
 #include "../symbol_table/symtable.h"
 #include <vector>
+#include <unordered_set>
+#include <mutex>
 
 class NodeVisitor;
 
@@ -12,7 +14,11 @@ namespace AST
 	// A disaster handle which all nodes register themselves at.
 	// If we encounter compromising memory leaks or maybe want to print all nodes easily
 	// we can go through this list and be sure that we find every single node in the AST.
-	inline std::vector<Node*> g_disasterHandle;
+	// Nodes deregister themselves when deleted, so the handle only ever holds live nodes.
+	// Nodes register and deregister under g_disasterHandleMutex, so the pipeline's worker can make and delete nodes while folding
+	// as the parser makes new ones. Walking or swapping the handle isn't guarded, so only do that while no other thread touches nodes.
+	inline std::unordered_set<Node*> g_disasterHandle;
+	inline std::mutex g_disasterHandleMutex;
 
 	// Page 251 illustrates how to design ASTs.
 	class Node
@@ -21,6 +27,10 @@ namespace AST
 	
 		Node(Node* rSibling = nullptr, Node* lmostChild = nullptr, Node* parent = nullptr);
 		virtual ~Node();
+
+		// Puts every node's allocation under the AST nodes category of --mem-report, see profiling/MemoryAccounting.h.
+		static void* operator new(const size_t size);
+		static void operator delete(void* memory);
 	
 		// Page 253.
 		Node* MakeSiblings(Node* y);
@@ -34,8 +44,15 @@ namespace AST
 
 		inline const Node_k GetNodeKind(void) const { return kind; }
 		inline Node* GetRightSibling(void) const { return rSibling; }
+		inline Node* GetLeftmostChild(void) const { return lmostChild; }
 		inline const bool HasRightSiblings(void) const { return rSibling != nullptr; }
 		inline void UnbindChildren(void) { lmostChild = nullptr; }
+		// Takes the node out of its list of siblings, without fixing up the rest of the list.
+		inline void UnbindSiblings(void) { rSibling = nullptr; lmostSibling = this; }
+
+		// The source line the node starts on, counting from 1. Only statements and functions get one, everything else is 0.
+		inline const ui32 GetLine(void) const { return line; }
+		inline void SetLine(const ui32 newLine) { line = newLine; }
 
 		friend Node* MakeNullNode();
 		friend void DoForAllChildren(Node*, void(*)(Node*, void*), void*);
@@ -58,6 +75,8 @@ namespace AST
 
 		// Get clean RTTI with a kind enum.
 		Node_k kind;
+
+		ui32 line = 0;
 	};
 
 	// Superclass for nodes that need symbol table access to derive from.
@@ -81,7 +100,7 @@ namespace AST
 		IntNode() = default;
 		virtual ~IntNode() override = default;
 		inline const ui64 Get(void) const { return n; }
-		friend Node* MakeIntNode(i32);
+		friend Node* MakeIntNode(i64);
 
 		static const PrimitiveType s_defaultIntLiteralType = PrimitiveType::i64;
 
@@ -119,6 +138,10 @@ namespace AST
 		inline Node* GetLHS(void) const { return lhs; }
 		inline Node* GetRHS(void) const { return rhs; }
 		inline const Op_k GetOp(void) const { return op; }
+
+		// For passes that rewrite expressions, see AST_Folding_Pass.h.
+		inline void SetLHS(Node* newLHS) { lhs = newLHS; }
+		inline void SetRHS(Node* newRHS) { rhs = newRHS; }
 		
 		friend Node* MakeOpNode(const Op_k, Node*, Node*);
 
@@ -140,6 +163,7 @@ namespace AST
 		virtual std::vector<Node*> GetChildren(void) override;
 		inline Node* GetVar(void) const { return var; }
 		inline Node* GetExpr(void) const { return expr; }
+		inline void SetExpr(Node* newExpr) { expr = newExpr; }
 		friend Node* MakeAssNode(Node*, Node*);
 
 	private:
@@ -191,6 +215,7 @@ namespace AST
 		virtual ~ReturnNode() override;
 		virtual std::vector<Node*> GetChildren(void) override;
 		inline Node* GetRetExpr(void) const { return retExpr; }
+		inline void SetRetExpr(Node* newRetExpr) { retExpr = newRetExpr; }
 		friend Node* MakeReturnNode(Node*);
 
 	private:
@@ -205,7 +230,7 @@ namespace AST
 	public:
 
 		FunctionNode() = default;
-		virtual ~FunctionNode() override = default;
+		virtual ~FunctionNode() override;
 		virtual std::vector<Node*> GetChildren(void) override;
 		inline const std::wstring& GetName(void) const { return name; }
 		inline const PrimitiveType GetRetType(void) const { return retType; }
@@ -246,10 +271,11 @@ namespace AST
 	public:
 
 		FunctionCallNode() = default;
-		virtual ~FunctionCallNode() override = default;
+		virtual ~FunctionCallNode() override;
 		virtual std::vector<Node*> GetChildren(void) override;
 		inline const std::wstring& GetName(void) const { return c; }
 		inline Node* GetArgs(void) const { return args; }
+		inline void SetArgs(Node* newArgs) { args = newArgs; }
 		friend Node* MakeFunctionCallNode(std::wstring*, Node*);
 
 	private:
@@ -262,7 +288,7 @@ namespace AST
 	{
 	public:
 		FwdDeclNode() = default;
-		virtual ~FwdDeclNode() override = default;
+		virtual ~FwdDeclNode() override;
 
 		inline const std::wstring& GetName(void) const { return name; }
 		inline const PrimitiveType GetRetType(void) const { return retType; }
@@ -280,7 +306,7 @@ namespace AST
 	{
 	public:
 		ExternFwdDeclNode() = default;
-		virtual ~ExternFwdDeclNode() override = default;
+		virtual ~ExternFwdDeclNode() override;
 		virtual std::vector<Node*> GetChildren(void) override;
 
 		inline Node* GetFwdDeclNode(void) const { return fwdDeclNode; }
@@ -307,10 +333,11 @@ namespace AST
 	{
 	public:
 		DerefNode() = default;
-		virtual ~DerefNode() override = default;
+		virtual ~DerefNode() override;
 		virtual std::vector<Node*> GetChildren(void) override;
 
 		inline Node* GetExpr(void) const { return expr; }
+		inline void SetExpr(Node* newExpr) { expr = newExpr; }
 		friend Node* MakeDerefNode(Node*);
 
 	private:
@@ -321,7 +348,7 @@ namespace AST
 	{
 	public:
 		ForLoopNode() = default;
-		virtual ~ForLoopNode() override = default;
+		virtual ~ForLoopNode() override;
 		virtual std::vector<Node*> GetChildren(void) override;
 		inline Node* GetHead(void) const { return head; }
 		inline Node* GetBody(void) const { return body; }
@@ -336,14 +363,20 @@ namespace AST
 	{
 	public:
 		ForLoopHeadNode() = default;
-		virtual ~ForLoopHeadNode() override = default;
+		virtual ~ForLoopHeadNode() override;
 		virtual std::vector<Node*> GetChildren(void) override;
 		inline Node* GetUpperBound(void) const { return upperBound; }
 		inline Node* GetLowerBound(void) const { return lowerBound; }
+		inline void SetUpperBound(Node* newUpperBound) { upperBound = newUpperBound; }
+		inline void SetLowerBound(Node* newLowerBound) { lowerBound = newLowerBound; }
 		friend Node* MakeForLoopHeadNode(Node*, Node*);
 
 	private:
 		Node* upperBound;
 		Node* lowerBound;
 	};
+
+	// Deletes every node still registered at the disaster handle, whether it made it into the AST or not.
+	// Used to clean up after a compilation that was aborted halfway, when the nodes on the parser's stack are owned by nobody.
+	void FreeAllNodes(void);
 }
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "AST_Analysis_Pass.h"
+#include "AST_Harvest_Pass.h"
+#include "AST_Semantics_Pass.h"
+#include "ASTNode.h"
+
+static void ProcessNode(AST::Node* n);
+
+void AST::AnalysisPass(Node* nodeHead)
+{
+	ProcessNode(nodeHead);
+	wprintf(L"ANALYSIS PASS: Semantically legal program recognized.\n");
+}
+
+void AST::AnalyseGlobalEntry(Node* globalEntry)
+{
+	ProcessNode(globalEntry);
+}
+
+static void ProcessNode(AST::Node* n)
+{
+	AST::HarvestNode(n);
+
+	for (AST::Node* childNode : n->GetChildren())
+	{
+		ProcessNode(childNode);
+	}
+
+	AST::LeaveHarvestedNode(n);
+
+	// Checked on the way up, since the deref rule needs the symbols of the whole subexpression to be resolved.
+	AST::CheckNodeSemantics(n);
+}
\ No newline at end of file
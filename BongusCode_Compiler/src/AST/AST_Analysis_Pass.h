@@ -0,0 +1,19 @@
+#pragma once
+
+/*
+	The harvest pass and the semantics pass fused into a single walk over the AST.
+	Symbols are declared and resolved on the way down(pre-order), and the semantic rules are checked
+	on the way back up(post-order), at which point every symbol in the subtree has been resolved.
+	Set FUSED_ANALYSIS_PASS to 0 in BuildSettings.h to run the two passes separately instead.
+*/
+
+namespace AST
+{
+	class Node;
+
+	void AnalysisPass(AST::Node* nodeHead);
+
+	// Runs the same analysis over a single top-level function or forward declaration. Entries must be analysed
+	// in source order, since a function may only refer to functions declared before it.
+	void AnalyseGlobalEntry(AST::Node* globalEntry);
+}
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include "AST_Folding_Pass.h"
+#include "ASTNode.h"
+#include "ASTAPI.h"
+
+// Computes lhs op rhs the way the generated code would. Returns false if it has to be left to the program.
+static bool Evaluate(const Op_k op, const ui64 lhs, const ui64 rhs, ui64& outResult)
+{
+	switch (op)
+	{
+		case Op_k::ADD: outResult = lhs + rhs; return true;
+		case Op_k::SUB: outResult = lhs - rhs; return true;
+		case Op_k::MUL: outResult = lhs * rhs; return true;
+
+		// div is unsigned. Dividing by 0 has to fault at runtime, same as it would have.
+		case Op_k::DIV:
+		{
+			if (rhs == 0)
+			{
+				return false;
+			}
+			outResult = lhs / rhs;
+			return true;
+		}
+
+		// shl and shr only look at the low 6 bits of CL, and shr shifts in zeroes.
+		case Op_k::SHL: outResult = lhs << (rhs & 63); return true;
+		case Op_k::SHR: outResult = lhs >> (rhs & 63); return true;
+
+		case Op_k::AND: outResult = lhs & rhs; return true;
+		case Op_k::OR: outResult = lhs | rhs; return true;
+	}
+
+	return false;
+}
+
+// Operators that can be rearranged among each other in a chain. Subtraction goes with addition, as adding the negation.
+static i32 GetChainGroup(const Op_k op)
+{
+	switch (op)
+	{
+		case Op_k::ADD:
+		case Op_k::SUB: return 0;
+		case Op_k::MUL: return 1;
+		case Op_k::AND: return 2;
+		case Op_k::OR: return 3;
+		default: return -1;
+	}
+}
+
+static bool IsConstant(AST::Node* n)
+{
+	return n->GetNodeKind() == Node_k::IntNode;
+}
+
+static ui64 GetConstant(AST::Node* n)
+{
+	return ((AST::IntNode*)n)->Get();
+}
+
+// Whether the operations in the chain ending in n compute without truncating anything. Every operation in a chain takes the
+// type of the leftmost operand, and the code generator truncates an operation to its type when it's used as an operand, so
+// in a narrower chain, moving or merging a constant moves where the truncation happens and changes the result.
+static bool IsFullWidthChain(AST::Node* n)
+{
+	switch (AST::GetExpressionType(n))
+	{
+		case PrimitiveType::ui64:
+		case PrimitiveType::i64:
+		case PrimitiveType::pointer: return true;
+		default: return false;
+	}
+}
+
+// Deletes an OpNode that has been taken apart, without the operands that live on elsewhere.
+static void DeleteOpNodeShell(AST::OpNode* n)
+{
+	n->SetLHS(nullptr);
+	n->SetRHS(nullptr);
+	delete n;
+}
+
+// (a op1 c1) op2 c2, with both in the same chain group, as a single operation on a. Returns a alone if the constants cancel out.
+static AST::Node* CombineChainConstants(AST::OpNode* outer, AST::OpNode* inner)
+{
+	AST::Node* a = inner->GetLHS();
+	const ui64 c1 = GetConstant(inner->GetRHS());
+	const ui64 c2 = GetConstant(outer->GetRHS());
+
+	Op_k op = outer->GetOp();
+	ui64 combined = 0;
+	bool isIdentity = false;
+	switch (op)
+	{
+		case Op_k::ADD:
+		case Op_k::SUB:
+		{
+			// The sum of the signed constants, subtracted instead of added if it's negative, to keep the literal positive.
+			combined = (inner->GetOp() == Op_k::ADD ? c1 : 0 - c1) + (outer->GetOp() == Op_k::ADD ? c2 : 0 - c2);
+			op = Op_k::ADD;
+			if ((i64)combined < 0 && combined != 0x8000000000000000ull)
+			{
+				op = Op_k::SUB;
+				combined = 0 - combined;
+			}
+			isIdentity = combined == 0;
+			break;
+		}
+		case Op_k::MUL: combined = c1 * c2; isIdentity = combined == 1; break;
+		case Op_k::AND: combined = c1 & c2; isIdentity = combined == ~0ull; break;
+		case Op_k::OR: combined = c1 | c2; isIdentity = combined == 0; break;
+		default: break;
+	}
+
+	inner->SetLHS(nullptr);
+	delete inner;
+	outer->SetLHS(nullptr);
+	delete outer;
+
+	if (isIdentity)
+	{
+		return a;
+	}
+	return AST::MakeOpNode(op, a, AST::MakeIntNode((i64)combined));
+}
+
+static AST::Node* FoldOpNode(AST::OpNode* n)
+{
+	n->SetLHS(AST::FoldExpression(n->GetLHS()));
+	n->SetRHS(AST::FoldExpression(n->GetRHS()));
+
+	AST::Node* lhs = n->GetLHS();
+	AST::Node* rhs = n->GetRHS();
+
+	ui64 result = 0;
+	if (IsConstant(lhs) && IsConstant(rhs) && Evaluate(n->GetOp(), GetConstant(lhs), GetConstant(rhs), result))
+	{
+		delete n;
+		return AST::MakeIntNode((i64)result);
+	}
+
+	// The operands are folded already, so a chain on the left has its constant, if it has one, as its last operand.
+	const i32 group = GetChainGroup(n->GetOp());
+	if (group == -1 || lhs->GetNodeKind() != Node_k::OpNode)
+	{
+		return n;
+	}
+
+	AST::OpNode* inner = (AST::OpNode*)lhs;
+	if (GetChainGroup(inner->GetOp()) != group || !IsConstant(inner->GetRHS()) || !IsFullWidthChain(inner))
+	{
+		return n;
+	}
+
+	if (IsConstant(rhs))
+	{
+		return CombineChainConstants(n, inner);
+	}
+
+	// (a op1 c) op2 b becomes (a op2 b) op1 c, moving the constant to the end where the next one in the chain can join it.
+	AST::Node* a = inner->GetLHS();
+	AST::Node* c = inner->GetRHS();
+	const Op_k innerOp = inner->GetOp();
+	const Op_k outerOp = n->GetOp();
+	DeleteOpNodeShell(inner);
+	DeleteOpNodeShell(n);
+
+	return AST::MakeOpNode(innerOp, AST::MakeOpNode(outerOp, a, rhs), c);
+}
+
+// Folds the arguments of a call, which are a list of siblings rather than children.
+static void FoldArguments(AST::FunctionCallNode* n)
+{
+	std::vector<AST::Node*> args;
+	for (AST::Node* arg = n->GetArgs(); arg != nullptr; arg = arg->GetRightSibling())
+	{
+		args.push_back(arg);
+	}
+	if (args.empty())
+	{
+		return;
+	}
+
+	// Each argument is taken out of the list before folding it, so that deleting it doesn't take the rest of the list along.
+	AST::Node* head = nullptr;
+	AST::Node* tail = nullptr;
+	for (AST::Node* arg : args)
+	{
+		arg->UnbindSiblings();
+		AST::Node* foldedArg = AST::FoldExpression(arg);
+
+		if (head == nullptr) { head = tail = foldedArg; }
+		else { tail = tail->MakeSiblings(foldedArg); }
+	}
+	n->SetArgs(head);
+}
+
+AST::Node* AST::FoldExpression(Node* n)
+{
+	switch (n->GetNodeKind())
+	{
+		case Node_k::OpNode:
+		{
+			return FoldOpNode((AST::OpNode*)n);
+		}
+		case Node_k::DerefNode:
+		{
+			AST::DerefNode* asDerefNode = (AST::DerefNode*)n;
+			asDerefNode->SetExpr(AST::FoldExpression(asDerefNode->GetExpr()));
+			return n;
+		}
+		case Node_k::FunctionCallNode:
+		{
+			FoldArguments((AST::FunctionCallNode*)n);
+			return n;
+		}
+		default:
+		{
+			return n;
+		}
+	}
+}
+
+static void FoldStatements(AST::Node* n)
+{
+	switch (n->GetNodeKind())
+	{
+		case Node_k::AssNode:
+		{
+			AST::AssNode* asAssNode = (AST::AssNode*)n;
+			asAssNode->SetExpr(AST::FoldExpression(asAssNode->GetExpr()));
+
+			// The address assigned through is an expression too.
+			AST::FoldExpression(asAssNode->GetVar());
+			return;
+		}
+		case Node_k::ReturnNode:
+		{
+			AST::ReturnNode* asReturnNode = (AST::ReturnNode*)n;
+			asReturnNode->SetRetExpr(AST::FoldExpression(asReturnNode->GetRetExpr()));
+			return;
+		}
+
+		// Expression statements stay where they are in their scope, only what's under them is folded.
+		case Node_k::OpNode:
+		{
+			AST::OpNode* asOpNode = (AST::OpNode*)n;
+			asOpNode->SetLHS(AST::FoldExpression(asOpNode->GetLHS()));
+			asOpNode->SetRHS(AST::FoldExpression(asOpNode->GetRHS()));
+			return;
+		}
+		case Node_k::DerefNode:
+		case Node_k::FunctionCallNode:
+		{
+			AST::FoldExpression(n);
+			return;
+		}
+		default:
+		{
+			break;
+		}
+	}
+
+	for (AST::Node* childNode : n->GetChildren())
+	{
+		FoldStatements(childNode);
+	}
+}
+
+void AST::FoldConstants(Node* subtree)
+{
+	FoldStatements(subtree);
+}
\ No newline at end of file
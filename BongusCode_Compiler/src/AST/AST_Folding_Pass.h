@@ -0,0 +1,28 @@
+#pragma once
+
+/*
+	Constant folding, run over the analysed AST before code generation.
+
+	Every OpNode whose operands are both literals is replaced by a literal holding its result, and constants in chains of
+	the same associative operator are gathered at the end of the chain and combined, e.g. x + 1 - y + 2 becomes (x - y) + 3.
+	What's left for the code generator then takes a single immediate where it used to evaluate the whole subtree.
+
+	The results are exactly what the generated code would have computed at runtime. An OpNode takes the type of its
+	leftmost operand, computes in 64 bits and truncates to that type, so:
+	● Two literals, both of the i64 literal type, fold with 64 bit wraparound, unsigned division(div) and shifts that only
+	  use the low 6 bits of the amount, like the instructions do. Division by 0 is left for the program to fault on.
+	● Chains are only rearranged when their leftmost operand is 64 bits wide. Then no step truncates anything, and adding,
+	  subtracting, multiplying, and'ing and or'ing modulo 2^64 don't care about the order. A narrower chain truncates
+	  after every step, so it's left as it is, e.g. with a ui32 x of 4294967295, (x + 1) - 0 is 0 but x + (1 - 0) isn't.
+*/
+
+namespace AST
+{
+	class Node;
+
+	// Folds every expression under subtree, which is the whole AST or a single top-level entry of it.
+	void FoldConstants(AST::Node* subtree);
+
+	// Folds a single expression. Returns what takes its place, which may be n itself.
+	AST::Node* FoldExpression(AST::Node* n);
+}
\ No newline at end of file
@@ -14,6 +14,18 @@ void AST::BuildSymbolTable(Node* nodeHead)
 }
 
 static void ProcessNode(AST::Node* n)
+{
+    AST::HarvestNode(n);
+
+    for (AST::Node* childnode : n->GetChildren())
+    {
+        ProcessNode(childnode);
+    }
+
+    AST::LeaveHarvestedNode(n);
+}
+
+void AST::HarvestNode(Node* n)
 {
     #define symtab g_symTable
     Node_k nodeKind = n->GetNodeKind();
@@ -165,15 +177,14 @@ static void ProcessNode(AST::Node* n)
         }
 
     }
-    for (AST::Node* childnode : n->GetChildren())
-    {
-        ProcessNode(childnode);
-    }
 
-    if (nodeKind == Node_k::FunctionNode)
+    #undef symtab
+}
+
+void AST::LeaveHarvestedNode(Node* n)
+{
+    if (n->GetNodeKind() == Node_k::FunctionNode)
     {
-      symtab.CloseFunction();
+      g_symTable.CloseFunction();
     }
-
-    #undef symtab
 }
@@ -13,4 +13,9 @@ namespace AST
 	class Node;
 
 	void BuildSymbolTable(AST::Node* nodeHead);
+
+	// The per-node halves of the pass, so that other passes can harvest while they walk the tree themselves.
+	// HarvestNode must be called before the node's children are visited, and LeaveHarvestedNode after.
+	void HarvestNode(AST::Node* n);
+	void LeaveHarvestedNode(AST::Node* n);
 }
\ No newline at end of file
@@ -0,0 +1,433 @@
+#include "AST_Propagation_Pass.h"
+#include "AST_Folding_Pass.h"
+#include "ASTNode.h"
+#include "ASTAPI.h"
+#include <unordered_map>
+
+// What's known about a local at some point in a function: either the literal it holds, or the other local it's a copy of.
+struct KnownValue
+{
+	bool isConstant;
+	ui64 constant;
+
+	SymTabEntry* copyOf;
+	std::wstring copyOfName;
+};
+
+using KnownValues = std::unordered_map<SymTabEntry*, KnownValue>;
+using EntrySet = std::unordered_set<SymTabEntry*>;
+
+// Locals that can be propagated and whose stores can be dropped, for the function being worked on.
+static bool IsTracked(SymTabEntry* entry, const EntrySet& addressTaken)
+{
+	return entry != nullptr && !entry->isFunction && entry->asVar.type != PrimitiveType::pointer && addressTaken.count(entry) == 0;
+}
+
+// The value a load of the local gives after storing value to it, which is truncated to the local's size and zero extended.
+static ui64 TruncateToLocal(SymTabEntry* entry, const ui64 value)
+{
+	return entry->asVar.size >= 8 ? value : value & ((1ull << (entry->asVar.size * 8)) - 1);
+}
+
+// Forgets everything known about entry, and about the locals that were copies of it.
+static void Kill(KnownValues& knownValues, SymTabEntry* entry)
+{
+	knownValues.erase(entry);
+	for (auto it = knownValues.begin(); it != knownValues.end();)
+	{
+		if (!it->second.isConstant && it->second.copyOf == entry) { it = knownValues.erase(it); }
+		else { ++it; }
+	}
+}
+
+// Every local a loop assigns to.
+static void CollectAssigned(AST::Node* n, EntrySet& outAssigned)
+{
+	for (AST::Node* assignment : AST::GetAllChildNodesOfType(n, Node_k::AssNode))
+	{
+		AST::Node* var = ((AST::AssNode*)assignment)->GetVar();
+		if (var->GetNodeKind() == Node_k::SymNode)
+		{
+			outAssigned.insert(((AST::SymNode*)var)->GetSymTabEntry());
+		}
+	}
+}
+
+// Every local read under n. The locals assigned to aren't read, unless they're read elsewhere.
+static void CollectUses(AST::Node* n, EntrySet& outUses)
+{
+	const std::vector<AST::Node*> subtree = AST::GetAllChildrenRecursively(n);
+
+	std::unordered_set<AST::Node*> assignedVars;
+	for (AST::Node* subtreeNode : subtree)
+	{
+		if (subtreeNode->GetNodeKind() == Node_k::AssNode)
+		{
+			assignedVars.insert(((AST::AssNode*)subtreeNode)->GetVar());
+		}
+	}
+
+	for (AST::Node* subtreeNode : subtree)
+	{
+		if (subtreeNode->GetNodeKind() == Node_k::SymNode && assignedVars.count(subtreeNode) == 0)
+		{
+			outUses.insert(((AST::SymNode*)subtreeNode)->GetSymTabEntry());
+		}
+	}
+}
+
+// Returns what takes n's place, which may be n itself. isLeftmostOperand is whether n gives an OpNode its type.
+static AST::Node* Substitute(AST::Node* n, const bool isLeftmostOperand, const KnownValues& knownValues);
+
+static void SubstituteArguments(AST::FunctionCallNode* n, const KnownValues& knownValues)
+{
+	std::vector<AST::Node*> args;
+	for (AST::Node* arg = n->GetArgs(); arg != nullptr; arg = arg->GetRightSibling())
+	{
+		args.push_back(arg);
+	}
+	if (args.empty())
+	{
+		return;
+	}
+
+	// Same as folding them, each argument leaves the list first, so replacing it doesn't delete the rest of the list.
+	AST::Node* head = nullptr;
+	AST::Node* tail = nullptr;
+	for (AST::Node* arg : args)
+	{
+		arg->UnbindSiblings();
+		AST::Node* newArg = Substitute(arg, false, knownValues);
+
+		if (head == nullptr) { head = tail = newArg; }
+		else { tail = tail->MakeSiblings(newArg); }
+	}
+	n->SetArgs(head);
+}
+
+static AST::Node* Substitute(AST::Node* n, const bool isLeftmostOperand, const KnownValues& knownValues)
+{
+	switch (n->GetNodeKind())
+	{
+		case Node_k::SymNode:
+		{
+			SymTabEntry* entry = ((AST::SymNode*)n)->GetSymTabEntry();
+			const auto found = knownValues.find(entry);
+			if (found == knownValues.end())
+			{
+				return n;
+			}
+
+			const KnownValue& knownValue = found->second;
+			if (knownValue.isConstant)
+			{
+				if (isLeftmostOperand && entry->asVar.size < 8)
+				{
+					return n;
+				}
+				delete n;
+				return AST::MakeIntNode((i64)knownValue.constant);
+			}
+
+			AST::Node* copy = AST::MakeSymNode(new std::wstring(knownValue.copyOfName));
+			((AST::SymNode*)copy)->SetSymTabEntry(knownValue.copyOf);
+			delete n;
+			return copy;
+		}
+		case Node_k::OpNode:
+		{
+			AST::OpNode* asOpNode = (AST::OpNode*)n;
+			asOpNode->SetLHS(Substitute(asOpNode->GetLHS(), true, knownValues));
+			asOpNode->SetRHS(Substitute(asOpNode->GetRHS(), false, knownValues));
+			return n;
+		}
+		case Node_k::DerefNode:
+		{
+			AST::DerefNode* asDerefNode = (AST::DerefNode*)n;
+			asDerefNode->SetExpr(Substitute(asDerefNode->GetExpr(), false, knownValues));
+			return n;
+		}
+		case Node_k::FunctionCallNode:
+		{
+			SubstituteArguments((AST::FunctionCallNode*)n, knownValues);
+			return n;
+		}
+		default:
+		{
+			return n;
+		}
+	}
+}
+
+static AST::Node* SubstituteAndFold(AST::Node* n, const KnownValues& knownValues)
+{
+	return AST::FoldExpression(Substitute(n, false, knownValues));
+}
+
+// A For loop's bounds are only ever literals or locals, so a bound is replaced by the literal a local holds and nothing else.
+static AST::Node* SubstituteBound(AST::Node* bound, const KnownValues& knownValues)
+{
+	if (bound->GetNodeKind() != Node_k::SymNode)
+	{
+		return bound;
+	}
+
+	const auto found = knownValues.find(((AST::SymNode*)bound)->GetSymTabEntry());
+	if (found == knownValues.end() || !found->second.isConstant)
+	{
+		return bound;
+	}
+
+	delete bound;
+	return AST::MakeIntNode((i64)found->second.constant);
+}
+
+static void PropagateStatements(AST::Node* scope, KnownValues& knownValues, const EntrySet& addressTaken)
+{
+	for (AST::Node* statement : scope->GetChildren())
+	{
+		switch (statement->GetNodeKind())
+		{
+			case Node_k::AssNode:
+			{
+				AST::AssNode* asAssNode = (AST::AssNode*)statement;
+				asAssNode->SetExpr(SubstituteAndFold(asAssNode->GetExpr(), knownValues));
+
+				AST::Node* var = asAssNode->GetVar();
+				if (var->GetNodeKind() == Node_k::DerefNode)
+				{
+					AST::DerefNode* asDerefNode = (AST::DerefNode*)var;
+					asDerefNode->SetExpr(SubstituteAndFold(asDerefNode->GetExpr(), knownValues));
+					break;
+				}
+
+				SymTabEntry* entry = ((AST::SymNode*)var)->GetSymTabEntry();
+				Kill(knownValues, entry);
+				if (!IsTracked(entry, addressTaken))
+				{
+					break;
+				}
+
+				AST::Node* expr = asAssNode->GetExpr();
+				if (expr->GetNodeKind() == Node_k::IntNode)
+				{
+					knownValues[entry] = { true, TruncateToLocal(entry, ((AST::IntNode*)expr)->Get()), nullptr, std::wstring() };
+				}
+				else if (expr->GetNodeKind() == Node_k::SymNode)
+				{
+					// Only copies of the same type, so the copy reads exactly like the original.
+					AST::SymNode* source = (AST::SymNode*)expr;
+					SymTabEntry* sourceEntry = source->GetSymTabEntry();
+					if (sourceEntry != entry && IsTracked(sourceEntry, addressTaken) && sourceEntry->asVar.type == entry->asVar.type)
+					{
+						knownValues[entry] = { false, 0, sourceEntry, source->GetName() };
+					}
+				}
+				break;
+			}
+			case Node_k::ReturnNode:
+			{
+				AST::ReturnNode* asReturnNode = (AST::ReturnNode*)statement;
+				asReturnNode->SetRetExpr(SubstituteAndFold(asReturnNode->GetRetExpr(), knownValues));
+				break;
+			}
+
+			// Expression statements stay where they are in their scope, only what's under them is rewritten.
+			case Node_k::OpNode:
+			{
+				AST::OpNode* asOpNode = (AST::OpNode*)statement;
+				asOpNode->SetLHS(AST::FoldExpression(Substitute(asOpNode->GetLHS(), true, knownValues)));
+				asOpNode->SetRHS(SubstituteAndFold(asOpNode->GetRHS(), knownValues));
+				break;
+			}
+			case Node_k::DerefNode:
+			case Node_k::FunctionCallNode:
+			{
+				SubstituteAndFold(statement, knownValues);
+				break;
+			}
+			case Node_k::DeclNode:
+			{
+				// Declared again on every iteration of a loop, without a value.
+				Kill(knownValues, ((AST::DeclNode*)statement)->GetSymTabEntry());
+				break;
+			}
+			case Node_k::ForLoopNode:
+			{
+				AST::ForLoopNode* asForLoopNode = (AST::ForLoopNode*)statement;
+				AST::ForLoopHeadNode* head = (AST::ForLoopHeadNode*)asForLoopNode->GetHead();
+
+				// The lower bound is read once before the loop, the upper bound before every iteration.
+				head->SetLowerBound(SubstituteBound(head->GetLowerBound(), knownValues));
+
+				EntrySet assigned;
+				CollectAssigned(asForLoopNode->GetBody(), assigned);
+				for (SymTabEntry* entry : assigned)
+				{
+					Kill(knownValues, entry);
+				}
+
+				head->SetUpperBound(SubstituteBound(head->GetUpperBound(), knownValues));
+
+				// What the body learns doesn't hold after the loop, which may not have run at all.
+				KnownValues bodyKnownValues = knownValues;
+				PropagateStatements(asForLoopNode->GetBody(), bodyKnownValues, addressTaken);
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+	}
+}
+
+// Stores to a local can be dropped if nothing reads it afterwards, unless computing what's stored does more than that.
+static bool IsRemovableStore(AST::AssNode* n, const EntrySet& live, const EntrySet& addressTaken)
+{
+	AST::Node* var = n->GetVar();
+	if (var->GetNodeKind() != Node_k::SymNode)
+	{
+		return false;
+	}
+
+	SymTabEntry* entry = ((AST::SymNode*)var)->GetSymTabEntry();
+	if (!IsTracked(entry, addressTaken) || live.count(entry) != 0)
+	{
+		return false;
+	}
+
+	for (AST::Node* exprNode : AST::GetAllChildrenRecursively(n->GetExpr()))
+	{
+		if (exprNode->GetNodeKind() == Node_k::FunctionCallNode || exprNode->GetNodeKind() == Node_k::DerefNode)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Walks the scope's statements backwards, dropping the dead stores. live holds the locals read after the scope on entry,
+// and those read before it by the time it returns.
+static void RemoveDeadStores(AST::Node* scope, EntrySet& live, const EntrySet& addressTaken)
+{
+	std::vector<AST::Node*> statements = scope->GetChildren();
+	std::vector<bool> isRemoved(statements.size(), false);
+	bool removedAny = false;
+
+	for (ui64 i = statements.size(); i-- > 0;)
+	{
+		AST::Node* statement = statements[i];
+		switch (statement->GetNodeKind())
+		{
+			case Node_k::AssNode:
+			{
+				AST::AssNode* asAssNode = (AST::AssNode*)statement;
+				if (IsRemovableStore(asAssNode, live, addressTaken))
+				{
+					isRemoved[i] = removedAny = true;
+					break;
+				}
+
+				AST::Node* var = asAssNode->GetVar();
+				if (var->GetNodeKind() == Node_k::SymNode)
+				{
+					live.erase(((AST::SymNode*)var)->GetSymTabEntry());
+				}
+				else
+				{
+					CollectUses(var, live);
+				}
+				CollectUses(asAssNode->GetExpr(), live);
+				break;
+			}
+			case Node_k::ReturnNode:
+			{
+				// Nothing after a return runs.
+				live.clear();
+				CollectUses(statement, live);
+				break;
+			}
+			case Node_k::ForLoopNode:
+			{
+				// Whatever the loop reads may be read on the next iteration, after the end of the body.
+				AST::ForLoopNode* asForLoopNode = (AST::ForLoopNode*)statement;
+				EntrySet loopUses;
+				CollectUses(statement, loopUses);
+
+				EntrySet bodyLive = live;
+				bodyLive.insert(loopUses.begin(), loopUses.end());
+				RemoveDeadStores(asForLoopNode->GetBody(), bodyLive, addressTaken);
+
+				live.insert(loopUses.begin(), loopUses.end());
+				break;
+			}
+			default:
+			{
+				CollectUses(statement, live);
+				break;
+			}
+		}
+	}
+
+	if (!removedAny)
+	{
+		return;
+	}
+
+	// Rebuild the scope's list of statements without the removed ones, which are taken out of it before they're deleted.
+	AST::Node* head = nullptr;
+	AST::Node* tail = nullptr;
+	for (ui64 i = 0; i < statements.size(); i++)
+	{
+		statements[i]->UnbindSiblings();
+		if (isRemoved[i])
+		{
+			delete statements[i];
+			continue;
+		}
+
+		if (head == nullptr) { head = tail = statements[i]; }
+		else { tail = tail->MakeSiblings(statements[i]); }
+	}
+
+	scope->UnbindChildren();
+	scope->AdoptChildren(head != nullptr ? head : AST::MakeNullNode());
+}
+
+static void PropagateFunction(AST::FunctionNode* n)
+{
+	const EntrySet addressTaken = AST::GetAddressTakenLocals(n);
+
+	for (AST::Node* childNode : n->GetChildren())
+	{
+		if (childNode->GetNodeKind() != Node_k::ScopeNode)
+		{
+			continue;
+		}
+
+		KnownValues knownValues;
+		PropagateStatements(childNode, knownValues, addressTaken);
+
+		// Locals don't outlive the function.
+		EntrySet live;
+		RemoveDeadStores(childNode, live, addressTaken);
+	}
+}
+
+void AST::PropagateConstants(Node* subtree)
+{
+	if (subtree->GetNodeKind() == Node_k::FunctionNode)
+	{
+		PropagateFunction((AST::FunctionNode*)subtree);
+		return;
+	}
+
+	for (Node* childNode : subtree->GetChildren())
+	{
+		if (childNode->GetNodeKind() == Node_k::FunctionNode)
+		{
+			PropagateFunction((AST::FunctionNode*)childNode);
+		}
+	}
+}
\ No newline at end of file
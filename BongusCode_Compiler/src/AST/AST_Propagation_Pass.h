@@ -0,0 +1,27 @@
+#pragma once
+
+/*
+	Constant and copy propagation, run over each function after constant folding.
+
+	Walking a function's statements in order, the pass remembers which locals hold a known literal(x = 5) or the value of
+	another local(y = x), and rewrites later reads of them into that literal or that local. The statements it touched are
+	folded again, so x = 5. y = x * 2. ends up as y = 10. Stores that nothing reads afterwards are then dropped.
+
+	The rewritten program computes exactly what the original one did:
+	● Locals whose address is taken(&x) can change behind the pass' back, so they're never propagated or dropped, and neither
+	  are the ones declared in the same run of declarations, which the pointer may be offset into(see GetAddressTakenLocals).
+	● Pointers aren't propagated either, the code generator reads the pointee type of a dereference off the pointer's symbol.
+	● Every load zero extends the local into the 64 bit register, so the literal that replaces it is its value truncated to its
+	  type. A local that's the leftmost operand of an operation gives the operation its type though, and a literal would widen
+	  it to i64, so those are only replaced if the local is 64 bits wide already.
+	● Nothing known survives into a For loop for a local the loop assigns to, as the body runs more than once.
+	● Stores whose expression calls a function or dereferences a pointer are kept, for the call's side effects or the fault.
+*/
+
+namespace AST
+{
+	class Node;
+
+	// Propagates through every function under subtree, which is the whole AST or a single top-level entry of it.
+	void PropagateConstants(AST::Node* subtree);
+}
\ No newline at end of file
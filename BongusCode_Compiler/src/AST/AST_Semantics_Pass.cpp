@@ -12,6 +12,16 @@ void AST::SemanticsPass(Node* nodeHead)
 }
 
 static void ProcessNode(AST::Node* n)
+{
+	AST::CheckNodeSemantics(n);
+
+	for (AST::Node* childNode : n->GetChildren())
+	{
+		ProcessNode(childNode);
+	}
+}
+
+void AST::CheckNodeSemantics(Node* n)
 {
 	Node_k nodeKind = n->GetNodeKind();
 	switch (nodeKind)
@@ -81,8 +91,4 @@ static void ProcessNode(AST::Node* n)
 			break;
 		}
 	}
-	for (AST::Node* childNode : n->GetChildren())
-	{
-		ProcessNode(childNode);
-	}
 }
\ No newline at end of file
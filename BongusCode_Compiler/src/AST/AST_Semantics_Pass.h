@@ -6,4 +6,7 @@ namespace AST
 
 	// We perform a semantics pass to enforce semantics like the return operation not obscuring more code, making it unreachable.
 	void SemanticsPass(AST::Node* nodeHead);
+
+	// Checks the semantic rules for a single node. Every symbol in the node's subtree must already be resolved.
+	void CheckNodeSemantics(AST::Node* n);
 }
\ No newline at end of file
@@ -2,4 +2,17 @@
 
 
 #define LEXER_LOGGING 0
-#define PARSER_DEBUG_TRACE 0
\ No newline at end of file
+#define PARSER_DEBUG_TRACE 0
+
+// 1 harvests symbols and checks semantics in one walk over the AST, 0 runs the harvest and semantics passes separately.
+#define FUSED_ANALYSIS_PASS 1
+
+// 1 compiles in the phase timers and trace scopes behind --time-report and --trace, 0 leaves them out altogether.
+#define PROFILING 1
+
+// 1 replaces the global operator new and delete to count allocations for --mem-report, 0 leaves the allocator alone.
+// Every allocation carries a 16 byte header while it's on, whether --mem-report is given or not.
+#define MEMORY_ACCOUNTING 1
+
+// Bump whenever the generated code changes. It's part of every compile cache key, so output cached by an older compiler stops matching.
+#define COMPILER_VERSION "0.2.8"
\ No newline at end of file
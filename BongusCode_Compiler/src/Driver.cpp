@@ -0,0 +1,529 @@
+#include "Driver.h"
+#include <stdio.h>
+#include <chrono>
+
+#include "BuildSettings.h"
+#include "Exit.h"
+#include "Utils.h"
+#include "Options.h"
+#include "parser/parser.hpp"
+#include "lexer/lexer.h"
+#include "lexer/TokenStream.h"
+#include "lexer/ChunkedLexing.h"
+#include "AST/ASTNode.h"
+#include "AST/AST_Harvest_Pass.h"
+#include "AST/AST_Semantics_Pass.h"
+#include "AST/AST_Analysis_Pass.h"
+#include "AST/AST_Folding_Pass.h"
+#include "AST/AST_Propagation_Pass.h"
+#include "symbol_table/symtable.h"
+#include "code_generator/codegen.h"
+#include "code_generator/CostModel.h"
+#include "IR/IR_PassManager.h"
+#include "pipeline/FunctionPipeline.h"
+#include "cache/CompileCache.h"
+#include "snapshot/Snapshot.h"
+#include "distributed/CodegenWorker.h"
+#include "profiling/Profiler.h"
+#include "profiling/MemoryAccounting.h"
+#include <filesystem>
+
+AST::Node* g_nodeHead = nullptr;
+
+// Closes the file when going out of scope, so an aborted compilation doesn't leave it open.
+struct ScopedFile
+{
+	FILE* file = nullptr;
+
+	~ScopedFile()
+	{
+		if (file != nullptr)
+		{
+			fclose(file);
+		}
+	}
+};
+
+static void WriteOutputFile(const char* outputPath, const std::string& code)
+{
+	Profiling::Phase phase("Writing output");
+	phase.AddThroughput(code.size(), "bytes");
+
+	FILE* outFile = fopen(outputPath, "w");
+	if (outFile == nullptr)
+	{
+		wprintf(L"ERROR: Unable to open output file.\n");
+		Exit(ErrCodes::malformed_cmd_line);
+	}
+
+	fwrite(code.c_str(), sizeof(code[0]), code.length(), outFile);
+	fclose(outFile);
+}
+
+static i64 GetMillisecondsSince(const std::chrono::steady_clock::time_point start)
+{
+	return (i64)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Writes the analysed AST to the snapshot, and with --verify-snapshot loads it back to check it against the original.
+static void EmitSnapshot(const std::chrono::steady_clock::time_point frontEndStart, const std::vector<std::string>& importedExternFunctions)
+{
+	Profiling::Phase phase("Writing snapshot");
+
+	const i64 frontEndTime = GetMillisecondsSince(frontEndStart);
+
+	const auto writeStart = std::chrono::steady_clock::now();
+	ui64 nodeCount = 0;
+	if (!Snapshot::Write(g_options.snapshotPath.c_str(), g_nodeHead, g_symTable, importedExternFunctions, nodeCount))
+	{
+		wprintf(L"ERROR: Unable to write snapshot file.\n");
+		Exit(ErrCodes::malformed_cmd_line);
+	}
+
+	wprintf(L"SNAPSHOT: Wrote %llu nodes and %llu symbols in %lld ms.\n", nodeCount, (ui64)g_symTable.GetEntries().size(), GetMillisecondsSince(writeStart));
+
+	if (g_options.verifySnapshot)
+	{
+		// Loaded into a table of its own, so the original symbols stay untouched for code generation.
+		SymTable loadedSymTable;
+		std::vector<std::string> loadedImportedExternFunctions;
+		const auto loadStart = std::chrono::steady_clock::now();
+		AST::Node* loadedNodeHead = Snapshot::Load(g_options.snapshotPath.c_str(), loadedSymTable, loadedImportedExternFunctions, nodeCount);
+		const i64 loadTime = GetMillisecondsSince(loadStart);
+
+		const bool isIdentical = Snapshot::VerifyRoundTrip(g_nodeHead, loadedNodeHead) && loadedImportedExternFunctions == importedExternFunctions;
+		delete loadedNodeHead;
+
+		if (!isIdentical)
+		{
+			wprintf(L"ERROR: The snapshot doesn't match the AST it was written from.\n");
+			Exit(ErrCodes::internal_compiler_error);
+		}
+
+		wprintf(L"SNAPSHOT: Round trip verified. Loading took %lld ms, against %lld ms for lexing, parsing and analysis.\n", loadTime, frontEndTime);
+	}
+}
+
+static void EmitInterface(void)
+{
+	Profiling::Phase phase("Writing interface");
+
+	ui64 functionCount = 0;
+	if (!Snapshot::WriteInterface(g_options.interfacePath.c_str(), g_nodeHead, g_symTable, functionCount))
+	{
+		wprintf(L"ERROR: Unable to write module interface file.\n");
+		Exit(ErrCodes::malformed_cmd_line);
+	}
+
+	wprintf(L"INTERFACE: Wrote the declarations of %llu functions.\n", functionCount);
+}
+
+// Generates the code for the whole AST under g_nodeHead, here or on the codegen workers.
+static void GenerateAllCode(const std::vector<std::string>& importedExternFunctions, std::string& outCode)
+{
+	Profiling::Phase phase("Code generation");
+
+	// The remarks are printed by whichever process generates the code, so it has to be this one.
+	if (g_options.codegenWorkers.empty() || g_options.remarks)
+	{
+		GenerateCode(g_nodeHead, outCode, importedExternFunctions);
+	}
+	else
+	{
+		Distributed::GenerateCodeOnWorkers(g_nodeHead, g_symTable, g_options.codegenWorkers, importedExternFunctions, outCode);
+	}
+
+	phase.AddThroughput(AST::g_disasterHandle.size(), "nodes");
+	phase.AddThroughput(outCode.size(), "bytes");
+}
+
+static void FreeAST(void)
+{
+	Memory::TakeCensus();
+
+	Profiling::Phase phase("Freeing the AST");
+
+	delete g_nodeHead;
+	g_nodeHead = nullptr;
+}
+
+// Compiles a snapshot written by --emit-snapshot, which starts out where the front end would have left off.
+static void CompileSnapshot(const char* snapshotPath, const char* outputPath)
+{
+	const auto loadStart = std::chrono::steady_clock::now();
+	Profiling::Phase loadPhase("Loading snapshot");
+	std::vector<std::string> importedExternFunctions;
+	ui64 nodeCount = 0;
+	g_nodeHead = Snapshot::Load(snapshotPath, g_symTable, importedExternFunctions, nodeCount);
+	loadPhase.AddThroughput(nodeCount, "nodes");
+	loadPhase.End();
+
+	wprintf(L"SNAPSHOT: Loaded %llu nodes in %lld ms.\n", nodeCount, GetMillisecondsSince(loadStart));
+
+	std::string code;
+	GenerateAllCode(importedExternFunctions, code);
+	FreeAST();
+	WriteOutputFile(outputPath, code);
+}
+
+// Compiles the translation unit from source, all the way through the front end.
+static void CompileSource(const char* sourcePath, const char* outputPath, const std::string* sourceBuffer)
+{
+
+	// The chunked lexer and the cache work on the whole source at once, so they get a mapping of the file rather than the FILE.
+	Utils::MappedFile mappedTranslationUnit;
+
+	// With the cache, a translation unit that has been compiled before is never lexed or parsed, its output is copied out of the cache.
+	Cache::CompileCache cache;
+	ui64 cacheKey = 0;
+	// A cache hit never gets to see an AST, so there'd be nothing to write a snapshot or an interface from, to remark on, or
+	// to build the IR from and print, before or after the passes ran.
+	if (g_options.cache && g_options.snapshotPath.empty() && g_options.interfacePath.empty() && !g_options.remarks && !g_options.emitIR &&
+		g_options.printAfterPasses.empty() && !g_options.passStats)
+	{
+		Profiling::Phase phase("Cache lookup");
+
+		if (!cache.Open(g_options.cacheDirectory, g_options.cacheMaxSize))
+		{
+			wprintf(L"WARNING: Unable to open the compile cache, compiling without it.\n");
+		}
+		else if (sourceBuffer != nullptr)
+		{
+			cacheKey = Cache::CompileCache::ComputeKey(sourceBuffer->data(), sourceBuffer->size(), g_options);
+		}
+		else if (mappedTranslationUnit.Open(sourcePath))
+		{
+			cacheKey = Cache::CompileCache::ComputeKey(mappedTranslationUnit.GetData(), mappedTranslationUnit.GetSize(), g_options);
+		}
+
+		if (cacheKey != 0 && cache.Fetch(cacheKey, outputPath))
+		{
+			wprintf(L"CACHE: Hit, output copied from the cache.\n");
+			if (g_options.cacheStats)
+			{
+				cache.PrintStats();
+			}
+			return;
+		}
+	}
+
+	std::vector<std::string> importedExternFunctions;
+	LoadImportedInterfaces(importedExternFunctions);
+
+	ScopedFile translationUnit;
+
+	if (sourceBuffer == nullptr)
+	{
+		translationUnit.file = fopen(sourcePath, "r");
+
+		if (translationUnit.file == nullptr)
+		{
+			wprintf(L"ERROR: Unable to open source file.\n");
+			Exit(ErrCodes::malformed_cmd_line);
+		}
+	}
+
+	yy::Lexer lexer(sourceBuffer != nullptr ? reflex::Input(sourceBuffer->data(), sourceBuffer->size()) : reflex::Input(translationUnit.file));
+
+	yy::parser parser(lexer);
+
+	// In pipelined mode the parser hands every function to the pipeline's worker as soon as it has been reduced.
+	// When streaming, the worker writes straight into the output file, so it has to be opened up front.
+	// The pipeline and token sources are declared after streamOutFile, so an abort joins their threads before the file is closed.
+	ScopedFile streamOutFile;
+	Pipeline::FunctionPipeline pipeline;
+	if (g_options.pipelined)
+	{
+		if (g_options.streaming)
+		{
+			streamOutFile.file = fopen(outputPath, "w");
+			if (streamOutFile.file == nullptr)
+			{
+				wprintf(L"ERROR: Unable to open output file.\n");
+				Exit(ErrCodes::malformed_cmd_line);
+			}
+		}
+
+		Pipeline::g_pipeline = &pipeline;
+		pipeline.Start(streamOutFile.file, importedExternFunctions);
+	}
+
+#if PARSER_DEBUG_TRACE == 1
+	parser.set_debug_level(1);
+#endif
+
+	yy::ChunkedTokenSource chunkedTokenSource;
+	yy::ThreadedTokenSource threadedTokenSource;
+	if (g_options.lexThreads != 0)
+	{
+		const char* source = nullptr;
+		ui64 sourceSize = 0;
+
+		if (sourceBuffer != nullptr)
+		{
+			source = sourceBuffer->data();
+			sourceSize = sourceBuffer->size();
+		}
+		else
+		{
+			if (mappedTranslationUnit.GetData() == nullptr && !mappedTranslationUnit.Open(sourcePath))
+			{
+				wprintf(L"ERROR: Unable to map source file.\n");
+				Exit(ErrCodes::malformed_cmd_line);
+			}
+
+			source = mappedTranslationUnit.GetData();
+			sourceSize = mappedTranslationUnit.GetSize();
+		}
+
+		const auto lexStart = std::chrono::steady_clock::now();
+		Profiling::Phase lexPhase("Lexing");
+		chunkedTokenSource.Lex(source, sourceSize, g_options.lexThreads);
+		lexPhase.AddThroughput(sourceSize, "bytes");
+		lexPhase.End();
+		const auto lexEnd = std::chrono::steady_clock::now();
+
+		wprintf(L"LEXER: Lexed %llu bytes on %u threads in %lld ms.\n",
+			sourceSize, g_options.lexThreads, (i64)std::chrono::duration_cast<std::chrono::milliseconds>(lexEnd - lexStart).count());
+
+		if (g_options.verifyLexing && !chunkedTokenSource.VerifyAgainstSerialLexing(source, sourceSize))
+		{
+			Exit(ErrCodes::internal_compiler_error);
+		}
+
+		yy::g_tokenSource = &chunkedTokenSource;
+	}
+	else if (g_options.threadedLexer)
+	{
+		threadedTokenSource.Start(lexer);
+		yy::g_tokenSource = &threadedTokenSource;
+	}
+
+	const auto frontEndStart = std::chrono::steady_clock::now();
+
+	// In pipelined mode, analysis and code generation run on the pipeline's worker while this is going on.
+	Profiling::Phase parsePhase(g_options.lexThreads != 0 ? "Parsing" : "Lexing and parsing");
+
+	if (parser.parse() == 0) { wprintf(L"PARSER: Syntactically legal program recognized.\n"); }
+
+	if (g_options.lexThreads == 0 && g_options.threadedLexer)
+	{
+		threadedTokenSource.Finish();
+	}
+	yy::g_tokenSource = nullptr;
+
+	if (Profiling::g_isEnabled)
+	{
+		const ui64 sourceSize = sourceBuffer != nullptr ? sourceBuffer->size() : (ui64)std::filesystem::file_size(sourcePath);
+		parsePhase.AddThroughput(Profiling::g_counters.tokens, "tokens");
+		parsePhase.AddThroughput(sourceSize, "bytes");
+	}
+	parsePhase.End();
+
+	std::string code;
+
+	if (g_options.pipelined)
+	{
+		// Everything has been analysed and generated on the worker already, we just wait for it to catch up.
+		Profiling::Phase phase("Waiting for the pipeline");
+		pipeline.Finish(code);
+		phase.End();
+		Pipeline::g_pipeline = nullptr;
+
+		if (!g_options.snapshotPath.empty() || !g_options.interfacePath.empty())
+		{
+			wprintf(L"WARNING: Pipelined compilation doesn't keep the whole AST around, no snapshot or interface was written.\n");
+		}
+	}
+	else
+	{
+
+#if FUSED_ANALYSIS_PASS == 1
+		// Single pass over the AST: we harvest the symbol declarations, resolve symbol references and check the semantic rules in one go.
+		Profiling::Phase analysisPhase("Analysis");
+		AST::AnalysisPass(g_nodeHead);
+		analysisPhase.AddThroughput(AST::g_disasterHandle.size(), "nodes");
+		analysisPhase.End();
+#else
+		// First pass over AST: we harvest the symbol declarations and resolve symbol references. Page 280.
+		Profiling::Phase harvestPhase("Harvest");
+		AST::BuildSymbolTable(g_nodeHead);
+		harvestPhase.AddThroughput(AST::g_disasterHandle.size(), "nodes");
+		harvestPhase.End();
+
+		// Second pass over the AST: we check to make sure no semantic rules are violated.
+		Profiling::Phase semanticsPhase("Semantics");
+		AST::SemanticsPass(g_nodeHead);
+		semanticsPhase.AddThroughput(AST::g_disasterHandle.size(), "nodes");
+		semanticsPhase.End();
+#endif
+
+		Profiling::Phase foldingPhase("Constant folding");
+		AST::FoldConstants(g_nodeHead);
+		foldingPhase.End();
+
+		Profiling::Phase propagationPhase("Constant propagation");
+		AST::PropagateConstants(g_nodeHead);
+		propagationPhase.End();
+
+		if (!g_options.snapshotPath.empty())
+		{
+			EmitSnapshot(frontEndStart, importedExternFunctions);
+		}
+
+		if (!g_options.interfacePath.empty())
+		{
+			EmitInterface();
+		}
+
+		// Now it's finally time to generate some code.
+		GenerateAllCode(importedExternFunctions, code);
+	}
+
+	FreeAST();
+
+	// At last, we can write out our assembly to a file, unless it has been streamed out already.
+	if (streamOutFile.file == nullptr)
+	{
+		WriteOutputFile(outputPath, code);
+	}
+	else
+	{
+		fclose(streamOutFile.file);
+		streamOutFile.file = nullptr;
+	}
+
+	if (cacheKey != 0)
+	{
+		Profiling::Phase phase("Cache store");
+		cache.Store(cacheKey, outputPath);
+		if (g_options.cacheStats)
+		{
+			cache.PrintStats();
+		}
+	}
+}
+
+// Measures the assembly written to outputPath, whichever way it got there, and checks it against the baseline if given one.
+static void ReportCost(const char* outputPath)
+{
+	std::vector<CostModel::Row> rows;
+	if (!CostModel::MeasureAssembly(outputPath, rows))
+	{
+		wprintf(L"WARNING: Unable to read back the output file for the cost report.\n");
+		return;
+	}
+	CostModel::PrintReport(rows);
+
+	const std::string& baselinePath = g_options.costBaselinePath;
+	if (baselinePath.empty())
+	{
+		return;
+	}
+
+	if (!std::filesystem::exists(baselinePath))
+	{
+		if (CostModel::WriteBaseline(baselinePath, rows))
+		{
+			wprintf(L"COST: No baseline yet, wrote one to %S.\n", baselinePath.c_str());
+		}
+		else
+		{
+			wprintf(L"WARNING: Unable to write the cost baseline.\n");
+		}
+		return;
+	}
+
+	std::vector<CostModel::Row> baselineRows;
+	if (!CostModel::ReadBaseline(baselinePath, baselineRows))
+	{
+		wprintf(L"ERROR: The cost baseline %S is malformed.\n", baselinePath.c_str());
+		Exit(ErrCodes::malformed_cmd_line);
+	}
+
+	const ui64 regressionCount = CostModel::CompareToBaseline(rows, baselineRows);
+	if (regressionCount != 0)
+	{
+		wprintf(L"ERROR: %llu functions or loops cost more than in the baseline.\n", regressionCount);
+		Exit(ErrCodes::cost_regression);
+	}
+	wprintf(L"COST: Nothing costs more than in the baseline.\n");
+}
+
+void CompileTranslationUnit(const char* sourcePath, const char* outputPath, const std::string* sourceBuffer)
+{
+	// The memory report gets its phases from the profiler too.
+	const bool isProfiling = g_options.timeReport || !g_options.tracePath.empty() || g_options.memReport;
+	if (g_options.memReport)
+	{
+		Memory::Start();
+	}
+	if (isProfiling)
+	{
+		Profiling::Start();
+	}
+
+	if (g_options.fromSnapshot)
+	{
+		CompileSnapshot(sourcePath, outputPath);
+	}
+	else
+	{
+		CompileSource(sourcePath, outputPath, sourceBuffer);
+	}
+
+	// Only once every phase has ended, which they all have by the time the compile functions return.
+	if (isProfiling && !Profiling::Finish(g_options.timeReport, g_options.memReport, g_options.tracePath))
+	{
+		wprintf(L"WARNING: Unable to write the trace file.\n");
+	}
+	if (g_options.memReport)
+	{
+		Memory::Finish();
+	}
+
+	if (g_options.passStats)
+	{
+		IR::PrintPassStats();
+		IR::ResetPassStats();
+	}
+
+	if (g_options.costReport)
+	{
+		ReportCost(outputPath);
+	}
+}
+
+void LoadImportedInterfaces(std::vector<std::string>& outExternFunctions)
+{
+	if (g_options.imports.empty())
+	{
+		return;
+	}
+
+	Profiling::Phase phase("Loading imports");
+
+	const auto importStart = std::chrono::steady_clock::now();
+	for (const std::string& import : g_options.imports)
+	{
+		Snapshot::LoadInterface(import.c_str(), g_symTable, outExternFunctions);
+	}
+
+	wprintf(L"INTERFACE: Imported %llu module interfaces in %lld ms.\n", (ui64)g_options.imports.size(), GetMillisecondsSince(importStart));
+}
+
+void ResetCompilerState(void)
+{
+	Pipeline::g_pipeline = nullptr;
+	yy::g_tokenSource = nullptr;
+
+	// After an abort, whatever the parser had built is still around, and not necessarily linked up under g_nodeHead.
+	AST::FreeAllNodes();
+	g_nodeHead = nullptr;
+
+	g_symTable.Clear();
+	ResetCodegenState();
+	IR::ResetPassStats();
+	Profiling::Reset();
+	Memory::Reset();
+}
\ No newline at end of file
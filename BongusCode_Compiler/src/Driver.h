@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Definitions.h"
+
+namespace AST
+{
+	class Node;
+}
+
+// The root of the AST, set by the parser.
+extern AST::Node* g_nodeHead;
+
+// Compiles the translation unit at sourcePath into outputPath, with the options in g_options.
+// If sourceBuffer is given, its contents are compiled instead of reading sourcePath, which is then only used for messages.
+// Errors go through Exit(), like everywhere else in the compiler.
+void CompileTranslationUnit(const char* sourcePath, const char* outputPath, const std::string* sourceBuffer = nullptr);
+
+// Enters the declarations of every module interface given with --import into the symbol table, and appends the names of the
+// external C functions among them to outExternFunctions, which the code header has to declare.
+void LoadImportedInterfaces(std::vector<std::string>& outExternFunctions);
+
+// Frees whatever a compilation has left behind, even one that was aborted halfway, and resets every piece of global state,
+// so the next translation unit compiles exactly as it would in a fresh process.
+void ResetCompilerState(void);
\ No newline at end of file
@@ -5,5 +5,11 @@
 void Exit(ErrCodes errCode)
 {
 	wprintf(L"Compilation aborted with exit code %i (%s)\n", errCode, ErrorsToString[(i32)errCode]);
+
+	if (g_exitThrows || t_exitThrows)
+	{
+		throw CompilationAborted{ errCode };
+	}
+
 	exit((i32)errCode);
 }
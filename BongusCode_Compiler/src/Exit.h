@@ -12,7 +12,9 @@ enum class ErrCodes : i32
 	unreachable_code,
 	internal_compiler_error,
 	attempted_to_call_a_non_function,
-	attempted_to_dereference_pointer_offset_involving_several_pointers
+	attempted_to_dereference_pointer_offset_involving_several_pointers,
+	malformed_snapshot,
+	cost_regression
 };
 
 inline const wchar_t* ErrorsToString[] = {
@@ -25,7 +27,28 @@ inline const wchar_t* ErrorsToString[] = {
 	L"Unreachable code",
 	L"Internal compiler error",
 	L"Attempted to call a non function",
-	L"Attempted to dereference pointer offset involving several pointers"
+	L"Attempted to dereference pointer offset involving several pointers",
+	L"Malformed snapshot",
+	L"Generated code costs more than its baseline"
 };
 
+// Thrown by Exit() instead of ending the process while g_exitThrows or t_exitThrows is set.
+struct CompilationAborted
+{
+	ErrCodes errCode;
+};
+
+// Set on threads that compile on behalf of another one(see the pipeline's worker), so an error unwinds back to the thread
+// that owns the compilation, instead of ending the process from under it.
+inline thread_local bool t_exitThrows = false;
+
+// Set by drivers that run more than one compilation in the same process(see the compile server),
+// so a failed compilation unwinds back to the driver instead of taking the whole process down with it.
+inline bool g_exitThrows = false;
+
+// Where the last syntax error was found, for drivers that report errors by position(see the language server).
+// The line counts from 1, the column from 0, as the lexer counts them.
+inline ui32 g_errorLine = 0;
+inline ui32 g_errorColumn = 0;
+
 [[noreturn]] void Exit(ErrCodes errCode);
\ No newline at end of file
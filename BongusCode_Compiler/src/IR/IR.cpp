@@ -0,0 +1,291 @@
+#include "IR.h"
+#include "../symbol_table/symtable.h"
+#include "../CStrLib.h"
+#include "../Utils.h"
+#include <algorithm>
+#include <unordered_set>
+
+static constexpr const char* s_opcodeNames[] = {
+	"const", "undef", "param", "slot", "load", "store", "add", "sub", "mul", "div", "shl", "shr", "and", "or", "trunc", "call", "phi",
+	"jmp", "br", "ret"
+};
+static_assert(GetArraySize(s_opcodeNames) == (ui64)IR::Opcode::count);
+
+IR::Instruction* IR::Block::GetTerminator(void) const
+{
+	if (instructions.empty() || !instructions.back()->IsTerminator())
+	{
+		return nullptr;
+	}
+	return instructions.back();
+}
+
+std::vector<IR::Block*> IR::Block::GetSuccessors(void) const
+{
+	const Instruction* terminator = GetTerminator();
+	return terminator == nullptr ? std::vector<Block*>() : terminator->blocks;
+}
+
+IR::Function::~Function()
+{
+	for (Block* block : blocks)
+	{
+		delete block;
+	}
+	for (Instruction* value : values)
+	{
+		delete value;
+	}
+}
+
+IR::Block* IR::Function::MakeBlock(const BlockKind kind, const ui32 loopNumber, const ui32 loopDepth)
+{
+	Block* block = new Block();
+	block->id = (ui32)blocks.size();
+	block->kind = kind;
+	block->loopNumber = loopNumber;
+	block->loopDepth = loopDepth;
+	blocks.push_back(block);
+	return block;
+}
+
+IR::Instruction* IR::Function::MakeInstruction(const Opcode op, const PrimitiveType type, const std::vector<Instruction*>& operands)
+{
+	Instruction* instruction = new Instruction();
+	instruction->op = op;
+	instruction->type = type;
+	instruction->id = (ui32)values.size();
+	instruction->operands = operands;
+	values.push_back(instruction);
+	return instruction;
+}
+
+IR::Instruction* IR::Function::Append(Block* block, const Opcode op, const PrimitiveType type, const std::vector<Instruction*>& operands)
+{
+	Instruction* instruction = MakeInstruction(op, type, operands);
+	instruction->block = block;
+	block->instructions.push_back(instruction);
+	return instruction;
+}
+
+IR::Instruction* IR::Function::GetConst(const i64 value, const PrimitiveType type)
+{
+	Instruction*& constant = constants[{ value, type }];
+	if (constant == nullptr)
+	{
+		constant = MakeInstruction(Opcode::Const, type);
+		constant->constant = value;
+	}
+	return constant;
+}
+
+IR::Instruction* IR::Function::GetUndef(const PrimitiveType type)
+{
+	Instruction*& undef = undefs[type];
+	if (undef == nullptr)
+	{
+		undef = MakeInstruction(Opcode::Undef, type);
+	}
+	return undef;
+}
+
+void IR::Function::ReplaceAllUses(Instruction* from, Instruction* to)
+{
+	for (Instruction* instruction : values)
+	{
+		std::replace(instruction->operands.begin(), instruction->operands.end(), from, to);
+	}
+}
+
+void IR::Function::Compact(void)
+{
+	std::unordered_set<Instruction*> isKept;
+	for (Block* block : blocks)
+	{
+		isKept.insert(block->instructions.begin(), block->instructions.end());
+	}
+	for (Block* block : blocks)
+	{
+		for (Instruction* instruction : block->instructions)
+		{
+			for (Instruction* operand : instruction->operands)
+			{
+				if (operand->block == nullptr)
+				{
+					isKept.insert(operand);
+				}
+			}
+		}
+	}
+
+	// The constants first, then the instructions in the order they're laid out in.
+	std::vector<Instruction*> keptValues;
+	for (Instruction* value : values)
+	{
+		if (value->block == nullptr && isKept.count(value) != 0)
+		{
+			keptValues.push_back(value);
+		}
+		else if (isKept.count(value) == 0)
+		{
+			if (value->op == Opcode::Const) { constants.erase({ value->constant, value->type }); }
+			else if (value->op == Opcode::Undef) { undefs.erase(value->type); }
+			delete value;
+		}
+	}
+	for (Block* block : blocks)
+	{
+		keptValues.insert(keptValues.end(), block->instructions.begin(), block->instructions.end());
+	}
+
+	values = std::move(keptValues);
+	for (ui32 i = 0; i < values.size(); i++)
+	{
+		values[i]->id = i;
+	}
+	for (ui32 i = 0; i < blocks.size(); i++)
+	{
+		blocks[i]->id = i;
+	}
+}
+
+ui32 IR::GetTypeSize(const PrimitiveType type)
+{
+	switch (type)
+	{
+	case PrimitiveType::ui8:
+	case PrimitiveType::i8:
+		return 1;
+	case PrimitiveType::ui16:
+	case PrimitiveType::i16:
+		return 2;
+	case PrimitiveType::ui32:
+	case PrimitiveType::i32:
+		return 4;
+	default:
+		return 8;
+	}
+}
+
+const char* IR::GetOpcodeName(const Opcode op)
+{
+	return s_opcodeNames[(ui64)op];
+}
+
+std::string IR::GetBlockName(const Block* block)
+{
+	const std::string loop = "loop" + std::to_string(block->loopNumber);
+	switch (block->kind)
+	{
+	case BlockKind::loopBody: return loop + ".body";
+	case BlockKind::loopHead: return loop + ".head";
+	case BlockKind::loopExit: return loop + ".exit";
+	default: return block->id == 0 ? std::string("entry") : "b" + std::to_string(block->id);
+	}
+}
+
+std::string IR::GetBlockLabel(const Block* block, const std::string& functionName)
+{
+	// The same labels the code generator gives its loops, so the cost model finds them.
+	const std::string suffix = std::to_string(block->loopNumber) + "@" + functionName;
+	switch (block->kind)
+	{
+	case BlockKind::loopBody: return "LB" + suffix;
+	case BlockKind::loopHead: return "LH" + suffix;
+	case BlockKind::loopExit: return "LE" + suffix;
+	default: return "L" + std::to_string(block->id) + "@" + functionName;
+	}
+}
+
+static std::string PrintOperand(const IR::Instruction* operand)
+{
+	switch (operand->op)
+	{
+	case IR::Opcode::Const: return std::to_string(operand->constant);
+	case IR::Opcode::Undef: return "undef";
+	default: return "%" + std::to_string(operand->id);
+	}
+}
+
+static std::string PrintInstruction(const IR::Instruction* instruction)
+{
+	std::string line = "IR:   ";
+	if (instruction->HasValue())
+	{
+		line += "%" + std::to_string(instruction->id) + " = ";
+	}
+	line += IR::GetOpcodeName(instruction->op);
+
+	const PrimitiveType shownType = instruction->memoryType != PrimitiveType::invalid ? instruction->memoryType : instruction->type;
+	if (shownType != PrimitiveType::nihil)
+	{
+		line += std::string(" ") + PrimitiveTypeReflectionNarrow[(ui16)shownType];
+	}
+
+	switch (instruction->op)
+	{
+	case IR::Opcode::Param:
+	{
+		return line + " " + std::to_string(instruction->constant) + " ; " + MangleName(instruction->symbol->name.c_str());
+	}
+	case IR::Opcode::Slot:
+	{
+		return line + ", " + std::to_string(instruction->constant) + " bytes ; " + MangleName(instruction->symbol->name.c_str());
+	}
+	case IR::Opcode::Call:
+	{
+		line += " " + instruction->symbol->functionName + "(";
+		for (ui64 i = 0; i < instruction->operands.size(); i++)
+		{
+			line += (i == 0 ? "" : ", ") + PrintOperand(instruction->operands[i]);
+		}
+		return line + ")";
+	}
+	case IR::Opcode::Phi:
+	{
+		for (ui64 i = 0; i < instruction->operands.size(); i++)
+		{
+			line += std::string(i == 0 ? " " : ", ") + "[" + PrintOperand(instruction->operands[i]) + ", " + IR::GetBlockName(instruction->blocks[i]) + "]";
+		}
+		return line;
+	}
+	default:
+	{
+		for (ui64 i = 0; i < instruction->operands.size(); i++)
+		{
+			line += (i == 0 ? " " : ", ") + PrintOperand(instruction->operands[i]);
+		}
+		for (ui64 i = 0; i < instruction->blocks.size(); i++)
+		{
+			line += (i == 0 && instruction->operands.empty() ? " " : ", ") + IR::GetBlockName(instruction->blocks[i]);
+		}
+		return line;
+	}
+	}
+}
+
+std::string IR::PrintFunction(const Function& function)
+{
+	std::string text = "IR: function " + function.name + " -> " + PrimitiveTypeReflectionNarrow[(ui16)function.retType] + "\n";
+
+	for (const Block* block : function.blocks)
+	{
+		text += "IR: " + GetBlockName(block) + ":";
+		if (!block->predecessors.empty())
+		{
+			text += " ; preds:";
+			for (ui64 i = 0; i < block->predecessors.size(); i++)
+			{
+				text += (i == 0 ? " " : ", ") + GetBlockName(block->predecessors[i]);
+			}
+		}
+		text += "\n";
+
+		for (const Instruction* instruction : block->instructions)
+		{
+			text += PrintInstruction(instruction) + "\n";
+		}
+	}
+
+	return text;
+}
\ No newline at end of file
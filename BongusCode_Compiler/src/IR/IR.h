@@ -0,0 +1,185 @@
+#pragma once
+#include "../Definitions.h"
+#include "../BongusTable.h"
+#include <string>
+#include <vector>
+#include <map>
+
+struct SymTabEntry;
+
+/*
+	The mid-level IR, a typed SSA form of a function's body that sits between the AST and the assembly, see IR_Builder.h for
+	how it's built from the AST and code_generator/IRLowering.h for how it's turned into assembly.
+
+	A function is a list of basic blocks, the first of which is its entry. Every block ends in exactly one terminator(jump,
+	branch or return), and starts with its phis, one operand per predecessor, in the order of the block's predecessors.
+	Every value is an instruction, defined once. Constants and undefined values are the exception, they belong to the function
+	rather than to a block, and are shared by every instruction using them.
+
+	Values are 64 bits wide. Their type is the width of what they hold: a value of a type narrower than 64 bits holds one of
+	that type's values zero extended, the way loads leave them. Arithmetic is done on all 64 bits, so its results are ui64.
+	Trunc narrows a value to its type. A pointer is 64 bits.
+
+	Locals whose address is taken live in a stack slot(see AST::GetAddressTakenLocals), defined in the entry block, and are
+	read and written with loads and stores like any other memory. Every other local and parameter is an SSA value.
+*/
+namespace IR
+{
+	enum class Opcode : ui8
+	{
+		// A constant, in constant.
+		Const,
+
+		// A value that's never been assigned, like a local read before it's written.
+		Undef,
+
+		// The parameter numbered constant, as passed in its register. Only in the entry block.
+		Param,
+
+		// The address of the stack slot of symbol, constant bytes large. Only in the entry block.
+		Slot,
+
+		// Reads a value of memoryType from the address in operand 0.
+		Load,
+
+		// Writes operand 1, truncated to memoryType, to the address in operand 0.
+		Store,
+
+		// Arithmetic on both operands, all 64 bits of them. Div is unsigned, the shifts only look at the low 6 bits of the amount
+		// and Shr is a logical shift.
+		Add,
+		Sub,
+		Mul,
+		Div,
+		Shl,
+		Shr,
+		And,
+		Or,
+
+		// Operand 0 truncated to the instruction's type.
+		Trunc,
+
+		// Calls symbol with the operands as arguments. The result is whatever the callee left in RAX, all 64 bits of it.
+		Call,
+
+		// The operand from the predecessor in the same place of blocks.
+		Phi,
+
+		// Terminators. A branch goes to blocks[0] if operand 0 is less than operand 1, compared as signed 64 bit values, and to
+		// blocks[1] otherwise. A return has the function's result as its operand, if there's one.
+		Jump,
+		Branch,
+		Return,
+
+		count
+	};
+
+	struct Block;
+
+	struct Instruction
+	{
+		Opcode op = Opcode::Undef;
+
+		// The type of the value it defines, nihil for instructions without one.
+		PrimitiveType type = PrimitiveType::nihil;
+
+		// The type loads read and stores write, and the type of a slot's local.
+		PrimitiveType memoryType = PrimitiveType::invalid;
+
+		// Numbers the values in the order they're made, for the dump and for the passes' tables.
+		ui32 id = 0;
+
+		std::vector<Instruction*> operands;
+
+		// Phis' incoming blocks, and jumps' and branches' targets.
+		std::vector<Block*> blocks;
+
+		i64 constant = 0;
+		SymTabEntry* symbol = nullptr;
+
+		// The block it's in, nullptr for constants and undefined values.
+		Block* block = nullptr;
+
+		bool IsTerminator(void) const { return op == Opcode::Jump || op == Opcode::Branch || op == Opcode::Return; }
+		bool HasValue(void) const { return type != PrimitiveType::nihil; }
+	};
+
+	// Loop blocks are named after the For loop they're part of, its body, its head(the increment and the test) and its exit.
+	enum class BlockKind : ui8
+	{
+		plain,
+		loopBody,
+		loopHead,
+		loopExit
+	};
+
+	struct Block
+	{
+		ui32 id = 0;
+		BlockKind kind = BlockKind::plain;
+
+		// The number of the For loop it's part of, numbered per function in the order the loops start, and how many loops it's in.
+		ui32 loopNumber = 0;
+		ui32 loopDepth = 0;
+
+		std::vector<Instruction*> instructions;
+		std::vector<Block*> predecessors;
+
+		// nullptr while the block is still being built.
+		Instruction* GetTerminator(void) const;
+		std::vector<Block*> GetSuccessors(void) const;
+	};
+
+	struct Function
+	{
+		// As it's called in the assembly.
+		std::string name;
+		PrimitiveType retType = PrimitiveType::nihil;
+
+		// In the order they're laid out in, the entry first.
+		std::vector<Block*> blocks;
+
+		// Every instruction made for the function, constants included, in the order they were made. Owned by the function.
+		std::vector<Instruction*> values;
+
+		// The constants and undefined values handed out so far, by value and type.
+		std::map<std::pair<i64, PrimitiveType>, Instruction*> constants;
+		std::map<PrimitiveType, Instruction*> undefs;
+
+		Function() = default;
+		Function(const Function&) = delete;
+		Function& operator=(const Function&) = delete;
+		~Function();
+
+		Block* MakeBlock(const BlockKind kind = BlockKind::plain, const ui32 loopNumber = 0, const ui32 loopDepth = 0);
+
+		// Makes an instruction that isn't in any block yet.
+		Instruction* MakeInstruction(const Opcode op, const PrimitiveType type, const std::vector<Instruction*>& operands = {});
+
+		// Makes an instruction at the end of block.
+		Instruction* Append(Block* block, const Opcode op, const PrimitiveType type, const std::vector<Instruction*>& operands = {});
+
+		// The same constant or undefined value of a type is always the same instruction.
+		Instruction* GetConst(const i64 value, const PrimitiveType type = PrimitiveType::i64);
+		Instruction* GetUndef(const PrimitiveType type);
+
+		// Rewrites every use of from into a use of to.
+		void ReplaceAllUses(Instruction* from, Instruction* to);
+
+		// Drops the instructions that were taken out of their blocks and aren't used anymore, and renumbers the values in the
+		// order they're laid out in.
+		void Compact(void);
+	};
+
+	// The number of bytes a value of the type takes up, 8 for pointers.
+	ui32 GetTypeSize(const PrimitiveType type);
+
+	const char* GetOpcodeName(const Opcode op);
+
+	// The block's name in the dump and its label in the assembly, e.g. "loop0.head" and "LH0@function".
+	std::string GetBlockName(const Block* block);
+	std::string GetBlockLabel(const Block* block, const std::string& functionName);
+
+	// --emit-ir: The function in text, a line per instruction, every line prefixed "IR: ".
+	std::string PrintFunction(const Function& function);
+}
\ No newline at end of file
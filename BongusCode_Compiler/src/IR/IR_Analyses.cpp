@@ -0,0 +1,180 @@
+#include "IR_Analyses.h"
+#include <algorithm>
+#include <iterator>
+
+bool IR::DominatorTree::Dominates(const Block* dominator, const Block* block) const
+{
+	const auto dominatorFound = indices.find(dominator);
+	const auto blockFound = indices.find(block);
+	if (dominatorFound == indices.end() || blockFound == indices.end())
+	{
+		return false;
+	}
+
+	// A block's dominators all come before it in reverse postorder.
+	ui32 i = blockFound->second;
+	while (i > dominatorFound->second)
+	{
+		i = immediateDominators[i];
+	}
+	return i == dominatorFound->second;
+}
+
+void IR::ComputeDominatorTree(const Function& function, DominatorTree& outTree)
+{
+	outTree = DominatorTree();
+
+	std::vector<Block*> postorder;
+	std::unordered_set<const Block*> isVisited{ function.blocks[0] };
+	std::vector<std::pair<Block*, ui64>> stack{ { function.blocks[0], 0 } };
+	while (!stack.empty())
+	{
+		auto& [block, nextSuccessor] = stack.back();
+		const std::vector<Block*> successors = block->GetSuccessors();
+		if (nextSuccessor < successors.size())
+		{
+			Block* successor = successors[nextSuccessor++];
+			if (isVisited.insert(successor).second)
+			{
+				stack.push_back({ successor, 0 });
+			}
+			continue;
+		}
+		postorder.push_back(block);
+		stack.pop_back();
+	}
+
+	std::vector<Block*>& order = outTree.order;
+	order.assign(postorder.rbegin(), postorder.rend());
+	for (ui32 i = 0; i < order.size(); i++)
+	{
+		outTree.indices[order[i]] = i;
+	}
+
+	constexpr ui32 undefined = ~0u;
+	std::vector<ui32>& dominators = outTree.immediateDominators;
+	dominators.assign(order.size(), undefined);
+	dominators[0] = 0;
+
+	for (bool isChanged = true; isChanged;)
+	{
+		isChanged = false;
+		for (ui32 i = 1; i < order.size(); i++)
+		{
+			ui32 dominator = undefined;
+			for (const Block* predecessor : order[i]->predecessors)
+			{
+				const auto found = outTree.indices.find(predecessor);
+				if (found == outTree.indices.end() || dominators[found->second] == undefined)
+				{
+					continue;
+				}
+
+				ui32 other = found->second;
+				if (dominator == undefined)
+				{
+					dominator = other;
+					continue;
+				}
+				while (dominator != other)
+				{
+					while (dominator > other) { dominator = dominators[dominator]; }
+					while (other > dominator) { other = dominators[other]; }
+				}
+			}
+
+			if (dominators[i] != dominator)
+			{
+				dominators[i] = dominator;
+				isChanged = true;
+			}
+		}
+	}
+
+	outTree.children.resize(order.size());
+	for (ui32 i = 1; i < order.size(); i++)
+	{
+		outTree.children[dominators[i]].push_back(order[i]);
+	}
+}
+
+void IR::ComputeLoopInfo(const DominatorTree& dominators, LoopInfo& outInfo)
+{
+	outInfo = LoopInfo();
+
+	// Every edge to a block that dominates where it comes from is a back edge, the loops with the same header are one.
+	std::unordered_map<const Block*, ui64> loopIndices;
+	for (Block* block : dominators.order)
+	{
+		for (Block* successor : block->GetSuccessors())
+		{
+			if (!dominators.Dominates(successor, block))
+			{
+				continue;
+			}
+
+			const auto [found, isNew] = loopIndices.insert({ successor, outInfo.loops.size() });
+			if (isNew)
+			{
+				outInfo.loops.emplace_back();
+				outInfo.loops.back().header = successor;
+				outInfo.loops.back().blockSet.insert(successor);
+			}
+			Loop& loop = outInfo.loops[found->second];
+
+			// Walks back from the edge to the header.
+			std::vector<Block*> worklist;
+			if (loop.blockSet.insert(block).second)
+			{
+				worklist.push_back(block);
+			}
+			while (!worklist.empty())
+			{
+				Block* current = worklist.back();
+				worklist.pop_back();
+				for (Block* predecessor : current->predecessors)
+				{
+					if (dominators.IsReachable(predecessor) && loop.blockSet.insert(predecessor).second)
+					{
+						worklist.push_back(predecessor);
+					}
+				}
+			}
+		}
+	}
+
+	for (Loop& loop : outInfo.loops)
+	{
+		// The header dominates the rest, so it comes first.
+		std::copy_if(dominators.order.begin(), dominators.order.end(), std::back_inserter(loop.blocks), [&](const Block* block) {
+			return loop.Contains(block);
+		});
+
+		Block* outside = nullptr;
+		ui64 outsideCount = 0;
+		for (Block* predecessor : loop.header->predecessors)
+		{
+			if (!loop.Contains(predecessor))
+			{
+				outside = predecessor;
+				outsideCount++;
+			}
+		}
+		if (outsideCount == 1 && outside->GetSuccessors().size() == 1)
+		{
+			loop.preheader = outside;
+		}
+	}
+
+	// A loop inside another has fewer blocks than it.
+	std::stable_sort(outInfo.loops.begin(), outInfo.loops.end(), [](const Loop& a, const Loop& b) {
+		return a.blocks.size() < b.blocks.size();
+	});
+	for (Loop& loop : outInfo.loops)
+	{
+		for (const Loop& other : outInfo.loops)
+		{
+			loop.depth += other.Contains(loop.header) ? 1 : 0;
+		}
+	}
+}
\ No newline at end of file
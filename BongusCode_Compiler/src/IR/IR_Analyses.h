@@ -0,0 +1,60 @@
+#pragma once
+#include "IR.h"
+#include <unordered_map>
+#include <unordered_set>
+
+/*
+	The analyses of a function's control flow the verifier and the passes share, see IR_PassManager.h for how the passes get
+	them and when they're computed again.
+
+	Only the blocks reachable from the entry are looked at.
+*/
+namespace IR
+{
+	// Cooper, Harvey and Kennedy's immediate dominators(A Simple, Fast Dominance Algorithm), over the blocks in reverse postorder.
+	struct DominatorTree
+	{
+		// The blocks in reverse postorder, the entry first, and every block's place in it.
+		std::vector<Block*> order;
+		std::unordered_map<const Block*, ui32> indices;
+
+		// The place of every block's immediate dominator, by the block's place. The entry is its own.
+		std::vector<ui32> immediateDominators;
+
+		// The blocks every block immediately dominates, by its place, in reverse postorder.
+		std::vector<std::vector<Block*>> children;
+
+		bool IsReachable(const Block* block) const { return indices.count(block) != 0; }
+
+		// Every block dominates itself.
+		bool Dominates(const Block* dominator, const Block* block) const;
+	};
+
+	// A natural loop: the blocks that can get to a back edge to its header without going through the header, which dominates
+	// all of them.
+	struct Loop
+	{
+		Block* header = nullptr;
+
+		// The only block outside the loop that goes to the header, and nowhere else, nullptr if there isn't one.
+		Block* preheader = nullptr;
+
+		// The header first, then the rest in reverse postorder.
+		std::vector<Block*> blocks;
+		std::unordered_set<const Block*> blockSet;
+
+		// 1 for loops no other loop is around.
+		ui32 depth = 0;
+
+		bool Contains(const Block* block) const { return blockSet.count(block) != 0; }
+	};
+
+	struct LoopInfo
+	{
+		// Innermost loops first, so a loop comes before every loop around it.
+		std::vector<Loop> loops;
+	};
+
+	void ComputeDominatorTree(const Function& function, DominatorTree& outTree);
+	void ComputeLoopInfo(const DominatorTree& dominators, LoopInfo& outInfo);
+}
\ No newline at end of file
@@ -0,0 +1,501 @@
+#include "IR_Builder.h"
+#include "../AST/ASTNode.h"
+#include "../AST/ASTAPI.h"
+#include "../symbol_table/symtable.h"
+#include "../Exit.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+// Arguments are passed in RCX, RDX, R8 and R9, there's nowhere to pass any more.
+static constexpr ui32 s_maxArguments = 4;
+
+struct Builder
+{
+	explicit Builder(IR::Function& function) : function(function) {}
+
+	IR::Function& function;
+
+	// Where the statements being built go. nullptr after a return, until the statements that can't be reached are over.
+	IR::Block* current = nullptr;
+
+	ui32 loopsStarted = 0;
+	ui32 loopDepth = 0;
+
+	// The slots of the locals whose address is taken.
+	std::unordered_map<SymTabEntry*, IR::Instruction*> slots;
+
+	// The value every local was last given in every block.
+	std::unordered_map<IR::Block*, std::unordered_map<SymTabEntry*, IR::Instruction*>> currentDefs;
+
+	// The phis placed in blocks whose predecessors aren't all known yet, completed when the blocks are sealed.
+	std::unordered_map<IR::Block*, std::vector<std::pair<SymTabEntry*, IR::Instruction*>>> incompletePhis;
+	std::unordered_set<IR::Block*> sealed;
+
+	// What the phis that were removed were replaced by.
+	std::unordered_map<IR::Instruction*, IR::Instruction*> replacedPhis;
+};
+
+static IR::Instruction* ReadVariable(Builder& b, SymTabEntry* variable, IR::Block* block);
+
+static void AddEdge(IR::Block* from, IR::Block* to)
+{
+	to->predecessors.push_back(from);
+}
+
+// Phis go before everything else in their block.
+static IR::Instruction* MakePhi(Builder& b, IR::Block* block, const PrimitiveType type)
+{
+	IR::Instruction* phi = b.function.MakeInstruction(IR::Opcode::Phi, type);
+	phi->block = block;
+
+	const auto firstNonPhi = std::find_if(block->instructions.begin(), block->instructions.end(),
+		[](IR::Instruction* instruction) { return instruction->op != IR::Opcode::Phi; });
+	block->instructions.insert(firstNonPhi, phi);
+	return phi;
+}
+
+static IR::Instruction* TryRemoveTrivialPhi(Builder& b, IR::Instruction* phi)
+{
+	IR::Instruction* same = nullptr;
+	for (IR::Instruction* operand : phi->operands)
+	{
+		if (operand == same || operand == phi)
+		{
+			continue;
+		}
+		if (same != nullptr)
+		{
+			// It merges at least two values, it stays.
+			return phi;
+		}
+		same = operand;
+	}
+
+	if (same == nullptr)
+	{
+		// Only ever reached from itself, or not at all.
+		same = b.function.GetUndef(phi->type);
+	}
+
+	std::vector<IR::Instruction*> phiUsers;
+	for (IR::Instruction* value : b.function.values)
+	{
+		if (value != phi && value->op == IR::Opcode::Phi && value->block != nullptr &&
+			std::find(value->operands.begin(), value->operands.end(), phi) != value->operands.end())
+		{
+			phiUsers.push_back(value);
+		}
+	}
+
+	phi->operands.clear();
+	b.function.ReplaceAllUses(phi, same);
+	for (auto& [block, defs] : b.currentDefs)
+	{
+		for (auto& [variable, value] : defs)
+		{
+			if (value == phi) { value = same; }
+		}
+	}
+
+	std::vector<IR::Instruction*>& instructions = phi->block->instructions;
+	instructions.erase(std::find(instructions.begin(), instructions.end(), phi));
+	phi->block = nullptr;
+	b.replacedPhis[phi] = same;
+
+	// Phis that used it may have become trivial with it gone, same among them.
+	for (IR::Instruction* user : phiUsers)
+	{
+		if (user->block != nullptr)
+		{
+			TryRemoveTrivialPhi(b, user);
+		}
+	}
+
+	while (same->op == IR::Opcode::Phi && same->block == nullptr)
+	{
+		same = b.replacedPhis.at(same);
+	}
+	return same;
+}
+
+static IR::Instruction* AddPhiOperands(Builder& b, SymTabEntry* variable, IR::Instruction* phi)
+{
+	for (IR::Block* predecessor : phi->block->predecessors)
+	{
+		phi->operands.push_back(ReadVariable(b, variable, predecessor));
+		phi->blocks.push_back(predecessor);
+	}
+	return TryRemoveTrivialPhi(b, phi);
+}
+
+static void WriteVariable(Builder& b, SymTabEntry* variable, IR::Block* block, IR::Instruction* value)
+{
+	b.currentDefs[block][variable] = value;
+}
+
+static IR::Instruction* ReadVariable(Builder& b, SymTabEntry* variable, IR::Block* block)
+{
+	const auto defs = b.currentDefs.find(block);
+	if (defs != b.currentDefs.end())
+	{
+		const auto def = defs->second.find(variable);
+		if (def != defs->second.end())
+		{
+			return def->second;
+		}
+	}
+
+	IR::Instruction* value = nullptr;
+	if (b.sealed.count(block) == 0)
+	{
+		value = MakePhi(b, block, variable->asVar.type);
+		b.incompletePhis[block].push_back({ variable, value });
+	}
+	else if (block->predecessors.empty())
+	{
+		// Read before it's ever written.
+		value = b.function.GetUndef(variable->asVar.type);
+	}
+	else if (block->predecessors.size() == 1)
+	{
+		value = ReadVariable(b, variable, block->predecessors[0]);
+	}
+	else
+	{
+		// Written first, so the lookups through a loop end at the phi rather than going round forever.
+		value = MakePhi(b, block, variable->asVar.type);
+		WriteVariable(b, variable, block, value);
+		value = AddPhiOperands(b, variable, value);
+	}
+
+	WriteVariable(b, variable, block, value);
+	return value;
+}
+
+static void SealBlock(Builder& b, IR::Block* block)
+{
+	const auto incomplete = b.incompletePhis.find(block);
+	if (incomplete != b.incompletePhis.end())
+	{
+		const std::vector<std::pair<SymTabEntry*, IR::Instruction*>> phis = std::move(incomplete->second);
+		b.incompletePhis.erase(incomplete);
+		for (const auto& [variable, phi] : phis)
+		{
+			AddPhiOperands(b, variable, phi);
+		}
+	}
+	b.sealed.insert(block);
+}
+
+static IR::Instruction* Append(Builder& b, const IR::Opcode op, const PrimitiveType type, const std::vector<IR::Instruction*>& operands = {})
+{
+	return b.function.Append(b.current, op, type, operands);
+}
+
+static void Jump(Builder& b, IR::Block* target)
+{
+	Append(b, IR::Opcode::Jump, PrimitiveType::nihil)->blocks.push_back(target);
+	AddEdge(b.current, target);
+}
+
+// The value truncated to the type, if it's any wider.
+static IR::Instruction* Narrow(Builder& b, IR::Instruction* value, const PrimitiveType type)
+{
+	const ui32 size = IR::GetTypeSize(type);
+	if (IR::GetTypeSize(value->type) <= size)
+	{
+		return value;
+	}
+
+	if (value->op == IR::Opcode::Const)
+	{
+		return b.function.GetConst(size == 8 ? value->constant : (i64)((ui64)value->constant & ((1ull << (8 * size)) - 1)), type);
+	}
+	return Append(b, IR::Opcode::Trunc, type, { value });
+}
+
+static IR::Instruction* BuildExpression(Builder& b, AST::Node* node);
+
+// Operations are computed 64 bits wide and calls may leave anything in the upper bits of RAX, so as an operand, their value is
+// truncated to their type.
+static IR::Instruction* BuildOperand(Builder& b, AST::Node* node)
+{
+	IR::Instruction* value = BuildExpression(b, node);
+
+	const Node_k kind = node->GetNodeKind();
+	if (kind == Node_k::OpNode || kind == Node_k::FunctionCallNode)
+	{
+		value = Narrow(b, value, AST::GetExpressionType(node));
+	}
+	return value;
+}
+
+static IR::Instruction* BuildCall(Builder& b, AST::FunctionCallNode* node)
+{
+	std::vector<IR::Instruction*> arguments;
+	for (AST::Node* arg = node->GetArgs(); arg != nullptr; arg = arg->GetRightSibling())
+	{
+		if (arguments.size() == s_maxArguments)
+		{
+			wprintf(L"WARNING: Ran out of registers while trying to call function %s.\n", node->GetName().c_str());
+			break;
+		}
+		arguments.push_back(BuildOperand(b, arg));
+	}
+
+	IR::Instruction* call = Append(b, IR::Opcode::Call, PrimitiveType::ui64, arguments);
+	call->symbol = node->GetSymTabEntry();
+	return call;
+}
+
+static IR::Instruction* BuildExpression(Builder& b, AST::Node* node)
+{
+	switch (node->GetNodeKind())
+	{
+	case Node_k::IntNode:
+	{
+		return b.function.GetConst((i64)((AST::IntNode*)node)->Get());
+	}
+	case Node_k::SymNode:
+	{
+		SymTabEntry* entry = ((AST::SymNode*)node)->GetSymTabEntry();
+
+		const auto slot = b.slots.find(entry);
+		if (slot != b.slots.end())
+		{
+			IR::Instruction* load = Append(b, IR::Opcode::Load, entry->asVar.type, { slot->second });
+			load->memoryType = entry->asVar.type;
+			return load;
+		}
+		return ReadVariable(b, entry, b.current);
+	}
+	case Node_k::AddrOfNode:
+	{
+		return b.slots.at(((AST::AddrOfNode*)node)->GetSymTabEntry());
+	}
+	case Node_k::OpNode:
+	{
+		static const IR::Opcode s_opcodes[] = {
+			IR::Opcode::count, IR::Opcode::Add, IR::Opcode::Sub, IR::Opcode::Mul, IR::Opcode::Div, IR::Opcode::Shl, IR::Opcode::Shr,
+			IR::Opcode::And, IR::Opcode::Or
+		};
+
+		AST::OpNode* asOpNode = (AST::OpNode*)node;
+		IR::Instruction* lhs = BuildOperand(b, asOpNode->GetLHS());
+		IR::Instruction* rhs = BuildOperand(b, asOpNode->GetRHS());
+		return Append(b, s_opcodes[(ui16)asOpNode->GetOp()], PrimitiveType::ui64, { lhs, rhs });
+	}
+	case Node_k::FunctionCallNode:
+	{
+		return BuildCall(b, (AST::FunctionCallNode*)node);
+	}
+	case Node_k::DerefNode:
+	{
+		const PrimitiveType pointeeType = AST::GetPointeeTypeFromDerefNode(node);
+		IR::Instruction* pointer = BuildExpression(b, ((AST::DerefNode*)node)->GetExpr());
+
+		IR::Instruction* load = Append(b, IR::Opcode::Load, pointeeType, { pointer });
+		load->memoryType = pointeeType;
+		return load;
+	}
+	default:
+	{
+		wprintf(L"ERROR: Node of kind %hu isn't an expression in " __FUNCTION__ "\n", node->GetNodeKind());
+		Exit(ErrCodes::internal_compiler_error);
+	}
+	}
+}
+
+static void BuildAssignment(Builder& b, AST::AssNode* node)
+{
+	AST::Node* var = node->GetVar();
+
+	if (var->GetNodeKind() == Node_k::DerefNode)
+	{
+		// The value first, then the address it goes to.
+		const PrimitiveType pointeeType = AST::GetPointeeTypeFromDerefNode(var);
+		IR::Instruction* value = BuildOperand(b, node->GetExpr());
+		IR::Instruction* pointer = BuildExpression(b, ((AST::DerefNode*)var)->GetExpr());
+
+		Append(b, IR::Opcode::Store, PrimitiveType::nihil, { pointer, value })->memoryType = pointeeType;
+		return;
+	}
+
+	SymTabEntry* entry = ((AST::SymNode*)var)->GetSymTabEntry();
+	IR::Instruction* value = BuildExpression(b, node->GetExpr());
+
+	const auto slot = b.slots.find(entry);
+	if (slot != b.slots.end())
+	{
+		Append(b, IR::Opcode::Store, PrimitiveType::nihil, { slot->second, value })->memoryType = entry->asVar.type;
+		return;
+	}
+	WriteVariable(b, entry, b.current, Narrow(b, value, entry->asVar.type));
+}
+
+static void BuildStatements(Builder& b, AST::Node* scope);
+
+static void BuildForLoop(Builder& b, AST::ForLoopNode* node)
+{
+	AST::ForLoopHeadNode* head = (AST::ForLoopHeadNode*)node->GetHead();
+	IR::Instruction* lowerBound = BuildExpression(b, head->GetLowerBound());
+
+	const ui32 loopNumber = b.loopsStarted++;
+	b.loopDepth++;
+
+	IR::Block* preheader = b.current;
+	IR::Block* body = b.function.MakeBlock(IR::BlockKind::loopBody, loopNumber, b.loopDepth);
+	Jump(b, body);
+
+	// Not sealed until the head, which jumps back to it, is there.
+	b.current = body;
+	BuildStatements(b, node->GetBody());
+
+	if (b.current == nullptr)
+	{
+		// The body always returns, the loop never goes round.
+		SealBlock(b, body);
+		b.loopDepth--;
+		return;
+	}
+
+	IR::Block* loopHead = b.function.MakeBlock(IR::BlockKind::loopHead, loopNumber, b.loopDepth);
+	Jump(b, loopHead);
+	SealBlock(b, loopHead);
+	b.current = loopHead;
+
+	IR::Instruction* iterationVariable = MakePhi(b, body, PrimitiveType::ui64);
+	IR::Instruction* incremented = Append(b, IR::Opcode::Add, PrimitiveType::ui64, { iterationVariable, b.function.GetConst(1) });
+	IR::Instruction* upperBound = BuildExpression(b, head->GetUpperBound());
+
+	IR::Block* exit = b.function.MakeBlock(IR::BlockKind::loopExit, loopNumber, b.loopDepth - 1);
+	IR::Instruction* branch = Append(b, IR::Opcode::Branch, PrimitiveType::nihil, { incremented, upperBound });
+	branch->blocks = { body, exit };
+	AddEdge(loopHead, body);
+	AddEdge(loopHead, exit);
+
+	iterationVariable->operands = { lowerBound, incremented };
+	iterationVariable->blocks = { preheader, loopHead };
+
+	SealBlock(b, body);
+	SealBlock(b, exit);
+	b.current = exit;
+	b.loopDepth--;
+}
+
+static void BuildStatements(Builder& b, AST::Node* scope)
+{
+	for (AST::Node* statement : scope->GetChildren())
+	{
+		if (b.current == nullptr)
+		{
+			// After a return.
+			return;
+		}
+
+		switch (statement->GetNodeKind())
+		{
+		case Node_k::Node:
+		case Node_k::DeclNode:
+		{
+			break;
+		}
+		case Node_k::AssNode:
+		{
+			BuildAssignment(b, (AST::AssNode*)statement);
+			break;
+		}
+		case Node_k::ReturnNode:
+		{
+			IR::Instruction* value = BuildExpression(b, ((AST::ReturnNode*)statement)->GetRetExpr());
+			Append(b, IR::Opcode::Return, PrimitiveType::nihil, { value });
+			b.current = nullptr;
+			break;
+		}
+		case Node_k::ForLoopNode:
+		{
+			BuildForLoop(b, (AST::ForLoopNode*)statement);
+			break;
+		}
+		default:
+		{
+			// An expression on its own, computed for its calls.
+			BuildExpression(b, statement);
+			break;
+		}
+		}
+	}
+}
+
+void IR::BuildFunction(AST::FunctionNode* functionNode, Function& outFunction)
+{
+	Builder b(outFunction);
+
+	outFunction.name = functionNode->GetName() == std::wstring(WideMainFunctionName) ? std::string("main") : functionNode->GetSymTabEntry()->functionName;
+	outFunction.retType = functionNode->GetRetType();
+
+	IR::Block* entry = outFunction.MakeBlock();
+	SealBlock(b, entry);
+	b.current = entry;
+
+	// The slots are laid out in the order the locals are declared in, like the code generator lays out its locals' section,
+	// as a pointer to one of them may well be used to get to its neighbours.
+	const std::unordered_set<SymTabEntry*> addressTaken = AST::GetAddressTakenLocals(functionNode);
+	for (AST::Node* n : AST::GetAllChildNodesOfType(functionNode, Node_k::DeclNode))
+	{
+		AST::DeclNode* asDeclNode = (AST::DeclNode*)n;
+		SymTabEntry* entry = asDeclNode->GetSymTabEntry();
+		if (addressTaken.count(entry) == 0 || b.slots.count(entry) != 0)
+		{
+			continue;
+		}
+
+		IR::Instruction* slot = Append(b, Opcode::Slot, PrimitiveType::pointer);
+		slot->memoryType = entry->asVar.type;
+		slot->constant = asDeclNode->GetSize();
+		slot->symbol = entry;
+		b.slots[entry] = slot;
+	}
+
+	ui32 paramNumber = 0;
+	for (AST::Node* arg = functionNode->GetArgsList(); arg != nullptr; arg = arg->GetRightSibling(), paramNumber++)
+	{
+		if (paramNumber == s_maxArguments)
+		{
+			wprintf(L"WARNING: Ran out of registers while trying to retrieve args for function %s.\n", functionNode->GetName().c_str());
+			break;
+		}
+
+		SymTabEntry* entry = ((AST::ArgNode*)arg)->GetSymTabEntry();
+		IR::Instruction* param = Append(b, Opcode::Param, entry->asVar.type);
+		param->constant = paramNumber;
+		param->symbol = entry;
+
+		const auto slot = b.slots.find(entry);
+		if (slot != b.slots.end())
+		{
+			Append(b, Opcode::Store, PrimitiveType::nihil, { slot->second, param })->memoryType = entry->asVar.type;
+		}
+		else
+		{
+			WriteVariable(b, entry, b.current, param);
+		}
+	}
+
+	for (AST::Node* childNode : functionNode->GetChildren())
+	{
+		if (childNode->GetNodeKind() == Node_k::ScopeNode)
+		{
+			BuildStatements(b, childNode);
+		}
+	}
+
+	// Falling off the end of the function returns whatever happens to be in RAX, as it always has.
+	if (b.current != nullptr)
+	{
+		Append(b, Opcode::Return, PrimitiveType::nihil);
+	}
+
+	outFunction.Compact();
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#include "IR.h"
+
+namespace AST
+{
+	class FunctionNode;
+}
+
+/*
+	Builds the IR of a function from its analysed AST.
+
+	SSA form is built on the fly, as the statements are visited, the way Braun et al. describe in "Simple and Efficient
+	Construction of Static Single Assignment Form": every block remembers the value each local was last given in it, a local
+	read in a block that didn't assign it is looked up in the block's predecessors, and a phi is placed where they disagree.
+	A loop's body is only sealed once the loop's head, its other predecessor, is there, the locals read in the body until then
+	get phis that are completed when it's sealed. Phis that turn out to only ever take one value are replaced by it.
+
+	The values come out exactly like the code generator computes them: operations and calls are truncated to their type when
+	they're the operand of an operation, stores truncate to what they store to, and operands are computed left to right.
+	A For loop jumps into its body, which its head, the increment of the iteration variable and the test against the upper
+	bound, follows. The body runs at least once.
+
+	A return ends the function right there, and whatever follows it in the same scope is never reached, so it isn't built.
+*/
+namespace IR
+{
+	void BuildFunction(AST::FunctionNode* functionNode, Function& outFunction);
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "IR_PassManager.h"
+#include "IR_Transforms.h"
+#include "IR_Verifier.h"
+#include "../Options.h"
+#include "../Exit.h"
+#include "../Utils.h"
+#include "../profiling/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+struct Pass
+{
+	const char* name;
+	const char* description;
+	ui64(*run)(IR::Function&, IR::AnalysisManager&);
+
+	// The analyses still right after it changed something.
+	IR::AnalysisSet preserved;
+};
+
+// None of the passes changes the control flow.
+static constexpr Pass s_passes[] = {
+	{ "fold", "Folds constants and algebraic identities", IR::FoldConstants, IR::s_controlFlowAnalyses },
+	{ "cse", "Shares computations and loads with the ones before them", IR::EliminateCommonSubexpressions, IR::s_controlFlowAnalyses },
+	{ "licm", "Hoists computations out of loops", IR::HoistLoopInvariants, IR::s_controlFlowAnalyses },
+	{ "dce", "Removes instructions whose values aren't used", IR::EliminateDeadCode, IR::s_controlFlowAnalyses },
+};
+
+static constexpr const char* s_analysisNames[] = { "dominators", "loops" };
+static_assert(GetArraySize(s_analysisNames) == (ui64)IR::AnalysisKind::count);
+
+static const std::vector<const char*>& GetPipeline(const OptLevel level)
+{
+	static const std::vector<const char*> s_none;
+	static const std::vector<const char*> s_o1 = { "fold", "dce" };
+	static const std::vector<const char*> s_o2 = { "fold", "cse", "licm", "fold", "dce" };
+	static const std::vector<const char*> s_os = { "fold", "cse", "dce" };
+	switch (level)
+	{
+	case OptLevel::O1: return s_o1;
+	case OptLevel::O2: return s_o2;
+	case OptLevel::Os: return s_os;
+	default: return s_none;
+	}
+}
+
+static const Pass* FindPass(const std::string& name)
+{
+	for (const Pass& pass : s_passes)
+	{
+		if (name == pass.name)
+		{
+			return &pass;
+		}
+	}
+	return nullptr;
+}
+
+struct PassStats
+{
+	ui64 runs = 0;
+	ui64 changes = 0;
+	i64 microseconds = 0;
+};
+
+// Over the whole compilation, from every thread generating code.
+static std::mutex s_statsMutex;
+static PassStats s_passStats[GetArraySize(s_passes)];
+static ui64 s_analysisComputeCounts[(ui64)IR::AnalysisKind::count] = {};
+static ui64 s_analysisReuseCounts[(ui64)IR::AnalysisKind::count] = {};
+
+bool IR::AnalysisManager::IsCached(const AnalysisKind kind)
+{
+	const ui64 index = (ui64)kind;
+	if (isValid[index])
+	{
+		reuseCounts[index]++;
+		return true;
+	}
+	isValid[index] = true;
+	computeCounts[index]++;
+	return false;
+}
+
+const IR::DominatorTree& IR::AnalysisManager::GetDominators(void)
+{
+	if (!IsCached(AnalysisKind::dominators))
+	{
+		ComputeDominatorTree(function, dominators);
+	}
+	return dominators;
+}
+
+const IR::LoopInfo& IR::AnalysisManager::GetLoops(void)
+{
+	if (!IsCached(AnalysisKind::loops))
+	{
+		ComputeLoopInfo(GetDominators(), loops);
+	}
+	return loops;
+}
+
+void IR::AnalysisManager::Invalidate(const AnalysisSet preserved)
+{
+	for (ui64 i = 0; i < (ui64)AnalysisKind::count; i++)
+	{
+		isValid[i] = isValid[i] && (preserved & (1u << i)) != 0;
+	}
+}
+
+[[noreturn]] static void FailUnknownPass(const std::string& name, const char* option)
+{
+	wprintf(L"ERROR: There's no pass named %S for %S, the passes are:", name.c_str(), option);
+	for (const Pass& pass : s_passes)
+	{
+		wprintf(L" %S", pass.name);
+	}
+	wprintf(L".\n");
+	Exit(ErrCodes::malformed_cmd_line);
+}
+
+void IR::RunPipeline(Function& function)
+{
+	for (const std::string& name : g_options.disabledPasses)
+	{
+		if (FindPass(name) == nullptr) { FailUnknownPass(name, "--disable-pass"); }
+	}
+	for (const std::string& name : g_options.printAfterPasses)
+	{
+		if (name != "all" && FindPass(name) == nullptr) { FailUnknownPass(name, "--print-after"); }
+	}
+
+	const std::vector<const char*>& pipeline = GetPipeline(g_options.optLevel);
+	if (pipeline.empty())
+	{
+		return;
+	}
+
+	AnalysisManager analyses(function);
+	PassStats stats[GetArraySize(s_passes)];
+	bool isChanged = false;
+
+	for (const char* name : pipeline)
+	{
+		const std::vector<std::string>& disabled = g_options.disabledPasses;
+		if (std::find(disabled.begin(), disabled.end(), name) != disabled.end())
+		{
+			continue;
+		}
+
+		const Pass* pass = FindPass(name);
+		PassStats& passStats = stats[pass - s_passes];
+		ui64 changeCount = 0;
+		{
+			Profiling::Scope scope(pass->name, &function.name);
+			const auto start = std::chrono::steady_clock::now();
+			changeCount = pass->run(function, analyses);
+			passStats.microseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+		passStats.runs++;
+		passStats.changes += changeCount;
+
+		if (changeCount != 0)
+		{
+			isChanged = true;
+			analyses.Invalidate(pass->preserved);
+
+			// Gets rid of what the pass took out, and numbers the values in order again for the dump.
+			function.Compact();
+		}
+
+		const std::vector<std::string>& printed = g_options.printAfterPasses;
+		if (std::find(printed.begin(), printed.end(), name) != printed.end() || std::find(printed.begin(), printed.end(), "all") != printed.end())
+		{
+			const std::string text = "IR: ; After " + std::string(name) + "\n" + PrintFunction(function);
+			wprintf(L"%S", text.c_str());
+		}
+	}
+
+	if (isChanged)
+	{
+		Verify(function);
+	}
+
+	if (g_options.passStats)
+	{
+		std::lock_guard<std::mutex> lock(s_statsMutex);
+		for (ui64 i = 0; i < GetArraySize(s_passes); i++)
+		{
+			s_passStats[i].runs += stats[i].runs;
+			s_passStats[i].changes += stats[i].changes;
+			s_passStats[i].microseconds += stats[i].microseconds;
+		}
+		for (ui64 i = 0; i < (ui64)AnalysisKind::count; i++)
+		{
+			s_analysisComputeCounts[i] += analyses.computeCounts[i];
+			s_analysisReuseCounts[i] += analyses.reuseCounts[i];
+		}
+	}
+}
+
+void IR::PrintPassStats(void)
+{
+	std::lock_guard<std::mutex> lock(s_statsMutex);
+
+	wprintf(L"PASSES: %-10S %10S %10S %10S   %S\n", "Pass", "Runs", "Changes", "Time ms", "Description");
+	for (ui64 i = 0; i < GetArraySize(s_passes); i++)
+	{
+		const PassStats& stats = s_passStats[i];
+		wprintf(L"PASSES: %-10S %10llu %10llu %10.2f   %S\n", s_passes[i].name, stats.runs, stats.changes, stats.microseconds / 1000.0, s_passes[i].description);
+	}
+
+	wprintf(L"PASSES: %-10S %10S %10S\n", "Analysis", "Computed", "Reused");
+	for (ui64 i = 0; i < (ui64)AnalysisKind::count; i++)
+	{
+		wprintf(L"PASSES: %-10S %10llu %10llu\n", s_analysisNames[i], s_analysisComputeCounts[i], s_analysisReuseCounts[i]);
+	}
+}
+
+void IR::ResetPassStats(void)
+{
+	std::lock_guard<std::mutex> lock(s_statsMutex);
+	std::fill(std::begin(s_passStats), std::end(s_passStats), PassStats());
+	std::fill(std::begin(s_analysisComputeCounts), std::end(s_analysisComputeCounts), 0);
+	std::fill(std::begin(s_analysisReuseCounts), std::end(s_analysisReuseCounts), 0);
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include "IR_Analyses.h"
+
+/*
+	Runs the optimization passes over a function's IR, between building it and lowering it to assembly.
+
+	The passes are registered in IR_PassManager.cpp, each with a name to refer to it by on the command line, and the pipeline
+	each optimization level runs is a list of their names:
+		-O0  nothing, the IR is lowered as it's built.
+		-O1  fold, dce
+		-O2  fold, cse, licm, fold, dce
+		-Os  fold, cse, dce, the same but without hoisting out of loops, which only adds instructions to the preheaders.
+	--disable-pass=NAME takes a pass out of the pipeline and --print-after=NAME prints the IR after every run of it, so a change
+	in the generated code can be pinned on a pass.
+
+	The analyses the passes use are computed when a pass first asks for one, and kept until a pass that doesn't preserve it
+	changes something. A pass that changes nothing preserves everything.
+
+	--pass-stats counts, over the whole compilation, how often every pass ran, how many instructions it changed and how long it
+	took, and how often every analysis was computed and how often it was reused instead. On a distributed build the passes run
+	on the workers, and they aren't counted.
+*/
+namespace IR
+{
+	enum class AnalysisKind : ui8
+	{
+		dominators,
+		loops,
+
+		count
+	};
+
+	// A set of analyses, a bit per AnalysisKind.
+	using AnalysisSet = ui32;
+	constexpr AnalysisSet s_noAnalyses = 0;
+	constexpr AnalysisSet s_controlFlowAnalyses = (1u << (ui32)AnalysisKind::dominators) | (1u << (ui32)AnalysisKind::loops);
+
+	class AnalysisManager
+	{
+	public:
+		explicit AnalysisManager(const Function& c_function) : function(c_function) {}
+
+		const DominatorTree& GetDominators(void);
+		const LoopInfo& GetLoops(void);
+
+		// Throws away every analysis not in preserved.
+		void Invalidate(const AnalysisSet preserved);
+
+		// How often every analysis was computed and reused, by AnalysisKind.
+		ui64 computeCounts[(ui64)AnalysisKind::count] = {};
+		ui64 reuseCounts[(ui64)AnalysisKind::count] = {};
+
+	private:
+		bool IsCached(const AnalysisKind kind);
+
+		const Function& function;
+		bool isValid[(ui64)AnalysisKind::count] = {};
+		DominatorTree dominators;
+		LoopInfo loops;
+	};
+
+	// Runs the pipeline of the optimization level in g_options over the function, then checks the result with Verify.
+	// Ends the compilation if a pass named on the command line doesn't exist.
+	void RunPipeline(Function& function);
+
+	// --pass-stats
+	void PrintPassStats(void);
+	void ResetPassStats(void);
+}
\ No newline at end of file
@@ -0,0 +1,433 @@
+#include "IR_Transforms.h"
+#include "IR_PassManager.h"
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+using IR::Instruction;
+using IR::Opcode;
+
+// The values a pass replaced with others. The uses that come after a replacement are rewritten as the pass comes by them, the
+// rest(phis' operands from back edges) all at once when it's done.
+class Replacements
+{
+public:
+	void Add(Instruction* from, Instruction* to)
+	{
+		map[from] = to;
+	}
+
+	Instruction* Resolve(Instruction* value) const
+	{
+		for (auto found = map.find(value); found != map.end(); found = map.find(value))
+		{
+			value = found->second;
+		}
+		return value;
+	}
+
+	// Returns whether any of the operands was replaced.
+	bool ResolveOperands(Instruction* instruction) const
+	{
+		bool isChanged = false;
+		for (Instruction*& operand : instruction->operands)
+		{
+			Instruction* resolved = Resolve(operand);
+			isChanged = isChanged || resolved != operand;
+			operand = resolved;
+		}
+		return isChanged;
+	}
+
+	void ApplyTo(IR::Function& function) const
+	{
+		if (map.empty())
+		{
+			return;
+		}
+		for (IR::Block* block : function.blocks)
+		{
+			for (Instruction* instruction : block->instructions)
+			{
+				ResolveOperands(instruction);
+			}
+		}
+	}
+
+private:
+	std::unordered_map<const Instruction*, Instruction*> map;
+};
+
+static bool IsArithmetic(const Opcode op)
+{
+	return op >= Opcode::Add && op <= Opcode::Or;
+}
+
+// Computes the same value every time from the same operands, and has no effect besides, so it can be shared or moved.
+static bool IsPure(const Instruction* instruction)
+{
+	return IsArithmetic(instruction->op) || instruction->op == Opcode::Trunc;
+}
+
+static bool IsCommutative(const Opcode op)
+{
+	return op == Opcode::Add || op == Opcode::Mul || op == Opcode::And || op == Opcode::Or;
+}
+
+static bool IsConst(const Instruction* value, const i64 constant)
+{
+	return value->op == Opcode::Const && value->constant == constant;
+}
+
+static ui64 GetMask(const ui32 size)
+{
+	return size == 8 ? ~0ull : (1ull << (8 * size)) - 1;
+}
+
+// Drops the instructions in the block that are no longer in it.
+static void RemoveTakenOut(IR::Block* block)
+{
+	std::erase_if(block->instructions, [&](const Instruction* instruction) { return instruction->block != block; });
+}
+
+// What the arithmetic instruction folds to, nullptr if it doesn't.
+static Instruction* FoldArithmetic(IR::Function& function, const Instruction* instruction)
+{
+	Instruction* lhs = instruction->operands[0];
+	Instruction* rhs = instruction->operands[1];
+	const ui64 a = (ui64)lhs->constant;
+	const ui64 b = (ui64)rhs->constant;
+	const auto make = [&](const ui64 value) { return function.GetConst((i64)value, instruction->type); };
+
+	if (lhs->op == Opcode::Const && rhs->op == Opcode::Const)
+	{
+		switch (instruction->op)
+		{
+		case Opcode::Add: return make(a + b);
+		case Opcode::Sub: return make(a - b);
+		case Opcode::Mul: return make(a * b);
+		case Opcode::Div: return b == 0 ? nullptr : make(a / b);
+		case Opcode::Shl: return make(a << (b & 63));
+		case Opcode::Shr: return make(a >> (b & 63));
+		case Opcode::And: return make(a & b);
+		default: return make(a | b);
+		}
+	}
+
+	switch (instruction->op)
+	{
+	case Opcode::Add:
+	case Opcode::Or:
+	{
+		if (IsConst(rhs, 0)) { return lhs; }
+		if (IsConst(lhs, 0)) { return rhs; }
+		if (instruction->op == Opcode::Or && lhs == rhs) { return lhs; }
+		return nullptr;
+	}
+	case Opcode::Sub:
+	{
+		if (IsConst(rhs, 0)) { return lhs; }
+		if (lhs == rhs) { return make(0); }
+		return nullptr;
+	}
+	case Opcode::Mul:
+	{
+		if (IsConst(rhs, 1)) { return lhs; }
+		if (IsConst(lhs, 1)) { return rhs; }
+		if (IsConst(lhs, 0) || IsConst(rhs, 0)) { return make(0); }
+		return nullptr;
+	}
+	case Opcode::Div:
+	{
+		return IsConst(rhs, 1) ? lhs : nullptr;
+	}
+	case Opcode::Shl:
+	case Opcode::Shr:
+	{
+		if (rhs->op == Opcode::Const && (b & 63) == 0) { return lhs; }
+		if (IsConst(lhs, 0)) { return make(0); }
+		return nullptr;
+	}
+	default:
+	{
+		if (IsConst(lhs, 0) || IsConst(rhs, 0)) { return make(0); }
+		if (lhs == rhs) { return lhs; }
+		return nullptr;
+	}
+	}
+}
+
+ui64 IR::FoldConstants(Function& function, AnalysisManager&)
+{
+	ui64 changeCount = 0;
+	Replacements replacements;
+
+	for (Block* block : function.blocks)
+	{
+		for (Instruction* instruction : block->instructions)
+		{
+			replacements.ResolveOperands(instruction);
+
+			Instruction* folded = nullptr;
+			if (IsArithmetic(instruction->op))
+			{
+				folded = FoldArithmetic(function, instruction);
+			}
+			else if (instruction->op == Opcode::Trunc)
+			{
+				Instruction* operand = instruction->operands[0];
+				const ui32 size = GetTypeSize(instruction->type);
+				if (GetTypeSize(operand->type) <= size)
+				{
+					folded = operand;
+				}
+				else if (operand->op == Opcode::Const)
+				{
+					folded = function.GetConst((i64)((ui64)operand->constant & GetMask(size)), instruction->type);
+				}
+				else if (operand->op == Opcode::Trunc)
+				{
+					// Narrower than the operand, which is narrower than its own operand.
+					instruction->operands[0] = operand->operands[0];
+					changeCount++;
+				}
+			}
+			else if (instruction->op == Opcode::Phi)
+			{
+				// The phis of loops whose variable isn't changed in them, once their operands are folded.
+				Instruction* same = nullptr;
+				bool isTrivial = true;
+				for (Instruction* operand : instruction->operands)
+				{
+					if (operand == instruction || operand == same)
+					{
+						continue;
+					}
+					if (same != nullptr)
+					{
+						isTrivial = false;
+						break;
+					}
+					same = operand;
+				}
+				if (isTrivial && same != nullptr)
+				{
+					folded = same;
+				}
+			}
+
+			if (folded != nullptr)
+			{
+				replacements.Add(instruction, folded);
+				instruction->block = nullptr;
+				changeCount++;
+			}
+		}
+		RemoveTakenOut(block);
+	}
+
+	replacements.ApplyTo(function);
+	return changeCount;
+}
+
+ui64 IR::EliminateCommonSubexpressions(Function& function, AnalysisManager& analyses)
+{
+	const DominatorTree& dominators = analyses.GetDominators();
+
+	using Key = std::tuple<Opcode, PrimitiveType, const Instruction*, const Instruction*>;
+	std::map<Key, Instruction*> available;
+
+	// The loads of the block so far, by address and type, and the values stored there, as far as they're known.
+	std::map<std::pair<const Instruction*, PrimitiveType>, Instruction*> memory;
+
+	ui64 changeCount = 0;
+	Replacements replacements;
+
+	// Walks the dominator tree, so what's available in a block is what its dominators computed.
+	struct Visit
+	{
+		Block* block;
+		ui64 nextChild;
+		std::vector<Key> added;
+	};
+	std::vector<Visit> stack;
+	stack.push_back({ dominators.order[0], 0, {} });
+	bool isEntering = true;
+
+	while (!stack.empty())
+	{
+		Visit& visit = stack.back();
+		if (isEntering)
+		{
+			memory.clear();
+			for (Instruction* instruction : visit.block->instructions)
+			{
+				if (instruction->op != Opcode::Phi)
+				{
+					replacements.ResolveOperands(instruction);
+				}
+
+				Instruction* existing = nullptr;
+				if (IsPure(instruction))
+				{
+					const Instruction* a = instruction->operands[0];
+					const Instruction* b = instruction->operands.size() > 1 ? instruction->operands[1] : nullptr;
+					if (IsCommutative(instruction->op) && a->id > b->id)
+					{
+						std::swap(a, b);
+					}
+
+					const Key key{ instruction->op, instruction->type, a, b };
+					const auto [found, isNew] = available.insert({ key, instruction });
+					if (isNew)
+					{
+						visit.added.push_back(key);
+					}
+					else
+					{
+						existing = found->second;
+					}
+				}
+				else if (instruction->op == Opcode::Load)
+				{
+					const auto [found, isNew] = memory.insert({ { instruction->operands[0], instruction->memoryType }, instruction });
+					if (!isNew)
+					{
+						existing = found->second;
+					}
+				}
+				else if (instruction->op == Opcode::Store)
+				{
+					// Any other address could be the same memory.
+					memory.clear();
+
+					Instruction* value = instruction->operands[1];
+					const ui32 size = GetTypeSize(instruction->memoryType);
+					if (value->op == Opcode::Const)
+					{
+						value = function.GetConst((i64)((ui64)value->constant & GetMask(size)), instruction->memoryType);
+					}
+					if (GetTypeSize(value->type) <= size)
+					{
+						memory[{ instruction->operands[0], instruction->memoryType }] = value;
+					}
+				}
+				else if (instruction->op == Opcode::Call)
+				{
+					memory.clear();
+				}
+
+				if (existing != nullptr)
+				{
+					replacements.Add(instruction, existing);
+					instruction->block = nullptr;
+					changeCount++;
+				}
+			}
+			RemoveTakenOut(visit.block);
+		}
+
+		const std::vector<Block*>& children = dominators.children[dominators.indices.at(visit.block)];
+		if (visit.nextChild < children.size())
+		{
+			Block* child = children[visit.nextChild++];
+			stack.push_back({ child, 0, {} });
+			isEntering = true;
+			continue;
+		}
+
+		for (const Key& key : visit.added)
+		{
+			available.erase(key);
+		}
+		stack.pop_back();
+		isEntering = false;
+	}
+
+	replacements.ApplyTo(function);
+	return changeCount;
+}
+
+ui64 IR::HoistLoopInvariants(Function&, AnalysisManager& analyses)
+{
+	const LoopInfo& loopInfo = analyses.GetLoops();
+
+	ui64 changeCount = 0;
+	for (const Loop& loop : loopInfo.loops)
+	{
+		if (loop.preheader == nullptr)
+		{
+			continue;
+		}
+
+		std::vector<Instruction*>& preheaderInstructions = loop.preheader->instructions;
+		for (Block* block : loop.blocks)
+		{
+			for (Instruction* instruction : block->instructions)
+			{
+				const bool isInvariant = std::all_of(instruction->operands.begin(), instruction->operands.end(), [&](const Instruction* operand) {
+					return operand->block == nullptr || !loop.Contains(operand->block);
+				});
+
+				// A division can only move when it can't fault, wherever it's moved to.
+				const bool isSafe = instruction->op != Opcode::Div || (instruction->operands[1]->op == Opcode::Const && instruction->operands[1]->constant != 0);
+				if (!IsPure(instruction) || !isInvariant || !isSafe)
+				{
+					continue;
+				}
+
+				preheaderInstructions.insert(preheaderInstructions.end() - 1, instruction);
+				instruction->block = loop.preheader;
+				changeCount++;
+			}
+			RemoveTakenOut(block);
+		}
+	}
+	return changeCount;
+}
+
+ui64 IR::EliminateDeadCode(Function& function, AnalysisManager&)
+{
+	std::unordered_set<const Instruction*> isLive;
+	std::vector<const Instruction*> worklist;
+	for (const Block* block : function.blocks)
+	{
+		for (const Instruction* instruction : block->instructions)
+		{
+			const bool isRoot = instruction->op == Opcode::Store || instruction->op == Opcode::Call || instruction->op == Opcode::Slot ||
+				instruction->IsTerminator();
+			if (isRoot && isLive.insert(instruction).second)
+			{
+				worklist.push_back(instruction);
+			}
+		}
+	}
+
+	while (!worklist.empty())
+	{
+		const Instruction* instruction = worklist.back();
+		worklist.pop_back();
+		for (const Instruction* operand : instruction->operands)
+		{
+			if (operand->block != nullptr && isLive.insert(operand).second)
+			{
+				worklist.push_back(operand);
+			}
+		}
+	}
+
+	ui64 changeCount = 0;
+	for (Block* block : function.blocks)
+	{
+		for (Instruction* instruction : block->instructions)
+		{
+			if (isLive.count(instruction) == 0)
+			{
+				instruction->block = nullptr;
+				changeCount++;
+			}
+		}
+		RemoveTakenOut(block);
+	}
+	return changeCount;
+}
\ No newline at end of file
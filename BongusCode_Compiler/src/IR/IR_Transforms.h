@@ -0,0 +1,30 @@
+#pragma once
+#include "IR.h"
+
+/*
+	The optimization passes, see IR_PassManager.h for the pipelines they're run in. Each returns how many instructions it
+	folded, replaced, moved or removed, 0 if it left the function as it was.
+
+	None of them changes the control flow. Instructions they take out of their blocks stay around until Function::Compact.
+*/
+namespace IR
+{
+	class AnalysisManager;
+
+	// fold: Folds arithmetic and truncations of constants, algebraic identities(x + 0, x * 1, x & 0, x - x...), truncations of
+	// values that already fit, and phis all of whose operands are the same value. Never folds a division by zero, that's
+	// left to fault at run time.
+	ui64 FoldConstants(Function& function, AnalysisManager& analyses);
+
+	// cse: Replaces arithmetic and truncations with the same computation in a block that dominates them, and loads with an
+	// earlier load of, or store to, the same address in the same block, when there's no store or call in between.
+	ui64 EliminateCommonSubexpressions(Function& function, AnalysisManager& analyses);
+
+	// licm: Moves arithmetic and truncations whose operands are all defined outside of a loop to its preheader, the innermost
+	// loops first, so they can keep moving outward. Divisions only move when they can't fault.
+	ui64 HoistLoopInvariants(Function& function, AnalysisManager& analyses);
+
+	// dce: Removes the instructions whose values are never used by a store, call, terminator or anything that is. Slots stay,
+	// a pointer to a local can be used to get to the locals next to it.
+	ui64 EliminateDeadCode(Function& function, AnalysisManager& analyses);
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "IR_Verifier.h"
+#include "IR_Analyses.h"
+#include "../Exit.h"
+#include <algorithm>
+
+[[noreturn]] static void Fail(const IR::Function& function, const IR::Block* block, const std::string& problem)
+{
+	const std::string text = IR::PrintFunction(function);
+	wprintf(L"%S", text.c_str());
+	wprintf(L"ERROR: Malformed IR in function %S, block %S: %S.\n", function.name.c_str(), IR::GetBlockName(block).c_str(), problem.c_str());
+	Exit(ErrCodes::internal_compiler_error);
+}
+
+static std::string Describe(const IR::Instruction* instruction)
+{
+	return std::string(IR::GetOpcodeName(instruction->op)) + " %" + std::to_string(instruction->id);
+}
+
+static ui64 GetOperandCount(const IR::Opcode op)
+{
+	switch (op)
+	{
+	case IR::Opcode::Const:
+	case IR::Opcode::Undef:
+	case IR::Opcode::Param:
+	case IR::Opcode::Slot:
+	case IR::Opcode::Jump:
+		return 0;
+	case IR::Opcode::Load:
+	case IR::Opcode::Trunc:
+		return 1;
+	default:
+		return 2;
+	}
+}
+
+void IR::Verify(const Function& function)
+{
+	if (function.blocks.empty())
+	{
+		wprintf(L"ERROR: Malformed IR in function %S: it has no blocks.\n", function.name.c_str());
+		Exit(ErrCodes::internal_compiler_error);
+	}
+
+	DominatorTree dominators;
+	ComputeDominatorTree(function, dominators);
+
+	if (!function.blocks[0]->predecessors.empty())
+	{
+		Fail(function, function.blocks[0], "the entry has predecessors");
+	}
+
+	// Where every instruction is, to tell whether its definition comes before a use in the same block.
+	std::unordered_map<const Instruction*, ui64> positions;
+	for (const Block* block : function.blocks)
+	{
+		if (!dominators.IsReachable(block))
+		{
+			Fail(function, block, "it can't be reached from the entry");
+		}
+		for (ui64 i = 0; i < block->instructions.size(); i++)
+		{
+			positions[block->instructions[i]] = i;
+		}
+	}
+
+	for (const Block* block : function.blocks)
+	{
+		if (block->GetTerminator() == nullptr)
+		{
+			Fail(function, block, "it doesn't end in a terminator");
+		}
+
+		const std::vector<Block*> successors = block->GetSuccessors();
+		for (const Block* successor : successors)
+		{
+			if (std::count(successor->predecessors.begin(), successor->predecessors.end(), block) != std::count(successors.begin(), successors.end(), successor))
+			{
+				Fail(function, block, "it isn't among the predecessors of its successor " + GetBlockName(successor));
+			}
+		}
+		for (const Block* predecessor : block->predecessors)
+		{
+			const std::vector<Block*> predecessorSuccessors = predecessor->GetSuccessors();
+			if (std::find(predecessorSuccessors.begin(), predecessorSuccessors.end(), block) == predecessorSuccessors.end())
+			{
+				Fail(function, block, "its predecessor " + GetBlockName(predecessor) + " doesn't go to it");
+			}
+		}
+
+		bool isPastPhis = false;
+		for (ui64 i = 0; i < block->instructions.size(); i++)
+		{
+			const Instruction* instruction = block->instructions[i];
+			const std::string described = Describe(instruction);
+
+			if (instruction->block != block)
+			{
+				Fail(function, block, described + " thinks it's in another block");
+			}
+			if (instruction->IsTerminator() != (i + 1 == block->instructions.size()))
+			{
+				Fail(function, block, described + (instruction->IsTerminator() ? " is a terminator before the end" : " comes after the terminator"));
+			}
+
+			switch (instruction->op)
+			{
+			case Opcode::Const:
+			case Opcode::Undef:
+			{
+				Fail(function, block, described + " is in a block");
+			}
+			case Opcode::Param:
+			case Opcode::Slot:
+			{
+				if (block != function.blocks[0])
+				{
+					Fail(function, block, described + " is outside of the entry");
+				}
+				break;
+			}
+			case Opcode::Phi:
+			{
+				if (isPastPhis)
+				{
+					Fail(function, block, described + " comes after an instruction that isn't a phi");
+				}
+				if (instruction->blocks != block->predecessors || instruction->operands.size() != block->predecessors.size())
+				{
+					Fail(function, block, described + " doesn't have an operand for every predecessor, in their order");
+				}
+				break;
+			}
+			case Opcode::Call:
+			{
+				if (instruction->operands.size() > 4 || instruction->symbol == nullptr)
+				{
+					Fail(function, block, described + " doesn't call a function with at most 4 arguments");
+				}
+				break;
+			}
+			case Opcode::Return:
+			{
+				if (instruction->operands.size() > 1)
+				{
+					Fail(function, block, described + " returns more than one value");
+				}
+				break;
+			}
+			case Opcode::Jump:
+			case Opcode::Branch:
+			{
+				if (instruction->blocks.size() != (instruction->op == Opcode::Jump ? 1 : 2))
+				{
+					Fail(function, block, described + " has the wrong number of targets");
+				}
+				[[fallthrough]];
+			}
+			default:
+			{
+				if (instruction->operands.size() != GetOperandCount(instruction->op))
+				{
+					Fail(function, block, described + " has the wrong number of operands");
+				}
+				break;
+			}
+			}
+			isPastPhis = isPastPhis || instruction->op != Opcode::Phi;
+
+			const bool isMemoryAccess = instruction->op == Opcode::Load || instruction->op == Opcode::Store || instruction->op == Opcode::Slot;
+			if (isMemoryAccess == (instruction->memoryType == PrimitiveType::invalid))
+			{
+				Fail(function, block, described + (isMemoryAccess ? " doesn't say what type it accesses memory as" : " has a memory type"));
+			}
+
+			for (ui64 j = 0; j < instruction->operands.size(); j++)
+			{
+				const Instruction* operand = instruction->operands[j];
+				if (operand == nullptr || !operand->HasValue())
+				{
+					Fail(function, block, described + " has an operand without a value");
+				}
+				if (operand->op == Opcode::Const || operand->op == Opcode::Undef)
+				{
+					continue;
+				}
+				if (operand->block == nullptr || positions.count(operand) == 0)
+				{
+					Fail(function, block, described + " uses " + Describe(operand) + ", which isn't in any block");
+				}
+
+				// A phi's operand is used at the end of the predecessor it comes from.
+				const bool isPhiOperand = instruction->op == Opcode::Phi;
+				const Block* useBlock = isPhiOperand ? instruction->blocks[j] : block;
+				const bool isDefinedBefore = operand->block == useBlock ? (isPhiOperand || positions.at(operand) < i) : dominators.Dominates(operand->block, useBlock);
+				if (!isDefinedBefore)
+				{
+					Fail(function, block, described + " uses " + Describe(operand) + " where it isn't defined on every path");
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
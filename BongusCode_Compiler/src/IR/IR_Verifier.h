@@ -0,0 +1,16 @@
+#pragma once
+#include "IR.h"
+
+/*
+	Checks that a function's IR is well formed, before anything relies on it being so:
+	every block is reachable from the entry, ends in its only terminator and starts with its phis, predecessors and successors
+	agree, every phi has an operand for every predecessor, parameters and slots are only in the entry, every instruction has
+	the operands its opcode takes, and every value is defined in a place that dominates all of its uses. A phi's operand is
+	used at the end of the predecessor it comes from.
+
+	The first problem found is reported along with the function's IR, and the compilation ends with an internal compiler error.
+*/
+namespace IR
+{
+	void Verify(const Function& function);
+}
\ No newline at end of file
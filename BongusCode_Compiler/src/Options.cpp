@@ -0,0 +1,221 @@
+#include "Options.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+bool ParseOptions(const i32 argc, char** argv, const i32 firstOption, CompilerOptions& outOptions)
+{
+	for (i32 i = firstOption; i < argc; i++)
+	{
+		const char* option = argv[i];
+
+		if (strcmp(option, "--pipelined") == 0)
+		{
+			outOptions.pipelined = true;
+		}
+		else if (strcmp(option, "--streaming") == 0)
+		{
+			outOptions.pipelined = true;
+			outOptions.streaming = true;
+		}
+		else if (strcmp(option, "--threaded-lexer") == 0)
+		{
+			outOptions.threadedLexer = true;
+		}
+		else if (strncmp(option, "--lex-threads=", strlen("--lex-threads=")) == 0)
+		{
+			outOptions.lexThreads = (ui32)strtoul(option + strlen("--lex-threads="), nullptr, 10);
+		}
+		else if (strcmp(option, "--verify-lexing") == 0)
+		{
+			outOptions.verifyLexing = true;
+		}
+		else if (strcmp(option, "--connect") == 0)
+		{
+			outOptions.connect = true;
+		}
+		else if (strncmp(option, "--connect=", strlen("--connect=")) == 0)
+		{
+			outOptions.connect = true;
+			outOptions.serverSocketPath = option + strlen("--connect=");
+		}
+		else if (strcmp(option, "--cache") == 0)
+		{
+			outOptions.cache = true;
+		}
+		else if (strncmp(option, "--cache=", strlen("--cache=")) == 0)
+		{
+			outOptions.cache = true;
+			outOptions.cacheDirectory = option + strlen("--cache=");
+		}
+		else if (strncmp(option, "--cache-size=", strlen("--cache-size=")) == 0)
+		{
+			outOptions.cacheMaxSize = strtoull(option + strlen("--cache-size="), nullptr, 10) << 20;
+		}
+		else if (strcmp(option, "--cache-stats") == 0)
+		{
+			outOptions.cacheStats = true;
+		}
+		else if (strcmp(option, "--watch") == 0)
+		{
+			outOptions.watch = true;
+		}
+		else if (strncmp(option, "--emit-snapshot=", strlen("--emit-snapshot=")) == 0)
+		{
+			outOptions.snapshotPath = option + strlen("--emit-snapshot=");
+		}
+		else if (strcmp(option, "--verify-snapshot") == 0)
+		{
+			outOptions.verifySnapshot = true;
+		}
+		else if (strcmp(option, "--from-snapshot") == 0)
+		{
+			outOptions.fromSnapshot = true;
+		}
+		else if (strncmp(option, "--emit-interface=", strlen("--emit-interface=")) == 0)
+		{
+			outOptions.interfacePath = option + strlen("--emit-interface=");
+		}
+		else if (strncmp(option, "--import=", strlen("--import=")) == 0)
+		{
+			outOptions.imports.push_back(option + strlen("--import="));
+		}
+		else if (strncmp(option, "--worker=", strlen("--worker=")) == 0)
+		{
+			outOptions.codegenWorkers.push_back(option + strlen("--worker="));
+		}
+		else if (strcmp(option, "--time-report") == 0)
+		{
+			outOptions.timeReport = true;
+		}
+		else if (strcmp(option, "--mem-report") == 0)
+		{
+			outOptions.memReport = true;
+		}
+		else if (strcmp(option, "--cost-report") == 0)
+		{
+			outOptions.costReport = true;
+		}
+		else if (strncmp(option, "--cost-report=", strlen("--cost-report=")) == 0)
+		{
+			outOptions.costReport = true;
+			outOptions.costBaselinePath = option + strlen("--cost-report=");
+		}
+		else if (strcmp(option, "--remarks") == 0)
+		{
+			outOptions.remarks = true;
+		}
+		else if (strcmp(option, "--emit-ir") == 0)
+		{
+			outOptions.emitIR = true;
+		}
+		else if (strcmp(option, "--via-ir") == 0)
+		{
+			outOptions.viaIR = true;
+		}
+		else if (strcmp(option, "-O0") == 0)
+		{
+			outOptions.optLevel = OptLevel::O0;
+		}
+		else if (strcmp(option, "-O1") == 0)
+		{
+			outOptions.optLevel = OptLevel::O1;
+		}
+		else if (strcmp(option, "-O2") == 0)
+		{
+			outOptions.optLevel = OptLevel::O2;
+		}
+		else if (strcmp(option, "-Os") == 0)
+		{
+			outOptions.optLevel = OptLevel::Os;
+		}
+		else if (strcmp(option, "--pass-stats") == 0)
+		{
+			outOptions.passStats = true;
+		}
+		else if (strncmp(option, "--disable-pass=", strlen("--disable-pass=")) == 0)
+		{
+			outOptions.disabledPasses.push_back(option + strlen("--disable-pass="));
+		}
+		else if (strncmp(option, "--print-after=", strlen("--print-after=")) == 0)
+		{
+			outOptions.printAfterPasses.push_back(option + strlen("--print-after="));
+		}
+		else if (strncmp(option, "--trace=", strlen("--trace=")) == 0)
+		{
+			outOptions.tracePath = option + strlen("--trace=");
+		}
+		else
+		{
+			wprintf(L"ERROR: Unknown option: %S\n", option);
+			return false;
+		}
+	}
+
+	// IRLowering lays out frames its own way, and has no source lines to remark on.
+	if (outOptions.remarks && outOptions.IsViaIR())
+	{
+		wprintf(L"WARNING: --remarks only explains the code generated straight from the AST, it has nothing to say with --via-ir, -O1, -O2 or -Os.\n");
+	}
+
+	return true;
+}
+
+std::string GetOutputAffectingOptions(const CompilerOptions& options)
+{
+	std::string result;
+
+	// Streaming writes the EXTERN declarations as they come by, instead of collecting them at the top.
+	if (options.streaming)
+	{
+		result += "--streaming ";
+	}
+
+	if (options.viaIR)
+	{
+		result += "--via-ir ";
+	}
+
+	constexpr const char* optLevelOptions[] = { "", "-O1 ", "-O2 ", "-Os " };
+	result += optLevelOptions[(ui64)options.optLevel];
+
+	// Only the ones the level runs make a difference, but the names are checked when the passes run.
+	for (const std::string& pass : options.disabledPasses)
+	{
+		result += "--disable-pass=" + pass + " ";
+	}
+
+	return result;
+}
+
+void PrintOptionsUsage(void)
+{
+	wprintf(L"OPTIONS:\n");
+	wprintf(L"  --pipelined      Compile each function on a worker thread while the rest of the file is still being parsed.\n");
+	wprintf(L"  --streaming      Like --pipelined, but write out and free each function as soon as it is compiled, to bound memory use.\n");
+	wprintf(L"  --threaded-lexer Run the lexer on its own thread, feeding the parser through a lock-free token ring.\n");
+	wprintf(L"  --lex-threads=N  Cut the source into N chunks at newlines and lex them in parallel before parsing.\n");
+	wprintf(L"  --verify-lexing  Check the result of --lex-threads against lexing the source serially.\n");
+	wprintf(L"  --connect[=PATH] Compile on the compile server listening on PATH, or compile locally if there is none.\n");
+	wprintf(L"  --cache[=DIR]    Reuse the output of an earlier compile of the same source from the cache in DIR.\n");
+	wprintf(L"  --cache-size=MB  Evict the least recently used outputs once the cache grows past MB megabytes. Default 512.\n");
+	wprintf(L"  --cache-stats    Print the cache's hit and miss counts after compiling.\n");
+	wprintf(L"  --watch          Recompile whenever the source file is saved, redoing only the functions that changed.\n");
+	wprintf(L"  --emit-snapshot=PATH Write the analysed AST and symbol table to a binary snapshot at PATH.\n");
+	wprintf(L"  --verify-snapshot    Load the snapshot back after writing it, check it, and time loading against parsing.\n");
+	wprintf(L"  --from-snapshot      Treat the source file as a snapshot, and compile it without lexing, parsing or analysis.\n");
+	wprintf(L"  --emit-interface=PATH Write the declarations of the file's functions to a module interface at PATH.\n");
+	wprintf(L"  --import=PATH        Declare the functions of the module interface at PATH, as if written at the top of the file.\n");
+	wprintf(L"  --worker=PATH        Generate the code on the codegen worker listening on PATH. Give more than once to share it out.\n");
+	wprintf(L"  --time-report        Print the wall and CPU time and the throughput of every phase of the compilation.\n");
+	wprintf(L"  --mem-report         Print what the compilation allocated by phase and category, and its peak memory use.\n");
+	wprintf(L"  --trace=PATH         Write a Chrome trace of the compilation, down to every function generated, to PATH.\n");
+	wprintf(L"  --remarks            Explain the stack frame laid out for every function, statement by statement. -O0 only.\n");
+	wprintf(L"  --cost-report[=PATH] Print the static cost of the generated code. Check it against the baseline at PATH, or write it there.\n");
+	wprintf(L"  --emit-ir            Print the IR every function is built into.\n");
+	wprintf(L"  --via-ir             Generate the assembly from the IR rather than straight from the AST.\n");
+	wprintf(L"  -O0 -O1 -O2 -Os      Optimize the IR before generating the assembly from it: not at all(the default), a little, fully, or for size.\n");
+	wprintf(L"  --pass-stats         Print the runs, changes and time of every optimization pass, and how often analyses were reused.\n");
+	wprintf(L"  --disable-pass=NAME  Leave the optimization pass NAME out. Give more than once to leave out several.\n");
+	wprintf(L"  --print-after=NAME   Print the IR after every run of the optimization pass NAME, or after every pass for \"all\".\n");
+}
\ No newline at end of file
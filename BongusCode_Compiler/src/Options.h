@@ -0,0 +1,130 @@
+#pragma once
+#include "Definitions.h"
+#include <string>
+#include <vector>
+
+// -O0, -O1, -O2, -Os: Which optimization passes run over the IR, see IR/IR_PassManager.h.
+enum class OptLevel : ui8
+{
+	O0,
+	O1,
+	O2,
+	Os
+};
+
+// Optional flags, given on the command line after the source and output file paths.
+struct CompilerOptions
+{
+	// --pipelined: Each function is analysed and compiled on a worker thread as soon as the parser has reduced it,
+	// so that parsing and code generation overlap.
+	bool pipelined = false;
+
+	// --streaming: Pipelined, but each function's code is written out and its memory freed as soon as it is compiled,
+	// which bounds the compiler's memory use by the largest function instead of the whole file.
+	bool streaming = false;
+
+	// --threaded-lexer: The lexer runs on its own thread, feeding the parser through a lock-free token ring.
+	bool threadedLexer = false;
+
+	// --lex-threads=N: The source is cut into N chunks at newlines, which are lexed in parallel before parsing starts.
+	// 0 lexes serially, like usual. Takes precedence over --threaded-lexer.
+	ui32 lexThreads = 0;
+
+	// --verify-lexing: Checks the chunked lexer's output against a serial lex of the same source.
+	bool verifyLexing = false;
+
+	// --connect[=PATH]: Hands the compilation to the compile server listening on PATH(or the default socket), if there is one.
+	// Falls back to compiling locally when no server answers.
+	bool connect = false;
+	std::string serverSocketPath;
+
+	// --cache[=DIR]: Looks the translation unit up in the compile cache in DIR(or the default directory) before compiling it,
+	// and stores the output there after a successful compile.
+	bool cache = false;
+	std::string cacheDirectory;
+
+	// --cache-size=MB: How large the cache may grow before the least recently used outputs are evicted.
+	ui64 cacheMaxSize = 512ull << 20;
+
+	// --cache-stats: Prints the cache's hit/miss statistics after compiling.
+	bool cacheStats = false;
+
+	// --watch: Stays alive after compiling, and recompiles the functions that changed whenever the source file is saved.
+	bool watch = false;
+
+	// --emit-snapshot=PATH: Writes the analysed AST and symbol table to a binary snapshot at PATH, see snapshot/Snapshot.h.
+	std::string snapshotPath;
+
+	// --verify-snapshot: Loads the snapshot back right after writing it, and checks it against the AST it was written from.
+	bool verifySnapshot = false;
+
+	// --from-snapshot: The source file is a snapshot written by --emit-snapshot, compile it without going through the front end.
+	bool fromSnapshot = false;
+
+	// --emit-interface=PATH: Writes the declarations of every function in the translation unit to a module interface at PATH.
+	std::string interfacePath;
+
+	// --import=PATH: Enters the declarations of the module interface at PATH into the symbol table before parsing starts,
+	// as if they had been written at the top of the source file. May be given more than once.
+	std::vector<std::string> imports;
+
+	// --worker=PATH: Generates the code on the codegen worker listening on PATH, see distributed/CodegenWorker.h.
+	// May be given more than once, the functions are shared out among all the workers given.
+	std::vector<std::string> codegenWorkers;
+
+	// --time-report: Prints the wall and CPU time of every phase of the compilation, and how fast it got through its input.
+	bool timeReport = false;
+
+	// --trace=PATH: Writes a Chrome trace of the compilation to PATH, with every phase, every function generated, and every
+	// thread involved. Open it in chrome://tracing or Perfetto.
+	std::string tracePath;
+
+	// --mem-report: Prints what the compilation allocated, by phase and by category, the AST's nodes by kind, and the peak
+	// live and resident memory. See profiling/MemoryAccounting.h.
+	bool memReport = false;
+
+	// --cost-report[=PATH]: Prints the static cost of the generated assembly, per function and per loop, see
+	// code_generator/CostModel.h. With a PATH, compares it to the baseline there and fails if anything got more expensive,
+	// or writes the baseline there if there's none yet.
+	bool costReport = false;
+	std::string costBaselinePath;
+
+	// --remarks: Explains each function's stack frame as the code generator lays it out, by source line: what the locals take
+	// up, how many temporaries every statement uses, what the loops reserve for their iteration variables, and which calls
+	// need the stack padded. The IR path(--via-ir and -O1 and above) doesn't, so there it only warns.
+	bool remarks = false;
+
+	// --emit-ir: Prints every function's IR, see IR/IR.h, as it's built from the AST.
+	bool emitIR = false;
+
+	// --via-ir: Generates the assembly from the IR(see code_generator/IRLowering.h) instead of straight from the AST.
+	bool viaIR = false;
+
+	// -O1, -O2, -Os: Optimizes the IR before generating the assembly from it, so everything but -O0(the default) goes via the IR.
+	OptLevel optLevel = OptLevel::O0;
+
+	// --pass-stats: Prints how often every optimization pass ran, what it changed and how long it took, and how often the
+	// analyses they share were computed.
+	bool passStats = false;
+
+	// --disable-pass=NAME: Leaves the pass out of the optimization level's pipeline. May be given more than once.
+	std::vector<std::string> disabledPasses;
+
+	// --print-after=NAME: Prints the IR after every run of the pass, or of every pass for "all". May be given more than once.
+	std::vector<std::string> printAfterPasses;
+
+	bool IsViaIR(void) const { return viaIR || optLevel != OptLevel::O0; }
+};
+
+// Global options instance, filled in once by main(), or per request by the compile server.
+inline CompilerOptions g_options;
+
+// Parses argv[firstOption] and onward into outOptions. Returns false if an option is not recognized.
+bool ParseOptions(const i32 argc, char** argv, const i32 firstOption, CompilerOptions& outOptions);
+
+// The options that change the generated code, spelled out for use in cache keys. Options that only change how the compiler
+// gets there(threading, caching and such) are left out, so they don't split the cache.
+std::string GetOutputAffectingOptions(const CompilerOptions& options);
+
+// Prints every available option, for the usage message.
+void PrintOptionsUsage(void);
\ No newline at end of file
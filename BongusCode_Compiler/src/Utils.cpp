@@ -2,7 +2,136 @@
 #include <iostream>
 #include <filesystem>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 void Utils::PrintCurrentWorkingDirectory(void)
 {
 	std::cout << "Current working directory:\n" << std::filesystem::current_path() << std::endl;
 }
+
+ui64 Utils::HashFNV1a(const void* data, const ui64 size, const ui64 seed)
+{
+	const ui8* bytes = (const ui8*)data;
+	ui64 hash = seed;
+
+	for (ui64 i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ull;
+	}
+
+	return hash;
+}
+
+Utils::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool Utils::MappedFile::Open(const char* path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		Close();
+		return false;
+	}
+	size = (ui64)fileSize.QuadPart;
+
+	// Empty files can't be mapped, but there's nothing to map anyway.
+	if (size == 0)
+	{
+		return true;
+	}
+
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	data = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	fileDescriptor = open(path, O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fileDescriptor, &fileStat) != 0)
+	{
+		Close();
+		return false;
+	}
+	size = (ui64)fileStat.st_size;
+
+	if (size == 0)
+	{
+		return true;
+	}
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	data = mapping == MAP_FAILED ? nullptr : (const char*)mapping;
+#endif
+
+	if (data == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void Utils::MappedFile::Close(void)
+{
+#ifdef _WIN32
+	if (data != nullptr)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle != nullptr)
+	{
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != nullptr)
+	{
+		CloseHandle(fileHandle);
+	}
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	if (data != nullptr)
+	{
+		munmap((void*)data, size);
+	}
+	if (fileDescriptor >= 0)
+	{
+		close(fileDescriptor);
+	}
+	fileDescriptor = -1;
+#endif
+
+	data = nullptr;
+	size = 0;
+}
\ No newline at end of file
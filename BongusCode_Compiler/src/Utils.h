@@ -1,6 +1,7 @@
 #pragma once
 #include <stdlib.h>
 #include <stdio.h>
+#include "Definitions.h"
 
 #ifdef _DEBUG
 #define DoIfDebug(x) x
@@ -26,4 +27,36 @@
 namespace Utils
 {
 	void PrintCurrentWorkingDirectory(void);
+
+	// 64-bit FNV-1a. Pass the result of a previous call as seed to hash several pieces as if they were one.
+	constexpr ui64 s_fnvOffsetBasis = 0xCBF29CE484222325ull;
+	ui64 HashFNV1a(const void* data, const ui64 size, const ui64 seed = s_fnvOffsetBasis);
+
+	// A read-only memory mapping of an entire file.
+	class MappedFile
+	{
+	public:
+
+		MappedFile() = default;
+		~MappedFile();
+
+		// Returns false if the file couldn't be opened or mapped.
+		bool Open(const char* path);
+		void Close(void);
+
+		inline const char* GetData(void) const { return data; }
+		inline const ui64 GetSize(void) const { return size; }
+
+	private:
+
+		const char* data = nullptr;
+		ui64 size = 0;
+
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		i32 fileDescriptor = -1;
+#endif
+	};
 }
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "CompileCache.h"
+#include "../BuildSettings.h"
+#include "../Options.h"
+#include "../Utils.h"
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <chrono>
+
+// How long to wait for the lock before giving up on it, and how old a lock has to be before it's considered abandoned.
+static constexpr ui32 s_lockAttempts = 2000;
+static constexpr std::chrono::seconds s_staleLockAge(10);
+
+// Holds the cache's lock for as long as it lives. Creating a directory is atomic everywhere, so the lock is a directory.
+class CacheLock
+{
+public:
+
+	CacheLock(const std::filesystem::path& c_path) : path(c_path)
+	{
+		for (ui32 attempt = 0; attempt < s_lockAttempts; attempt++)
+		{
+			std::error_code error;
+			if (std::filesystem::create_directory(path, error))
+			{
+				isLocked = true;
+				return;
+			}
+
+			// A process that died while holding the lock would otherwise lock everybody out for good.
+			const std::filesystem::file_time_type lockTime = std::filesystem::last_write_time(path, error);
+			if (!error && std::filesystem::file_time_type::clock::now() - lockTime > s_staleLockAge)
+			{
+				std::filesystem::remove(path, error);
+				continue;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	~CacheLock()
+	{
+		if (isLocked)
+		{
+			std::error_code ignored;
+			std::filesystem::remove(path, ignored);
+		}
+	}
+
+	inline bool IsLocked(void) const { return isLocked; }
+
+private:
+
+	std::filesystem::path path;
+	bool isLocked = false;
+};
+
+// A name no other process will come up with, for writing a file before it's renamed into place.
+static std::filesystem::path MakeTemporaryPath(const std::filesystem::path& path)
+{
+	static std::random_device s_randomDevice;
+	std::mt19937_64 generator(((ui64)s_randomDevice() << 32) ^ s_randomDevice() ^ (ui64)std::chrono::steady_clock::now().time_since_epoch().count());
+
+	std::filesystem::path temporaryPath = path;
+	temporaryPath += ".tmp" + std::to_string(generator());
+	return temporaryPath;
+}
+
+bool Cache::CompileCache::Open(const std::string& c_directory, const ui64 c_maxSize)
+{
+	std::error_code error;
+
+	if (c_directory.empty())
+	{
+		directory = std::filesystem::temp_directory_path(error) / "BongusCodeCache";
+		if (error)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		directory = c_directory;
+	}
+
+	std::filesystem::create_directories(directory, error);
+	if (error)
+	{
+		return false;
+	}
+
+	maxSize = c_maxSize;
+	isOpen = true;
+	return true;
+}
+
+ui64 Cache::CompileCache::ComputeKey(const char* source, const ui64 size, const CompilerOptions& options)
+{
+	const std::string version = COMPILER_VERSION;
+	const std::string outputOptions = GetOutputAffectingOptions(options);
+
+	ui64 key = Utils::HashFNV1a(source, size);
+	key = Utils::HashFNV1a(version.c_str(), version.length() + 1, key);
+	key = Utils::HashFNV1a(outputOptions.c_str(), outputOptions.length() + 1, key);
+
+	// Imported declarations go into the output as much as the source does, so the interfaces are part of the key too.
+	for (const std::string& import : options.imports)
+	{
+		Utils::MappedFile interfaceFile;
+		if (interfaceFile.Open(import.c_str()))
+		{
+			key = Utils::HashFNV1a(interfaceFile.GetData(), interfaceFile.GetSize(), key);
+		}
+		else
+		{
+			key = Utils::HashFNV1a(import.c_str(), import.length() + 1, key);
+		}
+	}
+
+	return key;
+}
+
+std::filesystem::path Cache::CompileCache::GetEntryPath(const ui64 key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.asm", key);
+
+	return directory / name;
+}
+
+bool Cache::CompileCache::Fetch(const ui64 key, const char* outputPath)
+{
+	const std::filesystem::path entryPath = GetEntryPath(key);
+
+	std::error_code error;
+	std::filesystem::copy_file(entryPath, outputPath, std::filesystem::copy_options::overwrite_existing, error);
+
+	const bool hit = !error;
+	if (hit)
+	{
+		// Eviction goes by modification time, so a hit marks the output as recently used.
+		std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), error);
+	}
+
+	CacheLock lock(directory / "lock");
+	if (lock.IsLocked())
+	{
+		CacheStats delta;
+		delta.hits = hit ? 1 : 0;
+		delta.misses = hit ? 0 : 1;
+		UpdateStats(delta);
+	}
+
+	return hit;
+}
+
+void Cache::CompileCache::Store(const ui64 key, const char* outputPath)
+{
+	const std::filesystem::path entryPath = GetEntryPath(key);
+	const std::filesystem::path temporaryPath = MakeTemporaryPath(entryPath);
+
+	std::error_code error;
+	std::filesystem::copy_file(outputPath, temporaryPath, std::filesystem::copy_options::overwrite_existing, error);
+	if (!error)
+	{
+		// If another process got there first, its output is just as good as ours.
+		std::filesystem::rename(temporaryPath, entryPath, error);
+	}
+
+	if (error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return;
+	}
+
+	CacheLock lock(directory / "lock");
+	if (!lock.IsLocked())
+	{
+		return;
+	}
+
+	CacheStats delta;
+	delta.stores = 1;
+	delta.evictions = EvictLeastRecentlyUsed();
+	UpdateStats(delta);
+}
+
+Cache::CacheStats Cache::CompileCache::UpdateStats(const CacheStats& delta)
+{
+	const std::string statsPath = (directory / "stats").string();
+
+	CacheStats stats;
+	FILE* statsFile = fopen(statsPath.c_str(), "r");
+	if (statsFile != nullptr)
+	{
+		if (fscanf(statsFile, "%llu %llu %llu %llu", &stats.hits, &stats.misses, &stats.stores, &stats.evictions) != 4)
+		{
+			stats = CacheStats();
+		}
+		fclose(statsFile);
+	}
+
+	if (delta.hits == 0 && delta.misses == 0 && delta.stores == 0 && delta.evictions == 0)
+	{
+		return stats;
+	}
+
+	stats.hits += delta.hits;
+	stats.misses += delta.misses;
+	stats.stores += delta.stores;
+	stats.evictions += delta.evictions;
+
+	statsFile = fopen(statsPath.c_str(), "w");
+	if (statsFile != nullptr)
+	{
+		fprintf(statsFile, "%llu %llu %llu %llu\n", stats.hits, stats.misses, stats.stores, stats.evictions);
+		fclose(statsFile);
+	}
+
+	return stats;
+}
+
+ui64 Cache::CompileCache::EvictLeastRecentlyUsed(void)
+{
+	struct Entry
+	{
+		std::filesystem::file_time_type lastUsed;
+		ui64 size;
+		std::filesystem::path path;
+	};
+
+	std::vector<Entry> entries;
+	ui64 totalSize = 0;
+
+	std::error_code error;
+	for (const std::filesystem::directory_entry& directoryEntry : std::filesystem::directory_iterator(directory, error))
+	{
+		if (directoryEntry.path().extension() != ".asm")
+		{
+			continue;
+		}
+
+		Entry entry;
+		entry.lastUsed = directoryEntry.last_write_time(error);
+		entry.size = directoryEntry.file_size(error);
+		entry.path = directoryEntry.path();
+		if (error)
+		{
+			// Gone already.
+			continue;
+		}
+
+		totalSize += entry.size;
+		entries.push_back(std::move(entry));
+	}
+
+	if (totalSize <= maxSize)
+	{
+		return 0;
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
+
+	ui64 evictions = 0;
+	for (const Entry& entry : entries)
+	{
+		if (totalSize <= maxSize)
+		{
+			break;
+		}
+
+		if (std::filesystem::remove(entry.path, error))
+		{
+			totalSize -= entry.size;
+			evictions++;
+		}
+	}
+
+	return evictions;
+}
+
+void Cache::CompileCache::PrintStats(void)
+{
+	CacheStats stats;
+	{
+		CacheLock lock(directory / "lock");
+		if (lock.IsLocked())
+		{
+			stats = UpdateStats(CacheStats());
+		}
+	}
+
+	ui64 outputCount = 0;
+	ui64 totalSize = 0;
+
+	std::error_code error;
+	for (const std::filesystem::directory_entry& directoryEntry : std::filesystem::directory_iterator(directory, error))
+	{
+		if (directoryEntry.path().extension() == ".asm")
+		{
+			outputCount++;
+			totalSize += directoryEntry.file_size(error);
+		}
+	}
+
+	const ui64 lookups = stats.hits + stats.misses;
+	wprintf(L"CACHE: %llu hits, %llu misses(%.1f%% hit rate), %llu stores, %llu evictions. %llu outputs taking %.2f of %.2f MB.\n",
+		stats.hits, stats.misses, lookups != 0 ? 100.0 * stats.hits / lookups : 0.0, stats.stores, stats.evictions,
+		outputCount, totalSize / 1048576.0, maxSize / 1048576.0);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <filesystem>
+#include "../Definitions.h"
+
+struct CompilerOptions;
+
+/*
+	Content-addressed cache of compiled translation units.
+	Outputs are stored under a hash of the source bytes, the imported module interfaces, the compiler version and the options
+	that affect the generated code, so an unchanged source compiles to a copy out of the cache, no matter where or when it was compiled before.
+
+	The cache directory may be shared by any number of compiler processes at once:
+	- Outputs are written to a temporary file first and renamed into place, so nobody ever reads a half written output.
+	- Reading an output that is being evicted at the same time simply fails, which counts as a miss.
+	- The statistics and the eviction are guarded by a lock, which is broken if its owner seems to have died.
+	  The statistics are best effort: if the lock can't be had in time, the lookup just isn't counted.
+*/
+namespace Cache
+{
+	struct CacheStats
+	{
+		ui64 hits = 0;
+		ui64 misses = 0;
+		ui64 stores = 0;
+		ui64 evictions = 0;
+	};
+
+	class CompileCache
+	{
+	public:
+
+		CompileCache() = default;
+		~CompileCache() = default;
+
+		// Creates the directory if needed. An empty directory picks the default one in the temp directory.
+		// Returns false if the cache can't be used, in which case compiling just goes on without it.
+		bool Open(const std::string& directory, const ui64 maxSize);
+		inline bool IsOpen(void) const { return isOpen; }
+
+		static ui64 ComputeKey(const char* source, const ui64 size, const CompilerOptions& options);
+
+		// Copies the output cached under key to outputPath. Returns false on a miss.
+		bool Fetch(const ui64 key, const char* outputPath);
+
+		// Caches the output at outputPath under key, and evicts the least recently used outputs if the cache has grown too large.
+		void Store(const ui64 key, const char* outputPath);
+
+		void PrintStats(void);
+
+	private:
+
+		std::filesystem::path GetEntryPath(const ui64 key) const;
+
+		// Adds delta to the statistics on disk, and returns the new totals. Must be called with the lock held.
+		CacheStats UpdateStats(const CacheStats& delta);
+
+		// Deletes the least recently used outputs until the cache is under its maximum size again. Returns how many were deleted.
+		// Must be called with the lock held.
+		ui64 EvictLeastRecentlyUsed(void);
+
+		std::filesystem::path directory;
+		ui64 maxSize = 0;
+		bool isOpen = false;
+	};
+}
\ No newline at end of file
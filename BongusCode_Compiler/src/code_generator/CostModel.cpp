@@ -0,0 +1,305 @@
+#include "CostModel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fstream>
+#include <unordered_map>
+#include <algorithm>
+
+// Instructions that only read their first operand, even when it's in memory.
+static constexpr const char* s_readOnlyMnemonics[] = { "cmp", "test", "push" };
+
+static bool StartsWith(const std::string& text, const char* prefix)
+{
+	return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+static bool EndsWith(const std::string& text, const char* suffix)
+{
+	const ui64 suffixLength = strlen(suffix);
+	return text.size() >= suffixLength && text.compare(text.size() - suffixLength, suffixLength, suffix) == 0;
+}
+
+// Strips the comment and the surrounding whitespace off an assembly line.
+static std::string StripLine(const std::string& line)
+{
+	std::string stripped = line.substr(0, line.find(';'));
+
+	const ui64 begin = stripped.find_first_not_of(" \t\r");
+	if (begin == std::string::npos)
+	{
+		return std::string();
+	}
+	const ui64 end = stripped.find_last_not_of(" \t\r");
+
+	return stripped.substr(begin, end - begin + 1);
+}
+
+static void CountInstruction(const std::string& instruction, CostModel::Cost& outCost)
+{
+	const ui64 mnemonicEnd = instruction.find(' ');
+	const std::string mnemonic = instruction.substr(0, mnemonicEnd);
+	const std::string operands = mnemonicEnd == std::string::npos ? std::string() : instruction.substr(mnemonicEnd + 1);
+
+	const ui64 comma = operands.find(',');
+	const std::string destination = operands.substr(0, comma);
+	const std::string source = comma == std::string::npos ? std::string() : operands.substr(comma + 1);
+
+	outCost.instructions++;
+
+	if (mnemonic == "call")
+	{
+		outCost.calls++;
+	}
+	else if (mnemonic[0] == 'j')
+	{
+		outCost.branches++;
+	}
+
+	// The stack operations touch memory without spelling it out.
+	if (mnemonic == "push")
+	{
+		outCost.stores++;
+	}
+	else if (mnemonic == "pop")
+	{
+		outCost.loads++;
+	}
+
+	// lea only computes an address.
+	if (mnemonic == "lea")
+	{
+		return;
+	}
+
+	if (source.find('[') != std::string::npos)
+	{
+		outCost.loads++;
+	}
+
+	if (destination.find('[') != std::string::npos)
+	{
+		bool isReadOnly = false;
+		for (const char* readOnlyMnemonic : s_readOnlyMnemonics)
+		{
+			isReadOnly |= mnemonic == readOnlyMnemonic;
+		}
+
+		if (isReadOnly) { outCost.loads++; }
+		else { outCost.stores++; }
+	}
+}
+
+bool CostModel::MeasureAssembly(const char* asmPath, std::vector<Row>& outRows)
+{
+	std::ifstream asmFile(asmPath);
+	if (!asmFile)
+	{
+		return false;
+	}
+
+	// Index of the function being read in outRows, and of its loops that are open, innermost last, along with their numbers.
+	ui64 functionRow = ~0ull;
+	std::vector<ui64> openLoopRows;
+	std::vector<std::string> openLoopNumbers;
+	bool isInPrologue = false;
+
+	std::string line;
+	while (std::getline(asmFile, line))
+	{
+		const std::string stripped = StripLine(line);
+		if (stripped.empty())
+		{
+			continue;
+		}
+
+		// "name PROC", not "EXTERN name : PROC".
+		if (EndsWith(stripped, " PROC") && stripped.find(' ') == stripped.size() - strlen(" PROC"))
+		{
+			Row row;
+			row.name = stripped.substr(0, stripped.size() - strlen(" PROC"));
+			functionRow = outRows.size();
+			outRows.push_back(row);
+			isInPrologue = true;
+			continue;
+		}
+
+		if (functionRow == ~0ull)
+		{
+			// The header, between functions.
+			continue;
+		}
+
+		if (EndsWith(stripped, " ENDP"))
+		{
+			functionRow = ~0ull;
+			openLoopRows.clear();
+			openLoopNumbers.clear();
+			continue;
+		}
+
+		if (stripped.back() == ':')
+		{
+			// Loop labels are "LHn@function", "LBn@function" and "LEn@function". The head runs every iteration too, so a loop
+			// is counted from whichever of its head and its body comes first, the code generator puts the head first and
+			// --via-ir the body.
+			const std::string label = stripped.substr(0, stripped.size() - 1);
+			const std::string loopNumber = label.substr(2, label.find('@') - 2);
+			const bool isOpen = std::find(openLoopNumbers.begin(), openLoopNumbers.end(), loopNumber) != openLoopNumbers.end();
+			if ((StartsWith(label, "LH") || StartsWith(label, "LB")) && !isOpen)
+			{
+				Row row;
+				row.name = outRows[functionRow].name + ":loop" + loopNumber;
+				row.depth = (ui32)openLoopRows.size() + 1;
+				openLoopRows.push_back(outRows.size());
+				openLoopNumbers.push_back(loopNumber);
+				outRows.push_back(row);
+			}
+			else if (StartsWith(label, "LE") && !openLoopRows.empty())
+			{
+				openLoopRows.pop_back();
+				openLoopNumbers.pop_back();
+			}
+			continue;
+		}
+
+		// The prologue is push rbp, mov rbp, rsp, the callee-saved registers being pushed and the stack frame's sections being
+		// allocated.
+		if (isInPrologue)
+		{
+			if (StartsWith(stripped, "sub rsp,"))
+			{
+				outRows[functionRow].frameBytes += strtoll(stripped.c_str() + strlen("sub rsp,"), nullptr, 10);
+			}
+			else if (StartsWith(stripped, "push ") && stripped != "push rbp")
+			{
+				outRows[functionRow].frameBytes += 8;
+			}
+			else if (stripped != "push rbp" && stripped != "mov rbp, rsp")
+			{
+				isInPrologue = false;
+			}
+		}
+
+		CountInstruction(stripped, outRows[functionRow].cost);
+		for (const ui64 loopRow : openLoopRows)
+		{
+			CountInstruction(stripped, outRows[loopRow].cost);
+		}
+	}
+
+	return true;
+}
+
+void CostModel::PrintReport(const std::vector<Row>& rows)
+{
+	wprintf(L"COST: %-40S %8S %8S %8S %8S %8S %8S\n", "Function / loop", "Instrs", "Loads", "Stores", "Calls", "Branches", "Frame");
+	for (const Row& row : rows)
+	{
+		// Loops are indented under their function by how deep they're nested.
+		const std::string name = std::string(row.depth * 2, ' ') + row.name;
+		wprintf(L"COST: %-40S %8llu %8llu %8llu %8llu %8llu ", name.c_str(), row.cost.instructions, row.cost.loads, row.cost.stores,
+			row.cost.calls, row.cost.branches);
+
+		if (row.depth == 0) { wprintf(L"%8lld\n", row.frameBytes); }
+		else { wprintf(L"%8S\n", "-"); }
+	}
+}
+
+bool CostModel::WriteBaseline(const std::string& baselinePath, const std::vector<Row>& rows)
+{
+	FILE* baselineFile = fopen(baselinePath.c_str(), "w");
+	if (baselineFile == nullptr)
+	{
+		return false;
+	}
+
+	fprintf(baselineFile, "# name depth instructions loads stores calls branches frameBytes\n");
+	for (const Row& row : rows)
+	{
+		fprintf(baselineFile, "%s %u %llu %llu %llu %llu %llu %lld\n", row.name.c_str(), row.depth, row.cost.instructions, row.cost.loads,
+			row.cost.stores, row.cost.calls, row.cost.branches, row.frameBytes);
+	}
+
+	return fclose(baselineFile) == 0;
+}
+
+bool CostModel::ReadBaseline(const std::string& baselinePath, std::vector<Row>& outRows)
+{
+	std::ifstream baselineFile(baselinePath);
+	if (!baselineFile)
+	{
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(baselineFile, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		char name[1024];
+		Row row;
+		if (sscanf(line.c_str(), "%1023s %u %llu %llu %llu %llu %llu %lld", name, &row.depth, &row.cost.instructions, &row.cost.loads,
+			&row.cost.stores, &row.cost.calls, &row.cost.branches, &row.frameBytes) != 8)
+		{
+			return false;
+		}
+		row.name = name;
+		outRows.push_back(row);
+	}
+
+	return true;
+}
+
+ui64 CostModel::CompareToBaseline(const std::vector<Row>& rows, const std::vector<Row>& baselineRows)
+{
+	std::unordered_map<std::string, const Row*> baselineByName;
+	for (const Row& baselineRow : baselineRows)
+	{
+		baselineByName[baselineRow.name] = &baselineRow;
+	}
+
+	ui64 regressionCount = 0;
+	for (const Row& row : rows)
+	{
+		const auto found = baselineByName.find(row.name);
+		if (found == baselineByName.end())
+		{
+			wprintf(L"COST: %S is new, it's not in the baseline.\n", row.name.c_str());
+			continue;
+		}
+		const Row& baselineRow = *found->second;
+		baselineByName.erase(found);
+
+		const struct { const char* name; i64 now; i64 before; } figures[] =
+		{
+			{ "instructions", (i64)row.cost.instructions, (i64)baselineRow.cost.instructions },
+			{ "loads", (i64)row.cost.loads, (i64)baselineRow.cost.loads },
+			{ "stores", (i64)row.cost.stores, (i64)baselineRow.cost.stores },
+			{ "calls", (i64)row.cost.calls, (i64)baselineRow.cost.calls },
+			{ "branches", (i64)row.cost.branches, (i64)baselineRow.cost.branches },
+			{ "frame bytes", row.frameBytes, baselineRow.frameBytes },
+		};
+
+		bool isRegression = false;
+		for (const auto& figure : figures)
+		{
+			if (figure.now != figure.before)
+			{
+				wprintf(L"COST: %S %S: %lld, was %lld.\n", row.name.c_str(), figure.name, figure.now, figure.before);
+				isRegression |= figure.now > figure.before;
+			}
+		}
+		regressionCount += isRegression ? 1 : 0;
+	}
+
+	for (const auto& [name, baselineRow] : baselineByName)
+	{
+		wprintf(L"COST: %S is gone, it's only in the baseline.\n", name.c_str());
+	}
+
+	return regressionCount;
+}
\ No newline at end of file
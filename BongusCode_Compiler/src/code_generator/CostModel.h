@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../Definitions.h"
+
+/*
+	Static cost model of the generated assembly, for --cost-report.
+
+	Nothing is assembled or run, the costs are counted off the assembly text: instructions, memory loads and stores, calls and
+	branches, per function and per For loop body, and the stack frame each function sets up in its prologue(the callee-saved
+	registers it saves, its locals' section and its temporaries' section). That's enough to tell whether a change to the code generator made the code it
+	emits better or worse, on a machine that can't run it.
+
+	A load or a store is an instruction with a memory operand it reads or writes, push and pop included. A loop runs from its
+	LH label(the increment and the test every iteration goes through) or its LB label(its body), whichever comes first, to its
+	LE label, so it includes the loops nested in it.
+*/
+namespace CostModel
+{
+	struct Cost
+	{
+		ui64 instructions = 0;
+		ui64 loads = 0;
+		ui64 stores = 0;
+		ui64 calls = 0;
+		ui64 branches = 0;
+	};
+
+	// A function, or a loop body in one, named "function:loopN" after the number the code generator gave the loop.
+	struct Row
+	{
+		std::string name;
+
+		// 0 for functions, 1 for the loops directly in them and so on.
+		ui32 depth = 0;
+		Cost cost;
+
+		// Only for functions.
+		i64 frameBytes = 0;
+	};
+
+	// Counts the costs of the assembly in the file at asmPath, in the order the functions and loops appear in it.
+	// Returns false if the file couldn't be read.
+	bool MeasureAssembly(const char* asmPath, std::vector<Row>& outRows);
+
+	void PrintReport(const std::vector<Row>& rows);
+
+	// Baselines are plain text, a row per line, so changes to them read well in a diff.
+	bool WriteBaseline(const std::string& baselinePath, const std::vector<Row>& rows);
+	bool ReadBaseline(const std::string& baselinePath, std::vector<Row>& outRows);
+
+	// Prints every row whose costs changed from the baseline, and returns how many of them got more expensive.
+	ui64 CompareToBaseline(const std::vector<Row>& rows, const std::vector<Row>& baselineRows);
+}
\ No newline at end of file
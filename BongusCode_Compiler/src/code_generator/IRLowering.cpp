@@ -0,0 +1,1088 @@
+#include "IRLowering.h"
+#include "Registers.h"
+#include "StrengthReduction.h"
+#include "../IR/IR.h"
+#include "../symbol_table/symtable.h"
+#include "../Exit.h"
+#include "../Utils.h"
+#include <algorithm>
+#include <unordered_map>
+
+// Calls clobber these, so they go to the values no call happens during first.
+static constexpr RG s_callClobberedRegisters[] = { RG::R8, RG::R9, RG::R10, RG::R11 };
+static constexpr RG s_calleeSavedRegisters[] = { RG::RBX, RG::RSI, RG::RDI, RG::R12, RG::R13, RG::R14, RG::R15 };
+static constexpr RG s_argumentRegisters[] = { RG::RCX, RG::RDX, RG::R8, RG::R9 };
+
+// How much more a use counts for every loop around it. Deeper than this, everything's about as hot.
+static constexpr ui64 s_loopWeights[] = { 1, 10, 100, 1000, 10000 };
+
+// External C functions may store their register arguments in the 32 bytes above their return address.
+static constexpr i32 s_shadowSpaceSize = 32;
+
+// Where a value is kept for all of its life, a register, or the stack offset bytes above rsp.
+struct Home
+{
+	RG reg = RG::size;
+	i32 offset = -1;
+
+	bool IsRegister(void) const { return reg != RG::size; }
+	bool IsSet(void) const { return reg != RG::size || offset >= 0; }
+	bool operator==(const Home& other) const { return reg == other.reg && offset == other.offset; }
+};
+
+struct LiveInterval
+{
+	const IR::Instruction* value = nullptr;
+	ui32 start = 0;
+	ui32 end = 0;
+	ui64 weight = 0;
+	bool crossesCall = false;
+	bool isUsed = false;
+};
+
+// A copy to dest, one of a parallel move. A value that isn't kept anywhere(no source) is computed into dest instead.
+struct Move
+{
+	Home dest;
+	Home source;
+	const IR::Instruction* value = nullptr;
+};
+
+struct Lowering
+{
+	explicit Lowering(const IR::Function& function) : function(function) {}
+
+	const IR::Function& function;
+	std::string code;
+
+	// By value id.
+	std::vector<Home> homes;
+	std::vector<i32> slotOffsets;
+
+	ui32 stubsMade = 0;
+	bool isReturnLabelUsed = false;
+};
+
+// Constants, undefined values and the addresses of slots are computed where they're used.
+static bool IsKeptSomewhere(const IR::Instruction* value)
+{
+	return value->HasValue() && value->op != IR::Opcode::Const && value->op != IR::Opcode::Undef && value->op != IR::Opcode::Slot;
+}
+
+// Fits in the sign extended 32 bit immediate of a 64 bit instruction.
+static bool IsImmediate(const IR::Instruction* value)
+{
+	return value->op == IR::Opcode::Const && value->constant >= INT32_MIN && value->constant <= INT32_MAX;
+}
+
+static bool IsCalleeSaved(const RG reg)
+{
+	return std::find(std::begin(s_calleeSavedRegisters), std::end(s_calleeSavedRegisters), reg) != std::end(s_calleeSavedRegisters);
+}
+
+static std::string GetReg(const RG reg, const ui32 size = 8)
+{
+	const ui16 subscript = size == 8 ? 0 : size == 4 ? 1 : size == 2 ? 2 : 3;
+	return Registers::Regs[(ui64)reg][subscript];
+}
+
+static std::string GetWordKind(const ui32 size)
+{
+	switch (size)
+	{
+	case 1: return "BYTE PTR";
+	case 2: return "WORD PTR";
+	case 4: return "DWORD PTR";
+	default: return "QWORD PTR";
+	}
+}
+
+static std::string RefStack(const i32 offset, const ui32 size = 8)
+{
+	return GetWordKind(size) + " " + std::to_string(offset) + "[rsp]";
+}
+
+static std::string RefHome(const Home& home)
+{
+	return home.IsRegister() ? GetReg(home.reg) : RefStack(home.offset);
+}
+
+static void Emit(Lowering& l, const std::string& line)
+{
+	l.code += line + "\n";
+}
+
+static std::string GetLabel(const Lowering& l, const IR::Block* block)
+{
+	return IR::GetBlockLabel(block, l.function.name);
+}
+
+static const Home& GetHome(const Lowering& l, const IR::Instruction* value)
+{
+	return l.homes[value->id];
+}
+
+static void MoveInto(Lowering& l, const RG reg, const IR::Instruction* value)
+{
+	switch (value->op)
+	{
+	case IR::Opcode::Const:
+	{
+		Emit(l, "mov " + GetReg(reg) + ", " + std::to_string(value->constant));
+		break;
+	}
+	case IR::Opcode::Undef:
+	{
+		// Whatever's in it will do.
+		break;
+	}
+	case IR::Opcode::Slot:
+	{
+		Emit(l, "lea " + GetReg(reg) + ", " + RefStack(l.slotOffsets[value->id]));
+		break;
+	}
+	default:
+	{
+		const Home& home = GetHome(l, value);
+		if (home.reg != reg)
+		{
+			Emit(l, "mov " + GetReg(reg) + ", " + RefHome(home));
+		}
+		break;
+	}
+	}
+}
+
+// The value as the second operand of a 64 bit instruction: an immediate, its register or its stack slot, or scratch it's
+// computed into.
+static std::string GetOperand(Lowering& l, const IR::Instruction* value, const RG scratch)
+{
+	if (IsImmediate(value))
+	{
+		return std::to_string(value->constant);
+	}
+	if (IsKeptSomewhere(value))
+	{
+		return RefHome(GetHome(l, value));
+	}
+	MoveInto(l, scratch, value);
+	return GetReg(scratch);
+}
+
+// Where an instruction computes its value, its register, or RAX when it's kept on the stack.
+static RG GetTarget(const Lowering& l, const IR::Instruction* instruction)
+{
+	const Home& home = GetHome(l, instruction);
+	return home.IsRegister() ? home.reg : RG::RAX;
+}
+
+static void StoreResult(Lowering& l, const IR::Instruction* instruction, const RG reg)
+{
+	const Home& home = GetHome(l, instruction);
+	if (home.reg != reg)
+	{
+		Emit(l, "mov " + RefHome(home) + ", " + GetReg(reg));
+	}
+}
+
+// target = the source truncated to size bytes, and zero extended.
+static void EmitTruncation(Lowering& l, const RG target, const Home& source, const ui32 size)
+{
+	const std::string from = source.IsRegister() ? GetReg(source.reg, size) : RefStack(source.offset, size);
+	if (size == 4)
+	{
+		// Writing the lower half of a register clears the upper half.
+		Emit(l, "mov " + GetReg(target, 4) + ", " + from);
+	}
+	else
+	{
+		Emit(l, "movzx " + GetReg(target) + ", " + from);
+	}
+}
+
+static void EmitMove(Lowering& l, const Move& move)
+{
+	if (move.dest.IsRegister())
+	{
+		if (move.source.IsSet())
+		{
+			Emit(l, "mov " + GetReg(move.dest.reg) + ", " + RefHome(move.source));
+		}
+		else
+		{
+			MoveInto(l, move.dest.reg, move.value);
+		}
+		return;
+	}
+
+	if (move.source.IsRegister())
+	{
+		Emit(l, "mov " + RefHome(move.dest) + ", " + GetReg(move.source.reg));
+		return;
+	}
+	if (!move.source.IsSet() && IsImmediate(move.value))
+	{
+		Emit(l, "mov " + RefHome(move.dest) + ", " + std::to_string(move.value->constant));
+		return;
+	}
+
+	// From the stack to the stack, through RCX. Parallel moves into the stack never read RCX.
+	if (move.source.IsSet())
+	{
+		Emit(l, "mov RCX, " + RefHome(move.source));
+	}
+	else
+	{
+		MoveInto(l, RG::RCX, move.value);
+	}
+	Emit(l, "mov " + RefHome(move.dest) + ", RCX");
+}
+
+// Makes every copy as if they all happened at once: a copy only overwrites a place once nothing else left to do reads it, and
+// when every place left is still to be read, they're copies round in circles, one of which is broken through RAX.
+static void EmitParallelMove(Lowering& l, const std::vector<Move>& moves)
+{
+	std::vector<Move> pending;
+	for (const Move& move : moves)
+	{
+		const bool isNothingToDo = move.source.IsSet() ? move.source == move.dest : move.value->op == IR::Opcode::Undef;
+		if (!isNothingToDo)
+		{
+			pending.push_back(move);
+		}
+	}
+
+	const auto isRead = [&pending](const Home& place, const ui64 except) {
+		for (ui64 i = 0; i < pending.size(); i++)
+		{
+			if (i != except && pending[i].source.IsSet() && pending[i].source == place)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	while (!pending.empty())
+	{
+		ui64 free = 0;
+		while (free < pending.size() && isRead(pending[free].dest, free))
+		{
+			free++;
+		}
+
+		if (free == pending.size())
+		{
+			// Every copy left is part of a cycle, the first one's place is read from RAX instead.
+			const Home saved = pending[0].dest;
+			Emit(l, "mov RAX, " + RefHome(saved));
+			for (Move& move : pending)
+			{
+				if (move.source == saved)
+				{
+					move.source = Home{ RG::RAX };
+				}
+			}
+			free = 0;
+		}
+
+		EmitMove(l, pending[free]);
+		pending.erase(pending.begin() + free);
+	}
+}
+
+// The copies of the operands of to's phis that come from the end of from into the phis' places.
+static std::vector<Move> GetEdgeMoves(const Lowering& l, const IR::Block* from, const IR::Block* to)
+{
+	std::vector<Move> moves;
+	for (const IR::Instruction* phi : to->instructions)
+	{
+		if (phi->op != IR::Opcode::Phi)
+		{
+			break;
+		}
+		if (!GetHome(l, phi).IsSet())
+		{
+			// Never used.
+			continue;
+		}
+
+		const ui64 index = std::find(phi->blocks.begin(), phi->blocks.end(), from) - phi->blocks.begin();
+		const IR::Instruction* operand = phi->operands[index];
+		moves.push_back({ GetHome(l, phi), IsKeptSomewhere(operand) ? GetHome(l, operand) : Home{}, operand });
+	}
+	return moves;
+}
+
+static void JumpTo(Lowering& l, const IR::Block* target, const IR::Block* next)
+{
+	if (target != next)
+	{
+		Emit(l, "jmp " + GetLabel(l, target));
+	}
+}
+
+/*
+	Gives every value that's used a home, see IRLowering.h, and returns the callee-saved registers handed out in the order of
+	their numbers, and how many 8 byte stack slots the spilled values take.
+*/
+static void AllocateHomes(Lowering& l, const i32 spillsOffset, std::vector<RG>& outSavedRegisters, ui32& outSpillSlots)
+{
+	const IR::Function& function = l.function;
+
+	std::unordered_map<const IR::Block*, ui32> blockIndices;
+	for (ui32 i = 0; i < function.blocks.size(); i++)
+	{
+		blockIndices[function.blocks[i]] = i;
+	}
+
+	// Every instruction but a phi takes two positions, its operands are used at the first and it defines its value at the
+	// second. Phis define their value where their block starts, and so do parameters, which all come in at once. The values
+	// live out of a block are live at its end.
+	std::vector<ui32> positions(l.homes.size()), blockStarts(function.blocks.size()), blockEnds(function.blocks.size());
+	std::vector<ui32> callPositions;
+	ui32 position = 0;
+	for (ui32 b = 0; b < function.blocks.size(); b++)
+	{
+		blockStarts[b] = position;
+		for (const IR::Instruction* instruction : function.blocks[b]->instructions)
+		{
+			if (instruction->op != IR::Opcode::Phi)
+			{
+				position += 2;
+			}
+			positions[instruction->id] = position;
+			if (instruction->op == IR::Opcode::Call)
+			{
+				callPositions.push_back(position);
+			}
+		}
+		blockEnds[b] = position + 1;
+		position += 2;
+	}
+
+	// Liveness, as bit sets of value ids. A phi's operands are live out of the predecessors they come from rather than into
+	// the phi's block.
+	const ui64 words = (l.homes.size() + 63) / 64;
+	using Set = std::vector<ui64>;
+	const auto test = [](const Set& set, const ui32 id) { return (set[id / 64] >> (id % 64)) & 1; };
+	const auto add = [](Set& set, const ui32 id) { set[id / 64] |= 1ull << (id % 64); };
+
+	std::vector<Set> uses(function.blocks.size(), Set(words)), defs(function.blocks.size(), Set(words));
+	std::vector<Set> liveIns(function.blocks.size(), Set(words)), liveOuts(function.blocks.size(), Set(words));
+	for (ui32 b = 0; b < function.blocks.size(); b++)
+	{
+		for (const IR::Instruction* instruction : function.blocks[b]->instructions)
+		{
+			if (instruction->op != IR::Opcode::Phi)
+			{
+				for (const IR::Instruction* operand : instruction->operands)
+				{
+					if (IsKeptSomewhere(operand) && !test(defs[b], operand->id))
+					{
+						add(uses[b], operand->id);
+					}
+				}
+			}
+			if (IsKeptSomewhere(instruction))
+			{
+				add(defs[b], instruction->id);
+			}
+		}
+	}
+
+	for (bool isChanged = true; isChanged;)
+	{
+		isChanged = false;
+		for (ui32 b = (ui32)function.blocks.size(); b-- > 0;)
+		{
+			const IR::Block* block = function.blocks[b];
+			Set liveOut(words);
+			for (const IR::Block* successor : block->GetSuccessors())
+			{
+				const Set& successorLiveIn = liveIns[blockIndices.at(successor)];
+				for (ui64 w = 0; w < words; w++)
+				{
+					liveOut[w] |= successorLiveIn[w];
+				}
+				for (const IR::Instruction* phi : successor->instructions)
+				{
+					if (phi->op != IR::Opcode::Phi)
+					{
+						break;
+					}
+					for (ui64 i = 0; i < phi->operands.size(); i++)
+					{
+						if (phi->blocks[i] == block && IsKeptSomewhere(phi->operands[i]))
+						{
+							add(liveOut, phi->operands[i]->id);
+						}
+					}
+				}
+			}
+
+			Set liveIn(words);
+			for (ui64 w = 0; w < words; w++)
+			{
+				liveIn[w] = uses[b][w] | (liveOut[w] & ~defs[b][w]);
+			}
+			if (liveIn != liveIns[b] || liveOut != liveOuts[b])
+			{
+				liveIns[b] = std::move(liveIn);
+				liveOuts[b] = std::move(liveOut);
+				isChanged = true;
+			}
+		}
+	}
+
+	// Every value's interval, from its definition to the furthest it's live.
+	std::vector<LiveInterval> intervals(l.homes.size());
+	std::vector<std::vector<const IR::Instruction*>> phiUsers(l.homes.size());
+	const auto getWeight = [](const IR::Block* block) { return s_loopWeights[std::min<ui64>(block->loopDepth, GetArraySize(s_loopWeights) - 1)]; };
+	const auto extend = [&intervals](const IR::Instruction* value, const ui32 at) {
+		LiveInterval& interval = intervals[value->id];
+		interval.start = std::min(interval.start, at);
+		interval.end = std::max(interval.end, at);
+	};
+
+	for (ui32 b = 0; b < function.blocks.size(); b++)
+	{
+		for (const IR::Instruction* instruction : function.blocks[b]->instructions)
+		{
+			if (IsKeptSomewhere(instruction))
+			{
+				LiveInterval& interval = intervals[instruction->id];
+				interval.value = instruction;
+				const bool isDefinedAtStart = instruction->op == IR::Opcode::Phi || instruction->op == IR::Opcode::Param;
+				interval.start = interval.end = isDefinedAtStart ? blockStarts[b] : positions[instruction->id] + 1;
+				interval.weight = getWeight(function.blocks[b]);
+			}
+		}
+	}
+	for (ui32 b = 0; b < function.blocks.size(); b++)
+	{
+		const IR::Block* block = function.blocks[b];
+		for (const IR::Instruction* instruction : block->instructions)
+		{
+			for (ui64 i = 0; i < instruction->operands.size(); i++)
+			{
+				const IR::Instruction* operand = instruction->operands[i];
+				if (!IsKeptSomewhere(operand))
+				{
+					continue;
+				}
+
+				const bool isPhi = instruction->op == IR::Opcode::Phi;
+				const IR::Block* useBlock = isPhi ? instruction->blocks[i] : block;
+				extend(operand, isPhi ? blockEnds[blockIndices.at(useBlock)] : positions[instruction->id]);
+				intervals[operand->id].weight += getWeight(useBlock);
+				intervals[operand->id].isUsed = true;
+				if (isPhi)
+				{
+					phiUsers[operand->id].push_back(instruction);
+				}
+			}
+		}
+		for (ui32 id = 0; id < l.homes.size(); id++)
+		{
+			if (test(liveIns[b], id)) { extend(intervals[id].value, blockStarts[b]); }
+			if (test(liveOuts[b], id)) { extend(intervals[id].value, blockEnds[b]); }
+		}
+	}
+
+	std::vector<LiveInterval*> order;
+	for (LiveInterval& interval : intervals)
+	{
+		if (interval.value != nullptr && interval.isUsed)
+		{
+			const auto call = std::upper_bound(callPositions.begin(), callPositions.end(), interval.start);
+			interval.crossesCall = call != callPositions.end() && *call < interval.end;
+			order.push_back(&interval);
+		}
+	}
+	std::sort(order.begin(), order.end(), [](const LiveInterval* a, const LiveInterval* b) {
+		return a->start != b->start ? a->start < b->start : a->value->id < b->value->id;
+	});
+
+	// The registers that would save a copy: the places of the values flowing in and out of a phi, and the register of an
+	// operand the instruction is the last use of, which it can compute its value in.
+	const auto getHints = [&](const LiveInterval& interval) {
+		std::vector<RG> hints;
+		const IR::Instruction* value = interval.value;
+		if (value->op == IR::Opcode::Phi)
+		{
+			for (const IR::Instruction* operand : value->operands)
+			{
+				if (IsKeptSomewhere(operand)) { hints.push_back(GetHome(l, operand).reg); }
+			}
+		}
+		for (const IR::Instruction* phi : phiUsers[value->id])
+		{
+			hints.push_back(GetHome(l, phi).reg);
+		}
+
+		const bool isCommutative = value->op == IR::Opcode::Add || value->op == IR::Opcode::Mul || value->op == IR::Opcode::And ||
+			value->op == IR::Opcode::Or;
+		const bool computesInPlace = isCommutative || value->op == IR::Opcode::Sub || value->op == IR::Opcode::Shl ||
+			value->op == IR::Opcode::Shr || value->op == IR::Opcode::Trunc || value->op == IR::Opcode::Load;
+		for (ui64 i = 0; computesInPlace && i < (isCommutative ? 2 : 1); i++)
+		{
+			const IR::Instruction* operand = value->operands[i];
+			if (IsKeptSomewhere(operand) && intervals[operand->id].end == positions[value->id])
+			{
+				hints.push_back(GetHome(l, operand).reg);
+			}
+		}
+		return hints;
+	};
+
+	std::vector<LiveInterval*> active, spilled;
+	for (LiveInterval* interval : order)
+	{
+		active.erase(std::remove_if(active.begin(), active.end(), [interval](const LiveInterval* a) { return a->end < interval->start; }), active.end());
+
+		const auto isFree = [&](const RG reg) {
+			if (reg == RG::size || (interval->crossesCall && !IsCalleeSaved(reg)))
+			{
+				return false;
+			}
+			return std::none_of(active.begin(), active.end(), [&](const LiveInterval* a) { return GetHome(l, a->value).reg == reg; });
+		};
+
+		RG chosen = RG::size;
+		for (const RG hint : getHints(*interval))
+		{
+			if (isFree(hint)) { chosen = hint; break; }
+		}
+		for (const RG reg : s_callClobberedRegisters)
+		{
+			if (chosen == RG::size && isFree(reg)) { chosen = reg; }
+		}
+		for (const RG reg : s_calleeSavedRegisters)
+		{
+			if (chosen == RG::size && isFree(reg)) { chosen = reg; }
+		}
+
+		if (chosen == RG::size)
+		{
+			// Whichever is used the least goes to the stack.
+			LiveInterval* victim = nullptr;
+			for (LiveInterval* a : active)
+			{
+				const bool isSuitable = !interval->crossesCall || IsCalleeSaved(GetHome(l, a->value).reg);
+				if (isSuitable && a->weight < interval->weight && (victim == nullptr || a->weight < victim->weight))
+				{
+					victim = a;
+				}
+			}
+			if (victim == nullptr)
+			{
+				spilled.push_back(interval);
+				continue;
+			}
+
+			chosen = GetHome(l, victim->value).reg;
+			l.homes[victim->value->id].reg = RG::size;
+			active.erase(std::find(active.begin(), active.end(), victim));
+			spilled.push_back(victim);
+		}
+
+		l.homes[interval->value->id].reg = chosen;
+		active.push_back(interval);
+	}
+
+	// The spilled values share the stack slots of the ones that are no longer live.
+	std::sort(spilled.begin(), spilled.end(), [](const LiveInterval* a, const LiveInterval* b) {
+		return a->start != b->start ? a->start < b->start : a->value->id < b->value->id;
+	});
+	std::vector<ui32> slotEnds;
+	for (const LiveInterval* interval : spilled)
+	{
+		ui32 slot = 0;
+		while (slot < slotEnds.size() && slotEnds[slot] >= interval->start)
+		{
+			slot++;
+		}
+		if (slot == slotEnds.size())
+		{
+			slotEnds.push_back(0);
+		}
+		slotEnds[slot] = interval->end;
+		l.homes[interval->value->id].offset = spillsOffset + 8 * (i32)slot;
+	}
+	outSpillSlots = (ui32)slotEnds.size();
+
+	for (ui64 reg = 0; reg < (ui64)RG::size; reg++)
+	{
+		const bool isUsed = std::any_of(l.homes.begin(), l.homes.end(), [reg](const Home& home) { return home.reg == (RG)reg; });
+		if (isUsed && IsCalleeSaved((RG)reg))
+		{
+			outSavedRegisters.push_back((RG)reg);
+		}
+	}
+}
+
+// Multiplications and divisions by constants, with the cheaper instructions StrengthReduction.h has for them. Returns false if
+// it has none for the instruction.
+static bool EmitReducedArithmetic(Lowering& l, const IR::Instruction* instruction)
+{
+	const IR::Instruction* lhs = instruction->operands[0];
+	const IR::Instruction* rhs = instruction->operands[1];
+	if (instruction->op == IR::Opcode::Mul && lhs->op == IR::Opcode::Const)
+	{
+		std::swap(lhs, rhs);
+	}
+	if ((instruction->op != IR::Opcode::Mul && instruction->op != IR::Opcode::Div) || rhs->op != IR::Opcode::Const)
+	{
+		return false;
+	}
+
+	// Divisions write RAX and RDX, so a result headed for the stack is computed in RCX.
+	const RG target = GetTarget(l, instruction);
+	const RG work = target == RG::RAX ? RG::RCX : target;
+
+	std::vector<std::string> instructions;
+	const bool isReduced = instruction->op == IR::Opcode::Mul ? StrengthReduction::MultiplyInPlace(rhs->constant, GetReg(work), instructions) :
+		StrengthReduction::DivideInPlace((ui64)rhs->constant, GetReg(work), instructions);
+	if (!isReduced)
+	{
+		return false;
+	}
+
+	MoveInto(l, work, lhs);
+	for (const std::string& line : instructions)
+	{
+		Emit(l, line);
+	}
+	StoreResult(l, instruction, work);
+	return true;
+}
+
+static void EmitArithmetic(Lowering& l, const IR::Instruction* instruction)
+{
+	if (EmitReducedArithmetic(l, instruction))
+	{
+		return;
+	}
+
+	const IR::Instruction* lhs = instruction->operands[0];
+	const IR::Instruction* rhs = instruction->operands[1];
+	RG target = GetTarget(l, instruction);
+
+	switch (instruction->op)
+	{
+	case IR::Opcode::Div:
+	{
+		// RDX:RAX / divisor, unsigned, the quotient ends up in RAX.
+		const std::string divisor = IsKeptSomewhere(rhs) ? RefHome(GetHome(l, rhs)) : (MoveInto(l, RG::RCX, rhs), std::string("RCX"));
+		MoveInto(l, RG::RAX, lhs);
+		Emit(l, "xor EDX, EDX");
+		Emit(l, "div " + divisor);
+		target = RG::RAX;
+		break;
+	}
+	case IR::Opcode::Shl:
+	case IR::Opcode::Shr:
+	{
+		std::string amount;
+		if (rhs->op == IR::Opcode::Const)
+		{
+			amount = std::to_string(rhs->constant & 63);
+		}
+		else
+		{
+			MoveInto(l, RG::RCX, rhs);
+			amount = "CL";
+		}
+		MoveInto(l, target, lhs);
+		Emit(l, std::string(instruction->op == IR::Opcode::Shl ? "shl " : "shr ") + GetReg(target) + ", " + amount);
+		break;
+	}
+	default:
+	{
+		// Two address instructions, target = target op rhs, so the rhs can't be in the target.
+		if (IsKeptSomewhere(rhs) && GetHome(l, rhs).reg == target)
+		{
+			if (instruction->op == IR::Opcode::Sub)
+			{
+				target = RG::RAX;
+			}
+			else
+			{
+				std::swap(lhs, rhs);
+			}
+		}
+
+		MoveInto(l, target, lhs);
+		const std::string operand = GetOperand(l, rhs, RG::RCX);
+		switch (instruction->op)
+		{
+		case IR::Opcode::Add: Emit(l, "add " + GetReg(target) + ", " + operand); break;
+		case IR::Opcode::Sub: Emit(l, "sub " + GetReg(target) + ", " + operand); break;
+		case IR::Opcode::And: Emit(l, "and " + GetReg(target) + ", " + operand); break;
+		case IR::Opcode::Or: Emit(l, "or " + GetReg(target) + ", " + operand); break;
+		default:
+		{
+			// imul has a three operand form for immediates.
+			Emit(l, "imul " + GetReg(target) + ", " + (IsImmediate(rhs) ? GetReg(target) + ", " : "") + operand);
+			break;
+		}
+		}
+		break;
+	}
+	}
+
+	StoreResult(l, instruction, target);
+}
+
+static void EmitTrunc(Lowering& l, const IR::Instruction* instruction)
+{
+	const IR::Instruction* operand = instruction->operands[0];
+	const RG target = GetTarget(l, instruction);
+
+	Home source;
+	if (IsKeptSomewhere(operand))
+	{
+		source = GetHome(l, operand);
+	}
+	else
+	{
+		MoveInto(l, target, operand);
+		source = Home{ target };
+	}
+
+	EmitTruncation(l, target, source, IR::GetTypeSize(instruction->type));
+	StoreResult(l, instruction, target);
+}
+
+// The memory at the address in value, as an operand of the size. scratch is where the address is computed, if it has to be.
+static std::string RefMemory(Lowering& l, const IR::Instruction* address, const ui32 size, const RG scratch)
+{
+	if (address->op == IR::Opcode::Slot)
+	{
+		return RefStack(l.slotOffsets[address->id], size);
+	}
+
+	RG reg = scratch;
+	if (IsKeptSomewhere(address) && GetHome(l, address).IsRegister())
+	{
+		reg = GetHome(l, address).reg;
+	}
+	else
+	{
+		MoveInto(l, scratch, address);
+	}
+	return GetWordKind(size) + " [" + GetReg(reg) + "]";
+}
+
+static void EmitLoad(Lowering& l, const IR::Instruction* instruction)
+{
+	const ui32 size = IR::GetTypeSize(instruction->memoryType);
+	const RG target = GetTarget(l, instruction);
+	const std::string memory = RefMemory(l, instruction->operands[0], size, target);
+
+	if (size == 8)
+	{
+		Emit(l, "mov " + GetReg(target) + ", " + memory);
+	}
+	else if (size == 4)
+	{
+		Emit(l, "mov " + GetReg(target, 4) + ", " + memory);
+	}
+	else
+	{
+		Emit(l, "movzx " + GetReg(target) + ", " + memory);
+	}
+	StoreResult(l, instruction, target);
+}
+
+static void EmitStore(Lowering& l, const IR::Instruction* instruction)
+{
+	const ui32 size = IR::GetTypeSize(instruction->memoryType);
+	const IR::Instruction* value = instruction->operands[1];
+
+	std::string source;
+	if (value->op == IR::Opcode::Undef)
+	{
+		// The memory may as well keep what it has.
+		return;
+	}
+	else if (value->op == IR::Opcode::Const && (size < 8 || IsImmediate(value)))
+	{
+		source = std::to_string(size < 8 ? (i64)((ui64)value->constant & ((1ull << (8 * size)) - 1)) : value->constant);
+	}
+	else if (IsKeptSomewhere(value) && GetHome(l, value).IsRegister())
+	{
+		source = GetReg(GetHome(l, value).reg, size);
+	}
+	else
+	{
+		MoveInto(l, RG::RCX, value);
+		source = GetReg(RG::RCX, size);
+	}
+
+	Emit(l, "mov " + RefMemory(l, instruction->operands[0], size, RG::RAX) + ", " + source);
+}
+
+static void EmitCall(Lowering& l, const IR::Instruction* instruction)
+{
+	std::vector<Move> moves;
+	for (ui64 i = 0; i < instruction->operands.size(); i++)
+	{
+		const IR::Instruction* argument = instruction->operands[i];
+		moves.push_back({ Home{ s_argumentRegisters[i] }, IsKeptSomewhere(argument) ? GetHome(l, argument) : Home{}, argument });
+	}
+	EmitParallelMove(l, moves);
+
+	Emit(l, "call " + instruction->symbol->functionName);
+	if (GetHome(l, instruction).IsSet())
+	{
+		StoreResult(l, instruction, RG::RAX);
+	}
+}
+
+static void EmitBranch(Lowering& l, const IR::Instruction* branch, const IR::Block* next)
+{
+	const IR::Instruction* lhs = branch->operands[0];
+	const IR::Instruction* rhs = branch->operands[1];
+
+	std::string left;
+	if (IsKeptSomewhere(lhs) && GetHome(l, lhs).IsRegister())
+	{
+		left = GetReg(GetHome(l, lhs).reg);
+	}
+	else
+	{
+		MoveInto(l, RG::RAX, lhs);
+		left = "RAX";
+	}
+	Emit(l, "cmp " + left + ", " + GetOperand(l, rhs, RG::RCX));
+
+	// The phis' copies only happen on their edge, after the jump that picks it, mov doesn't touch the flags.
+	const IR::Block* less = branch->blocks[0];
+	const IR::Block* notLess = branch->blocks[1];
+	const std::vector<Move> lessMoves = GetEdgeMoves(l, branch->block, less);
+	const std::vector<Move> notLessMoves = GetEdgeMoves(l, branch->block, notLess);
+
+	if (notLessMoves.empty() && (less == next || !lessMoves.empty()))
+	{
+		Emit(l, "jge " + GetLabel(l, notLess));
+		EmitParallelMove(l, lessMoves);
+		JumpTo(l, less, next);
+	}
+	else if (lessMoves.empty())
+	{
+		Emit(l, "jl " + GetLabel(l, less));
+		EmitParallelMove(l, notLessMoves);
+		JumpTo(l, notLess, next);
+	}
+	else
+	{
+		const std::string stub = "LS" + std::to_string(l.stubsMade++) + "@" + l.function.name;
+		Emit(l, "jge " + stub);
+		EmitParallelMove(l, lessMoves);
+		Emit(l, "jmp " + GetLabel(l, less));
+		Emit(l, stub + ":");
+		EmitParallelMove(l, notLessMoves);
+		JumpTo(l, notLess, next);
+	}
+}
+
+static void EmitInstruction(Lowering& l, const IR::Instruction* instruction, const IR::Block* next)
+{
+	// Values nothing uses aren't computed, unless computing them calls a function.
+	if (instruction->HasValue() && !GetHome(l, instruction).IsSet() && instruction->op != IR::Opcode::Call)
+	{
+		return;
+	}
+
+	switch (instruction->op)
+	{
+	case IR::Opcode::Param:
+	case IR::Opcode::Slot:
+	case IR::Opcode::Phi:
+	{
+		// Taken care of where the function starts and at the end of the phis' predecessors.
+		break;
+	}
+	case IR::Opcode::Load:
+	{
+		EmitLoad(l, instruction);
+		break;
+	}
+	case IR::Opcode::Store:
+	{
+		EmitStore(l, instruction);
+		break;
+	}
+	case IR::Opcode::Add:
+	case IR::Opcode::Sub:
+	case IR::Opcode::Mul:
+	case IR::Opcode::Div:
+	case IR::Opcode::Shl:
+	case IR::Opcode::Shr:
+	case IR::Opcode::And:
+	case IR::Opcode::Or:
+	{
+		EmitArithmetic(l, instruction);
+		break;
+	}
+	case IR::Opcode::Trunc:
+	{
+		EmitTrunc(l, instruction);
+		break;
+	}
+	case IR::Opcode::Call:
+	{
+		EmitCall(l, instruction);
+		break;
+	}
+	case IR::Opcode::Jump:
+	{
+		EmitParallelMove(l, GetEdgeMoves(l, instruction->block, instruction->blocks[0]));
+		JumpTo(l, instruction->blocks[0], next);
+		break;
+	}
+	case IR::Opcode::Branch:
+	{
+		EmitBranch(l, instruction, next);
+		break;
+	}
+	case IR::Opcode::Return:
+	{
+		if (!instruction->operands.empty())
+		{
+			MoveInto(l, RG::RAX, instruction->operands[0]);
+		}
+		if (next != nullptr)
+		{
+			Emit(l, "jmp LR@" + l.function.name);
+			l.isReturnLabelUsed = true;
+		}
+		break;
+	}
+	default:
+	{
+		wprintf(L"ERROR: Opcode %S can't be lowered in " __FUNCTION__ "\n", IR::GetOpcodeName(instruction->op));
+		Exit(ErrCodes::internal_compiler_error);
+	}
+	}
+}
+
+// The parameters come in RCX, RDX, R8 and R9, they're truncated to their type where they are and then moved to their homes.
+static void EmitParams(Lowering& l)
+{
+	std::vector<Move> moves;
+	for (const IR::Instruction* instruction : l.function.blocks[0]->instructions)
+	{
+		if (instruction->op != IR::Opcode::Param || !GetHome(l, instruction).IsSet())
+		{
+			continue;
+		}
+
+		const RG reg = s_argumentRegisters[instruction->constant];
+		const ui32 size = IR::GetTypeSize(instruction->type);
+		if (size < 8)
+		{
+			EmitTruncation(l, reg, Home{ reg }, size);
+		}
+		moves.push_back({ GetHome(l, instruction), Home{ reg }, instruction });
+	}
+	EmitParallelMove(l, moves);
+}
+
+void IRLowering::GenerateFunctionCode(const IR::Function& function, std::string& outCode)
+{
+	Lowering l(function);
+
+	ui32 valueCount = 0;
+	for (const IR::Instruction* value : function.values)
+	{
+		valueCount = std::max(valueCount, value->id + 1);
+	}
+	l.homes.resize(valueCount);
+	l.slotOffsets.resize(valueCount, -1);
+
+	// The frame, from rsp up: the space for the arguments of external C functions, the slots and the spilled values.
+	bool callsExternalFunction = false;
+	i32 frameSize = 0;
+	for (const IR::Block* block : function.blocks)
+	{
+		for (const IR::Instruction* instruction : block->instructions)
+		{
+			callsExternalFunction = callsExternalFunction || (instruction->op == IR::Opcode::Call && instruction->symbol->asFunction.isExtern);
+		}
+	}
+	frameSize = callsExternalFunction ? s_shadowSpaceSize : 0;
+	for (const IR::Instruction* instruction : function.blocks[0]->instructions)
+	{
+		if (instruction->op == IR::Opcode::Slot)
+		{
+			l.slotOffsets[instruction->id] = frameSize;
+			frameSize += (i32)instruction->constant;
+		}
+	}
+	const i32 spillsOffset = (frameSize + 7) / 8 * 8;
+
+	std::vector<RG> savedRegisters;
+	ui32 spillSlots = 0;
+	AllocateHomes(l, spillsOffset, savedRegisters, spillSlots);
+
+	// rsp is 8 off a multiple of 16 after the call that got here, and is back on one after pushing rbp.
+	frameSize = spillsOffset + 8 * (i32)spillSlots;
+	if ((frameSize + 8 * savedRegisters.size()) % 16 != 0)
+	{
+		frameSize += 8;
+	}
+
+	l.code = "\n\n\n; Body\n";
+	EmitParams(l);
+	for (ui64 b = 0; b < function.blocks.size(); b++)
+	{
+		const IR::Block* block = function.blocks[b];
+		const IR::Block* next = b + 1 < function.blocks.size() ? function.blocks[b + 1] : nullptr;
+		if (b != 0)
+		{
+			Emit(l, GetLabel(l, block) + ":");
+		}
+		for (const IR::Instruction* instruction : block->instructions)
+		{
+			EmitInstruction(l, instruction, next);
+		}
+	}
+
+	std::string prologue = "\n\n\n; Prologue\n" + function.name + " PROC\npush rbp\nmov rbp, rsp\n";
+	if (!savedRegisters.empty())
+	{
+		prologue += "; Save the callee-saved registers the function uses.\n";
+		for (const RG reg : savedRegisters)
+		{
+			prologue += "push " + GetReg(reg) + "\n";
+		}
+	}
+	if (frameSize != 0)
+	{
+		prologue += "; Alloc the stack frame.\nsub rsp, " + std::to_string(frameSize) + "\n";
+	}
+
+	std::string epilogue = "\n\n\n; Epilogue\n";
+	if (l.isReturnLabelUsed)
+	{
+		epilogue += "LR@" + function.name + ":\n";
+	}
+	if (frameSize != 0)
+	{
+		epilogue += "; Dealloc the stack frame.\nadd rsp, " + std::to_string(frameSize) + "\n";
+	}
+	if (!savedRegisters.empty())
+	{
+		epilogue += "; Restore the callee-saved registers.\n";
+		for (auto reg = savedRegisters.rbegin(); reg != savedRegisters.rend(); ++reg)
+		{
+			epilogue += "pop " + GetReg(*reg) + "\n";
+		}
+	}
+	epilogue += "mov rsp, rbp\npop rbp\nret\n" + function.name + " ENDP\n";
+
+	outCode += prologue + l.code + epilogue;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+
+namespace IR
+{
+	struct Function;
+}
+
+/*
+	Generates a function's assembly from its IR, for --via-ir, in place of the code generator's walk over the AST.
+
+	Every value gets a register or a stack slot for all of its life, by linear scan(Poletto & Sarkar) over the instructions,
+	numbered in the order their blocks are laid out in. A value's interval runs from its definition to its last use, stretched
+	over every block it's live into or out of, so a value live around a loop holds its place for the whole loop. A phi's
+	operands are used at the end of the predecessor they come from, where they're all copied into the phis' places at once.
+	Values the interval of a call falls inside of take RBX, RSI, RDI or R12 to R15, which are saved and restored around the
+	function for its callers, the others take R8 to R11 first. When there are none left, whichever of the values is used the
+	least, counting uses in loops ten times for every loop around them, goes to the stack. RAX, RCX and RDX are never handed
+	out, division, shifts, calls and the copies between places need them.
+	Constants and the addresses of slots aren't kept anywhere, they're immediates or computed right where they're used.
+
+	The stack frame is a single section: the space external C functions may use for their register arguments(only when the
+	function calls one), the slots in the order their locals are declared in, then the spilled values. It's padded so the stack
+	is 16 byte aligned at every call.
+*/
+namespace IRLowering
+{
+	void GenerateFunctionCode(const IR::Function& function, std::string& outCode);
+}
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include "RegisterAllocator.h"
+#include "../AST/ASTNode.h"
+#include "../AST/ASTAPI.h"
+#include "../symbol_table/symtable.h"
+#include "../Utils.h"
+#include <algorithm>
+
+// In the order they're handed out. Intervals that don't cross calls take the ones calls clobber first, those cost nothing to use.
+static constexpr RG s_callClobberedRegisters[] = { RG::R10, RG::R11 };
+
+// Calls pass arguments in these, so only the temporaries of statements without calls get them.
+static constexpr RG s_argumentRegisters[] = { RG::R8, RG::R9 };
+static constexpr RG s_calleeSavedRegisters[] = { RG::RSI, RG::RDI, RG::R12, RG::R13, RG::R14, RG::R15 };
+
+// How much more a use counts for every loop around it. Deeper than this, everything's about as hot.
+static constexpr ui64 s_loopWeights[] = { 1, 10, 100, 1000, 10000 };
+
+struct Interval
+{
+	// A local's, or the iteration variable of a loop.
+	SymTabEntry* entry = nullptr;
+	AST::Node* loop = nullptr;
+
+	ui32 start = 0;
+	ui32 end = 0;
+	ui64 weight = 0;
+	bool crossesCall = false;
+
+	RG reg = RG::size;
+};
+
+// What numbering a function's statements finds out about it.
+struct FunctionWalk
+{
+	// Position 0 is the function's entry, where the parameters are written. The statements start at 1.
+	ui32 nextPosition = 1;
+	std::vector<AST::Node*> statements{ nullptr };
+	std::vector<bool> hasCall{ false };
+	std::vector<ui32> depths{ 0 };
+
+	std::vector<Interval> intervals;
+	std::unordered_map<SymTabEntry*, ui64> intervalIndices;
+
+	// The positions of every loop's statement and of the last statement in its body.
+	std::vector<std::pair<ui32, ui32>> loops;
+
+	std::unordered_set<SymTabEntry*> addressTaken;
+};
+
+static ui64 GetLoopWeight(const ui32 depth)
+{
+	return s_loopWeights[std::min<ui64>(depth, GetArraySize(s_loopWeights) - 1)];
+}
+
+static void Mention(FunctionWalk& walk, SymTabEntry* entry, const ui32 position, const ui32 depth)
+{
+	if (entry == nullptr || entry->isFunction || walk.addressTaken.count(entry) != 0)
+	{
+		return;
+	}
+
+	const auto found = walk.intervalIndices.find(entry);
+	if (found == walk.intervalIndices.end())
+	{
+		Interval interval;
+		interval.entry = entry;
+		interval.start = interval.end = position;
+		interval.weight = GetLoopWeight(depth);
+
+		walk.intervalIndices[entry] = walk.intervals.size();
+		walk.intervals.push_back(interval);
+		return;
+	}
+
+	Interval& interval = walk.intervals[found->second];
+	interval.end = std::max(interval.end, position);
+	interval.weight += GetLoopWeight(depth);
+}
+
+static void MentionAll(FunctionWalk& walk, AST::Node* n, const ui32 position, const ui32 depth)
+{
+	for (AST::Node* symNode : AST::GetAllChildNodesOfType(n, Node_k::SymNode))
+	{
+		Mention(walk, ((AST::SymNode*)symNode)->GetSymTabEntry(), position, depth);
+	}
+}
+
+static ui32 NextPosition(FunctionWalk& walk, AST::Node* statement, const bool hasCall, const ui32 depth)
+{
+	walk.statements.push_back(statement);
+	walk.hasCall.push_back(hasCall);
+	walk.depths.push_back(depth);
+	return walk.nextPosition++;
+}
+
+static void WalkStatements(FunctionWalk& walk, AST::Node* scope, const ui32 depth)
+{
+	for (AST::Node* statement : scope->GetChildren())
+	{
+		switch (statement->GetNodeKind())
+		{
+			case Node_k::Node:
+			case Node_k::DeclNode:
+			{
+				// Nothing to generate.
+				break;
+			}
+			case Node_k::ForLoopNode:
+			{
+				AST::ForLoopNode* asForLoopNode = (AST::ForLoopNode*)statement;
+				AST::ForLoopHeadNode* head = (AST::ForLoopHeadNode*)asForLoopNode->GetHead();
+				const ui32 position = NextPosition(walk, statement, false, depth);
+
+				// The lower bound is read once, the upper bound on every iteration.
+				MentionAll(walk, head->GetLowerBound(), position, depth);
+				MentionAll(walk, head->GetUpperBound(), position, depth + 1);
+
+				WalkStatements(walk, asForLoopNode->GetBody(), depth + 1);
+				walk.loops.push_back({ position, walk.nextPosition - 1 });
+
+				// Incremented, stored and compared on every iteration.
+				Interval iterationVariable;
+				iterationVariable.loop = statement;
+				iterationVariable.start = position;
+				iterationVariable.end = walk.nextPosition - 1;
+				iterationVariable.weight = 3 * GetLoopWeight(depth + 1);
+				walk.intervals.push_back(iterationVariable);
+				break;
+			}
+			default:
+			{
+				const bool hasCall = !AST::GetAllChildNodesOfType(statement, Node_k::FunctionCallNode).empty();
+				MentionAll(walk, statement, NextPosition(walk, statement, hasCall, depth), depth);
+				break;
+			}
+		}
+	}
+}
+
+static RG TakeFreeRegister(bool* isFree, const bool needsCalleeSaved)
+{
+	if (!needsCalleeSaved)
+	{
+		for (const RG reg : s_callClobberedRegisters)
+		{
+			if (isFree[(ui64)reg]) { isFree[(ui64)reg] = false; return reg; }
+		}
+	}
+	for (const RG reg : s_calleeSavedRegisters)
+	{
+		if (isFree[(ui64)reg]) { isFree[(ui64)reg] = false; return reg; }
+	}
+	return RG::size;
+}
+
+static void LinearScan(std::vector<Interval>& intervals)
+{
+	std::stable_sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b) { return a.start < b.start; });
+
+	bool isFree[(ui64)RG::size] = {};
+	for (const RG reg : s_callClobberedRegisters) { isFree[(ui64)reg] = true; }
+	for (const RG reg : s_calleeSavedRegisters) { isFree[(ui64)reg] = true; }
+
+	// The intervals holding a register.
+	std::vector<Interval*> active;
+
+	for (Interval& interval : intervals)
+	{
+		for (ui64 i = 0; i < active.size();)
+		{
+			if (active[i]->end < interval.start)
+			{
+				isFree[(ui64)active[i]->reg] = true;
+				active.erase(active.begin() + i);
+			}
+			else { i++; }
+		}
+
+		interval.reg = TakeFreeRegister(isFree, interval.crossesCall);
+		if (interval.reg == RG::size)
+		{
+			// Out of registers, the least used of the interval and the ones it could take a register from is spilled.
+			Interval* spilled = nullptr;
+			for (Interval* activeInterval : active)
+			{
+				const bool isSuitable = !interval.crossesCall || RegisterAllocator::IsCalleeSaved(activeInterval->reg);
+				if (isSuitable && activeInterval->weight < interval.weight && (spilled == nullptr || activeInterval->weight < spilled->weight))
+				{
+					spilled = activeInterval;
+				}
+			}
+			if (spilled == nullptr)
+			{
+				continue;
+			}
+
+			interval.reg = spilled->reg;
+			spilled->reg = RG::size;
+			active.erase(std::find(active.begin(), active.end(), spilled));
+		}
+
+		active.push_back(&interval);
+	}
+}
+
+bool RegisterAllocator::IsCalleeSaved(const RG reg)
+{
+	return std::find(std::begin(s_calleeSavedRegisters), std::end(s_calleeSavedRegisters), reg) != std::end(s_calleeSavedRegisters);
+}
+
+void RegisterAllocator::AllocateRegisters(AST::FunctionNode* functionNode, Allocation& outAllocation)
+{
+	FunctionWalk walk;
+	walk.addressTaken = AST::GetAddressTakenLocals(functionNode);
+
+	for (AST::Node* arg = functionNode->GetArgsList(); arg != nullptr; arg = arg->GetRightSibling())
+	{
+		Mention(walk, ((AST::ArgNode*)arg)->GetSymTabEntry(), 0, 0);
+	}
+
+	for (AST::Node* childNode : functionNode->GetChildren())
+	{
+		if (childNode->GetNodeKind() == Node_k::ScopeNode)
+		{
+			WalkStatements(walk, childNode, 0);
+		}
+	}
+
+	// How many statements up to and including each position call a function.
+	std::vector<ui32> callsUpTo(walk.nextPosition, 0);
+	for (ui32 position = 1; position < walk.nextPosition; position++)
+	{
+		callsUpTo[position] = callsUpTo[position - 1] + (walk.hasCall[position] ? 1 : 0);
+	}
+
+	for (Interval& interval : walk.intervals)
+	{
+		if (interval.entry != nullptr)
+		{
+			for (const auto& [loopStart, loopEnd] : walk.loops)
+			{
+				if (interval.start <= loopEnd && interval.end >= loopStart)
+				{
+					interval.start = std::min(interval.start, loopStart);
+					interval.end = std::max(interval.end, loopEnd);
+				}
+			}
+		}
+
+		interval.crossesCall = callsUpTo[interval.end] != (interval.start == 0 ? 0 : callsUpTo[interval.start - 1]);
+	}
+
+	LinearScan(walk.intervals);
+
+	// The registers held at each position, and the callee-saved ones saved anyway because something holds them.
+	std::vector<std::vector<bool>> isHeld(walk.nextPosition, std::vector<bool>((ui64)RG::size, false));
+	bool isSavedAnyway[(ui64)RG::size] = {};
+	for (const Interval& interval : walk.intervals)
+	{
+		if (interval.reg == RG::size)
+		{
+			continue;
+		}
+		isSavedAnyway[(ui64)interval.reg] = true;
+
+		if (interval.entry != nullptr) { outAllocation.locals[interval.entry] = interval.reg; }
+		else { outAllocation.iterationVariables[interval.loop] = interval.reg; }
+
+		for (ui32 position = interval.start; position <= interval.end; position++)
+		{
+			isHeld[position][(ui64)interval.reg] = true;
+		}
+	}
+
+	for (ui32 position = 1; position < walk.nextPosition; position++)
+	{
+		AST::Node* statement = walk.statements[position];
+		if (statement->GetNodeKind() == Node_k::ForLoopNode)
+		{
+			continue;
+		}
+
+		// A temporary may well be computed before a call and used after it. Callee-saved registers that are saved anyway
+		// come before the ones that would have to be saved just for the temporaries, which only pays off in a loop.
+		std::vector<RG>& temporaries = outAllocation.temporaries[statement];
+		if (!walk.hasCall[position])
+		{
+			temporaries.assign(std::begin(s_argumentRegisters), std::end(s_argumentRegisters));
+			for (const RG reg : s_callClobberedRegisters)
+			{
+				if (!isHeld[position][(ui64)reg]) { temporaries.push_back(reg); }
+			}
+		}
+		for (const bool isSaved : { true, false })
+		{
+			if (!isSaved && walk.depths[position] == 0)
+			{
+				break;
+			}
+			for (const RG reg : s_calleeSavedRegisters)
+			{
+				if (!isHeld[position][(ui64)reg] && isSavedAnyway[(ui64)reg] == isSaved) { temporaries.push_back(reg); }
+			}
+		}
+	}
+}
\ No newline at end of file
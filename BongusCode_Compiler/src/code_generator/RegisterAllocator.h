@@ -0,0 +1,55 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "Registers.h"
+
+struct SymTabEntry;
+
+namespace AST
+{
+	class Node;
+	class FunctionNode;
+}
+
+/*
+	Linear scan register allocation(Poletto & Sarkar), run over a function before its code is generated.
+
+	The function's statements are numbered in the order they're generated, and every local gets the interval of statements from
+	its first mention to its last. A local mentioned inside a For loop may carry its value from one iteration into the next, so
+	its interval is stretched over the whole loop, and a loop's iteration variable gets the loop's interval. Walking the
+	intervals by where they start, each takes a register nobody holds anymore, and when there are none left, whichever of it
+	and the intervals holding a register is used the least, counting uses in loops ten times for every loop around them, goes
+	to the stack for all of its interval.
+
+	RAX, RBX, RCX, RDX, R8 and R9 are left alone, expressions, division and calls are generated with them. That leaves R10 and
+	R11, which calls clobber, for intervals without calls in them, and RSI, RDI and R12 to R15, which functions have to preserve
+	for their callers and so are saved and restored around the function, for the rest.
+
+	Temporaries never outlive their statement, so rather than getting intervals of their own, a statement's temporaries take
+	the registers no local or iteration variable holds during it, in order, and what doesn't fit goes to the stack as before.
+	Statements without calls also lend their temporaries R8 and R9.
+	Outside of loops, saving and restoring a callee-saved register costs as much as the temporary's store and load, so there
+	they only take the callee-saved registers the function saves anyway.
+
+	Locals whose address is taken(&x) always stay on the stack, they have to have an address. So do the ones declared in the same
+	run of declarations, see AST::GetAddressTakenLocals.
+*/
+namespace RegisterAllocator
+{
+	struct Allocation
+	{
+		// The locals that got a register. The rest keep their stack slot.
+		std::unordered_map<SymTabEntry*, RG> locals;
+
+		// The iteration variables that got a register, by their ForLoopNode.
+		std::unordered_map<AST::Node*, RG> iterationVariables;
+
+		// The registers free for the temporaries of each statement, in the order they're taken, by the statement's node.
+		std::unordered_map<AST::Node*, std::vector<RG>> temporaries;
+	};
+
+	void AllocateRegisters(AST::FunctionNode* functionNode, Allocation& outAllocation);
+
+	// Whether a function that uses the register has to save it first and restore it before returning.
+	bool IsCalleeSaved(const RG reg);
+}
\ No newline at end of file
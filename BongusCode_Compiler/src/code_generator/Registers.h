@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <stdio.h>
+#include "../Definitions.h"
+#include "../BongusTable.h"
+#include "../Exit.h"
+
+// The general purpose registers the code generator uses, and their names at each width, 64 bits first.
+namespace Registers
+{
+	enum class eRegisters : ui16
+	{
+		RAX,
+		RBX,
+		RCX,
+		RDX,
+		R8,
+		R9,
+		R10,
+		R11,
+		RSI,
+		RDI,
+		R12,
+		R13,
+		R14,
+		R15,
+		size
+	};
+
+	inline const std::string Regs[(ui64)eRegisters::size][4] = {
+		{ "RAX", "EAX", "AX", "AL" },
+		{ "RBX", "EBX", "BX", "BL" },
+		{ "RCX", "ECX", "CX", "CL" },
+		{ "RDX", "EDX", "DX", "DL" },
+		{ "R8", "R8D", "R8W", "R8B" },
+		{ "R9", "R9D", "R9W", "R9B" },
+		{ "R10", "R10D", "R10W", "R10B" },
+		{ "R11", "R11D", "R11W", "R11B" },
+		{ "RSI", "ESI", "SI", "SIL" },
+		{ "RDI", "EDI", "DI", "DIL" },
+		{ "R12", "R12D", "R12W", "R12B" },
+		{ "R13", "R13D", "R13W", "R13B" },
+		{ "R14", "R14D", "R14W", "R14B" },
+		{ "R15", "R15D", "R15W", "R15B" },
+	};
+
+	inline static const ui16 GetSubscriptFromType(const PrimitiveType type)
+	{
+		switch (type)
+		{
+		case PrimitiveType::ui64:
+		case PrimitiveType::i64:
+		case PrimitiveType::pointer:
+			return 0;
+
+		case PrimitiveType::ui32:
+		case PrimitiveType::i32:
+			return 1;
+
+		case PrimitiveType::ui16:
+		case PrimitiveType::i16:
+			return 2;
+
+		case PrimitiveType::ui8:
+		case PrimitiveType::i8:
+			return 3;
+
+		default:
+			wprintf(L"ERROR: Type %hu supplied to " __FUNCSIG__ " does not correspond with any register size.\n", type);
+			Exit(ErrCodes::internal_compiler_error);
+			return -1;
+		}
+	}
+}
+
+using RG = Registers::eRegisters;
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "SethiUllman.h"
+#include "../AST/ASTNode.h"
+#include <algorithm>
+
+bool SethiUllman::IsLeaf(AST::Node* n)
+{
+	const Node_k kind = n->GetNodeKind();
+	return kind == Node_k::IntNode || kind == Node_k::SymNode || kind == Node_k::AddrOfNode;
+}
+
+bool SethiUllman::IsImmediateOperand(const Op_k op, AST::Node* rhs)
+{
+	if (op == Op_k::DIV || rhs->GetNodeKind() != Node_k::IntNode)
+	{
+		return false;
+	}
+
+	const i64 value = (i64)((AST::IntNode*)rhs)->Get();
+	return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+const SethiUllman::Label& SethiUllman::LabelExpression(AST::Node* expr, Labels& outLabels)
+{
+	Label label;
+
+	switch (expr->GetNodeKind())
+	{
+	case Node_k::OpNode:
+	{
+		AST::OpNode* asOpNode = (AST::OpNode*)expr;
+		const Label lhs = LabelExpression(asOpNode->GetLHS(), outLabels);
+		const Label rhs = LabelExpression(asOpNode->GetRHS(), outLabels);
+
+		const ui32 rhsNeed = IsLeaf(asOpNode->GetRHS()) ? 0 : rhs.need;
+		label.need = lhs.need == rhsNeed ? lhs.need + 1 : std::max(lhs.need, rhsNeed);
+		label.hasCall = lhs.hasCall || rhs.hasCall;
+		label.hasDivision = lhs.hasDivision || rhs.hasDivision || asOpNode->GetOp() == Op_k::DIV;
+		break;
+	}
+	case Node_k::DerefNode:
+	{
+		// The pointee is loaded into the register that held the pointer.
+		label = LabelExpression(((AST::DerefNode*)expr)->GetExpr(), outLabels);
+		break;
+	}
+	case Node_k::FunctionCallNode:
+	{
+		// Arguments are leaves, loaded straight into the calling convention's registers.
+		label.need = 1;
+		label.hasCall = true;
+		for (AST::Node* arg = ((AST::FunctionCallNode*)expr)->GetArgs(); arg != nullptr; arg = arg->GetRightSibling())
+		{
+			label.hasDivision = LabelExpression(arg, outLabels).hasDivision || label.hasDivision;
+		}
+		break;
+	}
+	default:
+	{
+		label.need = 1;
+		break;
+	}
+	}
+
+	return outLabels[expr] = label;
+}
+
+bool SethiUllman::EvaluatesRightFirst(AST::OpNode* opNode, const Labels& labels)
+{
+	const Label& lhs = labels.at(opNode->GetLHS());
+	const Label& rhs = labels.at(opNode->GetRHS());
+
+	if (lhs.hasCall || rhs.hasCall || IsLeaf(opNode->GetRHS()))
+	{
+		return false;
+	}
+	return rhs.need > lhs.need;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <unordered_map>
+#include "../Definitions.h"
+#include "../BongusTable.h"
+
+namespace AST
+{
+	class Node;
+	class OpNode;
+}
+
+/*
+	Sethi-Ullman labelling of expression trees(Sethi & Ullman, The Generation of Optimal Code for Arithmetic Expressions), which
+	the code generator uses to evaluate expressions in registers.
+
+	Every node is labelled with how many registers computing it takes without spilling, its own result included. A leaf on the
+	right of an operator takes none, it's used as the operand where it lives, and a literal on the right is an immediate. An
+	operator whose operands take the same number needs one more than them, as one operand's value has to be held while the
+	other's computed, otherwise it needs as many as the heavier operand, if that one is computed first.
+
+	Computing the right operand first changes nothing about the result, unless one of the operands calls a function, which may
+	have side effects or change what the other reads through a pointer, so those are always computed left to right.
+
+	The labels also tell which subtrees call a function or divide, both of which clobber registers the generator otherwise
+	holds values in.
+*/
+namespace SethiUllman
+{
+	struct Label
+	{
+		ui32 need = 0;
+		bool hasCall = false;
+		bool hasDivision = false;
+	};
+
+	using Labels = std::unordered_map<AST::Node*, Label>;
+
+	// Labels expr and every node under it.
+	const Label& LabelExpression(AST::Node* expr, Labels& outLabels);
+
+	// Literals, locals and addresses of locals, which take no computing.
+	bool IsLeaf(AST::Node* n);
+
+	// A literal on the right of any operator but division is used as an immediate, rather than being loaded into a register.
+	// Only 32 bit immediates are encodable, and they're sign extended, so the value comes out the same.
+	bool IsImmediateOperand(const Op_k op, AST::Node* rhs);
+
+	// Whether the operation's right operand is computed before its left one.
+	bool EvaluatesRightFirst(AST::OpNode* opNode, const Labels& labels);
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "StrengthReduction.h"
+
+static bool IsPowerOfTwo(const ui64 value)
+{
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+static ui32 GetLog2(ui64 value)
+{
+	ui32 log = 0;
+	while (value > 1)
+	{
+		value >>= 1;
+		log++;
+	}
+	return log;
+}
+
+// lea multiplies by 3, 5 or 9.
+static bool IsLeaFactor(const ui64 value)
+{
+	return value == 3 || value == 5 || value == 9;
+}
+
+StrengthReduction::UnsignedDivision StrengthReduction::GetUnsignedDivision(const ui64 divisor)
+{
+	// Finds the smallest p for which 2^p / divisor, rounded up, is close enough to the reciprocal that no 64 bit dividend is off
+	// by one, keeping q = (2^p - 1) / divisor and r = (2^p - 1) % divisor as p grows.
+	constexpr ui64 highBit = 1ull << 63;
+
+	UnsignedDivision division;
+	ui32 p = 63;
+	ui64 q = (highBit - 1) / divisor;
+	ui64 r = (highBit - 1) - q * divisor;
+	ui64 p64 = 0;
+	ui64 delta = 0;
+	do
+	{
+		p++;
+
+		// 2^(p - 64)
+		p64 = p == 64 ? 1 : p64 * 2;
+
+		if (r + 1 >= divisor - r)
+		{
+			division.isAdd = division.isAdd || q >= highBit - 1;
+			q = 2 * q + 1;
+			r = 2 * r + 1 - divisor;
+		}
+		else
+		{
+			division.isAdd = division.isAdd || q >= highBit;
+			q = 2 * q;
+			r = 2 * r + 1;
+		}
+		delta = divisor - 1 - r;
+	} while (p < 128 && p64 < delta);
+
+	division.multiplier = q + 1;
+	division.shift = p - 64;
+	return division;
+}
+
+bool StrengthReduction::MultiplyInPlace(const i64 constant, const std::string& reg, std::vector<std::string>& outInstructions)
+{
+	if (constant == 0 || constant == INT64_MIN)
+	{
+		return false;
+	}
+
+	const ui64 magnitude = constant < 0 ? 0 - (ui64)constant : (ui64)constant;
+	const auto lea = [&](const ui64 factor) { return "lea " + reg + ", [" + reg + "+" + reg + "*" + std::to_string(factor - 1) + "]"; };
+
+	std::vector<std::string> instructions;
+	if (IsPowerOfTwo(magnitude))
+	{
+		if (magnitude != 1)
+		{
+			instructions.push_back("shl " + reg + ", " + std::to_string(GetLog2(magnitude)));
+		}
+	}
+	else
+	{
+		const ui64 oddPart = magnitude >> GetLog2(magnitude & (0 - magnitude));
+		const ui64 powerPart = magnitude / oddPart;
+
+		if (IsLeaFactor(oddPart))
+		{
+			instructions.push_back(lea(oddPart));
+		}
+		else
+		{
+			// Two leas in a row.
+			for (const ui64 factor : { 3ull, 5ull, 9ull })
+			{
+				if (oddPart % factor == 0 && IsLeaFactor(oddPart / factor))
+				{
+					instructions.push_back(lea(factor));
+					instructions.push_back(lea(oddPart / factor));
+					break;
+				}
+			}
+			if (instructions.empty())
+			{
+				return false;
+			}
+		}
+
+		if (powerPart != 1)
+		{
+			instructions.push_back("shl " + reg + ", " + std::to_string(GetLog2(powerPart)));
+		}
+	}
+
+	if (constant < 0)
+	{
+		instructions.push_back("neg " + reg);
+	}
+	if (instructions.size() > 2)
+	{
+		return false;
+	}
+
+	outInstructions.insert(outInstructions.end(), instructions.begin(), instructions.end());
+	return true;
+}
+
+bool StrengthReduction::DivideInPlace(const ui64 divisor, const std::string& reg, std::vector<std::string>& outInstructions)
+{
+	if (divisor == 0)
+	{
+		return false;
+	}
+	if (IsPowerOfTwo(divisor))
+	{
+		if (divisor != 1)
+		{
+			outInstructions.push_back("shr " + reg + ", " + std::to_string(GetLog2(divisor)));
+		}
+		return true;
+	}
+
+	// mul leaves the high half of RAX * reg in RDX.
+	const UnsignedDivision division = GetUnsignedDivision(divisor);
+	outInstructions.push_back("mov RAX, " + std::to_string((i64)division.multiplier));
+	outInstructions.push_back("mul " + reg);
+
+	if (!division.isAdd)
+	{
+		if (division.shift != 0)
+		{
+			outInstructions.push_back("shr RDX, " + std::to_string(division.shift));
+		}
+		outInstructions.push_back("mov " + reg + ", RDX");
+		return true;
+	}
+
+	// The 65th bit of the magic number adds x again, halved first so the sum doesn't overflow.
+	outInstructions.push_back("sub " + reg + ", RDX");
+	outInstructions.push_back("shr " + reg + ", 1");
+	outInstructions.push_back("add " + reg + ", RDX");
+	if (division.shift > 1)
+	{
+		outInstructions.push_back("shr " + reg + ", " + std::to_string(division.shift - 1));
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../Definitions.h"
+
+/*
+	Cheaper instructions for multiplications and divisions by constants, for both code generators.
+
+	A multiplication by a power of 2 is a shift, and one by 3, 5 or 9 a lea, which adds a register to itself scaled by 2, 4 or 8.
+	Constants that are a product of two of those, or negated, take two instructions, which still beat imul's latency of 3.
+	The low 64 bits of a product are the same whether it's signed or unsigned, so this is right for every type.
+
+	Division is unsigned and 64 bits wide, like div, the operands' types only say how many of the bits are in use. A division by a
+	power of 2 is a shift, any other one a multiplication by the divisor's reciprocal, scaled to a 64 bit fixed point magic number
+	and rounded up, of which the high half of the product is kept(Granlund & Montgomery, Division by Invariant Integers using
+	Multiplication, with the magic numbers found as in Warren's Hacker's Delight, 10-10). Some divisors need a 65 bit magic number,
+	whose top bit is added back in with a few more instructions. Either way it's exact for every dividend, and a handful of cycles
+	instead of div's few dozen.
+*/
+namespace StrengthReduction
+{
+	// The magic number and shifts that divide by a divisor other than 0 and the powers of 2.
+	//   isAdd == false:  q = mulhi(x, multiplier) >> shift
+	//   isAdd == true:   t = mulhi(x, multiplier), q = (((x - t) >> 1) + t) >> (shift - 1), where shift >= 1
+	struct UnsignedDivision
+	{
+		ui64 multiplier = 0;
+		ui32 shift = 0;
+		bool isAdd = false;
+	};
+
+	UnsignedDivision GetUnsignedDivision(const ui64 divisor);
+
+	// The instructions multiplying the 64 bit register reg by constant in place. Returns false if imul is as good.
+	bool MultiplyInPlace(const i64 constant, const std::string& reg, std::vector<std::string>& outInstructions);
+
+	// The instructions dividing the 64 bit register reg by divisor in place, writing RAX and RDX too, so reg can't be either of
+	// them. Returns false for division by 0, which is left to fault like it would.
+	bool DivideInPlace(const ui64 divisor, const std::string& reg, std::vector<std::string>& outInstructions);
+}
\ No newline at end of file
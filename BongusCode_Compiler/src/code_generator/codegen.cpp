@@ -1,72 +1,72 @@
 #include "codegen.h"
+#include "Registers.h"
+#include "RegisterAllocator.h"
+#include "SethiUllman.h"
+#include "StrengthReduction.h"
+#include "IRLowering.h"
 #include "../AST/ASTNode.h"
 #include "../AST/ASTAPI.h"
+#include "../IR/IR_Builder.h"
+#include "../IR/IR_Verifier.h"
+#include "../IR/IR_PassManager.h"
 #include "../symbol_table/symtable.h"
 #include "../Exit.h"
 #include "../Utils.h"
 #include "../CStrLib.h"
+#include "../profiling/Profiler.h"
+#include "../profiling/MemoryAccounting.h"
+#include "../Options.h"
 #include <cassert>
 #include <iostream>
+#include <algorithm>
 
 
 
-namespace Registers
+inline static const std::string& GetReg(RG reg, const PrimitiveType type)
 {
-	enum class eRegisters : ui16
-	{
-		RAX,
-		RBX,
-		RCX,
-		RDX,
-		R8,
-		R9,
-		size
-	};
+	using namespace Registers;
 
-	const std::string Regs[(ui64)eRegisters::size][4] = {
-		{ "RAX", "EAX", "AX", "AL" },
-		{ "RBX", "EBX", "BX", "BL" },
-		{ "RCX", "ECX", "CX", "CL" },
-		{ "RDX", "EDX", "DX", "DL" },
-		{ "R8", "R8D", "R8W", "R8B" },
-		{ "R9", "R9D", "R9W", "R9B" },
-	};
+	return Regs[(ui64)reg][GetSubscriptFromType(type)];
+}
 
-	inline static const ui16 GetSubscriptFromType(const PrimitiveType type)
-	{
-		switch (type)
-		{
-		case PrimitiveType::ui64:
-		case PrimitiveType::i64:
-		case PrimitiveType::pointer:
-			return 0;
+namespace CurrentFunctionMetaData
+{
+	// How far into the stack local variables occupy.
+	// After this point, the stack space left is used for temporaries
+	// during expression evaluation.
+	i32 varsStackSectionSize = 0;
 
-		case PrimitiveType::ui32:
-		case PrimitiveType::i32:
-			return 1;
+	// This is the amount our temporaries consume.
+	// varsStackSectionSize + temporariesStackSectionSize = total stack size
+	i32 temporariesStackSectionSize = 0;
 
-		case PrimitiveType::ui16:
-		case PrimitiveType::i16:
-			return 2;
+	static std::string funcName("NO_NAME_ASSIGNED");
 
-		case PrimitiveType::ui8:
-		case PrimitiveType::i8:
-			return 3;
+	PrimitiveType retType;
 
-		default:
-			wprintf(L"ERROR: Type %hu supplied to " __FUNCSIG__ " does not correspond with any register size.\n", type);
-			Exit(ErrCodes::internal_compiler_error);
-			return -1;
-		}
-	}
-}
+	AST::FunctionNode* currentFunction = nullptr;
 
-using RG = Registers::eRegisters;
-inline static const std::string& GetReg(RG reg, const PrimitiveType type)
-{
-	using namespace Registers;
+	// Which locals, iteration variables and temporaries are kept in registers, see RegisterAllocator.h.
+	RegisterAllocator::Allocation registers;
 
-	return Regs[(ui64)reg][GetSubscriptFromType(type)];
+	// The registers the temporaries of the statement being generated can take, which of them are taken, and the most that were
+	// taken at once.
+	static const std::vector<RG>* temporaryRegisters = nullptr;
+	static bool isTemporaryRegisterTaken[(ui64)RG::size] = {};
+	static ui64 temporaryRegistersTaken = 0;
+	static ui64 temporaryRegistersPeak = 0;
+
+	// The addresses of the statement's spill slots that were given back, reused before the temporaries' section grows.
+	static std::vector<i32> freeSpillSlots;
+
+	// The Sethi-Ullman labels of the statement being generated's expressions, see SethiUllman.h.
+	static SethiUllman::Labels expressionLabels;
+
+	// Every register the function ended up using. The callee-saved ones have to be saved in the prologue.
+	static bool isRegisterUsed[(ui64)RG::size] = {};
+
+	// Whether a return jumps to the epilogue, which then needs its label.
+	static bool isReturnLabelUsed = false;
 }
 
 // Processes local variables by incrementing the total allocation size, aswell as entering
@@ -80,6 +80,14 @@ void ProcessLocalsCallback(AST::Node* n, void* args)
 		AST::DeclNode* asDeclNode = (AST::DeclNode*)n;
 
 		SymTabEntry* entry = asDeclNode->GetSymTabEntry();
+
+		// Locals kept in a register don't need a slot.
+		if (CurrentFunctionMetaData::registers.locals.count(entry) != 0)
+		{
+			entry->asVar.adress = -1;
+			return;
+		}
+
 		entry->asVar.adress = *allocSize;
 
 
@@ -87,23 +95,6 @@ void ProcessLocalsCallback(AST::Node* n, void* args)
 	}
 }
 
-namespace CurrentFunctionMetaData
-{
-	// How far into the stack local variables occupy.
-	// After this point, the stack space left is used for temporaries
-	// during expression evaluation.
-	i32 varsStackSectionSize = 0;
-
-	// This is the amount our temporaries consume.
-	// varsStackSectionSize + temporariesStackSectionSize = total stack size
-	i32 temporariesStackSectionSize = 0;
-
-	static std::string funcName("NO_NAME_ASSIGNED");
-
-	PrimitiveType retType;
-
-	AST::FunctionNode* currentFunction = nullptr;
-}
 
 // This uses pointers instead of modifying the above namespace's globals directly, so we can easily swap out where the metadata
 // will be stored in the future.
@@ -112,6 +103,15 @@ inline static void ResetFunctionMetaData(i32* varsStackSectionSize, i32* tempora
 	*varsStackSectionSize = 0;
 	*temporariesStackSectionSize = 0;
 	*funcName = std::string("NO_NAME_ASSIGNED");
+
+	CurrentFunctionMetaData::registers = RegisterAllocator::Allocation();
+	CurrentFunctionMetaData::temporaryRegisters = nullptr;
+	CurrentFunctionMetaData::temporaryRegistersTaken = 0;
+	CurrentFunctionMetaData::temporaryRegistersPeak = 0;
+	CurrentFunctionMetaData::freeSpillSlots.clear();
+	CurrentFunctionMetaData::expressionLabels.clear();
+	CurrentFunctionMetaData::isReturnLabelUsed = false;
+	std::fill(std::begin(CurrentFunctionMetaData::isRegisterUsed), std::end(CurrentFunctionMetaData::isRegisterUsed), false);
 }
 
 ui32 AllocLocals(AST::Node* funcHeadNode)
@@ -129,6 +129,16 @@ struct TempVar
 	std::string name;
 	i32 adress;
 	PrimitiveType type;
+
+	// RG::size if the temporary is on the stack, at adress.
+	RG reg = RG::size;
+};
+
+// Where a local or a temporary is kept, a register or a stack slot.
+struct Location
+{
+	i32 adress;
+	RG reg;
 };
 
 
@@ -179,7 +189,196 @@ inline static const ui16 GetSizeFromType(const PrimitiveType type)
 	}
 };
 
+// Call before generating a statement, its temporaries take the registers the register allocator left free for it.
+inline static void UseTemporaryRegistersOf(AST::Node* statement)
+{
+	const auto found = CurrentFunctionMetaData::registers.temporaries.find(statement);
+	CurrentFunctionMetaData::temporaryRegisters = found == CurrentFunctionMetaData::registers.temporaries.end() ? nullptr : &found->second;
+	std::fill(std::begin(CurrentFunctionMetaData::isTemporaryRegisterTaken), std::end(CurrentFunctionMetaData::isTemporaryRegisterTaken), false);
+	CurrentFunctionMetaData::temporaryRegistersTaken = 0;
+	CurrentFunctionMetaData::temporaryRegistersPeak = 0;
+	CurrentFunctionMetaData::freeSpillSlots.clear();
+	CurrentFunctionMetaData::expressionLabels.clear();
+}
+
+// Takes the statement's first free register, or returns RG::size once they're all taken.
+inline static RG TakeTemporaryRegister(void)
+{
+	if (CurrentFunctionMetaData::temporaryRegisters == nullptr)
+	{
+		return RG::size;
+	}
 
+	for (const RG reg : *CurrentFunctionMetaData::temporaryRegisters)
+	{
+		if (!CurrentFunctionMetaData::isTemporaryRegisterTaken[(ui64)reg])
+		{
+			CurrentFunctionMetaData::isTemporaryRegisterTaken[(ui64)reg] = true;
+			CurrentFunctionMetaData::isRegisterUsed[(ui64)reg] = true;
+			CurrentFunctionMetaData::temporaryRegistersTaken++;
+			CurrentFunctionMetaData::temporaryRegistersPeak = std::max(CurrentFunctionMetaData::temporaryRegistersPeak, CurrentFunctionMetaData::temporaryRegistersTaken);
+			return reg;
+		}
+	}
+
+	return RG::size;
+}
+
+inline static void ReleaseTemporaryRegister(const RG reg)
+{
+	CurrentFunctionMetaData::isTemporaryRegisterTaken[(ui64)reg] = false;
+	CurrentFunctionMetaData::temporaryRegistersTaken--;
+}
+
+// For when the registers run out. Spills are consumed in the opposite order they're made, so the statement's section only
+// grows by the most spills held at once.
+inline static TempVar TakeSpillSlot(void)
+{
+	if (CurrentFunctionMetaData::freeSpillSlots.empty())
+	{
+		return AllocStackSpace(&CurrentFunctionMetaData::temporariesStackSectionSize, 8, PrimitiveType::ui64);
+	}
+
+	const i32 adress = CurrentFunctionMetaData::freeSpillSlots.back();
+	CurrentFunctionMetaData::freeSpillSlots.pop_back();
+	return { "_t" + std::to_string(g_tempsNamingCounter++), adress, PrimitiveType::ui64 };
+}
+
+inline static void ReleaseSpillSlot(const i32 adress)
+{
+	CurrentFunctionMetaData::freeSpillSlots.push_back(adress);
+}
+
+
+// --remarks: Explains the stack frame the code generator lays out for each function, as it makes its decisions.
+namespace Remarks
+{
+	// The line of the statement being generated, for what's decided below the statement level, like calls' alignment.
+	static ui32 currentLine = 0;
+
+	// The most temporaries any statement needed, loop iteration variables included, which is what sizes the temporaries' section.
+	static i32 largestTemporaries = 0;
+	static ui32 largestTemporariesLine = 0;
+
+	inline static void Remark(const ui32 line, const std::string& message)
+	{
+		wprintf(L"REMARK: %S, line %u: %S\n", CurrentFunctionMetaData::funcName.c_str(), line, message.c_str());
+	}
+
+	inline static std::string Count(const i64 count, const char* noun)
+	{
+		return std::to_string(count) + " " + noun + (count == 1 ? "" : "s");
+	}
+
+	// The ones kept in registers first, then in the order they're laid out in the locals' section.
+	inline static void RemarkLocals(AST::FunctionNode* functionNode)
+	{
+		std::vector<AST::Node*> declNodes = AST::GetAllChildNodesOfType(functionNode, Node_k::DeclNode);
+		std::stable_sort(declNodes.begin(), declNodes.end(), [](AST::Node* a, AST::Node* b) {
+			return ((AST::DeclNode*)a)->GetSymTabEntry()->asVar.adress < ((AST::DeclNode*)b)->GetSymTabEntry()->asVar.adress;
+		});
+
+		const std::unordered_set<SymTabEntry*> addressTaken = AST::GetAddressTakenLocals(functionNode);
+		std::unordered_set<SymTabEntry*> used;
+		for (AST::Node* symNode : AST::GetAllChildNodesOfType(functionNode, Node_k::SymNode))
+		{
+			used.insert(((AST::SymNode*)symNode)->GetSymTabEntry());
+		}
+
+		for (AST::Node* n : declNodes)
+		{
+			AST::DeclNode* asDeclNode = (AST::DeclNode*)n;
+			const std::string local = "Local " + MangleName(asDeclNode->GetName().c_str()) + ", " + std::to_string(asDeclNode->GetSize()) + " bytes";
+
+			const auto reg = CurrentFunctionMetaData::registers.locals.find(asDeclNode->GetSymTabEntry());
+			if (reg != CurrentFunctionMetaData::registers.locals.end())
+			{
+				Remark(n->GetLine(), local + ", kept in " + GetReg(reg->second, PrimitiveType::ui64) + ".");
+				continue;
+			}
+
+			// Locals only stay on the stack if their address is taken, if they're never used, or if busier ones took the registers.
+			std::string reason = ", busier locals took the registers";
+			if (addressTaken.count(asDeclNode->GetSymTabEntry()) != 0) { reason = ", its address or a neighbour's is taken"; }
+			else if (used.count(asDeclNode->GetSymTabEntry()) == 0) { reason = ", it's never used"; }
+			Remark(n->GetLine(), local + " at " + std::to_string(asDeclNode->GetSymTabEntry()->asVar.adress) + "[rsp]" + reason + ".");
+		}
+	}
+
+	// Call once the statement has been generated, while its temporaries are still allocated. need is its expression's
+	// Sethi-Ullman label.
+	inline static void RemarkTemporaries(const char* statementKind, const ui32 need, const i32 reservedMem)
+	{
+		const i32 temporaries = CurrentFunctionMetaData::temporariesStackSectionSize;
+		if (temporaries > largestTemporaries)
+		{
+			largestTemporaries = temporaries;
+			largestTemporariesLine = currentLine;
+		}
+
+		std::string message = std::string(statementKind) + " needs " + Count(need, "register") + ", it got RAX and " +
+			std::to_string(CurrentFunctionMetaData::temporaryRegistersPeak) + " more, and spills " + Count(temporaries - reservedMem, "byte");
+		if (reservedMem != 0)
+		{
+			message += ", on top of the " + std::to_string(reservedMem) + " bytes held by the iteration variables of the loops around it";
+		}
+		Remark(currentLine, message + ".");
+	}
+
+	inline static void RemarkLoop(const std::string& loopNumber, const TempVar& iterVar, const i32 iterVarSize)
+	{
+		if (iterVar.reg != RG::size)
+		{
+			Remark(currentLine, "For loop " + loopNumber + " keeps its iteration variable " + iterVar.name + " in " + GetReg(iterVar.reg, PrimitiveType::ui64) +
+				" until it exits.");
+			return;
+		}
+
+		Remark(currentLine, "For loop " + loopNumber + " reserves " + iterVar.name + ", " + std::to_string(iterVarSize) + " bytes at " +
+			std::to_string(CurrentFunctionMetaData::varsStackSectionSize + iterVar.adress) + "[rsp], for its iteration variable until it exits. "
+			"Its body's temporaries start after it.");
+
+		const i32 temporaries = CurrentFunctionMetaData::temporariesStackSectionSize;
+		if (temporaries > largestTemporaries)
+		{
+			largestTemporaries = temporaries;
+			largestTemporariesLine = currentLine;
+		}
+	}
+
+	inline static void RemarkFrame(AST::FunctionNode* functionNode, const std::vector<RG>& savedRegisters)
+	{
+		const i32 locals = CurrentFunctionMetaData::varsStackSectionSize;
+		const i32 temporaries = CurrentFunctionMetaData::temporariesStackSectionSize;
+		const ui64 declarationCount = AST::GetAllChildNodesOfType(functionNode, Node_k::DeclNode).size() - CurrentFunctionMetaData::registers.locals.size();
+
+		const i32 saved = 8 * (i32)savedRegisters.size();
+
+		std::string message = "Frame is " + std::to_string(saved + locals + temporaries) + " bytes. ";
+		if (saved != 0)
+		{
+			message += std::to_string(saved) + " for the " + Count((i64)savedRegisters.size(), "callee-saved register") + " the function uses, saved by the prologue. ";
+		}
+		message += std::to_string(locals) + " for locals";
+		if (declarationCount != 0)
+		{
+			message += ", every one of the " + Count(declarationCount, "declaration") + " kept on the stack, parameters and nested scopes included, gets a slot of its own";
+		}
+		message += ". " + std::to_string(temporaries) + " for temporaries";
+		if (temporaries != 0)
+		{
+			message += ", the most any statement needed at once, at line " + std::to_string(largestTemporariesLine);
+		}
+		Remark(functionNode->GetLine(), message + ".");
+	}
+
+	inline static void Reset(void)
+	{
+		currentLine = 0;
+		largestTemporaries = 0;
+		largestTemporariesLine = 0;
+	}
+}
 
 namespace Prologue
 {
@@ -203,12 +402,27 @@ namespace Prologue
 	{
 		code += "sub rsp, " + std::to_string(allocSize) + "\n";
 	}
+
+	inline static void SaveRegisters(std::string& code, const std::vector<RG>& savedRegisters)
+	{
+		if (savedRegisters.empty())
+		{
+			return;
+		}
+
+		code += "; Save the callee-saved registers the function uses.\n";
+		for (const RG reg : savedRegisters)
+		{
+			code += "push " + GetReg(reg, PrimitiveType::ui64) + "\n";
+		}
+	}
 	
-	inline static void GenerateFunctionPrologue(std::string& code, const i32 stackAllocSizeForLocals, const i32 stackAllocSizeForTemporaries, const std::string& functionName)
+	inline static void GenerateFunctionPrologue(std::string& code, const i32 stackAllocSizeForLocals, const i32 stackAllocSizeForTemporaries, const std::vector<RG>& savedRegisters, const std::string& functionName)
 	{
 		WriteFunctionNameProc(code, functionName);
 	
 		SetupStackFrame(code);
+		SaveRegisters(code, savedRegisters);
 	
 		code += "; Alloc section for local variables.\n";
 		GenerateStackAllocation(code, stackAllocSizeForLocals);
@@ -237,12 +451,28 @@ namespace Epilogue
 		code += "add rsp, " + std::to_string(allocSize) + "\n";
 	}
 
-	inline static void GenerateFunctionEpilogue(std::string& code, const i32 stackAllocSizeForLocals, const i32 stackAllocSizeForTemporaries, const std::string& functionName)
+	// The stack pointer is back at the saved registers once the sections are deallocated.
+	inline static void RestoreRegisters(std::string& code, const std::vector<RG>& savedRegisters)
+	{
+		if (savedRegisters.empty())
+		{
+			return;
+		}
+
+		code += "; Restore the callee-saved registers.\n";
+		for (auto reg = savedRegisters.rbegin(); reg != savedRegisters.rend(); ++reg)
+		{
+			code += "pop " + GetReg(*reg, PrimitiveType::ui64) + "\n";
+		}
+	}
+
+	inline static void GenerateFunctionEpilogue(std::string& code, const i32 stackAllocSizeForLocals, const i32 stackAllocSizeForTemporaries, const std::vector<RG>& savedRegisters, const std::string& functionName)
 	{
 		code += "; Dealloc section for local variables.\n";
 		GenerateStackDeallocation(code, stackAllocSizeForLocals);
 		code += "; Dealloc section for temporary variables.\n";
 		GenerateStackDeallocation(code, stackAllocSizeForTemporaries);
+		RestoreRegisters(code, savedRegisters);
 
 		RestoreStackFrame(code);
 
@@ -269,6 +499,10 @@ bool FindNodeInVisitedNodes(AST::Node* node)
 	return false;
 }
 
+// Numbers the labels of for loops. Starts over at 0 for every function, the labels are suffixed with the function's name anyway.
+// That way a function's code only depends on the function itself, and can be reused when other functions change(see IncrementalCompiler.h).
+static ui32 s_forLoopsEncountered = 0;
+
 namespace Tools
 {
 	inline static std::string GetWordKindFromType(const PrimitiveType type)
@@ -303,9 +537,25 @@ namespace Tools
 		}
 	}
 
-	inline static i32 GetAdressOfTemporary(const TempVar& t)
+	inline static Location GetLocationOfTemporary(const TempVar& t)
 	{
-		return CurrentFunctionMetaData::varsStackSectionSize + t.adress;
+		return { CurrentFunctionMetaData::varsStackSectionSize + t.adress, t.reg };
+	}
+
+	inline static Location GetLocationOfLocal(SymTabEntry* entry)
+	{
+		const auto found = CurrentFunctionMetaData::registers.locals.find(entry);
+		return { entry->asVar.adress, found == CurrentFunctionMetaData::registers.locals.end() ? RG::size : found->second };
+	}
+
+	// The location as an operand of the given width, e.g. ESI or DWORD PTR 4[rsp].
+	inline static std::string RefLocation(const Location& location, const PrimitiveType type)
+	{
+		if (location.reg != RG::size)
+		{
+			return GetReg(location.reg, type);
+		}
+		return GetWordKindFromType(type) + " " + std::to_string(location.adress) + "[rsp]";
 	}
 
 	inline static std::string RefTempVar(const i32 offset, const PrimitiveType type)
@@ -316,11 +566,6 @@ namespace Tools
 		std::string wordKind = GetWordKindFromType(type);
 		return std::string(wordKind + " " + std::to_string(CurrentFunctionMetaData::varsStackSectionSize + offset) + "[rsp]");
 	}
-	inline static std::string RefLocalVar(const i32 offset, const PrimitiveType type)
-	{
-		std::string wordKind = GetWordKindFromType(type);
-		return std::string(wordKind + " " + std::to_string(offset) + "[rsp]");
-	}
 
 	// string1 -> mov variant
 	// string2 -> REG variant
@@ -340,11 +585,11 @@ namespace Tools
 		return std::tuple(movVariant, regVariant, sizeVariant);
 	}
 
-	std::string FetchIntoReg(const RG reg, const i32 sourceAdress, const PrimitiveType sourceType)
+	std::string FetchIntoReg(const RG reg, const Location& source, const PrimitiveType sourceType)
 	{
 		const auto [movVariant, regVariant, sizeVariant] = GetFetchInstructionsForType(reg, sourceType);
 
-		std::string result = movVariant + " " + regVariant + ", " + sizeVariant + " " + std::to_string(sourceAdress) + "[rsp]";
+		std::string result = movVariant + " " + regVariant + ", " + RefLocation(source, sourceType);
 
 		return result;
 	}
@@ -358,11 +603,11 @@ namespace Tools
 		return result;
 	}
 
-	std::string FetchImmediateIntoMem(const i32 destAdress, const PrimitiveType destType, const std::string& immediate)
+	std::string FetchImmediateIntoMem(const Location& dest, const PrimitiveType destType, const std::string& immediate)
 	{
 		const auto [movVariant, regVariant, sizeVariant] = GetFetchInstructionsForType(RG::RAX, destType);
 
-		std::string result = movVariant + " " + sizeVariant + " " + std::to_string(destAdress) + "[rsp], " + immediate;
+		std::string result = movVariant + " " + RefLocation(dest, destType) + ", " + immediate;
 
 		return result;
 	}
@@ -376,9 +621,9 @@ namespace Tools
 		return result;
 	}
 
-	std::string PushRegIntoMem(const RG reg, const i32 destAdress, const PrimitiveType destType)
+	std::string PushRegIntoMem(const RG reg, const Location& dest, const PrimitiveType destType)
 	{
-		std::string result = "mov " + GetWordKindFromType(destType) + " " + std::to_string(destAdress) + "[rsp]" + ", " + GetReg(reg, destType);
+		std::string result = "mov " + RefLocation(dest, destType) + ", " + GetReg(reg, destType);
 
 		return result;
 	}
@@ -413,60 +658,19 @@ namespace Body
 		return std::tuple(readRegStr, writeRegStr, movToRaxOpStr);
 	}
 
-	inline static const PrimitiveType GetPointeeTypeFromDerefNode(AST::DerefNode* derefNode)
-	{
-		/*
-				Hunt through the subexpr until we find a pointer node.
-				Most sane dereference operations evolve from a single pointer, e.g.
-					(pointer + 1) = 200
-				and not typically
-					(pointer + **another pointer**) = 200
-
-				in fact(just checked this in compiler explorer), adding a pointer to another pointer in C++ raises an error,
-				so we can safely look for only 1 pointer in the subexpression, and take it's pointeeType.
-
-				There's a safety check in the semantics pass which checks for more than 1 pointer in a subexpression,
-				which raises an error if several are found, so we can happily pick the first pointee type here and call it a day.
-			*/
-
-		PrimitiveType pointeeType = PrimitiveType::invalid;
-
-		for (AST::Node* symNode : AST::GetAllChildNodesOfType(derefNode, Node_k::SymNode))
-		{
-			AST::SymNode* asSymNode = (AST::SymNode*)symNode;
-			SymTabEntry* entry = asSymNode->GetSymTabEntry();
-
-			if (entry->asVar.type == PrimitiveType::pointer)
-			{
-				// Find first pointer, get it's pointee-type and break.
-				pointeeType = entry->asVar.pointeeType;
-				break;
-			}
-		}
-
-		if (pointeeType == PrimitiveType::invalid)
-		{
-			wprintf(L"ERROR: couldn't find pointee type in " __FUNCTION__ "\n");
-			Exit(ErrCodes::internal_compiler_error);
-		}
-
-		return pointeeType;
-	}
-
-	inline static const std::string GenDerefCode(const PrimitiveType pointeeType)
+	inline static const std::string GenDerefCode(const RG reg, const PrimitiveType pointeeType)
 	{
-			std::string readReg(GetReg(RG::RAX, pointeeType));
+			std::string readReg(GetReg(reg, pointeeType));
 			std::string movToRaxOp("mov ");
 			std::string wordKind = GetWordKindFromType(pointeeType);
 			if (pointeeType == PrimitiveType::ui16 || pointeeType == PrimitiveType::i16)
 			{
 				movToRaxOp = "movzx ";
-				readReg = Registers::Regs[(ui16)RG::RAX][0]; // Yields RAX.
+				readReg = GetReg(reg, PrimitiveType::ui64);
 			}
 			
-			// By this point, the entire expression should be generated and held in rax.
-			// Dereference rax and store it out in _t0.
-			std::string output = "\n" + movToRaxOp + readReg + ", " + wordKind + "[RAX]\n";
+			// By this point, the pointer should be computed and held in reg. Dereference it into reg.
+			std::string output = "\n" + movToRaxOp + readReg + ", " + wordKind + "[" + GetReg(reg, PrimitiveType::ui64) + "]\n";
 
 			return output;
 	}
@@ -479,6 +683,12 @@ namespace Body
 				const i32 alignmentPadding = 16;
 				const std::string alignmentPaddingString = std::to_string(alignmentPadding);
 
+				if (g_options.remarks)
+				{
+					Remarks::Remark(Remarks::currentLine, "Call to " + funcName + " reserves a fixed " + alignmentPaddingString +
+						" bytes of stack around it. This does not align RSP, so the 16 byte alignment external C functions need is not guaranteed.");
+				}
+
 				std::string result = "; Align by " + alignmentPaddingString + " (16 byte alignment is a requirement for extern calls)\n" \
 														 "sub RSP, " + alignmentPaddingString + "\n"
 														 "call " + funcName + "\n" \
@@ -493,287 +703,397 @@ namespace Body
 		};
 
 
-		return isExtern ? callExternalFunction(funcName) : callInternalFunction(funcName);
+		return isExtern ? callExternalFunction(funcName) : callInternalFunction(funcName);
+	}
+
+	// Operations are computed 64 bits wide and calls may leave anything in the upper bits of RAX, so as an operand, their value
+	// is truncated to their type, zero extended like every load is.
+	inline static void TruncateOperand(std::string& code, AST::Node* node, const RG reg)
+	{
+		if (node->GetNodeKind() != Node_k::OpNode && node->GetNodeKind() != Node_k::FunctionCallNode)
+		{
+			return;
+		}
+
+		const PrimitiveType type = AST::GetExpressionType(node);
+		switch (GetSizeFromType(type))
+		{
+		case 4: code += "\nmov " + GetReg(reg, type) + ", " + GetReg(reg, type); break;
+		case 2: code += "\nmovzx " + GetReg(reg, PrimitiveType::ui64) + ", " + GetReg(reg, type); break;
+		default: break;
+		}
+	}
+
+	// Where an operand's value is when its operation is generated. Values in registers or spilled are truncated already.
+	struct Operand
+	{
+		RG reg = RG::size;
+
+		// Where it was spilled in the temporaries' section, if it's neither in a register nor a leaf.
+		i32 adress = -1;
+
+		// A leaf that's loaded when the operation needs it.
+		AST::Node* leaf = nullptr;
+	};
+
+	inline static void GenLeafCode(std::string& code, AST::Node* leaf, const RG reg)
+	{
+		switch (leaf->GetNodeKind())
+		{
+		case Node_k::IntNode:
+		{
+			code += "\n" + FetchImmediateIntoReg(reg, std::to_string((i64)((AST::IntNode*)leaf)->Get()));
+			break;
+		}
+		case Node_k::SymNode:
+		{
+			AST::SymNode* asSymNode = (AST::SymNode*)leaf;
+			SymTabEntry* entry = asSymNode->GetSymTabEntry();
+
+			if (entry == nullptr)
+			{
+				wprintf(L"ERROR: Couldn't find symtable entry for %s.\n", asSymNode->GetName().c_str());
+				Exit(ErrCodes::undeclared_symbol);
+			}
+
+			code += "\n; " + GetReg(reg, PrimitiveType::ui64) + " = " + MangleName(asSymNode->GetName().c_str()) + "\n" +
+							FetchIntoReg(reg, GetLocationOfLocal(entry), entry->asVar.type);
+			break;
+		}
+		case Node_k::AddrOfNode:
+		{
+			AST::AddrOfNode* asAddrOfNode = (AST::AddrOfNode*)leaf;
+
+			code += "\n; " + GetReg(reg, PrimitiveType::ui64) + " = &" + MangleName(asAddrOfNode->GetName().c_str()) + "\n" +
+							OperateOnReg(reg, "lea", asAddrOfNode->GetSymTabEntry()->asVar.adress, PrimitiveType::pointer);
+			break;
+		}
+		}
+	}
+
+	inline static void MoveOperandIntoReg(std::string& code, const RG reg, const Operand& operand)
+	{
+		if (operand.leaf != nullptr)
+		{
+			GenLeafCode(code, operand.leaf, reg);
+		}
+		else if (operand.reg == RG::size)
+		{
+			code += "\nmov " + GetReg(reg, PrimitiveType::ui64) + ", " + RefTempVar(operand.adress, PrimitiveType::ui64);
+		}
+		else if (operand.reg != reg)
+		{
+			code += "\nmov " + GetReg(reg, PrimitiveType::ui64) + ", " + GetReg(operand.reg, PrimitiveType::ui64);
+		}
+	}
+
+	// The operand as the source of a 64 bit instruction. Leaves that can't be one where they are, like locals narrower than 64
+	// bits, are loaded into scratch first.
+	inline static std::string GetOperandString(std::string& code, const Operand& operand, const RG scratch)
+	{
+		if (operand.leaf == nullptr)
+		{
+			return operand.reg == RG::size ? RefTempVar(operand.adress, PrimitiveType::ui64) : GetReg(operand.reg, PrimitiveType::ui64);
+		}
+
+		if (operand.leaf->GetNodeKind() == Node_k::IntNode)
+		{
+			const i64 value = (i64)((AST::IntNode*)operand.leaf)->Get();
+			if (value >= INT32_MIN && value <= INT32_MAX)
+			{
+				return std::to_string(value);
+			}
+		}
+		else if (operand.leaf->GetNodeKind() == Node_k::SymNode)
+		{
+			SymTabEntry* entry = ((AST::SymNode*)operand.leaf)->GetSymTabEntry();
+			if (entry != nullptr && GetSizeFromType(entry->asVar.type) == 8)
+			{
+				return RefLocation(GetLocationOfLocal(entry), entry->asVar.type);
+			}
+		}
+
+		GenLeafCode(code, operand.leaf, scratch);
+		return GetReg(scratch, PrimitiveType::ui64);
+	}
+
+	inline static void GenImmediateOperationCode(std::string& code, const Op_k op, const RG dest, const i64 immediate)
+	{
+		const std::string& destString = GetReg(dest, PrimitiveType::ui64);
+		const std::string immediateString = std::to_string(immediate);
+
+		// The shifts only look at the low 6 bits of the amount, in CL or not.
+		const std::string shiftString = std::to_string(immediate & 63);
+
+		switch (op)
+		{
+		case Op_k::ADD: code += "\nadd " + destString + ", " + immediateString; break;
+		case Op_k::SUB: code += "\nsub " + destString + ", " + immediateString; break;
+		case Op_k::MUL:
+		{
+			std::vector<std::string> instructions;
+			if (!StrengthReduction::MultiplyInPlace(immediate, destString, instructions))
+			{
+				instructions.push_back("imul " + destString + ", " + destString + ", " + immediateString);
+			}
+			for (const std::string& instruction : instructions)
+			{
+				code += "\n" + instruction;
+			}
+			break;
+		}
+		case Op_k::SHL: code += "\nshl " + destString + ", " + shiftString; break;
+		case Op_k::SHR: code += "\nshr " + destString + ", " + shiftString; break;
+		case Op_k::AND: code += "\nand " + destString + ", " + immediateString; break;
+		case Op_k::OR: code += "\nor " + destString + ", " + immediateString; break;
+		default:
+		{
+			wprintf(L"ERROR: No immediate form of the operator in " __FUNCTION__ "\n");
+			Exit(ErrCodes::internal_compiler_error);
+		}
+		}
+	}
+
+	// Computes lhs op rhs into dest, which holds one of the two already.
+	inline static void GenOperationCode(std::string& code, const Op_k op, const RG dest, const Operand& lhs, Operand rhs)
+	{
+		const std::string& destString = GetReg(dest, PrimitiveType::ui64);
+
+		if (lhs.reg != dest)
+		{
+			// The right operand is in dest. Either the operator commutes, or the right operand moves over to RCX.
+			if (op == Op_k::ADD || op == Op_k::MUL || op == Op_k::AND || op == Op_k::OR)
+			{
+				rhs = lhs;
+			}
+			else
+			{
+				code += "\nmov RCX, " + destString;
+				MoveOperandIntoReg(code, dest, lhs);
+				rhs = { RG::RCX };
+			}
+		}
+
+		switch (op)
+		{
+		case Op_k::ADD:
+		case Op_k::SUB:
+		case Op_k::AND:
+		case Op_k::OR:
+		{
+			static const char* s_mnemonics[] = { "", "add", "sub", "", "", "", "", "and", "or" };
+
+			const std::string source = GetOperandString(code, rhs, RG::RCX);
+			code += "\n" + std::string(s_mnemonics[(ui16)op]) + " " + destString + ", " + source;
+			break;
+		}
+		case Op_k::MUL:
+		{
+			// Literals too large to be an immediate, which may still be powers of 2.
+			std::vector<std::string> instructions;
+			const bool isLiteral = rhs.leaf != nullptr && rhs.leaf->GetNodeKind() == Node_k::IntNode;
+			if (isLiteral && StrengthReduction::MultiplyInPlace((i64)((AST::IntNode*)rhs.leaf)->Get(), destString, instructions))
+			{
+				for (const std::string& instruction : instructions)
+				{
+					code += "\n" + instruction;
+				}
+				break;
+			}
+
+			// imul only takes an immediate in its 3 operand form.
+			const std::string source = GetOperandString(code, rhs, RG::RCX);
+			const bool isImmediate = rhs.leaf != nullptr && rhs.leaf->GetNodeKind() == Node_k::IntNode && source != "RCX";
+			code += "\nimul " + destString + ", " + (isImmediate ? destString + ", " : "") + source;
+			break;
+		}
+		case Op_k::DIV:
+		{
+			// Division by a literal is a shift or a multiplication, see StrengthReduction.h. The multiplication writes RAX and RDX,
+			// so a dividend in either of them is divided in RCX.
+			std::vector<std::string> instructions;
+			const bool isLiteral = rhs.leaf != nullptr && rhs.leaf->GetNodeKind() == Node_k::IntNode;
+			const RG work = dest == RG::RAX || dest == RG::RDX ? RG::RCX : dest;
+			if (isLiteral && StrengthReduction::DivideInPlace((ui64)((AST::IntNode*)rhs.leaf)->Get(), GetReg(work, PrimitiveType::ui64), instructions))
+			{
+				if (work != dest)
+				{
+					code += "\nmov RCX, " + destString;
+				}
+				for (const std::string& instruction : instructions)
+				{
+					code += "\n" + instruction;
+				}
+				if (work != dest)
+				{
+					code += "\nmov " + destString + ", RCX";
+				}
+				break;
+			}
+
+			// For 64 bit division, the dividend goes in RDX:RAX, the result in RAX and the remainder in RDX.
+			MoveOperandIntoReg(code, RG::RBX, rhs);
+			if (dest != RG::RAX)
+			{
+				code += "\nmov RAX, " + destString;
+			}
+			code += "\nxor RDX, RDX"		// The upper half of the dividend.
+							"\ndiv RBX";
+			if (dest != RG::RAX)
+			{
+				code += "\nmov " + destString + ", RAX";
+			}
+			break;
+		}
+		case Op_k::SHL:
+		case Op_k::SHR:
+		{
+			// The amount to shift by has to be in CL.
+			if (rhs.reg != RG::RCX)
+			{
+				MoveOperandIntoReg(code, RG::RCX, rhs);
+			}
+			code += std::string(op == Op_k::SHL ? "\nshl " : "\nshr ") + destString + ", CL";
+			break;
+		}
+		}
 	}
 
-	static TempVar GenOpNodeCode(std::string& code, AST::Node* node)
+	// Generates code computing the expression into dest, in the order SethiUllman.h describes. Besides dest and the temporary
+	// registers it takes, only RCX is written, and RAX, RBX and RDX by divisions, as well as everything calls clobber.
+	static void GenExpressionCode(std::string& code, AST::Node* node, const RG dest)
 	{
 		visitedNodes.push_back(node);
 
-	
 		switch (node->GetNodeKind())
 		{
 		case Node_k::OpNode:
 		{
 			AST::OpNode* asOpNode = (AST::OpNode*)node;
 			const Op_k op = asOpNode->GetOp();
-	
+			AST::Node* lhs = asOpNode->GetLHS();
+			AST::Node* rhs = asOpNode->GetRHS();
 
-			TempVar t0 = GenOpNodeCode(code, asOpNode->GetLHS());
-			TempVar t1 = GenOpNodeCode(code, asOpNode->GetRHS());
-	
-			const i32 t0ActualAdress = GetAdressOfTemporary(t0);
-			const PrimitiveType t0Type = t0.type;
-
-			const i32 t1ActualAdress = GetAdressOfTemporary(t1);
-			const PrimitiveType t1Type = t1.type;
-
-			switch (op)
-			{
-			// Arithmetical operators.
-			case Op_k::ADD:
+			// Leaves on the right are used where they are.
+			if (SethiUllman::IsLeaf(rhs))
 			{
-				/*
-					Transition from
-					add RAX, MEM			to
-
-					mov RCX, MEM
-					add RAX, RCX
-
-					This transition is for cases when a 64 bit value (e.g. pointer) is being calculated from
-					a pointer variable plus an offset, and this offset is of a type other than a 64-bit wide type,
-					the adding (or subtracting or any other arithmetical operation done with a source operand straight from memory)
-					of e.g. a 32 bit wide type will null out the top 4 bytes of RAX, invalidating your pointer.
-				*/
-				//std::string output = "\n; " + t0.name + " += " + t1.name + "\n" +
-				//	FetchIntoReg(RG::RAX, t0ActualAdress, t0Type) + "\n" +
-				//	OperateOnReg(RG::RAX, "add", t1ActualAdress, t1Type) + "\n" +
-				//	PushRegIntoMem(RG::RAX, t0ActualAdress, t0Type);
-				std::string output = "\n; " + t0.name + " += " + t1.name + "\n" +
-					FetchIntoReg(RG::RAX, t0ActualAdress, t0Type) + "\n" \
-					"xor RCX, RCX\n" +
-					FetchIntoReg(RG::RCX, t1ActualAdress, t1Type) + "\n" \
-					"add RAX, RCX\n" +
-					PushRegIntoMem(RG::RAX, t0ActualAdress, t0Type);
-					
-				code += output;
+				GenExpressionCode(code, lhs, dest);
+				TruncateOperand(code, lhs, dest);
+				visitedNodes.push_back(rhs);
 
+				if (SethiUllman::IsImmediateOperand(op, rhs))
+				{
+					GenImmediateOperationCode(code, op, dest, (i64)((AST::IntNode*)rhs)->Get());
+				}
+				else
+				{
+					GenOperationCode(code, op, dest, { dest }, { RG::size, -1, rhs });
+				}
 				break;
 			}
-			case Op_k::SUB:
-			{
-				std::string output = "\n; " + t0.name + " -= " + t1.name + "\n" +
-					FetchIntoReg(RG::RAX, t0ActualAdress, t0Type) + "\n" \
-					"xor RCX, RCX\n" +
-					FetchIntoReg(RG::RCX, t1ActualAdress, t1Type) + "\n" \
-					"sub RAX, RCX\n" +
-					PushRegIntoMem(RG::RAX, t0ActualAdress, t0Type);
 
-				code += output;
+			const bool isRightFirst = SethiUllman::EvaluatesRightFirst(asOpNode, CurrentFunctionMetaData::expressionLabels);
+			AST::Node* first = isRightFirst ? rhs : lhs;
+			AST::Node* second = isRightFirst ? lhs : rhs;
 
-				break;
-			}
-			case Op_k::MUL:
-			{
-				std::string output = "\n; " + t0.name + " *= " + t1.name + "\n" +
-					FetchIntoReg(RG::RAX, t0ActualAdress, t0Type) + "\n" \
-					"xor RCX, RCX\n" +
-					FetchIntoReg(RG::RCX, t1ActualAdress, t1Type) + "\n" \
-					"imul RAX, RCX\n" +
-					PushRegIntoMem(RG::RAX, t0ActualAdress, t0Type);
+			GenExpressionCode(code, first, dest);
+			TruncateOperand(code, first, dest);
 
-				code += output;
+			Operand firstOperand = { dest };
+			Operand secondOperand = { dest };
+			RG taken = RG::size;
 
-				break;
-			}
-			case Op_k::DIV:
+			if (SethiUllman::IsLeaf(second))
 			{
-				// TODO: Division is anal. Here's a guide:
-				// https://www.youtube.com/watch?v=vwTYM0oSwjg
-				// TLDR: For 64 bit division, the result goes in rax, the remainder in rdx
-				// The divisor goes in rbx.
-				//const std::string& RBX = GetReg(RG::RBX, exprType);
-				//const std::string& RDX = GetReg(RG::RDX, exprType);
-
-				std::string output = "\n; " + t0.name + " /= " + t1.name + "\n" +
-					FetchIntoReg(RG::RAX, t0ActualAdress, t0Type) + "\n" +									// Store _tfirst in eax
-					FetchIntoReg(RG::RBX, t1ActualAdress, t1Type) + "\n" +									// Store divisor in rbx
-					"xor RDX, RDX\n" +																											// You have to make sure to 0 out rdx first, or else you get an integer underflow :P.
-					"div RBX\n" +																														// Perform operation in ebx
-					FetchImmediateIntoReg(RG::RBX, "3405691582 ; 0xCAFEBABE") + "\n" +			// Store sentinel value CAFEBABE in rbx in case of bugs.
-					FetchImmediateIntoReg(RG::RDX, "4276993775 ; 0xFEEDBEEF") + "\n" +			// Do the same for rdx with FEEDBEEF since it was also used.
-					PushRegIntoMem(RG::RAX, t0ActualAdress, t0Type);												// Store result in _tfirst on stack
-				code += output;
-
-				break;
+				// A leaf on the left, loaded once the operation needs it.
+				visitedNodes.push_back(second);
+				secondOperand = { RG::size, -1, second };
 			}
-
-			// Bitwise operators.
-			case Op_k::SHL:
+			else
 			{
-				std::string output = "\n; Bring in amount to shift left by into RCX(" + t1.name + ")\n" \
-					"xor RCX, RCX\n" + // Null out
-					FetchIntoReg(RG::RCX, t1ActualAdress, t1Type) + "\n" \
-					"; " + t0.name + " <<= " + t1.name + "\n" +
-					FetchIntoReg(RG::RAX, t0ActualAdress, t0Type) + "\n" \
-					"shl RAX, CL\n" +
-					PushRegIntoMem(RG::RAX, t0ActualAdress, t0Type);
+				// Whatever holds the first operand has to survive computing the second one.
+				const SethiUllman::Label& secondLabel = CurrentFunctionMetaData::expressionLabels.at(second);
+				const bool isDestClobbered = (secondLabel.hasCall && !RegisterAllocator::IsCalleeSaved(dest)) || (secondLabel.hasDivision && dest == RG::RAX);
 
-				code += output;
+				taken = TakeTemporaryRegister();
+				if (taken != RG::size && !isDestClobbered)
+				{
+					GenExpressionCode(code, second, taken);
+					TruncateOperand(code, second, taken);
+					secondOperand = { taken };
+				}
+				else
+				{
+					if (taken != RG::size)
+					{
+						code += "\nmov " + GetReg(taken, PrimitiveType::ui64) + ", " + GetReg(dest, PrimitiveType::ui64);
+						firstOperand = { taken };
+					}
+					else
+					{
+						const TempVar spill = TakeSpillSlot();
+						code += "\n; Out of registers, spill " + GetReg(dest, PrimitiveType::ui64) + " to " + spill.name + "\n" +
+										"mov " + RefTempVar(spill.adress, PrimitiveType::ui64) + ", " + GetReg(dest, PrimitiveType::ui64);
+						firstOperand = { RG::size, spill.adress };
+					}
 
-				break;
+					GenExpressionCode(code, second, dest);
+					TruncateOperand(code, second, dest);
+				}
 			}
-			case Op_k::SHR:
-			{
-				std::string output = "\n; Bring in amount to shift right by into RCX(" + t1.name + ")\n" \
-					"xor RCX, RCX\n" + // Null out
-					FetchIntoReg(RG::RCX, t1ActualAdress, t1Type) + "\n" \
-					"; " + t0.name + " >>= " + t1.name + "\n" +
-					FetchIntoReg(RG::RAX, t0ActualAdress, t0Type) + "\n" \
-					"shr RAX, CL\n" +
-					PushRegIntoMem(RG::RAX, t0ActualAdress, t0Type);
 
-				code += output;
+			GenOperationCode(code, op, dest, isRightFirst ? secondOperand : firstOperand, isRightFirst ? firstOperand : secondOperand);
 
-				break;
-			}
-			case Op_k::AND:
+			if (taken != RG::size)
 			{
-				std::string output = "\n; " + t0.name + " &= " + t1.name + "\n" +
-					FetchIntoReg(RG::RAX, t0ActualAdress, t0Type) + "\n" \
-					"xor RCX, RCX\n" +
-					FetchIntoReg(RG::RCX, t1ActualAdress, t1Type) + "\n" \
-					"and RAX, RCX\n" +
-					PushRegIntoMem(RG::RAX, t0ActualAdress, t0Type);
-
-				code += output;
-
-				break;
+				ReleaseTemporaryRegister(taken);
 			}
-			case Op_k::OR:
+			else if (firstOperand.reg == RG::size)
 			{
-				std::string output = "\n; " + t0.name + " |= " + t1.name + "\n" +
-					FetchIntoReg(RG::RAX, t0ActualAdress, t0Type) + "\n" \
-					"xor RCX, RCX\n" +
-					FetchIntoReg(RG::RCX, t1ActualAdress, t1Type) + "\n" \
-					"or RAX, RCX\n" +
-					PushRegIntoMem(RG::RAX, t0ActualAdress, t0Type);
-
-				code += output;
-
-				break;
-			}
+				ReleaseSpillSlot(firstOperand.adress);
 			}
-
-			return t0;
+			break;
 		}
 		case Node_k::IntNode:
-		{
-			AST::IntNode* asIntNode = (AST::IntNode*)node;
-
-			const PrimitiveType t0Type = AST::IntNode::s_defaultIntLiteralType;
-			TempVar t0 = AllocStackSpace(&CurrentFunctionMetaData::temporariesStackSectionSize, GetSizeFromType(t0Type), t0Type);
-
-			std::string intValueAsString = std::to_string(asIntNode->Get());
-			const i32 t0ActualAdress = GetAdressOfTemporary(t0);
-			
-
-			std::string output = "\n; " + t0.name + " = " + intValueAsString + "\n" +
-													 FetchImmediateIntoMem(t0ActualAdress, t0Type, intValueAsString) + "\n" +
-													 FetchIntoReg(RG::RAX, t0ActualAdress, t0Type);
-
-			code += output;
-	
-			return t0;
-		}
 		case Node_k::SymNode:
+		case Node_k::AddrOfNode:
 		{
-			AST::SymNode* asSymNode = (AST::SymNode*)node;
-
-			SymTabEntry* entry = asSymNode->GetSymTabEntry();
-
-			if (entry == nullptr)
-			{
-				wprintf(L"ERROR: Couldn't find symtable entry for %s.\n", asSymNode->GetName().c_str());
-				Exit(ErrCodes::undeclared_symbol);
-			}
-
-			TempVar t0 = AllocStackSpace(&CurrentFunctionMetaData::temporariesStackSectionSize, GetSizeFromType(entry->asVar.type), entry->asVar.type);
-			const i32 t0ActualAdress = GetAdressOfTemporary(t0);
-
-			std::string output = "\n; " + t0.name + " = " + MangleName(asSymNode->GetName().c_str()) + "\n" +
-													 FetchIntoReg(RG::RAX, entry->asVar.adress, t0.type) + "\n" +
-													 PushRegIntoMem(RG::RAX, t0ActualAdress, t0.type);
-
-			code += output;
-
-			return t0;
+			GenLeafCode(code, node, dest);
+			break;
 		}
 		case Node_k::FunctionCallNode:
 		{
 			AST::FunctionCallNode* asFunctionCallNode = (AST::FunctionCallNode*)node;
 
 			// We've already made sure in the harvest pass that this is indeed a function, and in the semantics pass that this function can be called.
-			std::string output;
-
-			PushArgsIntoRegs(output, asFunctionCallNode);
+			PushArgsIntoRegs(code, asFunctionCallNode);
 
 			SymTabEntry* entry = asFunctionCallNode->GetSymTabEntry();
-
-			//std::string mangledFunctionName = std::string(MangleFunctionName(asFunctionCallNode->GetName().c_str()));
-			std::string mangledFunctionName = entry->functionName;
-			
-			const PrimitiveType funcRetType = entry->asFunction.retType;
-			TempVar t0 = AllocStackSpace(&CurrentFunctionMetaData::temporariesStackSectionSize, GetSizeFromType(funcRetType), funcRetType);
-			const i32 t0ActualAdress = GetAdressOfTemporary(t0);
-
-			// Make sure to also store the result out into _t0.
-			output += "\n; " + t0.name + " = result of function " + mangledFunctionName + "\n" +
-								CallFunction(mangledFunctionName, entry->asFunction.isExtern) + "\n" +
-								PushRegIntoMem(RG::RAX, t0ActualAdress, funcRetType);
-
-			code += output;
-
-			return t0;
-		}
-		case Node_k::AddrOfNode:
-		{
-			AST::AddrOfNode* asAddrOfNode = (AST::AddrOfNode*)node;
-			SymTabEntry* entry = asAddrOfNode->GetSymTabEntry();
-			const PrimitiveType addrOfNodeExprType = PrimitiveType::pointer;
-
-			TempVar t0 = AllocStackSpace(&CurrentFunctionMetaData::temporariesStackSectionSize, GetSizeFromType(addrOfNodeExprType), addrOfNodeExprType);
-
-			const i32 t0ActualAdress = GetAdressOfTemporary(t0);
-			std::string output = "\n; " + t0.name + " = &" + MangleName(asAddrOfNode->GetName().c_str()) + "\n" +
-													 OperateOnReg(RG::RAX, "lea", entry->asVar.adress, addrOfNodeExprType) + "\n" +
-													 PushRegIntoMem(RG::RAX, t0ActualAdress, addrOfNodeExprType);
-
-
-			code += output;
-
-			return t0;
+			code += "\n; " + GetReg(dest, PrimitiveType::ui64) + " = result of function " + entry->functionName + "\n" +
+							CallFunction(entry->functionName, entry->asFunction.isExtern);
+			if (dest != RG::RAX)
+			{
+				code += "\nmov " + GetReg(dest, PrimitiveType::ui64) + ", RAX";
+			}
+			break;
 		}
 		case Node_k::DerefNode:
 		{
 			AST::DerefNode* asDerefNode = (AST::DerefNode*)node;
-			const PrimitiveType pointerType = PrimitiveType::pointer;
-			
-			TempVar t0 = AllocStackSpace(&CurrentFunctionMetaData::temporariesStackSectionSize, GetSizeFromType(pointerType), pointerType);
-
-			const PrimitiveType pointeeType = GetPointeeTypeFromDerefNode(asDerefNode);
-
-			TempVar t1 = GenOpNodeCode(code, asDerefNode->GetExpr());
+			const PrimitiveType pointeeType = AST::GetPointeeTypeFromDerefNode(asDerefNode);
 
-			std::string output = GenDerefCode(pointeeType);
-			const i32 t0ActualAdress = GetAdressOfTemporary(t0);
-			
-
-			output += "\n; Move out to " + t0.name + "\n" +
-								PushRegIntoMem(RG::RAX, t0ActualAdress, t0.type);
-
-			code += output;
-
-			return t0;
+			GenExpressionCode(code, asDerefNode->GetExpr(), dest);
+			code += GenDerefCode(dest, pointeeType);
+			break;
 		}
 		}
 	}
 
-	// This function generates code to store a value into a memory address either through reading a variable
+	// This function generates code to store a value into a register or a memory address either through reading a variable
 	// or by supplying an immediate value, depending on if the node given is a symNode or an intNode.
-	inline static void GenAssignmentToStackMem(std::string& code, AST::Node* valueNode, const ui32 stackAddress, const PrimitiveType assigneeType)
+	inline static void GenAssignmentToLocation(std::string& code, AST::Node* valueNode, const Location& destination, const PrimitiveType assigneeType)
 	{
-		std::string assignmentString = GetWordKindFromType(assigneeType) + " " + std::to_string(stackAddress) + "[rsp]";
+		std::string assignmentString = RefLocation(destination, assigneeType);
 
 		switch (valueNode->GetNodeKind())
 		{
@@ -804,7 +1124,7 @@ namespace Body
 				symType
 			);
 
-			std::string output = "\n" + movToRaxOp + readReg + ", " + RefLocalVar(entry->asVar.adress, symType) +
+			std::string output = "\n" + movToRaxOp + readReg + ", " + RefLocation(GetLocationOfLocal(entry), symType) +
 													 "\nmov " + assignmentString + ", " + writeReg;
 
 			code += output;
@@ -814,7 +1134,7 @@ namespace Body
 		}
 	}
 
-	inline static void GenForLoopHeadComparison(std::string& code, AST::Node* upperBound, const std::string& labelToJumpTo, const ui32 iterVarAddress, const PrimitiveType iterVarType)
+	inline static void GenForLoopHeadComparison(std::string& code, AST::Node* upperBound, const std::string& labelToJumpTo, const Location& iterVarLocation, const PrimitiveType iterVarType)
 	{
 		switch (upperBound->GetNodeKind())
 		{
@@ -837,7 +1157,7 @@ namespace Body
 			SymTabEntry* entry = asSymNode->GetSymTabEntry();
 			const PrimitiveType symType = entry->asVar.type;
 
-			const std::string bringInSymString = GetWordKindFromType(entry->asVar.type) + " " + std::to_string(entry->asVar.adress) + "[rsp]";
+			const std::string bringInSymString = RefLocation(GetLocationOfLocal(entry), entry->asVar.type);
 			const auto [readReg, writeReg, movToRaxOp] = GetTypeDependentInstructions(
 				RG::RAX,
 				RG::RAX,
@@ -854,7 +1174,7 @@ namespace Body
 		}
 		
 		// Now it's time to compare with the iter variable and jump if greater than or equal to.
-		const std::string iterVarString = GetWordKindFromType(iterVarType) + " " + std::to_string(iterVarAddress) + "[rsp]";
+		const std::string iterVarString = RefLocation(iterVarLocation, iterVarType);
 		code += "\ncmp " + iterVarString + ", " + GetReg(RG::RAX, iterVarType) +
 						"\njge " + labelToJumpTo + "\n";
 	}
@@ -869,8 +1189,8 @@ namespace Body
 		const std::string& exitLabel
 	)
 	{
-		const i32 actualAddress = GetAdressOfTemporary(iterVar);
-		GenAssignmentToStackMem(code, node->GetLowerBound(), actualAddress, iterVarType);
+		const Location iterVarLocation = GetLocationOfTemporary(iterVar);
+		GenAssignmentToLocation(code, node->GetLowerBound(), iterVarLocation, iterVarType);
 
 
 		// Now we must generate the jump instruction.
@@ -878,38 +1198,61 @@ namespace Body
 
 		// And then for the actual head, where we increment the iter variable.
 
-		const std::string iterVarAssignmentString = GetWordKindFromType(iterVarType) + " " + std::to_string(actualAddress) + "[rsp]";
+		const std::string iterVarAssignmentString = RefLocation(iterVarLocation, iterVarType);
 
 		const std::string& toFromReg = GetReg(RG::RAX, iterVarType);
 
-		code += "\n" + headLabel + ":\n" +
-						"\nmov " + toFromReg + ", " + iterVarAssignmentString +
-						"\ninc " + toFromReg +
-						"\nmov " + iterVarAssignmentString + ", " + toFromReg + "\n";
+		if (iterVarLocation.reg != RG::size)
+		{
+			code += "\n" + headLabel + ":\n" +
+							"\ninc " + iterVarAssignmentString + "\n";
+		}
+		else
+		{
+			code += "\n" + headLabel + ":\n" +
+							"\nmov " + toFromReg + ", " + iterVarAssignmentString +
+							"\ninc " + toFromReg +
+							"\nmov " + iterVarAssignmentString + ", " + toFromReg + "\n";
+		}
 
 
 		// Now we can generate code for the comparison between iterVar and the upper bound.
-		GenForLoopHeadComparison(code, node->GetUpperBound(), exitLabel, actualAddress, iterVarType);
+		GenForLoopHeadComparison(code, node->GetUpperBound(), exitLabel, iterVarLocation, iterVarType);
 	}
 
 	void GenerateFunctionBody(std::string& code, AST::Node* node, i32* const largestTempAllocation, const i32 reservedMem);
 
 	inline static void GenForLoopCode(std::string& code, AST::ForLoopNode* node, i32* const largestTempAllocation, const i32 reservedMem)
 	{
-		// The iter var(typically i in C/C++ for loops) will be maintained as a temporary variable.
+		// The iter var(typically i in C/C++ for loops) will be maintained as a temporary variable, in a register if the
+		// register allocator gave it one.
 		const PrimitiveType iterVarType = PrimitiveType::ui64;
-		TempVar iterVar = AllocStackSpace(&CurrentFunctionMetaData::temporariesStackSectionSize, GetSizeFromType(iterVarType), iterVarType);
+		TempVar iterVar;
+		i32 iterVarStackSize = 0;
+		const auto iterVarRegister = CurrentFunctionMetaData::registers.iterationVariables.find(node);
+		if (iterVarRegister != CurrentFunctionMetaData::registers.iterationVariables.end())
+		{
+			iterVar = { "_t" + std::to_string(g_tempsNamingCounter++), 0, iterVarType, iterVarRegister->second };
+			CurrentFunctionMetaData::isRegisterUsed[(ui64)iterVar.reg] = true;
+		}
+		else
+		{
+			iterVarStackSize = GetSizeFromType(iterVarType);
+			iterVar = AllocStackSpace(&CurrentFunctionMetaData::temporariesStackSectionSize, iterVarStackSize, iterVarType);
+		}
 		
 		
-		// This variable will not take functions into account, so if it encounters 2 loops in function Foo,
-		// and then a loop in main, the main loop will not start over numbered as 0.
-		static ui32 s_forLoopsEncountered = 0;
 		std::string forLoopNumStr = std::to_string(s_forLoopsEncountered);
 		std::string headLabel = "LH" + forLoopNumStr + "@" + CurrentFunctionMetaData::funcName;
 		std::string bodyLabel = "LB" + forLoopNumStr + "@" + CurrentFunctionMetaData::funcName;
 		std::string exitLabel = "LE" + forLoopNumStr + "@" + CurrentFunctionMetaData::funcName;
 		s_forLoopsEncountered++;
 
+		if (g_options.remarks)
+		{
+			Remarks::RemarkLoop(forLoopNumStr, iterVar, GetSizeFromType(iterVarType));
+		}
+
 		// Fix the head (iter var init + comparison)
 		GenForLoopHeadCode(code, (AST::ForLoopHeadNode*)node->GetHead(), iterVar, iterVarType, headLabel, bodyLabel, exitLabel);
 
@@ -917,7 +1260,7 @@ namespace Body
 		code += bodyLabel + ":\n";
 		// Important -- This ensures that when GenerateFunctionBody clears the temporaries section, it doesn't completely clear
 		// everything, including our iter variable, instead clearing everything up until the iter variable.
-		const i32 reservedMemSize = GetSizeFromType(iterVarType) + reservedMem;
+		const i32 reservedMemSize = iterVarStackSize + reservedMem;
 		GenerateFunctionBody(code, node->GetBody(), largestTempAllocation, reservedMemSize);
 
 		// Jump back to head after executing an iteration.
@@ -981,16 +1324,20 @@ namespace Body
 			const PrimitiveType argType = GetTypeFromNode(arg);
 			const i32 exprSize = GetSizeFromType(argType);
 
-			// We need to generate the code for the values we're pushing before we push them.
-			TempVar t0 = GenOpNodeCode(code, arg);
-
+			// Leaves are loaded straight into the argument's register, results of calls are truncated to the argument's type on the way.
 			const std::string& reg = GetReg(callingConvention[nextSlot], argType);
-			const i32 t0ActualAdress = GetAdressOfTemporary(t0);
+			code += "\n; Push argument into " + reg;
 
-			std::string output = "\n; Push " + t0.name + " into " + reg + "\n" +
-													 FetchIntoReg(callingConvention[nextSlot], t0ActualAdress, argType);
-
-			code += output;
+			SethiUllman::LabelExpression(arg, CurrentFunctionMetaData::expressionLabels);
+			if (SethiUllman::IsLeaf(arg))
+			{
+				GenExpressionCode(code, arg, callingConvention[nextSlot]);
+			}
+			else
+			{
+				GenExpressionCode(code, arg, RG::RAX);
+				code += "\n" + FetchIntoReg(callingConvention[nextSlot], { -1, RG::RAX }, argType);
+			}
 
 			// TODO: In the future we might want to support more than 4 arguments.
 			if (!(nextSlot < GetArraySize(callingConvention)))
@@ -1025,7 +1372,7 @@ namespace Body
 			std::string readReg(GetReg(callingConvention[nextSlot], entry->asVar.type));
 			std::string movToRaxOp("mov ");
 
-			code += movToRaxOp + RefLocalVar(entry->asVar.adress, entry->asVar.type) + ", " + readReg + "\n";
+			code += movToRaxOp + RefLocation(GetLocationOfLocal(entry), entry->asVar.type) + ", " + readReg + "\n";
 
 
 			// TODO: In the future we might want to support more than 4 arguments.
@@ -1038,6 +1385,19 @@ namespace Body
 		}
 	}
 	
+	// Whether node ends the body of the function being generated, the code right after it is the epilogue then.
+	inline static bool IsLastStatementOfFunction(AST::Node* node)
+	{
+		for (AST::Node* child : CurrentFunctionMetaData::currentFunction->GetChildren())
+		{
+			if (child->GetNodeKind() == Node_k::ScopeNode && !child->GetChildren().empty() && child->GetChildren().back() == node)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	void GenerateFunctionBody(std::string& code, AST::Node* node, i32* const largestTempAllocation, const i32 reservedMem)
 	{
 		auto gatherLargestAllocation = [](i32* const out, const i32 newAllocSize) -> void {
@@ -1053,6 +1413,11 @@ namespace Body
 		};
 
 		visitedNodes.push_back(node);
+
+		if (node->GetLine() != 0)
+		{
+			Remarks::currentLine = node->GetLine();
+		}
 	
 		switch (node->GetNodeKind())
 		{
@@ -1060,9 +1425,16 @@ namespace Body
 			{
 				// This is just a lone op node without assignment, but we'll perform the evaluation.
 				ResetTempsNaming();
-				TempVar t0 = GenOpNodeCode(code, node);
+				UseTemporaryRegistersOf(node);
+				const ui32 need = SethiUllman::LabelExpression(node, CurrentFunctionMetaData::expressionLabels).need;
+				GenExpressionCode(code, node, RG::RAX);
+
+				if (g_options.remarks)
+				{
+					Remarks::RemarkTemporaries("Expression", need, reservedMem);
+				}
 				
-				// Check to see if the allocation done by the expression evaluation of GenOpNodeCode() requires more memory than the last evaluation.
+				// Check to see if the allocation done by the expression evaluation of GenExpressionCode() requires more memory than the last evaluation.
 				//gatherLargestAllocation(largestTempAllocation, CurrentFunctionMetaData::temporariesStackSectionSize);
 				// Enforce allocation policy.
 				//CurrentFunctionMetaData::temporariesStackSectionSize = 0;
@@ -1077,7 +1449,7 @@ namespace Body
 				AST::AssNode* asAssNode = (AST::AssNode*)node;
 
 				// Get target of assignment
-				i32 stackLocation = -1;
+				Location assigneeLocation = { -1, RG::size };
 				PrimitiveType exprType = PrimitiveType::invalid;
 
 				AST::Node* assNodeVar = asAssNode->GetVar();
@@ -1098,7 +1470,7 @@ namespace Body
 					}
 
 
-					stackLocation = entry->asVar.adress;
+					assigneeLocation = GetLocationOfLocal(entry);
 					exprType = entry->asVar.type;
 
 					break;
@@ -1107,7 +1479,7 @@ namespace Body
 				{
 					AST::DerefNode* derefOp = (AST::DerefNode*)assNodeVar;
 
-					exprType = GetPointeeTypeFromDerefNode(derefOp);
+					exprType = AST::GetPointeeTypeFromDerefNode(derefOp);
 
 					break;
 				}
@@ -1115,7 +1487,8 @@ namespace Body
 
 				// Generate operation code. Remember that the temporaries naming scheme needs to be reset!
 				ResetTempsNaming();
-				TempVar t0 = GenOpNodeCode(code, asAssNode->GetExpr());
+				UseTemporaryRegistersOf(node);
+				ui32 need = SethiUllman::LabelExpression(asAssNode->GetExpr(), CurrentFunctionMetaData::expressionLabels).need;
 
 				std::string output;
 
@@ -1125,8 +1498,10 @@ namespace Body
 				{
 					AST::SymNode* asSymNode = (AST::SymNode*)assNodeVar;
 
+					GenExpressionCode(code, asAssNode->GetExpr(), RG::RAX);
+
 					output = "\n; " + MangleName(asSymNode->GetName().c_str()) + " = Result of expr(rax)\n" +
-									 PushRegIntoMem(RG::RAX, stackLocation, exprType) + "\n";
+									 PushRegIntoMem(RG::RAX, assigneeLocation, exprType) + "\n";
 
 					break;
 				}
@@ -1137,54 +1512,40 @@ namespace Body
 
 					/*
 						mov RAX, ptr
-						mov [RAX], t0(holds expr)
+						mov [RAX], value
 					*/
 
 					AST::DerefNode* asDerefNode = (AST::DerefNode*)assNodeVar;
-					const PrimitiveType pointerType = PrimitiveType::pointer;
-					
-					// Result held in RAX, hence not using t1.
-					TempVar t1 = GenOpNodeCode(code, asDerefNode->GetExpr());
+					AST::Node* pointerExpr = asDerefNode->GetExpr();
+					need = std::max(need, SethiUllman::LabelExpression(pointerExpr, CurrentFunctionMetaData::expressionLabels).need + 1);
 
-					const i32 t0ActualAdress = GetAdressOfTemporary(t0);
-
-
-#pragma region REFACTORINO
-					// Get the correct version of RCX for pushing RCX -> pointee.
-					// TODO: Refactor.
-					std::string RCXVariant("invalid register");
-					switch (pointeeType)
+					// The value is held in a register of its own while the pointer is computed into RAX, or spilled if there's none.
+					RG valueReg = TakeTemporaryRegister();
+					TempVar spill;
+					if (valueReg != RG::size)
 					{
-					case PrimitiveType::ui16:
-					case PrimitiveType::i16:
-						RCXVariant = "CX";
-						break;
-
-					case PrimitiveType::ui32:
-					case PrimitiveType::i32:
-						RCXVariant = "ECX";
-						break;
-
-					case PrimitiveType::ui64:
-					case PrimitiveType::i64:
-						RCXVariant = "RCX";
-						break;
-
-					default:
-						break;
+						GenExpressionCode(code, asAssNode->GetExpr(), valueReg);
+						TruncateOperand(code, asAssNode->GetExpr(), valueReg);
 					}
-					if (RCXVariant == "invalid register")
+					else
 					{
-						wprintf(L"ERROR: Couldn't find register in " __FUNCTION__ "\n");
-						Exit(ErrCodes::internal_compiler_error);
-					}
-#pragma endregion
+						GenExpressionCode(code, asAssNode->GetExpr(), RG::RAX);
+						TruncateOperand(code, asAssNode->GetExpr(), RG::RAX);
 
+						spill = TakeSpillSlot();
+						code += "\n; Out of registers, spill RAX to " + spill.name + "\n" +
+										"mov " + RefTempVar(spill.adress, PrimitiveType::ui64) + ", RAX";
+					}
 
-					output = "\n; Copy " + t0.name + " to rcx, as a middle-man\n" +
-									 FetchIntoReg(RG::RCX, t0ActualAdress, pointerType) + "\n"
-									 "mov [RAX], " + RCXVariant + "\n";
+					GenExpressionCode(code, pointerExpr, RG::RAX);
 
+					if (valueReg == RG::size)
+					{
+						valueReg = RG::RCX;
+						output = "\n; Copy " + spill.name + " to rcx, as a middle-man\n" +
+										 "mov RCX, " + RefTempVar(spill.adress, PrimitiveType::ui64);
+					}
+					output += "\nmov [RAX], " + GetReg(valueReg, pointeeType) + "\n";
 
 					break;
 				}
@@ -1192,6 +1553,11 @@ namespace Body
 
 				code += output;
 
+				if (g_options.remarks)
+				{
+					Remarks::RemarkTemporaries("Assignment", need, reservedMem);
+				}
+
 				//gatherLargestAllocation(largestTempAllocation, CurrentFunctionMetaData::temporariesStackSectionSize);
 				//CurrentFunctionMetaData::temporariesStackSectionSize = 0;
 				enforceAllocationPolicy(gatherLargestAllocation, largestTempAllocation, &CurrentFunctionMetaData::temporariesStackSectionSize, reservedMem);
@@ -1210,11 +1576,26 @@ namespace Body
 
 				// Generate operation code. Remember that the temporaries naming scheme needs to be reset!
 				ResetTempsNaming();
-				TempVar t0 = GenOpNodeCode(code, asReturnNode->GetRetExpr());
+				UseTemporaryRegistersOf(node);
+				const ui32 need = SethiUllman::LabelExpression(asReturnNode->GetRetExpr(), CurrentFunctionMetaData::expressionLabels).need;
+				GenExpressionCode(code, asReturnNode->GetRetExpr(), RG::RAX);
+
+				if (g_options.remarks)
+				{
+					Remarks::RemarkTemporaries("Return", need, reservedMem);
+				}
 
-				// Check to see if the allocation done by the expression evaluation of GenOpNodeCode() requires more memory than the last evaluation.
+				// Check to see if the allocation done by the expression evaluation of GenExpressionCode() requires more memory than the last evaluation.
 				gatherLargestAllocation(largestTempAllocation, CurrentFunctionMetaData::temporariesStackSectionSize);
 
+				// Nothing after a return runs, so unless it's the function's last statement it jumps to the epilogue, like the
+				// IR path's(see IRLowering.cpp).
+				if (!IsLastStatementOfFunction(node))
+				{
+					code += "\njmp LR@" + CurrentFunctionMetaData::funcName + "\n";
+					CurrentFunctionMetaData::isReturnLabelUsed = true;
+				}
+
 				code += "\n\n";
 
 				break;
@@ -1227,6 +1608,7 @@ namespace Body
 
 				PrimitiveType funcRetType = entry->asFunction.retType;
 				
+				UseTemporaryRegistersOf(node);
 				PushArgsIntoRegs(code, asFunctionCallNode);
 
 				code += "\n" + CallFunction(entry->functionName, entry->asFunction.isExtern) + "\n";
@@ -1259,20 +1641,13 @@ namespace Body
 
 namespace Boilerplate
 {
-	inline static std::string GetExternFunctionsList(AST::Node* nodeHead)
+	inline static std::string GetExternFunctionsList(const std::vector<std::string>& externFunctions)
 	{
 		std::string result("; External C functions list\n");
 
-		for (AST::Node* childNode : nodeHead->GetChildren())
+		for (const std::string& functionName : externFunctions)
 		{
-			if (childNode->GetNodeKind() == Node_k::ExternFwdDeclNode)
-			{
-				AST::ExternFwdDeclNode* asExternFwdDeclNode = (AST::ExternFwdDeclNode*)childNode;
-				AST::FwdDeclNode* fwdDeclNode = (AST::FwdDeclNode*)asExternFwdDeclNode->GetFwdDeclNode();
-
-				// The name is mangled in the harvest pass.
-				result += "EXTERN " + fwdDeclNode->GetSymTabEntry()->functionName + " : PROC\n";
-			}
+			result += "EXTERN " + functionName + " : PROC\n";
 		}
 
 		return result;
@@ -1288,13 +1663,13 @@ namespace Boilerplate
 		code += ".code\n";
 	}
 
-	inline static void GenerateHeader(AST::Node* nodeHead, std::string& code)
+	inline static void GenerateHeader(const std::vector<std::string>& externFunctions, std::string& code)
 	{
 		code += "OPTION DOTNAME   ; Allows the use of dot notation(MASM64 requires this for 64 - bit assembly)\n";
 
 		code += "\n\n";
 
-		code += GetExternFunctionsList(nodeHead) + "\n";
+		code += GetExternFunctionsList(externFunctions) + "\n";
 
 		GenerateDataSection(code);
 		GenerateCodeSection(code);
@@ -1308,85 +1683,199 @@ namespace Boilerplate
 	}
 }
 
-void GenerateCode(AST::Node* nodeHead, std::string& outCode)
+void GenerateCodeHeader(const std::vector<std::string>& externFunctions, std::string& outCode)
 {
-	// Note narrowing to narrow string from wide string.
-	std::string boilerplateHeader, boilerplateFooter;
+	Boilerplate::GenerateHeader(externFunctions, outCode);
+}
 
-	Boilerplate::GenerateHeader(nodeHead, boilerplateHeader);
-	outCode = boilerplateHeader;
-	//NOTE /\ is assignment, not += !!!!!
+void GenerateCodeFooter(std::string& outCode)
+{
+	Boilerplate::GenerateFooter(outCode);
+}
 
-	for (AST::Node* childNode : nodeHead->GetChildren())
+void GenerateFunctionCode(AST::FunctionNode* functionNode, std::string& outCode)
+{
+	Profiling::Scope scope("Function", &functionNode->GetSymTabEntry()->functionName);
+	Memory::CategoryScope codegenScope(Memory::Category::codegen);
+
+	if (g_options.emitIR || g_options.IsViaIR())
 	{
-		if (childNode->GetNodeKind() != Node_k::FunctionNode)
+		IR::Function function;
+		IR::BuildFunction(functionNode, function);
+		IR::Verify(function);
+
+		if (g_options.emitIR)
 		{
-			// childNode is a forward declaration node, skip it.
-			continue;
+			const std::string text = IR::PrintFunction(function);
+			wprintf(L"%S", text.c_str());
 		}
+		if (g_options.IsViaIR())
+		{
+			IR::RunPipeline(function);
+			IRLowering::GenerateFunctionCode(function, outCode);
+			return;
+		}
+	}
+
+	std::string prologue, body, epilogue;
+	
+	// Because we use the stack for temporaries, we need to figure out how much stack space to reserve in the body,
+	// and cannot go on amount of declnodes alone in the prologue function.
+	// Therefore, we defer the composing of the complete code until we know the total amount of stack space to reserve.
 
-		AST::FunctionNode* asFunctionNode = (AST::FunctionNode*)childNode;
+	// Firstly, decide which locals are kept in registers, those don't need stack space.
+	RegisterAllocator::AllocateRegisters(functionNode, CurrentFunctionMetaData::registers);
+	for (const auto& [entry, reg] : CurrentFunctionMetaData::registers.locals)
+	{
+		CurrentFunctionMetaData::isRegisterUsed[(ui64)reg] = true;
+	}
 
-		std::string prologue, body, epilogue;
-		
-		// Because we use the stack for temporaries, we need to figure out how much stack space to reserve in the body,
-		// and cannot go on amount of declnodes alone in the prologue function.
-		// Therefore, we defer the composing of the complete code until we know the total amount of stack space to reserve.
+	// Then figure out the amount of stack space required by the other local variables, and allocate them.
+	// Results for variables is stored in the symbol table.
+	CurrentFunctionMetaData::varsStackSectionSize = AllocLocals(functionNode);
 
-		// Firstly, figure out the amount of stack space required by local variables, and allocate them.
-		// Results for variables is stored in the symbol table.
-		CurrentFunctionMetaData::varsStackSectionSize = AllocLocals(childNode);
+	// Special case for the main function, because you can't define the entrypoint to be whatever with the Microsoft linker.
+	std::string mangledFuncName;
+	if (functionNode->GetName() == std::wstring(WideMainFunctionName))
+	{
+		mangledFuncName = "main";
+	}
+	else
+	{
+		mangledFuncName = functionNode->GetSymTabEntry()->functionName;
+	}
+	CurrentFunctionMetaData::funcName = mangledFuncName;
+	CurrentFunctionMetaData::retType = functionNode->GetRetType();
+	CurrentFunctionMetaData::currentFunction = functionNode;
+
+	if (g_options.remarks)
+	{
+		Remarks::RemarkLocals(functionNode);
+	}
+
+	// We need to get the biggest size the stack will ever grow to so we can enforce our allocation policy.
+	// Without this we'd allocate more and more stack size for each expression evaluation, even though temporaries should start back at 0 when evaluating a new expression.
+	i32 largestTemporariesAlloc = 0;
 
-		// Special case for the main function, because you can't define the entrypoint to be whatever with the Microsoft linker.
-		std::string mangledFuncName;
-		if (asFunctionNode->GetName() == std::wstring(WideMainFunctionName))
+	body = "\n\n\n; Body\n";
+	Body::RetrieveArgs(body, functionNode);
+	Body::GenerateFunctionBody(body, functionNode, &largestTemporariesAlloc, 0);
+
+	CurrentFunctionMetaData::temporariesStackSectionSize = largestTemporariesAlloc;
+
+	// Only now is it known which registers the temporaries took. In a fixed order, the epilogue pops them in reverse.
+	std::vector<RG> savedRegisters;
+	for (ui64 reg = 0; reg < (ui64)RG::size; reg++)
+	{
+		if (CurrentFunctionMetaData::isRegisterUsed[reg] && RegisterAllocator::IsCalleeSaved((RG)reg))
 		{
-			mangledFuncName = "main";
+			savedRegisters.push_back((RG)reg);
 		}
-		else
+	}
+
+	if (g_options.remarks)
+	{
+		Remarks::RemarkFrame(functionNode, savedRegisters);
+	}
+
+	prologue = "\n\n\n; Prologue\n";
+	Prologue::GenerateFunctionPrologue(
+		prologue,
+		CurrentFunctionMetaData::varsStackSectionSize,
+		CurrentFunctionMetaData::temporariesStackSectionSize,
+		savedRegisters,
+		CurrentFunctionMetaData::funcName
+	);
+
+	epilogue = "\n\n\n; Epilogue\n";
+	if (CurrentFunctionMetaData::isReturnLabelUsed)
+	{
+		epilogue += "LR@" + CurrentFunctionMetaData::funcName + ":\n";
+	}
+	Epilogue::GenerateFunctionEpilogue(
+		epilogue,
+		CurrentFunctionMetaData::varsStackSectionSize,
+		CurrentFunctionMetaData::temporariesStackSectionSize,
+		savedRegisters,
+		CurrentFunctionMetaData::funcName
+	);
+
+
+	outCode += prologue + body + epilogue;
+
+	ResetFunctionMetaData(
+		&CurrentFunctionMetaData::varsStackSectionSize,
+		&CurrentFunctionMetaData::temporariesStackSectionSize,
+		&CurrentFunctionMetaData::funcName
+	);
+
+	// No node of this function will be visited again, so there's no reason to keep searching through them for the next function.
+	visitedNodes.clear();
+
+	// Loop labels and temporaries are numbered per function.
+	s_forLoopsEncountered = 0;
+	ResetTempsNaming();
+	Remarks::Reset();
+}
+
+void CollectExternFunctions(AST::Node* nodeHead, const std::vector<std::string>& importedExternFunctions, std::vector<std::string>& outExternFunctions)
+{
+	// Imports come first, just as if their declarations had been written at the top of the file.
+	outExternFunctions = importedExternFunctions;
+	for (AST::Node* childNode : nodeHead->GetChildren())
+	{
+		if (childNode->GetNodeKind() == Node_k::ExternFwdDeclNode)
 		{
-			mangledFuncName = asFunctionNode->GetSymTabEntry()->functionName;
-		}
-		CurrentFunctionMetaData::funcName = mangledFuncName;
-		CurrentFunctionMetaData::retType = asFunctionNode->GetRetType();
-		CurrentFunctionMetaData::currentFunction = asFunctionNode;
-
-		// We need to get the biggest size the stack will ever grow to so we can enforce our allocation policy.
-		// Without this we'd allocate more and more stack size for each expression evaluation, even though temporaries should start back at 0 when evaluating a new expression.
-		i32 largestTemporariesAlloc = 0;
-
-		body = "\n\n\n; Body\n";
-		Body::RetrieveArgs(body, asFunctionNode);
-		Body::GenerateFunctionBody(body, childNode, &largestTemporariesAlloc, 0);
-
-		CurrentFunctionMetaData::temporariesStackSectionSize = largestTemporariesAlloc;
-
-		prologue = "\n\n\n; Prologue\n";
-		Prologue::GenerateFunctionPrologue(
-			prologue,
-			CurrentFunctionMetaData::varsStackSectionSize,
-			CurrentFunctionMetaData::temporariesStackSectionSize,
-			CurrentFunctionMetaData::funcName
-		);
-
-		epilogue = "\n\n\n; Epilogue\n";
-		Epilogue::GenerateFunctionEpilogue(
-			epilogue,
-			CurrentFunctionMetaData::varsStackSectionSize,
-			CurrentFunctionMetaData::temporariesStackSectionSize,
-			CurrentFunctionMetaData::funcName
-		);
-	
+			AST::ExternFwdDeclNode* asExternFwdDeclNode = (AST::ExternFwdDeclNode*)childNode;
+			AST::FwdDeclNode* fwdDeclNode = (AST::FwdDeclNode*)asExternFwdDeclNode->GetFwdDeclNode();
+
+			// The name is mangled in the harvest pass.
+			outExternFunctions.push_back(fwdDeclNode->GetSymTabEntry()->functionName);
+		}
+	}
+}
+
+void GenerateCode(AST::Node* nodeHead, std::string& outCode, const std::vector<std::string>& importedExternFunctions)
+{
+	Memory::CategoryScope codegenScope(Memory::Category::codegen);
+
+	std::vector<std::string> externFunctions;
+	CollectExternFunctions(nodeHead, importedExternFunctions, externFunctions);
 
-		outCode += prologue + body + epilogue;
+	// Note narrowing to narrow string from wide string.
+	std::string boilerplateHeader, boilerplateFooter;
+
+	GenerateCodeHeader(externFunctions, boilerplateHeader);
+	outCode = boilerplateHeader;
+	//NOTE /\ is assignment, not += !!!!!
+
+	for (AST::Node* childNode : nodeHead->GetChildren())
+	{
+		if (childNode->GetNodeKind() != Node_k::FunctionNode)
+		{
+			// childNode is a forward declaration node, skip it.
+			continue;
+		}
 
-		ResetFunctionMetaData(
-			&CurrentFunctionMetaData::varsStackSectionSize,
-			&CurrentFunctionMetaData::temporariesStackSectionSize,
-			&CurrentFunctionMetaData::funcName
-		);
+		GenerateFunctionCode((AST::FunctionNode*)childNode, outCode);
 	}
 
-	Boilerplate::GenerateFooter(boilerplateFooter);
+	GenerateCodeFooter(boilerplateFooter);
 	outCode += boilerplateFooter;
 }
+
+
+void ResetCodegenState(void)
+{
+	ResetFunctionMetaData(
+		&CurrentFunctionMetaData::varsStackSectionSize,
+		&CurrentFunctionMetaData::temporariesStackSectionSize,
+		&CurrentFunctionMetaData::funcName
+	);
+	CurrentFunctionMetaData::currentFunction = nullptr;
+
+	ResetTempsNaming();
+	visitedNodes.clear();
+	s_forLoopsEncountered = 0;
+	Remarks::Reset();
+}
\ No newline at end of file
@@ -1,10 +1,26 @@
 #pragma once
 #include <string>
+#include <vector>
 
 namespace AST
 {
 	class Node;
+	class FunctionNode;
 }
 
 
-void GenerateCode(AST::Node* nodeHead, std::string& outCode);
\ No newline at end of file
+// importedExternFunctions are the external C functions declared by imported module interfaces rather than in the AST.
+void GenerateCode(AST::Node* nodeHead, std::string& outCode, const std::vector<std::string>& importedExternFunctions = {});
+
+// The pieces GenerateCode is made of, for drivers that generate code one function at a time.
+// The header needs the (already harvested) names of all external C functions the translation unit declares.
+void GenerateCodeHeader(const std::vector<std::string>& externFunctions, std::string& outCode);
+void GenerateFunctionCode(AST::FunctionNode* functionNode, std::string& outCode);
+void GenerateCodeFooter(std::string& outCode);
+
+// The names of the external C functions the code header has to declare: the imported ones, then the ones declared under nodeHead.
+void CollectExternFunctions(AST::Node* nodeHead, const std::vector<std::string>& importedExternFunctions, std::vector<std::string>& outExternFunctions);
+
+// Forgets everything the code generator carries over from one function to the next, so that another translation unit
+// can be compiled in the same process and come out exactly as it would from a fresh one.
+void ResetCodegenState(void);
\ No newline at end of file
@@ -0,0 +1,326 @@
+#include "CodegenWorker.h"
+#include "../Exit.h"
+#include "../Driver.h"
+#include "../AST/ASTNode.h"
+#include "../symbol_table/symtable.h"
+#include "../code_generator/codegen.h"
+#include "../snapshot/Snapshot.h"
+#include "../server/LocalSocket.h"
+#include "../server/StreamCapture.h"
+#include "../profiling/Profiler.h"
+#include "../Options.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <exception>
+
+#ifndef _WIN32
+#define _write write
+#endif
+
+static constexpr char s_requestMagic[4] = { 'B', 'C', 'W', '2' };
+
+// Limits on a shard's options and snapshot, so a garbled request gets refused rather than allocated.
+static constexpr ui64 s_maxOptionsSize = 1 << 16;
+static constexpr ui64 s_maxShardSize = 1ull << 32;
+
+// More shards than workers, so a worker that gets through its shards early takes over some of the others'.
+static constexpr ui64 s_shardsPerWorker = 4;
+
+struct Shard
+{
+	std::vector<AST::Node*> functions;
+	std::string snapshot;
+
+	// Filled in by whichever worker generated the shard.
+	bool isDone = false;
+	i32 exitCode = (i32)ErrCodes::success;
+	ui64 workerMicroseconds = 0;
+	std::string code;
+	std::string printed;
+};
+
+// Generates the code for one shard. Returns the exit code the compilation would have exited with.
+static i32 GenerateShard(const std::string& snapshot, std::string& outCode, ui64& outFunctionCount)
+{
+	i32 exitCode = (i32)ErrCodes::success;
+
+	try
+	{
+		ui64 nodeCount;
+		AST::Node* functions = Snapshot::LoadFunctions(snapshot, g_symTable, nodeCount);
+
+		for (AST::Node* n = functions; n != nullptr; n = n->GetRightSibling())
+		{
+			if (n->GetNodeKind() != Node_k::FunctionNode)
+			{
+				wprintf(L"ERROR: The shard holds something other than functions.\n");
+				Exit(ErrCodes::malformed_snapshot);
+			}
+
+			GenerateFunctionCode((AST::FunctionNode*)n, outCode);
+			outFunctionCount++;
+		}
+
+		delete functions;
+	}
+	catch (const CompilationAborted& abort)
+	{
+		// Exit() has printed the reason already.
+		exitCode = (i32)abort.errCode;
+	}
+	catch (const std::exception& exception)
+	{
+		wprintf(L"ERROR: Internal compiler error: %S\n", exception.what());
+		exitCode = (i32)ErrCodes::internal_compiler_error;
+	}
+
+	ResetCompilerState();
+
+	return exitCode;
+}
+
+static void ServeCoordinator(Server::LocalSocket& coordinator)
+{
+	char magic[sizeof(s_requestMagic)];
+	std::string options, snapshot;
+	if (!coordinator.ReceiveAll(magic, sizeof(magic)) || memcmp(magic, s_requestMagic, sizeof(magic)) != 0 ||
+		!coordinator.ReceiveString(options, s_maxOptionsSize) || !coordinator.ReceiveString(snapshot, s_maxShardSize))
+	{
+		wprintf(L"WORKER: Dropped a malformed request.\n");
+		return;
+	}
+
+	// The shard is generated with the coordinator's options, not the ones the worker was started with.
+	std::vector<std::string> words;
+	for (ui64 start = 0, end; start < options.size(); start = end + 1)
+	{
+		end = std::min(options.find(' ', start), options.size());
+		if (end != start)
+		{
+			words.push_back(options.substr(start, end - start));
+		}
+	}
+	std::vector<char*> optionsArgv;
+	for (std::string& word : words)
+	{
+		optionsArgv.push_back(word.data());
+	}
+
+	CompilerOptions shardOptions;
+	if (!ParseOptions((i32)optionsArgv.size(), optionsArgv.data(), 0, shardOptions))
+	{
+		wprintf(L"WORKER: Dropped a request with options it doesn't know.\n");
+		return;
+	}
+	const CompilerOptions workerOptions = g_options;
+	g_options = shardOptions;
+
+	// What the code generator prints goes back to the coordinator.
+	StreamCapture stdoutCapture(stdout, true);
+	stdoutCapture.Begin();
+
+	const auto generateStart = std::chrono::steady_clock::now();
+	std::string code;
+	ui64 functionCount = 0;
+	const i32 exitCode = GenerateShard(snapshot, code, functionCount);
+	const auto generateEnd = std::chrono::steady_clock::now();
+
+	const std::string printed = stdoutCapture.End();
+	g_options = workerOptions;
+	const ui64 generateMicroseconds = (ui64)std::chrono::duration_cast<std::chrono::microseconds>(generateEnd - generateStart).count();
+
+	wprintf(L"WORKER: Generated %llu functions from a %llu byte shard in %.2f ms, exit code %i.\n",
+		functionCount, (ui64)snapshot.size(), generateMicroseconds / 1000.0, exitCode);
+
+	if (!coordinator.SendU32((ui32)exitCode) || !coordinator.SendU64(generateMicroseconds) || !coordinator.SendString(code) || !coordinator.SendString(printed))
+	{
+		wprintf(L"WORKER: Coordinator hung up before the response was sent.\n");
+	}
+}
+
+i32 Distributed::RunCodegenWorker(const std::string& socketPath)
+{
+	Server::LocalSocket listener;
+	if (!listener.Listen(socketPath))
+	{
+		wprintf(L"ERROR: Unable to listen on %S.\n", socketPath.c_str());
+		return (i32)ErrCodes::malformed_cmd_line;
+	}
+
+	// From here on, a failed shard must only end the request, not the worker.
+	g_exitThrows = true;
+
+	wprintf(L"WORKER: Listening on %S.\n", socketPath.c_str());
+
+	for (;;)
+	{
+		Server::LocalSocket coordinator;
+		if (!listener.Accept(coordinator))
+		{
+			continue;
+		}
+
+		ServeCoordinator(coordinator);
+	}
+}
+
+// Sends the shard to the connected worker and waits for its code. Returns false if the worker went away.
+static bool ExchangeShard(Server::LocalSocket& worker, const std::string& options, Shard& shard)
+{
+	ui32 exitCode = 0;
+	if (!worker.SendAll(s_requestMagic, sizeof(s_requestMagic)) || !worker.SendString(options) || !worker.SendString(shard.snapshot) ||
+		!worker.ReceiveU32(exitCode) || !worker.ReceiveU64(shard.workerMicroseconds) ||
+		!worker.ReceiveString(shard.code, ~0ull) || !worker.ReceiveString(shard.printed, ~0ull))
+	{
+		return false;
+	}
+
+	shard.exitCode = (i32)exitCode;
+	shard.isDone = true;
+	return true;
+}
+
+void Distributed::GenerateCodeOnWorkers(AST::Node* nodeHead, const SymTable& symTable, const std::vector<std::string>& workerSockets,
+	const std::vector<std::string>& importedExternFunctions, std::string& outCode)
+{
+	const auto distributeStart = std::chrono::steady_clock::now();
+
+	// Cut the functions into contiguous shards of about the same number of nodes, so they can be put back together in order.
+	std::vector<AST::Node*> functions;
+	std::vector<ui64> functionSizes;
+	ui64 totalSize = 0;
+	for (AST::Node* childNode : nodeHead->GetChildren())
+	{
+		if (childNode->GetNodeKind() == Node_k::FunctionNode)
+		{
+			functions.push_back(childNode);
+			functionSizes.push_back(AST::GetAllChildrenRecursively(childNode).size());
+			totalSize += functionSizes.back();
+		}
+	}
+
+	const ui64 shardCount = std::min((ui64)functions.size(), (ui64)workerSockets.size() * s_shardsPerWorker);
+	std::vector<Shard> shards(shardCount);
+
+	ui64 sizeSoFar = 0;
+	for (ui64 i = 0, shardIndex = 0; i < functions.size(); i++)
+	{
+		shards[shardIndex].functions.push_back(functions[i]);
+		sizeSoFar += functionSizes[i];
+
+		// Move on once this shard has its share of the nodes, leaving at least one function for each shard that's left.
+		if (shardIndex + 1 < shardCount && (sizeSoFar * shardCount >= totalSize * (shardIndex + 1) || functions.size() - i - 1 == shardCount - shardIndex - 1))
+		{
+			shardIndex++;
+		}
+	}
+
+	// One thread per worker, each taking the next shard nobody has taken yet, serializing it, and waiting for its code.
+	// The AST and the symbol table are only read from here on, so the shards can be serialized side by side.
+	// A thread whose worker can't be reached stops, leaving the shard it had for later.
+	const auto workersStart = std::chrono::steady_clock::now();
+	std::atomic<ui64> nextShard = 0;
+	std::atomic<ui64> serializeMicroseconds = 0;
+	std::atomic<ui64> snapshotBytes = 0;
+
+	// The options the code comes out differently with, and the IR dumps, which come back with what the workers printed.
+	std::string options = GetOutputAffectingOptions(g_options) + (g_options.emitIR ? "--emit-ir " : "");
+	for (const std::string& pass : g_options.printAfterPasses)
+	{
+		options += "--print-after=" + pass + " ";
+	}
+
+	std::vector<std::thread> threads;
+	for (const std::string& socketPath : workerSockets)
+	{
+		threads.emplace_back([&shards, &nextShard, &serializeMicroseconds, &snapshotBytes, &symTable, &options, socketPath]()
+		{
+			Profiling::SetThreadName("Shard sender");
+
+			for (ui64 shardIndex = nextShard++; shardIndex < shards.size(); shardIndex = nextShard++)
+			{
+				Shard& shard = shards[shardIndex];
+
+				// Connected first, so no time goes into serializing a shard for a worker that isn't there.
+				Server::LocalSocket worker;
+				if (!worker.Connect(socketPath))
+				{
+					return;
+				}
+
+				Profiling::Scope serializeScope("Serializing shard");
+				const auto serializeStart = std::chrono::steady_clock::now();
+				Snapshot::WriteFunctions(shard.functions, symTable, shard.snapshot);
+				serializeScope.End();
+				serializeMicroseconds += (ui64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - serializeStart).count();
+				snapshotBytes += shard.snapshot.size();
+
+				Profiling::Scope exchangeScope("Waiting for the worker", &socketPath);
+				if (!ExchangeShard(worker, options, shard))
+				{
+					return;
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	const auto workersEnd = std::chrono::steady_clock::now();
+
+	std::vector<std::string> externFunctions;
+	CollectExternFunctions(nodeHead, importedExternFunctions, externFunctions);
+
+	std::string header;
+	GenerateCodeHeader(externFunctions, header);
+	outCode = header;
+
+	ui64 localShardCount = 0;
+	ui64 workerMicroseconds = 0;
+	for (Shard& shard : shards)
+	{
+		if (!shard.isDone)
+		{
+			for (AST::Node* function : shard.functions)
+			{
+				GenerateFunctionCode((AST::FunctionNode*)function, outCode);
+			}
+			localShardCount++;
+			continue;
+		}
+
+		// What the worker printed is in the same encoding our own stdout is written in, so it's passed through untouched.
+		if (!shard.printed.empty())
+		{
+			fflush(stdout);
+			(void)_write(_fileno(stdout), shard.printed.data(), (ui32)shard.printed.size());
+		}
+
+		if (shard.exitCode != (i32)ErrCodes::success)
+		{
+			// The worker has printed the reason already, it's ours to abort the compilation.
+			Exit((ErrCodes)shard.exitCode);
+		}
+
+		outCode += shard.code;
+		workerMicroseconds += shard.workerMicroseconds;
+	}
+
+	std::string footer;
+	GenerateCodeFooter(footer);
+	outCode += footer;
+
+	const auto distributeEnd = std::chrono::steady_clock::now();
+	wprintf(L"DISTRIBUTED: Generated %llu functions in %llu shards on %llu workers in %.2f ms, %llu shards generated locally.\n",
+		(ui64)functions.size(), shardCount, (ui64)workerSockets.size(),
+		std::chrono::duration<double, std::milli>(distributeEnd - distributeStart).count(), localShardCount);
+	wprintf(L"DISTRIBUTED: Waited %.2f ms for the workers. Serializing %.2f MB of shards took %.2f ms, the workers spent %.2f ms generating, both in total.\n",
+		std::chrono::duration<double, std::milli>(workersEnd - workersStart).count(), snapshotBytes / (1024.0 * 1024.0),
+		serializeMicroseconds / 1000.0, workerMicroseconds / 1000.0);
+}
\ No newline at end of file
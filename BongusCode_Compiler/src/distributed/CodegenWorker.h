@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../Definitions.h"
+
+namespace AST
+{
+	class Node;
+}
+
+class SymTable;
+
+/*
+	Distributed code generation.
+	The coordinator, an ordinary compile given --worker=PATH, lexes, parses and analyses the translation unit itself, then cuts
+	its functions into contiguous shards of about equal size and hands them out to the codegen workers. It writes the results
+	out in source order, along with the code header and footer.
+	Functions are generated independently of each other, so the output is the same byte for byte as a compile on one machine.
+
+	A shard travels as an in-memory snapshot(see snapshot/Snapshot.h) of its functions' subtrees, and the symbols they refer to:
+	their locals and arguments, and the declarations of the functions they call. That's all code generation ever looks at.
+	The connections are local sockets for now, and the protocol has nothing tied to the machine beyond the snapshot's
+	little endian layout, so the same workers could just as well sit behind a TCP socket on other machines.
+
+	Protocol, one shard per connection, integers in native byte order:
+		Request:  "BCW2", the options that change the generated code(see GetOutputAffectingOptions) as a string, then the
+		          snapshot as a string. The worker generates the shard with those options rather than its own.
+		Response: i32 exit code, u64 code generation time in microseconds, the generated code as a string, and everything the
+		          worker printed, as a string.
+	Strings are a u64 length followed by the bytes.
+
+	Shards a worker can't be reached for, or fails on without a compile error, are generated locally after all the others,
+	so a dead worker slows the build down, but doesn't break it.
+*/
+namespace Distributed
+{
+	// Generates code for whatever shards the coordinators send to socketPath, until the process is killed.
+	// Only returns if the socket couldn't be set up.
+	i32 RunCodegenWorker(const std::string& socketPath);
+
+	// Generates the code for the analysed AST under nodeHead on the workers listening on workerSockets, like GenerateCode().
+	void GenerateCodeOnWorkers(AST::Node* nodeHead, const SymTable& symTable, const std::vector<std::string>& workerSockets,
+		const std::vector<std::string>& importedExternFunctions, std::string& outCode);
+}
\ No newline at end of file
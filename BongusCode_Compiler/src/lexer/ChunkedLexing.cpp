@@ -0,0 +1,181 @@
+#include "ChunkedLexing.h"
+#include "lexer.h"
+#include "../profiling/Profiler.h"
+#include <thread>
+#include <string.h>
+
+yy::ChunkedTokenSource::~ChunkedTokenSource()
+{
+	// Free the ID strings of any tokens the parser never got to.
+	for (ui64 c = currentChunk; c < chunks.size(); c++)
+	{
+		for (ui64 t = (c == currentChunk ? currentToken : 0); t < chunks[c].tokens.size(); t++)
+		{
+			if (chunks[c].tokens[t].kind == BTok::ID)
+			{
+				delete chunks[c].tokens[t].value.str;
+			}
+		}
+	}
+}
+
+void yy::ChunkedTokenSource::Lex(const char* source, const ui64 size, const ui32 threadCount)
+{
+	// Skip past a UTF-8 BOM, as it would be taken for a stray character in the middle of a chunk.
+	const char* begin = source;
+	const char* end = source + size;
+	if (size >= 3 && memcmp(source, "\xEF\xBB\xBF", 3) == 0)
+	{
+		begin += 3;
+	}
+
+	// Cut at the first newline after every 1/threadCount of the source.
+	const ui64 targetChunkSize = (ui64)(end - begin) / (threadCount != 0 ? threadCount : 1) + 1;
+	for (const char* chunkBegin = begin; chunkBegin < end;)
+	{
+		const char* chunkEnd = chunkBegin + targetChunkSize < end ? chunkBegin + targetChunkSize : end;
+		const char* newline = (const char*)memchr(chunkEnd, '\n', end - chunkEnd);
+		chunkEnd = newline != nullptr ? newline + 1 : end;
+
+		chunks.push_back({ chunkBegin, (ui64)(chunkEnd - chunkBegin), 0, 0, {} });
+		chunkBegin = chunkEnd;
+	}
+
+	std::vector<std::thread> threads;
+	for (Chunk& chunk : chunks)
+	{
+		threads.emplace_back(&ChunkedTokenSource::LexChunk, &chunk);
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Stitch the chunks together: every chunk but the last ends in an end-of-input token that the parser mustn't see,
+	// and the line numbers are relative to the start of each chunk.
+	ui32 line = 0;
+	for (ui64 c = 0; c < chunks.size(); c++)
+	{
+		Chunk& chunk = chunks[c];
+		chunk.firstLine = line;
+		line += chunk.newlineCount;
+
+		if (c + 1 != chunks.size())
+		{
+			chunk.tokens.pop_back();
+		}
+	}
+
+	if (chunks.empty())
+	{
+		// Empty input, so all the parser gets is the end.
+		Token endToken = {};
+		chunks.push_back({ begin, 0, 0, 0, { endToken } });
+	}
+}
+
+void yy::ChunkedTokenSource::LexChunk(Chunk* chunk)
+{
+	Profiling::SetThreadName("Lexer");
+	Profiling::Scope scope("Lexing chunk");
+
+	yy::Lexer lexer(reflex::Input(chunk->begin, chunk->size));
+
+	// Roughly one token per 5 bytes of source.
+	chunk->tokens.reserve(chunk->size / 5);
+
+	for (;;)
+	{
+		Token token;
+		location loc;
+		token.kind = lexer.lex(&token.value, &loc);
+		token.beginLine = loc.begin.line;
+		token.beginColumn = loc.begin.column;
+		token.endLine = loc.end.line;
+		token.endColumn = loc.end.column;
+
+		chunk->tokens.push_back(token);
+
+		if (token.kind == 0)
+		{
+			break;
+		}
+	}
+
+	for (const char* c = chunk->begin; (c = (const char*)memchr(c, '\n', chunk->begin + chunk->size - c)) != nullptr; c++)
+	{
+		chunk->newlineCount++;
+	}
+}
+
+i32 yy::ChunkedTokenSource::Next(parser::semantic_type* value, location* loc)
+{
+	while (currentToken == chunks[currentChunk].tokens.size())
+	{
+		currentChunk++;
+		currentToken = 0;
+	}
+
+	const Chunk& chunk = chunks[currentChunk];
+	const Token& token = chunk.tokens[currentToken++];
+
+	*value = token.value;
+	loc->begin.line = token.beginLine + chunk.firstLine;
+	loc->begin.column = token.beginColumn;
+	loc->end.line = token.endLine + chunk.firstLine;
+	loc->end.column = token.endColumn;
+
+	return token.kind;
+}
+
+bool yy::ChunkedTokenSource::VerifyAgainstSerialLexing(const char* source, const ui64 size)
+{
+	const char* begin = source;
+	if (size >= 3 && memcmp(source, "\xEF\xBB\xBF", 3) == 0)
+	{
+		begin += 3;
+	}
+
+	yy::Lexer lexer(reflex::Input(begin, size - (begin - source)));
+
+	ui64 tokenNumber = 0;
+	for (const Chunk& chunk : chunks)
+	{
+		for (const Token& token : chunk.tokens)
+		{
+			parser::semantic_type serialValue;
+			location serialLoc;
+			const i32 serialKind = lexer.lex(&serialValue, &serialLoc);
+
+			// The end of input has no location of its own worth comparing.
+			bool matches = serialKind == token.kind &&
+				(serialKind == 0 || (serialLoc.begin.line == token.beginLine + chunk.firstLine && serialLoc.begin.column == token.beginColumn));
+
+			if (matches && serialKind == BTok::ID)
+			{
+				matches = *serialValue.str == *token.value.str;
+			}
+			else if (matches && serialKind == BTok::NUM_LIT)
+			{
+				matches = serialValue.num == token.value.num;
+			}
+
+			if (serialKind == BTok::ID)
+			{
+				delete serialValue.str;
+			}
+
+			if (!matches)
+			{
+				wprintf(L"ERROR: Chunked lexing differs from serial lexing at token %llu(line %u, column %u).\n",
+					tokenNumber, serialLoc.begin.line, serialLoc.begin.column);
+				return false;
+			}
+
+			tokenNumber++;
+		}
+	}
+
+	wprintf(L"LEXER: Chunked lexing matches serial lexing(%llu tokens).\n", tokenNumber);
+	return true;
+}
\ No newline at end of file
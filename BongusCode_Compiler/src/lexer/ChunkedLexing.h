@@ -0,0 +1,51 @@
+#pragma once
+#include "TokenStream.h"
+#include <vector>
+
+/*
+	Parallel lexing of a single translation unit.
+	BC:PL's lexical structure makes every newline a token boundary: comments run from "||" to the end of the line,
+	and there are no string literals. So the source can be cut into chunks at newlines, each chunk lexed on its own
+	thread with its own lexer, and the per-chunk token arrays read back to back, in order, by the parser.
+*/
+namespace yy
+{
+	class ChunkedTokenSource : public TokenSource
+	{
+	public:
+
+		ChunkedTokenSource() = default;
+		virtual ~ChunkedTokenSource() override;
+
+		// Lexes source on threadCount threads. source must stay alive for as long as the tokens are being read.
+		void Lex(const char* source, const ui64 size, const ui32 threadCount);
+
+		// Lexes source again, serially with a single lexer, and compares the result token by token.
+		// Returns false and prints the first difference if the chunked result doesn't match.
+		bool VerifyAgainstSerialLexing(const char* source, const ui64 size);
+
+		virtual i32 Next(parser::semantic_type* value, location* loc) override;
+
+	private:
+
+		struct Chunk
+		{
+			const char* begin;
+			ui64 size;
+
+			// The line the chunk starts on, so locations can be made absolute again.
+			ui32 firstLine;
+			ui32 newlineCount;
+
+			std::vector<Token> tokens;
+		};
+
+		static void LexChunk(Chunk* chunk);
+
+		std::vector<Chunk> chunks;
+
+		// Read position.
+		ui64 currentChunk = 0;
+		ui64 currentToken = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include "../Definitions.h"
+#include <atomic>
+#include <new>
+
+/*
+	Lock-free single-producer/single-consumer ring buffer.
+	The producer only ever writes tail and the consumer only ever writes head, so the two threads never contend
+	for the same index, and each side keeps its own cached copy of the other side's index to avoid reading it
+	(and pulling in its cache line) on every single push or pop.
+*/
+template<typename T, ui32 Capacity>
+class TokenRing
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "TokenRing capacity must be a power of 2.");
+
+public:
+
+	// Producer side. Returns false if the ring is full.
+	bool TryPush(const T& item)
+	{
+		const ui64 tail = tailIndex.load(std::memory_order_relaxed);
+
+		if (tail - cachedHead == Capacity)
+		{
+			cachedHead = headIndex.load(std::memory_order_acquire);
+			if (tail - cachedHead == Capacity)
+			{
+				return false;
+			}
+		}
+
+		items[tail & s_mask] = item;
+		tailIndex.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// Consumer side. Pops up to maxItems items into outItems, and returns how many were popped(0 if the ring is empty).
+	ui32 PopBatch(T* outItems, const ui32 maxItems)
+	{
+		const ui64 head = headIndex.load(std::memory_order_relaxed);
+
+		if (cachedTail == head)
+		{
+			cachedTail = tailIndex.load(std::memory_order_acquire);
+			if (cachedTail == head)
+			{
+				return 0;
+			}
+		}
+
+		const ui64 available = cachedTail - head;
+		const ui32 count = available < maxItems ? (ui32)available : maxItems;
+
+		for (ui32 i = 0; i < count; i++)
+		{
+			outItems[i] = items[(head + i) & s_mask];
+		}
+
+		headIndex.store(head + count, std::memory_order_release);
+
+		return count;
+	}
+
+	// Only a snapshot, as the other side may move on at any time. Good enough for statistics.
+	ui64 ApproximateSize(void) const
+	{
+		return tailIndex.load(std::memory_order_relaxed) - headIndex.load(std::memory_order_relaxed);
+	}
+
+private:
+
+	static constexpr ui64 s_mask = Capacity - 1;
+	static constexpr size_t s_cacheLineSize = 64;
+
+	// Written by the consumer.
+	alignas(s_cacheLineSize) std::atomic<ui64> headIndex = 0;
+	ui64 cachedTail = 0;
+
+	// Written by the producer.
+	alignas(s_cacheLineSize) std::atomic<ui64> tailIndex = 0;
+	ui64 cachedHead = 0;
+
+	alignas(s_cacheLineSize) T items[Capacity];
+};
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "TokenStream.h"
+#include "lexer.h"
+#include "../profiling/Profiler.h"
+
+i32 yy::LexNextToken(Lexer& lexer, parser::semantic_type* value, location* loc)
+{
+#if PROFILING == 1
+	if (Profiling::g_isEnabled)
+	{
+		Profiling::g_counters.tokens++;
+	}
+#endif
+
+	if (g_tokenSource != nullptr)
+	{
+		return g_tokenSource->Next(value, loc);
+	}
+
+	return lexer.lex(value, loc);
+}
+
+i32 yy::OffsetTokenSource::Next(parser::semantic_type* value, location* loc)
+{
+	const i32 kind = lexer.lex(value, loc);
+	loc->begin.line += lineOffset;
+	loc->end.line += lineOffset;
+
+	return kind;
+}
+
+yy::ThreadedTokenSource::~ThreadedTokenSource()
+{
+	// Only the case when the parse was aborted halfway, normally Finish() has joined the thread already.
+	if (lexerThread.joinable())
+	{
+		Abandon();
+	}
+}
+
+void yy::ThreadedTokenSource::Start(Lexer& lexer)
+{
+	lexerThread = std::thread(&ThreadedTokenSource::LexerMain, this, &lexer);
+}
+
+void yy::ThreadedTokenSource::LexerMain(Lexer* lexer)
+{
+	Profiling::SetThreadName("Lexer");
+	Profiling::Scope scope("Lexing");
+
+	for (;;)
+	{
+		Token token;
+		location loc;
+		token.kind = lexer->lex(&token.value, &loc);
+		token.beginLine = loc.begin.line;
+		token.beginColumn = loc.begin.column;
+		token.endLine = loc.end.line;
+		token.endColumn = loc.end.column;
+
+		while (!ring.TryPush(token))
+		{
+			if (abandoned.load(std::memory_order_relaxed))
+			{
+				// Nobody is going to read the ring anymore.
+				if (token.kind == BTok::ID)
+				{
+					delete token.value.str;
+				}
+				return;
+			}
+
+			// The parser is behind, give it the core.
+			producerStalls++;
+			std::this_thread::yield();
+		}
+
+		tokensLexed++;
+
+		if (token.kind == 0)
+		{
+			// End of input.
+			return;
+		}
+	}
+}
+
+i32 yy::ThreadedTokenSource::Next(parser::semantic_type* value, location* loc)
+{
+	if (batchNext == batchSize)
+	{
+		const ui64 depth = ring.ApproximateSize();
+		summedDepth += depth;
+		maxDepth = depth > maxDepth ? depth : maxDepth;
+
+		while ((batchSize = ring.PopBatch(batch, s_batchSize)) == 0)
+		{
+			// The lexer is behind.
+			consumerStalls++;
+			std::this_thread::yield();
+		}
+
+		batchesPopped++;
+		batchNext = 0;
+	}
+
+	const Token& token = batch[batchNext++];
+	*value = token.value;
+	loc->begin.line = token.beginLine;
+	loc->begin.column = token.beginColumn;
+	loc->end.line = token.endLine;
+	loc->end.column = token.endColumn;
+
+	return token.kind;
+}
+
+void yy::ThreadedTokenSource::Finish(void)
+{
+	lexerThread.join();
+
+	const ui64 averageDepth = batchesPopped != 0 ? summedDepth / batchesPopped : 0;
+	wprintf(L"LEXER: %llu tokens in %llu batches. Ring depth at each batch: avg %llu, max %llu of %u. Producer stalls: %llu, consumer stalls: %llu.\n",
+		tokensLexed, batchesPopped, averageDepth, maxDepth, s_ringCapacity, producerStalls, consumerStalls);
+}
+
+void yy::ThreadedTokenSource::Abandon(void)
+{
+	abandoned.store(true, std::memory_order_relaxed);
+	lexerThread.join();
+
+	// Free the ID strings of any tokens the parser never got to.
+	for (ui32 i = batchNext; i < batchSize; i++)
+	{
+		if (batch[i].kind == BTok::ID)
+		{
+			delete batch[i].value.str;
+		}
+	}
+	batchNext = batchSize = 0;
+
+	while ((batchSize = ring.PopBatch(batch, s_batchSize)) != 0)
+	{
+		for (ui32 i = 0; i < batchSize; i++)
+		{
+			if (batch[i].kind == BTok::ID)
+			{
+				delete batch[i].value.str;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+#include "../Definitions.h"
+#include "../parser/parser.hpp"
+#include "TokenRing.h"
+#include <thread>
+#include <atomic>
+
+/*
+	Token streams the parser can read from instead of calling the lexer itself.
+	The yylex macro in parser.y goes through yy::LexNextToken(), which reads from g_tokenSource whenever one is set.
+*/
+namespace yy
+{
+	class Lexer;
+
+	// A compact token for handing tokens between threads: kind, value and position in the source.
+	// ID values are the heap strings made by the lexer, ownership of which travels with the token(see {ID} in lexer.l).
+	struct Token
+	{
+		i32 kind;
+		ui32 beginLine;
+		ui32 beginColumn;
+		ui32 endLine;
+		ui32 endColumn;
+		parser::semantic_type value;
+	};
+
+	class TokenSource
+	{
+	public:
+
+		virtual ~TokenSource() = default;
+
+		// Same contract as yy::Lexer::lex(): fills in value and loc, and returns the token kind, or 0 at the end of input.
+		virtual i32 Next(parser::semantic_type* value, location* loc) = 0;
+	};
+
+	// The token source the parser reads from, or nullptr to call the lexer directly.
+	inline TokenSource* g_tokenSource = nullptr;
+
+	// Called by the parser for every token.
+	i32 LexNextToken(Lexer& lexer, parser::semantic_type* value, location* loc);
+
+	// Reads straight from a lexer, but moves every location down by lineOffset lines.
+	// For parsing a piece cut out of a larger source, so that messages still point at the right line of the whole file.
+	class OffsetTokenSource : public TokenSource
+	{
+	public:
+
+		OffsetTokenSource(Lexer& c_lexer, const ui32 c_lineOffset) : lexer(c_lexer), lineOffset(c_lineOffset) {}
+
+		virtual i32 Next(parser::semantic_type* value, location* loc) override;
+
+	private:
+
+		Lexer& lexer;
+		const ui32 lineOffset;
+	};
+
+	// Runs the lexer on its own thread, which pushes tokens into a lock-free ring that the parser drains in batches.
+	// That way lexing and parsing run side by side on two cores instead of taking turns on one.
+	class ThreadedTokenSource : public TokenSource
+	{
+	public:
+
+		ThreadedTokenSource() = default;
+		virtual ~ThreadedTokenSource() override;
+
+		void Start(Lexer& lexer);
+
+		virtual i32 Next(parser::semantic_type* value, location* loc) override;
+
+		// Joins the lexer thread and prints how the ring behaved.
+		void Finish(void);
+
+		// Stops the lexer thread without waiting for it to reach the end of input, for when parsing was aborted.
+		void Abandon(void);
+
+	private:
+
+		void LexerMain(Lexer* lexer);
+
+		static constexpr ui32 s_ringCapacity = 4096;
+		static constexpr ui32 s_batchSize = 256;
+
+		TokenRing<Token, s_ringCapacity> ring;
+		std::thread lexerThread;
+		std::atomic<bool> abandoned = false;
+
+		// The batch the parser is currently working through.
+		Token batch[s_batchSize];
+		ui32 batchSize = 0;
+		ui32 batchNext = 0;
+
+		// Statistics. The producer's are only read after the lexer thread has been joined.
+		ui64 tokensLexed = 0;
+		ui64 producerStalls = 0;
+		ui64 consumerStalls = 0;
+		ui64 batchesPopped = 0;
+		ui64 summedDepth = 0;
+		ui64 maxDepth = 0;
+	};
+}
\ No newline at end of file
@@ -52,6 +52,7 @@
 using BTok = yy::parser::token::token_kind_type;
 
 #include "../BuildSettings.h"
+#include "../profiling/MemoryAccounting.h"
 #if LEXER_LOGGING == 1
 #define LEXLOG(s, ...) wprintf(s, __VA_ARGS__)
 #else
@@ -118,119 +119,122 @@ int yy::Lexer::lex(yy::parser::semantic_type& yylval, yy::location& yylloc)
               return int();
             }
             break;
-          case 1: // rule lexer.l:68: {COMMENT} :
-#line 68 "lexer.l"
-            break;
-          case 2: // rule lexer.l:69: {WHITESPACE} :
+          case 1: // rule lexer.l:69: {COMMENT} :
 #line 69 "lexer.l"
+            break;
+          case 2: // rule lexer.l:70: {WHITESPACE} :
+#line 70 "lexer.l"
 
 
             break;
-          case 3: // rule lexer.l:71: {KWD_NIHIL} :
-#line 71 "lexer.l"
+          case 3: // rule lexer.l:72: {KWD_NIHIL} :
+#line 72 "lexer.l"
 
 	LEXLOG(L"Found KWD_NIHIL: %s\n", wstr().c_str());
 	return BTok::KWD_NIHIL;
 
             break;
-          case 4: // rule lexer.l:75: {SYM_PTR} :
-#line 75 "lexer.l"
+          case 4: // rule lexer.l:76: {SYM_PTR} :
+#line 76 "lexer.l"
 
 	LEXLOG(L"Found SYM_PTR: %s\n", wstr().c_str());
 	return BTok::SYM_PTR;
 
             break;
-          case 5: // rule lexer.l:79: {KWD_UI8} :
-#line 79 "lexer.l"
+          case 5: // rule lexer.l:80: {KWD_UI8} :
+#line 80 "lexer.l"
 
 	LEXLOG(L"Found KWD_UI8: %s\n", wstr().c_str());
 	return BTok::KWD_UI8;
 
             break;
-          case 6: // rule lexer.l:83: {KWD_I8} :
-#line 83 "lexer.l"
+          case 6: // rule lexer.l:84: {KWD_I8} :
+#line 84 "lexer.l"
 
 	LEXLOG(L"Found KWD_I8: %s\n", wstr().c_str());
 	return BTok::KWD_I8;
 
             break;
-          case 7: // rule lexer.l:87: {KWD_UI16} :
-#line 87 "lexer.l"
+          case 7: // rule lexer.l:88: {KWD_UI16} :
+#line 88 "lexer.l"
 
 	LEXLOG(L"Found KWD_UI16: %s\n", wstr().c_str());
 	return BTok::KWD_UI16;
 
             break;
-          case 8: // rule lexer.l:91: {KWD_I16} :
-#line 91 "lexer.l"
+          case 8: // rule lexer.l:92: {KWD_I16} :
+#line 92 "lexer.l"
 
 	LEXLOG(L"Found KWD_I16: %s\n", wstr().c_str());
 	return BTok::KWD_I16;
 
             break;
-          case 9: // rule lexer.l:95: {KWD_UI32} :
-#line 95 "lexer.l"
+          case 9: // rule lexer.l:96: {KWD_UI32} :
+#line 96 "lexer.l"
 
 	LEXLOG(L"Found KWD_UI32: %s\n", wstr().c_str());
 	return BTok::KWD_UI32;
 
             break;
-          case 10: // rule lexer.l:99: {KWD_I32} :
-#line 99 "lexer.l"
+          case 10: // rule lexer.l:100: {KWD_I32} :
+#line 100 "lexer.l"
 
 	LEXLOG(L"Found KWD_I32: %s\n", wstr().c_str());
 	return BTok::KWD_I32;
 
             break;
-          case 11: // rule lexer.l:103: {KWD_UI64} :
-#line 103 "lexer.l"
+          case 11: // rule lexer.l:104: {KWD_UI64} :
+#line 104 "lexer.l"
 
 	LEXLOG(L"Found KWD_UI64: %s\n", wstr().c_str());
 	return BTok::KWD_UI64;
 
             break;
-          case 12: // rule lexer.l:107: {KWD_I64} :
-#line 107 "lexer.l"
+          case 12: // rule lexer.l:108: {KWD_I64} :
+#line 108 "lexer.l"
 
 	LEXLOG(L"Found KWD_I64: %s\n", wstr().c_str());
 	return BTok::KWD_I64;
 
             break;
-          case 13: // rule lexer.l:111: {KWD_RETURN} :
-#line 111 "lexer.l"
+          case 13: // rule lexer.l:112: {KWD_RETURN} :
+#line 112 "lexer.l"
 
 	LEXLOG(L"Found KWD_RETURN: %s\n", wstr().c_str());
 	return BTok::KWD_RETURN;
 
             break;
-          case 14: // rule lexer.l:115: {KWD_FOR} :
-#line 115 "lexer.l"
+          case 14: // rule lexer.l:116: {KWD_FOR} :
+#line 116 "lexer.l"
 
 	LEXLOG(L"Found KWD_FOR: %s\n", wstr().c_str());
 	return BTok::KWD_FOR;
 
             break;
-          case 15: // rule lexer.l:119: {KWD_EXTERN} :
-#line 119 "lexer.l"
+          case 15: // rule lexer.l:120: {KWD_EXTERN} :
+#line 120 "lexer.l"
 
 	LEXLOG(L"Found KWD_EXTERN: %s\n", wstr().c_str());
 	return BTok::KWD_EXTERN;
 
             break;
-          case 16: // rule lexer.l:123: {ID} :
-#line 123 "lexer.l"
+          case 16: // rule lexer.l:124: {ID} :
+#line 124 "lexer.l"
 
 	LEXLOG(L"Found ID: %s\n", wstr().c_str());
 
 	// TODO: Ugly and jank heap allocation to ensure that the string lives long enough for the parser to get it. Please fix man.
 	// Memory leak is handled in MakeNode(), make sure to modify that aswell when you find something more elegant than this.
-	yylval.str = new std::wstring(wstr());
+	{
+		Memory::CategoryScope identifierScope(Memory::Category::identifiers);
+		yylval.str = new std::wstring(wstr());
+	}
 
 	return BTok::ID;
 
             break;
-          case 17: // rule lexer.l:132: {NUM_LIT} :
-#line 132 "lexer.l"
+          case 17: // rule lexer.l:136: {NUM_LIT} :
+#line 136 "lexer.l"
 
 	LEXLOG(L"Found NUM_LIT: %s\n", wstr().c_str());
 
@@ -241,112 +245,112 @@ int yy::Lexer::lex(yy::parser::semantic_type& yylval, yy::location& yylloc)
 
 
             break;
-          case 18: // rule lexer.l:141: {EQOP} :
-#line 141 "lexer.l"
+          case 18: // rule lexer.l:145: {EQOP} :
+#line 145 "lexer.l"
 
 	LEXLOG(L"Found EQ_OP: %s\n", wstr().c_str());
 	return BTok::EQ_OP;
 
             break;
-          case 19: // rule lexer.l:145: {PLUSOP} :
-#line 145 "lexer.l"
+          case 19: // rule lexer.l:149: {PLUSOP} :
+#line 149 "lexer.l"
 
 	LEXLOG(L"Found PLUS_OP: %s\n", wstr().c_str());
 	return BTok::PLUS_OP;
 
             break;
-          case 20: // rule lexer.l:149: {MINUSOP} :
-#line 149 "lexer.l"
+          case 20: // rule lexer.l:153: {MINUSOP} :
+#line 153 "lexer.l"
 
 	LEXLOG(L"Found MINUS_OP: %s\n", wstr().c_str());
 	return BTok::MINUS_OP;
 
             break;
-          case 21: // rule lexer.l:153: {MULOP} :
-#line 153 "lexer.l"
+          case 21: // rule lexer.l:157: {MULOP} :
+#line 157 "lexer.l"
 
 	LEXLOG(L"Found MUL_OP: %s\n", wstr().c_str());
 	return BTok::MUL_OP;
 
             break;
-          case 22: // rule lexer.l:157: {DIVOP} :
-#line 157 "lexer.l"
+          case 22: // rule lexer.l:161: {DIVOP} :
+#line 161 "lexer.l"
 
 	LEXLOG(L"Found DIV_OP: %s\n", wstr().c_str());
 	return BTok::DIV_OP;
 
             break;
-          case 23: // rule lexer.l:161: {SHL_OP} :
-#line 161 "lexer.l"
+          case 23: // rule lexer.l:165: {SHL_OP} :
+#line 165 "lexer.l"
 return BTok::SHL_OP;
 
             break;
-          case 24: // rule lexer.l:163: {SHR_OP} :
-#line 163 "lexer.l"
+          case 24: // rule lexer.l:167: {SHR_OP} :
+#line 167 "lexer.l"
 return BTok::SHR_OP;
 
             break;
-          case 25: // rule lexer.l:165: {AND_OP} :
-#line 165 "lexer.l"
+          case 25: // rule lexer.l:169: {AND_OP} :
+#line 169 "lexer.l"
 return BTok::AND_OP;
 
             break;
-          case 26: // rule lexer.l:167: {OR_OP} :
-#line 167 "lexer.l"
+          case 26: // rule lexer.l:171: {OR_OP} :
+#line 171 "lexer.l"
 return BTok::OR_OP;
 
             break;
-          case 27: // rule lexer.l:169: {LPAREN} :
-#line 169 "lexer.l"
+          case 27: // rule lexer.l:173: {LPAREN} :
+#line 173 "lexer.l"
 
 	LEXLOG(L"Found LPAREN: %s\n", wstr().c_str());
 	return BTok::LPAREN;
 
             break;
-          case 28: // rule lexer.l:173: {RPAREN} :
-#line 173 "lexer.l"
+          case 28: // rule lexer.l:177: {RPAREN} :
+#line 177 "lexer.l"
 
 	LEXLOG(L"Found RPAREN: %s\n", wstr().c_str());
 	return BTok::RPAREN;
 
             break;
-          case 29: // rule lexer.l:177: {LCURLY} :
-#line 177 "lexer.l"
+          case 29: // rule lexer.l:181: {LCURLY} :
+#line 181 "lexer.l"
 
 	LEXLOG(L"Found LCURLY: %s\n", wstr().c_str());
 	return BTok::LCURLY;
 
             break;
-          case 30: // rule lexer.l:181: {RCURLY} :
-#line 181 "lexer.l"
+          case 30: // rule lexer.l:185: {RCURLY} :
+#line 185 "lexer.l"
 
 	LEXLOG(L"Found RCURLY: %s\n", wstr().c_str());
 	return BTok::RCURLY;
 
             break;
-          case 31: // rule lexer.l:185: {SEMI} :
-#line 185 "lexer.l"
+          case 31: // rule lexer.l:189: {SEMI} :
+#line 189 "lexer.l"
 
 	LEXLOG(L"Found SEMI: %s\n", wstr().c_str());
 	return BTok::SEMI;
 
             break;
-          case 32: // rule lexer.l:189: {RANGE_SYMBOL} :
-#line 189 "lexer.l"
+          case 32: // rule lexer.l:193: {RANGE_SYMBOL} :
+#line 193 "lexer.l"
 
 	LEXLOG(L"Found RANGE_SYMBOL: %s\n", wstr().c_str());
 	return BTok::RANGE_SYMBOL;
 
             break;
-          case 33: // rule lexer.l:193: {COMMA} :
-#line 193 "lexer.l"
+          case 33: // rule lexer.l:197: {COMMA} :
+#line 197 "lexer.l"
 
 	LEXLOG(L"Found COMMA: %s\n", wstr().c_str());
 	return BTok::COMMA;
 
             break;
-          case 34: // rule lexer.l:197: {ADDR_OF_OP} :
-#line 197 "lexer.l"
+          case 34: // rule lexer.l:201: {ADDR_OF_OP} :
+#line 201 "lexer.l"
 
 	LEXLOG(L"Found ADDR_OF_OP: %s\n", wstr().c_str());
 	return BTok::ADDR_OF_OP;
@@ -0,0 +1,390 @@
+#include "Json.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Deeper nesting than this is refused, so a hostile message can't run the parser out of stack.
+static constexpr ui32 s_maxDepth = 64;
+
+class JsonReader
+{
+public:
+
+	JsonReader(const std::string& c_text) : text(c_text) {}
+
+	bool ReadDocument(Lsp::JsonValue& outValue)
+	{
+		if (!ReadValue(outValue, 0))
+		{
+			return false;
+		}
+
+		SkipWhitespace();
+		return position == text.size();
+	}
+
+private:
+
+	void SkipWhitespace(void)
+	{
+		while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r'))
+		{
+			position++;
+		}
+	}
+
+	bool ReadLiteral(const char* literal)
+	{
+		const ui64 length = strlen(literal);
+		if (text.compare(position, length, literal) != 0)
+		{
+			return false;
+		}
+
+		position += length;
+		return true;
+	}
+
+	bool ReadValue(Lsp::JsonValue& outValue, const ui32 depth)
+	{
+		if (depth > s_maxDepth)
+		{
+			return false;
+		}
+
+		SkipWhitespace();
+		if (position >= text.size())
+		{
+			return false;
+		}
+
+		switch (text[position])
+		{
+		case '{':
+			outValue.kind = Lsp::JsonValue::Kind::Object;
+			return ReadObject(outValue, depth);
+		case '[':
+			outValue.kind = Lsp::JsonValue::Kind::Array;
+			return ReadArray(outValue, depth);
+		case '"':
+			outValue.kind = Lsp::JsonValue::Kind::String;
+			return ReadString(outValue.string);
+		case 't':
+			outValue.kind = Lsp::JsonValue::Kind::Bool;
+			outValue.boolean = true;
+			return ReadLiteral("true");
+		case 'f':
+			outValue.kind = Lsp::JsonValue::Kind::Bool;
+			outValue.boolean = false;
+			return ReadLiteral("false");
+		case 'n':
+			outValue.kind = Lsp::JsonValue::Kind::Null;
+			return ReadLiteral("null");
+		default:
+			outValue.kind = Lsp::JsonValue::Kind::Number;
+			return ReadNumber(outValue);
+		}
+	}
+
+	bool ReadObject(Lsp::JsonValue& outValue, const ui32 depth)
+	{
+		position++;
+		SkipWhitespace();
+		if (position < text.size() && text[position] == '}')
+		{
+			position++;
+			return true;
+		}
+
+		for (;;)
+		{
+			SkipWhitespace();
+
+			std::pair<std::string, Lsp::JsonValue> member;
+			if (position >= text.size() || text[position] != '"' || !ReadString(member.first))
+			{
+				return false;
+			}
+
+			SkipWhitespace();
+			if (position >= text.size() || text[position] != ':')
+			{
+				return false;
+			}
+			position++;
+
+			if (!ReadValue(member.second, depth + 1))
+			{
+				return false;
+			}
+			outValue.object.push_back(std::move(member));
+
+			SkipWhitespace();
+			if (position >= text.size())
+			{
+				return false;
+			}
+
+			if (text[position++] == '}')
+			{
+				return true;
+			}
+
+			if (text[position - 1] != ',')
+			{
+				return false;
+			}
+		}
+	}
+
+	bool ReadArray(Lsp::JsonValue& outValue, const ui32 depth)
+	{
+		position++;
+		SkipWhitespace();
+		if (position < text.size() && text[position] == ']')
+		{
+			position++;
+			return true;
+		}
+
+		for (;;)
+		{
+			outValue.array.emplace_back();
+			if (!ReadValue(outValue.array.back(), depth + 1))
+			{
+				return false;
+			}
+
+			SkipWhitespace();
+			if (position >= text.size())
+			{
+				return false;
+			}
+
+			if (text[position++] == ']')
+			{
+				return true;
+			}
+
+			if (text[position - 1] != ',')
+			{
+				return false;
+			}
+		}
+	}
+
+	bool ReadHexQuad(ui32& outUnit)
+	{
+		if (position + 4 > text.size())
+		{
+			return false;
+		}
+
+		outUnit = 0;
+		for (ui32 i = 0; i < 4; i++)
+		{
+			const char digit = text[position++];
+			outUnit <<= 4;
+
+			if (digit >= '0' && digit <= '9')
+			{
+				outUnit |= digit - '0';
+			}
+			else if (digit >= 'a' && digit <= 'f')
+			{
+				outUnit |= digit - 'a' + 10;
+			}
+			else if (digit >= 'A' && digit <= 'F')
+			{
+				outUnit |= digit - 'A' + 10;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static void AppendUtf8(std::string& out, const ui32 codePoint)
+	{
+		if (codePoint < 0x80)
+		{
+			out += (char)codePoint;
+		}
+		else if (codePoint < 0x800)
+		{
+			out += (char)(0xC0 | (codePoint >> 6));
+			out += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			out += (char)(0xE0 | (codePoint >> 12));
+			out += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			out += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			out += (char)(0xF0 | (codePoint >> 18));
+			out += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+			out += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			out += (char)(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	bool ReadString(std::string& outString)
+	{
+		position++;
+
+		for (;;)
+		{
+			// Copy the plain run in one go, most strings(the whole document, in didOpen) have next to no escapes.
+			const ui64 runEnd = text.find_first_of("\"\\", position);
+			if (runEnd == std::string::npos)
+			{
+				return false;
+			}
+
+			outString.append(text, position, runEnd - position);
+			position = runEnd + 1;
+
+			if (text[runEnd] == '"')
+			{
+				return true;
+			}
+
+			if (position >= text.size())
+			{
+				return false;
+			}
+
+			const char escape = text[position++];
+			switch (escape)
+			{
+			case '"': outString += '"'; break;
+			case '\\': outString += '\\'; break;
+			case '/': outString += '/'; break;
+			case 'b': outString += '\b'; break;
+			case 'f': outString += '\f'; break;
+			case 'n': outString += '\n'; break;
+			case 'r': outString += '\r'; break;
+			case 't': outString += '\t'; break;
+			case 'u':
+			{
+				ui32 codePoint;
+				if (!ReadHexQuad(codePoint))
+				{
+					return false;
+				}
+
+				// A surrogate pair is two escapes that make up one code point.
+				if (codePoint >= 0xD800 && codePoint <= 0xDBFF && text.compare(position, 2, "\\u") == 0)
+				{
+					position += 2;
+
+					ui32 lowSurrogate;
+					if (!ReadHexQuad(lowSurrogate) || lowSurrogate < 0xDC00 || lowSurrogate > 0xDFFF)
+					{
+						return false;
+					}
+
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+				}
+
+				AppendUtf8(outString, codePoint);
+				break;
+			}
+			default:
+				return false;
+			}
+		}
+	}
+
+	bool ReadNumber(Lsp::JsonValue& outValue)
+	{
+		const ui64 start = position;
+		while (position < text.size() && strchr("+-.0123456789eE", text[position]) != nullptr && text[position] != '\0')
+		{
+			position++;
+		}
+
+		if (position == start)
+		{
+			return false;
+		}
+
+		outValue.string = text.substr(start, position - start);
+
+		char* end;
+		outValue.number = strtod(outValue.string.c_str(), &end);
+		return *end == '\0';
+	}
+
+	const std::string& text;
+	ui64 position = 0;
+};
+
+const Lsp::JsonValue* Lsp::JsonValue::Find(const char* key) const
+{
+	for (const auto& member : object)
+	{
+		if (member.first == key)
+		{
+			return &member.second;
+		}
+	}
+
+	return nullptr;
+}
+
+i64 Lsp::JsonValue::GetInteger(const char* key, const i64 fallback) const
+{
+	const JsonValue* value = Find(key);
+	return value != nullptr && value->kind == Kind::Number ? (i64)value->number : fallback;
+}
+
+const std::string& Lsp::JsonValue::GetString(const char* key) const
+{
+	static const std::string s_empty;
+
+	const JsonValue* value = Find(key);
+	return value != nullptr && value->kind == Kind::String ? value->string : s_empty;
+}
+
+bool Lsp::ParseJson(const std::string& text, JsonValue& outValue)
+{
+	outValue = JsonValue();
+
+	JsonReader reader(text);
+	return reader.ReadDocument(outValue);
+}
+
+void Lsp::AppendJsonString(std::string& out, const std::string& text)
+{
+	static constexpr char s_hexDigits[] = "0123456789abcdef";
+
+	out += '"';
+	for (const char c : text)
+	{
+		switch (c)
+		{
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\r': out += "\\r"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			if ((ui8)c < 0x20)
+			{
+				out += "\\u00";
+				out += s_hexDigits[(ui8)c >> 4];
+				out += s_hexDigits[(ui8)c & 0xF];
+			}
+			else
+			{
+				out += c;
+			}
+		}
+	}
+	out += '"';
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include "../Definitions.h"
+
+// Just enough JSON for the language server protocol: a reader for the messages that come in, and string escaping for the ones
+// that go out, which are put together by hand.
+namespace Lsp
+{
+	struct JsonValue
+	{
+		enum class Kind : ui8
+		{
+			Null,
+			Bool,
+			Number,
+			String,
+			Array,
+			Object
+		};
+
+		Kind kind = Kind::Null;
+		bool boolean = false;
+		double number = 0.0;
+
+		// A number keeps its text as well, so request ids go back to the client exactly as they came.
+		std::string string;
+
+		std::vector<JsonValue> array;
+		std::vector<std::pair<std::string, JsonValue>> object;
+
+		// The member called key, or nullptr if this isn't an object or has no such member.
+		const JsonValue* Find(const char* key) const;
+
+		// The member called key as a number or a string, or the fallback if it's missing or of another kind.
+		i64 GetInteger(const char* key, const i64 fallback) const;
+		const std::string& GetString(const char* key) const;
+	};
+
+	// Parses text into outValue. Returns false if it isn't a single valid JSON value.
+	bool ParseJson(const std::string& text, JsonValue& outValue);
+
+	// Appends text to out as a quoted JSON string.
+	void AppendJsonString(std::string& out, const std::string& text);
+}
\ No newline at end of file
@@ -0,0 +1,500 @@
+#include "LanguageServer.h"
+#include "Json.h"
+#include "../Exit.h"
+#include "../BuildSettings.h"
+#include "../server/StreamCapture.h"
+#include "../watch/IncrementalCompiler.h"
+#include "../symbol_table/symtable.h"
+#include "../code_generator/codegen.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+
+#ifndef _WIN32
+#define _write write
+#endif
+
+// Anything bigger is taken for a garbled header rather than allocated.
+static constexpr ui64 s_maxMessageSize = 1ull << 30;
+
+// JSON-RPC error codes.
+static constexpr i32 s_parseError = -32700;
+static constexpr i32 s_methodNotFound = -32601;
+
+// Position as the protocol has it: line and character both count from 0, characters in UTF-16 code units.
+struct Position
+{
+	ui64 line;
+	ui64 character;
+};
+
+// How many bytes the UTF-8 sequence starting with lead takes up. Stray continuation bytes count as one.
+static ui64 GetSequenceLength(const ui8 lead)
+{
+	return lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+}
+
+static ui64 PositionToOffset(const std::string& text, const Position& position)
+{
+	ui64 offset = 0;
+	for (ui64 line = 0; line < position.line; line++)
+	{
+		const ui64 lineEnd = text.find('\n', offset);
+		if (lineEnd == std::string::npos)
+		{
+			return text.size();
+		}
+		offset = lineEnd + 1;
+	}
+
+	// Characters beyond the end of the line mean the end of the line.
+	for (ui64 units = 0; units < position.character && offset < text.size() && text[offset] != '\n';)
+	{
+		const ui64 length = GetSequenceLength((ui8)text[offset]);
+		units += length == 4 ? 2 : 1;
+		offset += length;
+	}
+
+	return std::min(offset, (ui64)text.size());
+}
+
+static Position OffsetToPosition(const std::string& text, ui64 offset)
+{
+	offset = std::min(offset, (ui64)text.size());
+
+	const ui64 lineStart = offset == 0 ? 0 : text.rfind('\n', offset - 1) + 1;
+
+	Position position = { (ui64)std::count(text.begin(), text.begin() + lineStart, '\n'), 0 };
+	for (ui64 i = lineStart; i < offset; i += GetSequenceLength((ui8)text[i]))
+	{
+		position.character += GetSequenceLength((ui8)text[i]) == 4 ? 2 : 1;
+	}
+
+	return position;
+}
+
+static void AppendPosition(std::string& out, const Position& position)
+{
+	out += "{\"line\":" + std::to_string(position.line) + ",\"character\":" + std::to_string(position.character) + "}";
+}
+
+#ifdef _WIN32
+// stdout is in wide text mode, so what was captured from it is UTF-16, while the protocol is UTF-8 throughout.
+static std::string DecodeWideCapture(const std::string& captured)
+{
+	std::string decoded;
+	for (ui64 i = 0; i + 1 < captured.size(); i += 2)
+	{
+		ui32 codePoint = (ui8)captured[i] | ((ui32)(ui8)captured[i + 1] << 8);
+		if (codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 3 < captured.size())
+		{
+			const ui32 lowSurrogate = (ui8)captured[i + 2] | ((ui32)(ui8)captured[i + 3] << 8);
+			codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+			i += 2;
+		}
+
+		if (codePoint < 0x80)
+		{
+			decoded += (char)codePoint;
+		}
+		else if (codePoint < 0x800)
+		{
+			decoded += (char)(0xC0 | (codePoint >> 6));
+			decoded += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			decoded += (char)(0xE0 | (codePoint >> 12));
+			decoded += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			decoded += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			decoded += (char)(0xF0 | (codePoint >> 18));
+			decoded += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+			decoded += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			decoded += (char)(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	return decoded;
+}
+#else
+static std::string DecodeWideCapture(const std::string& captured)
+{
+	return captured;
+}
+#endif
+
+// Builds a diagnostic's message from what the compiler printed before it gave up: every line but the one Exit() prints.
+static std::string ExtractErrorMessage(const std::string& printed, const ErrCodes errCode)
+{
+	std::string message;
+
+	for (ui64 lineStart = 0; lineStart < printed.size();)
+	{
+		ui64 lineEnd = printed.find('\n', lineStart);
+		if (lineEnd == std::string::npos)
+		{
+			lineEnd = printed.size();
+		}
+
+		std::string line = printed.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+
+		while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+		{
+			line.pop_back();
+		}
+
+		if (line.empty() || line.starts_with("Compilation aborted"))
+		{
+			continue;
+		}
+
+		if (line.starts_with("ERROR: "))
+		{
+			line.erase(0, strlen("ERROR: "));
+		}
+
+		message += message.empty() ? "" : "\n";
+		message += line;
+	}
+
+	if (message.empty())
+	{
+		for (const wchar_t* c = ErrorsToString[(i32)errCode]; *c != L'\0'; c++)
+		{
+			message += (char)*c;
+		}
+	}
+
+	return message;
+}
+
+class LanguageServer
+{
+public:
+
+	i32 Run(void)
+	{
+		// The protocol gets the real stdout to itself, whatever the compiler prints ends up on stderr instead.
+		fflush(stdout);
+		protocolDescriptor = _dup(_fileno(stdout));
+		_dup2(_fileno(stderr), _fileno(stdout));
+
+#ifdef _WIN32
+		(void)_setmode(_fileno(stdin), _O_BINARY);
+		(void)_setmode(protocolDescriptor, _O_BINARY);
+		(void)_setmode(_fileno(stdout), _O_U16TEXT);
+#endif
+
+		// A broken edit must only produce a diagnostic, not end the server.
+		g_exitThrows = true;
+
+		wprintf(L"LSP: BongusCode language server %S, waiting for the client.\n", COMPILER_VERSION);
+
+		std::string content;
+		while (ReadMessage(content))
+		{
+			Lsp::JsonValue message;
+			if (!Lsp::ParseJson(content, message) || message.kind != Lsp::JsonValue::Kind::Object)
+			{
+				SendError("null", s_parseError, "Malformed message.");
+				continue;
+			}
+
+			if (message.GetString("method") == "exit")
+			{
+				return isShuttingDown ? 0 : 1;
+			}
+
+			HandleMessage(message);
+		}
+
+		// The client went away without saying goodbye.
+		return 1;
+	}
+
+private:
+
+	struct Document
+	{
+		std::string text;
+		i64 version = 0;
+		Watch::IncrementalCompiler compiler;
+	};
+
+	bool ReadMessage(std::string& outContent)
+	{
+		ui64 contentLength = 0;
+		bool hasContentLength = false;
+
+		// Headers, up to an empty line. Content-Type is the only other one, and there's only the one it can be.
+		for (;;)
+		{
+			std::string header;
+			i32 c;
+			while ((c = getc(stdin)) != EOF && c != '\n')
+			{
+				header += (char)c;
+			}
+
+			if (c == EOF)
+			{
+				return false;
+			}
+
+			if (!header.empty() && header.back() == '\r')
+			{
+				header.pop_back();
+			}
+
+			if (header.empty())
+			{
+				break;
+			}
+
+			if (header.starts_with("Content-Length:"))
+			{
+				contentLength = strtoull(header.c_str() + strlen("Content-Length:"), nullptr, 10);
+				hasContentLength = true;
+			}
+		}
+
+		if (!hasContentLength || contentLength > s_maxMessageSize)
+		{
+			wprintf(L"ERROR: Malformed message header.\n");
+			return false;
+		}
+
+		outContent.resize(contentLength);
+		return fread(outContent.data(), 1, contentLength, stdin) == contentLength;
+	}
+
+	void Send(const std::string& content)
+	{
+		const std::string message = "Content-Length: " + std::to_string(content.size()) + "\r\n\r\n" + content;
+
+		for (ui64 written = 0; written < message.size();)
+		{
+			const i32 result = _write(protocolDescriptor, message.data() + written, (ui32)(message.size() - written));
+			if (result <= 0)
+			{
+				return;
+			}
+			written += (ui64)result;
+		}
+	}
+
+	void SendResult(const std::string& id, const std::string& result)
+	{
+		Send("{\"jsonrpc\":\"2.0\",\"id\":" + id + ",\"result\":" + result + "}");
+	}
+
+	void SendError(const std::string& id, const i32 code, const std::string& text)
+	{
+		std::string content = "{\"jsonrpc\":\"2.0\",\"id\":" + id + ",\"error\":{\"code\":" + std::to_string(code) + ",\"message\":";
+		Lsp::AppendJsonString(content, text);
+		Send(content + "}}");
+	}
+
+	void HandleMessage(const Lsp::JsonValue& message)
+	{
+		const std::string& method = message.GetString("method");
+
+		// The id goes back as it came, a number or a string.
+		std::string id;
+		if (const Lsp::JsonValue* idValue = message.Find("id"))
+		{
+			if (idValue->kind == Lsp::JsonValue::Kind::String)
+			{
+				Lsp::AppendJsonString(id, idValue->string);
+			}
+			else
+			{
+				id = idValue->kind == Lsp::JsonValue::Kind::Number ? idValue->string : "null";
+			}
+		}
+
+		static const Lsp::JsonValue s_noParams;
+		const Lsp::JsonValue* params = message.Find("params");
+		if (params == nullptr)
+		{
+			params = &s_noParams;
+		}
+
+		static const Lsp::JsonValue s_noTextDocument;
+		const Lsp::JsonValue* textDocument = params->Find("textDocument");
+		if (textDocument == nullptr)
+		{
+			textDocument = &s_noTextDocument;
+		}
+
+		if (method == "initialize")
+		{
+			// Sync kind 2 is incremental: edits come in as ranges.
+			SendResult(id, "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2}},"
+				"\"serverInfo\":{\"name\":\"BongusCodeCompiler\",\"version\":\"" COMPILER_VERSION "\"}}");
+		}
+		else if (method == "shutdown")
+		{
+			isShuttingDown = true;
+			SendResult(id, "null");
+		}
+		else if (method == "textDocument/didOpen")
+		{
+			const std::string& uri = textDocument->GetString("uri");
+
+			std::unique_ptr<Document>& document = documents[uri];
+			document = std::make_unique<Document>();
+			document->text = textDocument->GetString("text");
+			document->version = textDocument->GetInteger("version", 0);
+
+			AnalyseDocument(uri, *document);
+		}
+		else if (method == "textDocument/didChange")
+		{
+			auto found = documents.find(textDocument->GetString("uri"));
+			const Lsp::JsonValue* contentChanges = params->Find("contentChanges");
+			if (found == documents.end() || contentChanges == nullptr)
+			{
+				return;
+			}
+
+			Document& document = *found->second;
+			document.version = textDocument->GetInteger("version", document.version + 1);
+
+			// Changes apply one after the other, each to the text the one before it left, and are analysed together.
+			for (const Lsp::JsonValue& change : contentChanges->array)
+			{
+				const Lsp::JsonValue* range = change.Find("range");
+				if (range == nullptr)
+				{
+					document.text = change.GetString("text");
+					continue;
+				}
+
+				static const Lsp::JsonValue s_noPosition;
+				const Lsp::JsonValue* start = range->Find("start");
+				const Lsp::JsonValue* end = range->Find("end");
+				start = start != nullptr ? start : &s_noPosition;
+				end = end != nullptr ? end : &s_noPosition;
+
+				const ui64 startOffset = PositionToOffset(document.text, { (ui64)start->GetInteger("line", 0), (ui64)start->GetInteger("character", 0) });
+				const ui64 endOffset = PositionToOffset(document.text, { (ui64)end->GetInteger("line", 0), (ui64)end->GetInteger("character", 0) });
+
+				document.text.replace(startOffset, std::max(startOffset, endOffset) - startOffset, change.GetString("text"));
+			}
+
+			AnalyseDocument(found->first, document);
+		}
+		else if (method == "textDocument/didClose")
+		{
+			const std::string& uri = textDocument->GetString("uri");
+			if (documents.erase(uri) != 0)
+			{
+				PublishDiagnostics(uri, nullptr, "[]");
+			}
+		}
+		else if (!id.empty())
+		{
+			SendError(id, s_methodNotFound, "Unsupported method " + method + ".");
+		}
+
+		// Any other notification, initialized included, needs nothing done.
+	}
+
+	void AnalyseDocument(const std::string& uri, Document& document)
+	{
+		const auto analysisStart = std::chrono::steady_clock::now();
+
+		StreamCapture stdoutCapture(stdout, true);
+		StreamCapture stderrCapture(stderr, false);
+		stdoutCapture.Begin();
+		stderrCapture.Begin();
+
+		g_errorLine = 0;
+		ui64 reparsedCount = 0;
+		bool isAborted = false;
+		ErrCodes errCode = ErrCodes::success;
+
+		try
+		{
+			reparsedCount = document.compiler.Analyse(document.text);
+		}
+		catch (const CompilationAborted& abort)
+		{
+			// Exit() has printed the reason already, into the capture. Whatever was half done is thrown away.
+			g_symTable.Clear();
+			ResetCodegenState();
+			isAborted = true;
+			errCode = abort.errCode;
+		}
+
+		// The parser prints to stderr, everything else to stdout.
+		const std::string printed = stderrCapture.End() + DecodeWideCapture(stdoutCapture.End());
+
+		std::string diagnostics = "[]";
+		if (isAborted)
+		{
+			Position start, end;
+			if (errCode == ErrCodes::syntax_error && g_errorLine != 0)
+			{
+				// Where the parser ran into it, up to the end of that line.
+				const ui64 lineStart = PositionToOffset(document.text, { (ui64)g_errorLine - 1, 0 });
+				const ui64 lineEnd = std::min((ui64)document.text.find('\n', lineStart), (ui64)document.text.size());
+				start = OffsetToPosition(document.text, std::min(lineStart + g_errorColumn, lineEnd));
+				end = OffsetToPosition(document.text, lineEnd);
+			}
+			else
+			{
+				// The first line of the global entry, which for a function is its head.
+				const Watch::IncrementalCompiler::SourceRange failedRange = document.compiler.GetFailedRange();
+				const ui64 lineEnd = std::min((ui64)document.text.find('\n', failedRange.begin), failedRange.end);
+				start = OffsetToPosition(document.text, failedRange.begin);
+				end = OffsetToPosition(document.text, lineEnd);
+			}
+
+			diagnostics = "[{\"range\":{\"start\":";
+			AppendPosition(diagnostics, start);
+			diagnostics += ",\"end\":";
+			AppendPosition(diagnostics, end);
+			diagnostics += "},\"severity\":1,\"source\":\"BongusCode\",\"message\":";
+			Lsp::AppendJsonString(diagnostics, ExtractErrorMessage(printed, errCode));
+			diagnostics += "}]";
+		}
+
+		PublishDiagnostics(uri, &document, diagnostics);
+
+		const auto analysisEnd = std::chrono::steady_clock::now();
+		wprintf(L"LSP: Analysed %S(version %lli) in %.2f ms, reparsed %llu global entries%s.\n", uri.c_str(), document.version,
+			std::chrono::duration<double, std::milli>(analysisEnd - analysisStart).count(), reparsedCount, isAborted ? L", with an error" : L"");
+	}
+
+	void PublishDiagnostics(const std::string& uri, const Document* document, const std::string& diagnostics)
+	{
+		std::string content = "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":";
+		Lsp::AppendJsonString(content, uri);
+		if (document != nullptr)
+		{
+			content += ",\"version\":" + std::to_string(document->version);
+		}
+		Send(content + ",\"diagnostics\":" + diagnostics + "}}");
+	}
+
+	i32 protocolDescriptor = -1;
+	bool isShuttingDown = false;
+
+	// By URI. Documents stay put when others are opened, as their compilers are in the middle of things.
+	std::unordered_map<std::string, std::unique_ptr<Document>> documents;
+};
+
+i32 Lsp::RunLanguageServer(void)
+{
+	LanguageServer server;
+	return server.Run();
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+#include "../Definitions.h"
+
+/*
+	Language server, speaking the language server protocol over stdin and stdout.
+
+	Every open document is kept in memory, along with an incremental compiler holding its global entries, parsed, and what its
+	functions were last analysed from(see Watch::IncrementalCompiler). An edit is applied to the text by range, after which only
+	the global entries whose text it touched are lexed and parsed again, and only the functions that changed, or whose callees'
+	declarations changed, have their bodies analysed again. Nothing is generated.
+
+	The compiler stops at the first error, so a document has at most one diagnostic: syntax errors are reported where the parser
+	ran into them, harvest and semantics errors on the first line of the global entry they were raised in.
+
+	Supported: initialize, initialized, shutdown, exit, textDocument/didOpen, didChange(full and incremental), didClose,
+	and textDocument/publishDiagnostics going out. Any other request is answered with MethodNotFound.
+	Everything the compiler prints, including timings, goes to stderr, as stdout belongs to the protocol.
+*/
+namespace Lsp
+{
+	// Serves the client on stdin and stdout until it sends exit, or goes away. Returns the exit code for the process.
+	i32 RunLanguageServer(void);
+}
\ No newline at end of file
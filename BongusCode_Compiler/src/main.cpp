@@ -1,4 +1,4 @@
-﻿#include <stdio.h>
+#include <stdio.h>
 #include <fcntl.h>
 #include <io.h>
 #include <string.h>
@@ -7,12 +7,13 @@
 #include "Definitions.h"
 #include "Exit.h"
 #include "Utils.h"
-#include "parser/parser.hpp"
-#include "lexer/lexer.h"
-#include "AST/AST_Harvest_Pass.h"
-#include "AST/AST_Semantics_Pass.h"
-#include "symbol_table/symtable.h"
-#include "code_generator/codegen.h"
+#include "Options.h"
+#include "Driver.h"
+#include "server/CompileServer.h"
+#include "server/LocalSocket.h"
+#include "watch/IncrementalCompiler.h"
+#include "lsp/LanguageServer.h"
+#include "distributed/CodegenWorker.h"
 
 /*
 wchar_t ProgramSrc[] = L"\n"
@@ -42,12 +43,13 @@ wchar_t ProgramSrc[] = LR"(
 */
 
 
-#include "AST/ASTNode.h"
-AST::Node* g_nodeHead = nullptr;
-
 inline static void PrintUsage(void)
 {
-	wprintf(L"USAGE: BongusCodeCompiler.exe \"sourceFilePath\" \"outFilePath\"\n");
+	wprintf(L"USAGE: BongusCodeCompiler.exe \"sourceFilePath\" \"outFilePath\" [options]\n");
+	wprintf(L"       BongusCodeCompiler.exe --server [socketPath]\n");
+	wprintf(L"       BongusCodeCompiler.exe --lsp\n");
+	wprintf(L"       BongusCodeCompiler.exe --codegen-worker socketPath\n");
+	PrintOptionsUsage();
 }
 
 // Tries to assemble, link and run the program, aswell as to print out the error level.
@@ -65,8 +67,25 @@ i32 main(i32 argc, char** argv)
 
 	(void)_setmode(_fileno(stdout), _O_U16TEXT);
 
+	// Compile server mode: stay alive and compile whatever the clients send.
+	if (argc > 1 && strcmp(argv[1], "--server") == 0)
+	{
+		return Server::RunCompileServer(argc > 2 ? argv[2] : Server::GetDefaultSocketPath());
+	}
+
+	// Language server mode: keep the open documents analysed for an editor, over stdin and stdout.
+	if (argc > 1 && strcmp(argv[1], "--lsp") == 0)
+	{
+		return Lsp::RunLanguageServer();
+	}
+
+	// Codegen worker mode: generate code for the shards of functions coordinators send, see --worker.
+	if (argc > 2 && strcmp(argv[1], "--codegen-worker") == 0)
+	{
+		return Distributed::RunCodegenWorker(argv[2]);
+	}
 
-	if (argc > 3)
+	if (argc > 3 && !ParseOptions(argc, argv, 3, g_options))
 	{
 		wprintf(L"ERROR: Malformed command arguments.\n");
 		PrintUsage();
@@ -87,47 +106,26 @@ i32 main(i32 argc, char** argv)
 
 	const char* fSourceFilePath = argv[1];
 	const char* fOutputFilePath = argv[2];
-	
-	FILE* translationUnit = fopen(fSourceFilePath, "r");
-	
-	if (translationUnit == nullptr)
-	{
-		wprintf(L"ERROR: Unable to open source file.\n");
-		Exit(ErrCodes::malformed_cmd_line);
-	}
 
-	yy::Lexer lexer(translationUnit);
-	
-	yy::parser parser(lexer);
-
-#if PARSER_DEBUG_TRACE == 1
-	parser.set_debug_level(1);
-#endif
-
-	if (parser.parse() == 0) { wprintf(L"PARSER: Syntactically legal program recognized.\n"); }
-
-	// Now we're done with reading the translation unit, so we can close it down.
-	fclose(translationUnit);
-
-
-	// First pass over AST: we harvest the symbol declarations and resolve symbol references. Page 280.
-	AST::BuildSymbolTable(g_nodeHead);
-	
-	// Second pass over the AST: we check to make sure no semantic rules are violated.
-	AST::SemanticsPass(g_nodeHead);
+	if (g_options.connect)
+	{
+		const std::string socketPath = g_options.serverSocketPath.empty() ? Server::GetDefaultSocketPath() : g_options.serverSocketPath;
 
-	// Now it's finally time to generate some code.
-	std::string code;
-	GenerateCode(g_nodeHead, code);
+		i32 exitCode = 0;
+		if (Server::CompileOnServer(socketPath, argc, argv, exitCode))
+		{
+			return exitCode;
+		}
 
-	delete g_nodeHead;
+		wprintf(L"CLIENT: No compile server answered on %S, compiling locally.\n", socketPath.c_str());
+	}
 
-	// At last, we can write out our assembly to a file.
-	FILE* outFile = fopen(fOutputFilePath, "w");
-	fwrite(code.c_str(), sizeof(code[0]), code.length(), outFile);
-	fclose(outFile);
-	
+	if (g_options.watch)
+	{
+		return Watch::RunWatchMode(fSourceFilePath, fOutputFilePath);
+	}
 
+	CompileTranslationUnit(fSourceFilePath, fOutputFilePath);
 
 	//TryRunProgram();
 
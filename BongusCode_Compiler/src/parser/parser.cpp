@@ -1,8 +1,8 @@
-// A Bison parser, made by GNU Bison 3.7.4.
+// A Bison parser, made by GNU Bison 3.8.2.
 
 // Skeleton implementation for Bison LALR(1) parsers in C++
 
-// Copyright (C) 2002-2015, 2018-2020 Free Software Foundation, Inc.
+// Copyright (C) 2002-2015, 2018-2021 Free Software Foundation, Inc.
 
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -15,7 +15,7 @@
 // GNU General Public License for more details.
 
 // You should have received a copy of the GNU General Public License
-// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 // As a special exception, you may create a larger work that contains
 // part or all of the Bison parser skeleton and distribute that work
@@ -46,18 +46,34 @@
 
 	#include <stdio.h>
 	#include "../lexer/lexer.h"
+	#include "../lexer/TokenStream.h"
 	#include "../AST/ASTNode.h"
 	#include "../AST/ASTAPI.h"
 	#include "../BongusTable.h"
 	#include "../Exit.h"
+	#include "../pipeline/FunctionPipeline.h"
 
 	#undef yylex
-	#define yylex lexer.lex  // Within bison's parse() we should invoke lexer.lex(), not the global yylex()
+	// Within bison's parse() we should invoke lexer.lex(), not the global yylex(). LexNextToken() does that, unless another token source is set.
+	#define yylex(value, loc) yy::LexNextToken(lexer, value, loc)
 
 	// Jank-ass temp global to store the head. TODO: Please fix.
 	extern AST::Node* g_nodeHead;
 
-#line 61 "parser.cpp"
+	// When compiling pipelined, a completed global entry is handed straight over to the pipeline instead of being linked into the AST.
+	// Returns the node to link into the AST, which is nullptr once the pipeline has taken it.
+	static AST::Node* DispatchGlobalEntry(AST::Node* entry)
+	{
+		if (Pipeline::g_pipeline == nullptr)
+		{
+			return entry;
+		}
+
+		Pipeline::g_pipeline->Submit(entry);
+		return nullptr;
+	}
+
+#line 77 "parser.cpp"
 
 
 #ifndef YY_
@@ -134,7 +150,7 @@
 #else // !YYDEBUG
 
 # define YYCDEBUG if (false) std::cerr
-# define YY_SYMBOL_PRINT(Title, Symbol)  YYUSE (Symbol)
+# define YY_SYMBOL_PRINT(Title, Symbol)  YY_USE (Symbol)
 # define YY_REDUCE_PRINT(Rule)           static_cast<void> (0)
 # define YY_STACK_PRINT()                static_cast<void> (0)
 
@@ -149,7 +165,7 @@
 #define YYRECOVERING()  (!!yyerrstatus_)
 
 namespace yy {
-#line 153 "parser.cpp"
+#line 169 "parser.cpp"
 
   /// Build a parser object.
   parser::parser (yy::Lexer& lexer_yyarg)
@@ -168,9 +184,9 @@ namespace yy {
   parser::syntax_error::~syntax_error () YY_NOEXCEPT YY_NOTHROW
   {}
 
-  /*---------------.
-  | symbol kinds.  |
-  `---------------*/
+  /*---------.
+  | symbol.  |
+  `---------*/
 
   // basic_symbol.
   template <typename Base>
@@ -190,12 +206,13 @@ namespace yy {
   {}
 
   template <typename Base>
-  parser::basic_symbol<Base>::basic_symbol (typename Base::kind_type t, YY_RVREF (semantic_type) v, YY_RVREF (location_type) l)
+  parser::basic_symbol<Base>::basic_symbol (typename Base::kind_type t, YY_RVREF (value_type) v, YY_RVREF (location_type) l)
     : Base (t)
     , value (YY_MOVE (v))
     , location (YY_MOVE (l))
   {}
 
+
   template <typename Base>
   parser::symbol_kind_type
   parser::basic_symbol<Base>::type_get () const YY_NOEXCEPT
@@ -203,6 +220,7 @@ namespace yy {
     return this->kind ();
   }
 
+
   template <typename Base>
   bool
   parser::basic_symbol<Base>::empty () const YY_NOEXCEPT
@@ -220,28 +238,30 @@ namespace yy {
   }
 
   // by_kind.
-  parser::by_kind::by_kind ()
+  parser::by_kind::by_kind () YY_NOEXCEPT
     : kind_ (symbol_kind::S_YYEMPTY)
   {}
 
 #if 201103L <= YY_CPLUSPLUS
-  parser::by_kind::by_kind (by_kind&& that)
+  parser::by_kind::by_kind (by_kind&& that) YY_NOEXCEPT
     : kind_ (that.kind_)
   {
     that.clear ();
   }
 #endif
 
-  parser::by_kind::by_kind (const by_kind& that)
+  parser::by_kind::by_kind (const by_kind& that) YY_NOEXCEPT
     : kind_ (that.kind_)
   {}
 
-  parser::by_kind::by_kind (token_kind_type t)
+  parser::by_kind::by_kind (token_kind_type t) YY_NOEXCEPT
     : kind_ (yytranslate_ (t))
   {}
 
+
+
   void
-  parser::by_kind::clear ()
+  parser::by_kind::clear () YY_NOEXCEPT
   {
     kind_ = symbol_kind::S_YYEMPTY;
   }
@@ -259,6 +279,7 @@ namespace yy {
     return kind_;
   }
 
+
   parser::symbol_kind_type
   parser::by_kind::type_get () const YY_NOEXCEPT
   {
@@ -266,6 +287,7 @@ namespace yy {
   }
 
 
+
   // by_state.
   parser::by_state::by_state () YY_NOEXCEPT
     : state (empty_state)
@@ -350,7 +372,7 @@ namespace yy {
       YY_SYMBOL_PRINT (yymsg, yysym);
 
     // User destructor.
-    YYUSE (yysym.kind ());
+    YY_USE (yysym.kind ());
   }
 
 #if YYDEBUG
@@ -359,7 +381,7 @@ namespace yy {
   parser::yy_print_ (std::ostream& yyo, const basic_symbol<Base>& yysym) const
   {
     std::ostream& yyoutput = yyo;
-    YYUSE (yyoutput);
+    YY_USE (yyoutput);
     if (yysym.empty ())
       yyo << "empty symbol";
     else
@@ -368,7 +390,7 @@ namespace yy {
         yyo << (yykind < YYNTOKENS ? "token" : "nterm")
             << ' ' << yysym.name () << " ("
             << yysym.location << ": ";
-        YYUSE (yykind);
+        YY_USE (yykind);
         yyo << ')';
       }
   }
@@ -394,7 +416,7 @@ namespace yy {
   }
 
   void
-  parser::yypop_ (int n)
+  parser::yypop_ (int n) YY_NOEXCEPT
   {
     yystack_.pop (n);
   }
@@ -437,13 +459,13 @@ namespace yy {
   }
 
   bool
-  parser::yy_pact_value_is_default_ (int yyvalue)
+  parser::yy_pact_value_is_default_ (int yyvalue) YY_NOEXCEPT
   {
     return yyvalue == yypact_ninf_;
   }
 
   bool
-  parser::yy_table_value_is_error_ (int yyvalue)
+  parser::yy_table_value_is_error_ (int yyvalue) YY_NOEXCEPT
   {
     return yyvalue == yytable_ninf_;
   }
@@ -614,37 +636,42 @@ namespace yy {
           switch (yyn)
             {
   case 2: // program: globalEntries
-#line 140 "parser.y"
-                                                { g_nodeHead = AST::MakeNullNode(); g_nodeHead->AdoptChildren((yystack_[0].value.ASTNode)); }
-#line 620 "parser.cpp"
+#line 156 "parser.y"
+                                                { g_nodeHead = AST::MakeNullNode(); if ((yystack_[0].value.ASTNode) != nullptr) { g_nodeHead->AdoptChildren((yystack_[0].value.ASTNode)); } }
+#line 642 "parser.cpp"
     break;
 
   case 3: // globalEntries: globalEntries globalEntry
-#line 143 "parser.y"
-                                                { (yystack_[1].value.ASTNode)->MakeSiblings((yystack_[0].value.ASTNode)); (yylhs.value.ASTNode) = (yystack_[1].value.ASTNode); }
-#line 626 "parser.cpp"
+#line 159 "parser.y"
+                                                {
+						// Either side is nullptr if the pipeline took the entries.
+						if ((yystack_[1].value.ASTNode) == nullptr) { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
+						else if ((yystack_[0].value.ASTNode) == nullptr) { (yylhs.value.ASTNode) = (yystack_[1].value.ASTNode); }
+						else { (yystack_[1].value.ASTNode)->MakeSiblings((yystack_[0].value.ASTNode)); (yylhs.value.ASTNode) = (yystack_[1].value.ASTNode); }
+					}
+#line 653 "parser.cpp"
     break;
 
   case 4: // globalEntries: globalEntry
-#line 144 "parser.y"
+#line 165 "parser.y"
                            { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 632 "parser.cpp"
+#line 659 "parser.cpp"
     break;
 
   case 5: // globalEntry: function
-#line 148 "parser.y"
-             { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 638 "parser.cpp"
+#line 169 "parser.y"
+                                                        { (yylhs.value.ASTNode) = DispatchGlobalEntry((yystack_[0].value.ASTNode)); }
+#line 665 "parser.cpp"
     break;
 
   case 6: // globalEntry: fwdDecl
-#line 149 "parser.y"
-                                           { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 644 "parser.cpp"
+#line 170 "parser.y"
+                                                                                        { (yylhs.value.ASTNode) = DispatchGlobalEntry((yystack_[0].value.ASTNode)); }
+#line 671 "parser.cpp"
     break;
 
   case 7: // function: functionHead scope
-#line 152 "parser.y"
+#line 173 "parser.y"
                              {
 			(yylhs.value.ASTNode) = (yystack_[1].value.ASTNode);
 			(yystack_[1].value.ASTNode)->AdoptChildren((yystack_[0].value.ASTNode));
@@ -657,6 +684,7 @@ namespace yy {
 			{
 				std::wstring* str = new std::wstring(arg->GetName());
 				AST::Node* declNode = AST::MakeDeclNode(str, arg->GetType(), arg->GetPointeeType());
+				declNode->SetLine((yystack_[1].value.ASTNode)->GetLine());
 
 				for (const AST::Node* n = arg->GetRightSibling(); n != nullptr; n = n->GetRightSibling())
 				{
@@ -666,7 +694,9 @@ namespace yy {
 					std::wstring* str = new std::wstring(asArgNode->GetName());
 
 					// Create a new declnode and append it to the list by going through the head declNode.
-					declNode->MakeSiblings(AST::MakeDeclNode(str, asArgNode->GetType(), asArgNode->GetPointeeType()));
+					AST::Node* argDeclNode = AST::MakeDeclNode(str, asArgNode->GetType(), asArgNode->GetPointeeType());
+					argDeclNode->SetLine((yystack_[1].value.ASTNode)->GetLine());
+					declNode->MakeSiblings(argDeclNode);
 				}
 
 
@@ -678,377 +708,377 @@ namespace yy {
 				(yystack_[0].value.ASTNode)->AdoptChildren(declNode);
 			}
 		}
-#line 682 "parser.cpp"
+#line 712 "parser.cpp"
     break;
 
   case 8: // functionHead: type ID LPAREN paramList RPAREN
-#line 187 "parser.y"
-                                                        { (yylhs.value.ASTNode) = AST::MakeFunctionNode((yystack_[4].value.primtype), (yystack_[3].value.str), (yystack_[1].value.ASTNode)); }
-#line 688 "parser.cpp"
+#line 211 "parser.y"
+                                                        { (yylhs.value.ASTNode) = AST::MakeFunctionNode((yystack_[4].value.primtype), (yystack_[3].value.str), (yystack_[1].value.ASTNode)); (yylhs.value.ASTNode)->SetLine(yystack_[3].location.begin.line); }
+#line 718 "parser.cpp"
     break;
 
   case 9: // paramList: paramList COMMA param
-#line 190 "parser.y"
+#line 214 "parser.y"
                                         { (yystack_[2].value.ASTNode)->MakeSiblings((yystack_[0].value.ASTNode)); (yylhs.value.ASTNode) = (yystack_[2].value.ASTNode); }
-#line 694 "parser.cpp"
+#line 724 "parser.cpp"
     break;
 
   case 10: // paramList: param
-#line 191 "parser.y"
+#line 215 "parser.y"
                    { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 700 "parser.cpp"
+#line 730 "parser.cpp"
     break;
 
   case 11: // paramList: KWD_NIHIL
-#line 192 "parser.y"
+#line 216 "parser.y"
                                                         { (yylhs.value.ASTNode) = nullptr; }
-#line 706 "parser.cpp"
+#line 736 "parser.cpp"
     break;
 
   case 12: // param: type ID
-#line 195 "parser.y"
+#line 219 "parser.y"
                                                         { (yylhs.value.ASTNode) = AST::MakeArgNode((yystack_[0].value.str), (yystack_[1].value.primtype)); }
-#line 712 "parser.cpp"
+#line 742 "parser.cpp"
     break;
 
   case 13: // param: type SYM_PTR ID
-#line 196 "parser.y"
+#line 220 "parser.y"
                                                 { (yylhs.value.ASTNode) = AST::MakeArgNode((yystack_[0].value.str), PrimitiveType::pointer, (yystack_[2].value.primtype)); }
-#line 718 "parser.cpp"
+#line 748 "parser.cpp"
     break;
 
   case 14: // fwdDecl: bcplFuncFwdDecl
-#line 200 "parser.y"
+#line 224 "parser.y"
          { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 724 "parser.cpp"
+#line 754 "parser.cpp"
     break;
 
   case 15: // fwdDecl: externCFuncFwdDecl
-#line 201 "parser.y"
+#line 225 "parser.y"
                            { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 730 "parser.cpp"
+#line 760 "parser.cpp"
     break;
 
   case 16: // bcplFuncFwdDecl: type ID LPAREN paramList RPAREN SEMI
-#line 204 "parser.y"
+#line 228 "parser.y"
                                                                                                         { (yylhs.value.ASTNode) = AST::MakeFwdDeclNode((yystack_[5].value.primtype), (yystack_[4].value.str), (yystack_[2].value.ASTNode)); }
-#line 736 "parser.cpp"
+#line 766 "parser.cpp"
     break;
 
   case 17: // externCFuncFwdDecl: KWD_EXTERN bcplFuncFwdDecl
-#line 207 "parser.y"
+#line 231 "parser.y"
                                                                                                                         { (yylhs.value.ASTNode) = AST::MakeExternFwdDeclNode((yystack_[0].value.ASTNode)); }
-#line 742 "parser.cpp"
+#line 772 "parser.cpp"
     break;
 
   case 18: // scope: LCURLY stmts RCURLY
-#line 217 "parser.y"
+#line 241 "parser.y"
                                                 { (yylhs.value.ASTNode) = AST::MakeScopeNode(); (yylhs.value.ASTNode)->AdoptChildren((yystack_[1].value.ASTNode)); }
-#line 748 "parser.cpp"
+#line 778 "parser.cpp"
     break;
 
   case 19: // scope: LCURLY RCURLY
-#line 218 "parser.y"
+#line 242 "parser.y"
                                                                                 { (yylhs.value.ASTNode) = AST::MakeScopeNode(); (yylhs.value.ASTNode)->AdoptChildren(AST::MakeNullNode()); }
-#line 754 "parser.cpp"
+#line 784 "parser.cpp"
     break;
 
   case 20: // stmts: stmts stmt SEMI
-#line 221 "parser.y"
-                                                { (yylhs.value.ASTNode) = (yystack_[2].value.ASTNode)->MakeSiblings((yystack_[1].value.ASTNode)); }
-#line 760 "parser.cpp"
+#line 245 "parser.y"
+                                                { (yystack_[1].value.ASTNode)->SetLine(yystack_[1].location.begin.line); (yylhs.value.ASTNode) = (yystack_[2].value.ASTNode)->MakeSiblings((yystack_[1].value.ASTNode)); }
+#line 790 "parser.cpp"
     break;
 
   case 21: // stmts: stmt SEMI
-#line 222 "parser.y"
-                                                        { (yylhs.value.ASTNode) = (yystack_[1].value.ASTNode); }
-#line 766 "parser.cpp"
+#line 246 "parser.y"
+                                                        { (yystack_[1].value.ASTNode)->SetLine(yystack_[1].location.begin.line); (yylhs.value.ASTNode) = (yystack_[1].value.ASTNode); }
+#line 796 "parser.cpp"
     break;
 
   case 22: // stmt: expr
-#line 225 "parser.y"
+#line 249 "parser.y"
                                                                 { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 772 "parser.cpp"
+#line 802 "parser.cpp"
     break;
 
   case 23: // stmt: varDecl
-#line 226 "parser.y"
+#line 250 "parser.y"
                                                                         { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 778 "parser.cpp"
+#line 808 "parser.cpp"
     break;
 
   case 24: // stmt: varAss
-#line 227 "parser.y"
+#line 251 "parser.y"
                                                                         { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 784 "parser.cpp"
+#line 814 "parser.cpp"
     break;
 
   case 25: // stmt: returnOp
-#line 228 "parser.y"
+#line 252 "parser.y"
                                                                 { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 790 "parser.cpp"
+#line 820 "parser.cpp"
     break;
 
   case 26: // stmt: forLoop
-#line 229 "parser.y"
+#line 253 "parser.y"
                                                                         { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 796 "parser.cpp"
+#line 826 "parser.cpp"
     break;
 
   case 27: // expr: addExpr
-#line 234 "parser.y"
+#line 258 "parser.y"
                                                         { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 802 "parser.cpp"
+#line 832 "parser.cpp"
     break;
 
   case 28: // addExpr: addExpr PLUS_OP mulExpr
-#line 237 "parser.y"
+#line 261 "parser.y"
                                         { (yylhs.value.ASTNode) = AST::MakeOpNode(Op_k::ADD, (yystack_[2].value.ASTNode), (yystack_[0].value.ASTNode)); }
-#line 808 "parser.cpp"
+#line 838 "parser.cpp"
     break;
 
   case 29: // addExpr: addExpr MINUS_OP mulExpr
-#line 238 "parser.y"
+#line 262 "parser.y"
                                                         { (yylhs.value.ASTNode) = AST::MakeOpNode(Op_k::SUB, (yystack_[2].value.ASTNode), (yystack_[0].value.ASTNode)); }
-#line 814 "parser.cpp"
+#line 844 "parser.cpp"
     break;
 
   case 30: // addExpr: addExpr SHL_OP mulExpr
-#line 239 "parser.y"
+#line 263 "parser.y"
                                                                 { (yylhs.value.ASTNode) = AST::MakeOpNode(Op_k::SHL, (yystack_[2].value.ASTNode), (yystack_[0].value.ASTNode)); }
-#line 820 "parser.cpp"
+#line 850 "parser.cpp"
     break;
 
   case 31: // addExpr: addExpr SHR_OP mulExpr
-#line 240 "parser.y"
+#line 264 "parser.y"
                                                                 { (yylhs.value.ASTNode) = AST::MakeOpNode(Op_k::SHR, (yystack_[2].value.ASTNode), (yystack_[0].value.ASTNode)); }
-#line 826 "parser.cpp"
+#line 856 "parser.cpp"
     break;
 
   case 32: // addExpr: addExpr AND_OP mulExpr
-#line 241 "parser.y"
+#line 265 "parser.y"
                                                                 { (yylhs.value.ASTNode) = AST::MakeOpNode(Op_k::AND, (yystack_[2].value.ASTNode), (yystack_[0].value.ASTNode)); }
-#line 832 "parser.cpp"
+#line 862 "parser.cpp"
     break;
 
   case 33: // addExpr: addExpr OR_OP mulExpr
-#line 242 "parser.y"
+#line 266 "parser.y"
                                                                 { (yylhs.value.ASTNode) = AST::MakeOpNode(Op_k::OR, (yystack_[2].value.ASTNode), (yystack_[0].value.ASTNode));	 }
-#line 838 "parser.cpp"
+#line 868 "parser.cpp"
     break;
 
   case 34: // addExpr: mulExpr
-#line 243 "parser.y"
+#line 267 "parser.y"
                            { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 844 "parser.cpp"
+#line 874 "parser.cpp"
     break;
 
   case 35: // mulExpr: mulExpr MUL_OP factor
-#line 246 "parser.y"
+#line 270 "parser.y"
                                         { (yylhs.value.ASTNode) = AST::MakeOpNode(Op_k::MUL, (yystack_[2].value.ASTNode), (yystack_[0].value.ASTNode)); }
-#line 850 "parser.cpp"
+#line 880 "parser.cpp"
     break;
 
   case 36: // mulExpr: mulExpr DIV_OP factor
-#line 247 "parser.y"
+#line 271 "parser.y"
                                                                 { (yylhs.value.ASTNode) = AST::MakeOpNode(Op_k::DIV, (yystack_[2].value.ASTNode), (yystack_[0].value.ASTNode)); }
-#line 856 "parser.cpp"
+#line 886 "parser.cpp"
     break;
 
   case 37: // mulExpr: factor
-#line 248 "parser.y"
+#line 272 "parser.y"
                            { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 862 "parser.cpp"
+#line 892 "parser.cpp"
     break;
 
   case 38: // factor: NUM_LIT
-#line 251 "parser.y"
+#line 275 "parser.y"
                                                                         { (yylhs.value.ASTNode) = AST::MakeIntNode((yystack_[0].value.num)); }
-#line 868 "parser.cpp"
+#line 898 "parser.cpp"
     break;
 
   case 39: // factor: ID
-#line 252 "parser.y"
+#line 276 "parser.y"
                                                                                                         { (yylhs.value.ASTNode) = AST::MakeSymNode((yystack_[0].value.str)); }
-#line 874 "parser.cpp"
+#line 904 "parser.cpp"
     break;
 
   case 40: // factor: LPAREN expr RPAREN
-#line 253 "parser.y"
+#line 277 "parser.y"
                                                         { (yylhs.value.ASTNode) = (yystack_[1].value.ASTNode); }
-#line 880 "parser.cpp"
+#line 910 "parser.cpp"
     break;
 
   case 41: // factor: functionCall
-#line 254 "parser.y"
+#line 278 "parser.y"
                                                                         { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 886 "parser.cpp"
+#line 916 "parser.cpp"
     break;
 
   case 42: // factor: addrOfOp
-#line 255 "parser.y"
+#line 279 "parser.y"
                                                                                         { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 892 "parser.cpp"
+#line 922 "parser.cpp"
     break;
 
   case 43: // factor: derefOp
-#line 256 "parser.y"
+#line 280 "parser.y"
                                                                                                 { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 898 "parser.cpp"
+#line 928 "parser.cpp"
     break;
 
   case 44: // varDecl: type ID
-#line 262 "parser.y"
+#line 286 "parser.y"
                                                         { (yylhs.value.ASTNode) = AST::MakeDeclNode((yystack_[0].value.str), (yystack_[1].value.primtype)); }
-#line 904 "parser.cpp"
+#line 934 "parser.cpp"
     break;
 
   case 45: // varDecl: type SYM_PTR ID
-#line 263 "parser.y"
+#line 287 "parser.y"
                                                 { (yylhs.value.ASTNode) = AST::MakeDeclNode((yystack_[0].value.str), PrimitiveType::pointer, (yystack_[2].value.primtype)); }
-#line 910 "parser.cpp"
+#line 940 "parser.cpp"
     break;
 
   case 46: // type: KWD_UI16
-#line 266 "parser.y"
+#line 290 "parser.y"
                                                         { (yylhs.value.primtype) = PrimitiveType::ui16; }
-#line 916 "parser.cpp"
+#line 946 "parser.cpp"
     break;
 
   case 47: // type: KWD_I16
-#line 267 "parser.y"
+#line 291 "parser.y"
                                                                                 { (yylhs.value.primtype) = PrimitiveType::i16;	}
-#line 922 "parser.cpp"
+#line 952 "parser.cpp"
     break;
 
   case 48: // type: KWD_UI32
-#line 269 "parser.y"
+#line 293 "parser.y"
                                                                         { (yylhs.value.primtype) = PrimitiveType::ui32;	}
-#line 928 "parser.cpp"
+#line 958 "parser.cpp"
     break;
 
   case 49: // type: KWD_I32
-#line 270 "parser.y"
+#line 294 "parser.y"
                                                                                 { (yylhs.value.primtype) = PrimitiveType::i32;	}
-#line 934 "parser.cpp"
+#line 964 "parser.cpp"
     break;
 
   case 50: // type: KWD_UI64
-#line 272 "parser.y"
+#line 296 "parser.y"
                                                                         { (yylhs.value.primtype) = PrimitiveType::ui64; }
-#line 940 "parser.cpp"
+#line 970 "parser.cpp"
     break;
 
   case 51: // type: KWD_I64
-#line 273 "parser.y"
+#line 297 "parser.y"
                                                                                 { (yylhs.value.primtype) = PrimitiveType::i64;	}
-#line 946 "parser.cpp"
+#line 976 "parser.cpp"
     break;
 
   case 52: // type: KWD_NIHIL
-#line 275 "parser.y"
+#line 299 "parser.y"
                                                                         { (yylhs.value.primtype) = PrimitiveType::nihil; }
-#line 952 "parser.cpp"
+#line 982 "parser.cpp"
     break;
 
   case 53: // varAss: lvalue EQ_OP expr
-#line 281 "parser.y"
+#line 305 "parser.y"
                                                         { (yylhs.value.ASTNode) = AST::MakeAssNode((yystack_[2].value.ASTNode), (yystack_[0].value.ASTNode)); }
-#line 958 "parser.cpp"
+#line 988 "parser.cpp"
     break;
 
   case 54: // returnOp: KWD_RETURN expr
-#line 287 "parser.y"
+#line 311 "parser.y"
                                                 { (yylhs.value.ASTNode) = AST::MakeReturnNode((yystack_[0].value.ASTNode)); }
-#line 964 "parser.cpp"
+#line 994 "parser.cpp"
     break;
 
   case 55: // forLoop: forLoopHead scope
-#line 293 "parser.y"
+#line 317 "parser.y"
                                                 { (yylhs.value.ASTNode) = AST::MakeForLoopNode((yystack_[1].value.ASTNode), (yystack_[0].value.ASTNode)); }
-#line 970 "parser.cpp"
+#line 1000 "parser.cpp"
     break;
 
   case 56: // forLoopHead: KWD_FOR LPAREN value RANGE_SYMBOL value RPAREN
-#line 296 "parser.y"
+#line 320 "parser.y"
                                                                { (yylhs.value.ASTNode) = AST::MakeForLoopHeadNode((yystack_[1].value.ASTNode), (yystack_[3].value.ASTNode)); }
-#line 976 "parser.cpp"
+#line 1006 "parser.cpp"
     break;
 
   case 57: // functionCall: ID LPAREN argsList RPAREN
-#line 301 "parser.y"
+#line 325 "parser.y"
                                         { (yylhs.value.ASTNode) = AST::MakeFunctionCallNode((yystack_[3].value.str), (yystack_[1].value.ASTNode)); }
-#line 982 "parser.cpp"
+#line 1012 "parser.cpp"
     break;
 
   case 58: // argsList: argsList COMMA arg
-#line 304 "parser.y"
+#line 328 "parser.y"
                                                 { (yystack_[2].value.ASTNode)->MakeSiblings((yystack_[0].value.ASTNode)); (yylhs.value.ASTNode) = (yystack_[2].value.ASTNode); }
-#line 988 "parser.cpp"
+#line 1018 "parser.cpp"
     break;
 
   case 59: // argsList: arg
-#line 305 "parser.y"
+#line 329 "parser.y"
                                                                         { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 994 "parser.cpp"
+#line 1024 "parser.cpp"
     break;
 
   case 60: // argsList: %empty
-#line 306 "parser.y"
+#line 330 "parser.y"
                                                                         { (yylhs.value.ASTNode) = nullptr; }
-#line 1000 "parser.cpp"
+#line 1030 "parser.cpp"
     break;
 
   case 61: // arg: expr
-#line 309 "parser.y"
+#line 333 "parser.y"
                                                                         { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 1006 "parser.cpp"
+#line 1036 "parser.cpp"
     break;
 
   case 62: // addrOfOp: ADDR_OF_OP ID
-#line 315 "parser.y"
+#line 339 "parser.y"
                               { (yylhs.value.ASTNode) = AST::MakeAddrOfNode((yystack_[0].value.str)); }
-#line 1012 "parser.cpp"
+#line 1042 "parser.cpp"
     break;
 
   case 63: // derefOp: SYM_PTR expr
-#line 321 "parser.y"
+#line 345 "parser.y"
                                 { (yylhs.value.ASTNode) = AST::MakeDerefNode((yystack_[0].value.ASTNode)); }
-#line 1018 "parser.cpp"
+#line 1048 "parser.cpp"
     break;
 
   case 64: // value: lvalue
-#line 327 "parser.y"
+#line 351 "parser.y"
        { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 1024 "parser.cpp"
+#line 1054 "parser.cpp"
     break;
 
   case 65: // value: rvalue
-#line 328 "parser.y"
+#line 352 "parser.y"
                    { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 1030 "parser.cpp"
+#line 1060 "parser.cpp"
     break;
 
   case 66: // lvalue: ID
-#line 331 "parser.y"
+#line 355 "parser.y"
                                 { (yylhs.value.ASTNode) = AST::MakeSymNode((yystack_[0].value.str)); }
-#line 1036 "parser.cpp"
+#line 1066 "parser.cpp"
     break;
 
   case 67: // lvalue: derefOp
-#line 332 "parser.y"
+#line 356 "parser.y"
                           { (yylhs.value.ASTNode) = (yystack_[0].value.ASTNode); }
-#line 1042 "parser.cpp"
+#line 1072 "parser.cpp"
     break;
 
   case 68: // rvalue: NUM_LIT
-#line 335 "parser.y"
+#line 359 "parser.y"
                 { (yylhs.value.ASTNode) = AST::MakeIntNode((yystack_[0].value.num)); }
-#line 1048 "parser.cpp"
+#line 1078 "parser.cpp"
     break;
 
 
-#line 1052 "parser.cpp"
+#line 1082 "parser.cpp"
 
             default:
               break;
@@ -1237,6 +1267,10 @@ namespace yy {
 
 
 
+
+
+
+
   const signed char parser::yypact_ninf_ = -55;
 
   const signed char parser::yytable_ninf_ = -68;
@@ -1287,7 +1321,7 @@ namespace yy {
   const signed char
   parser::yydefgoto_[] =
   {
-      -1,     9,    10,    11,    12,    13,    76,    77,    14,    15,
+       0,     9,    10,    11,    12,    13,    76,    77,    14,    15,
       16,    23,    34,    35,    36,    37,    38,    39,    40,    78,
       42,    43,    44,    45,    46,    81,    82,    47,    55,    86,
       49,    88
@@ -1399,13 +1433,13 @@ namespace yy {
   const short
   parser::yyrline_[] =
   {
-       0,   140,   140,   143,   144,   148,   149,   152,   187,   190,
-     191,   192,   195,   196,   200,   201,   204,   207,   217,   218,
-     221,   222,   225,   226,   227,   228,   229,   234,   237,   238,
-     239,   240,   241,   242,   243,   246,   247,   248,   251,   252,
-     253,   254,   255,   256,   262,   263,   266,   267,   269,   270,
-     272,   273,   275,   281,   287,   293,   296,   301,   304,   305,
-     306,   309,   315,   321,   327,   328,   331,   332,   335
+       0,   156,   156,   159,   165,   169,   170,   173,   211,   214,
+     215,   216,   219,   220,   224,   225,   228,   231,   241,   242,
+     245,   246,   249,   250,   251,   252,   253,   258,   261,   262,
+     263,   264,   265,   266,   267,   270,   271,   272,   275,   276,
+     277,   278,   279,   280,   286,   287,   290,   291,   293,   294,
+     296,   297,   299,   305,   311,   317,   320,   325,   328,   329,
+     330,   333,   339,   345,   351,   352,   355,   356,   359
   };
 
   void
@@ -1436,7 +1470,7 @@ namespace yy {
 #endif // YYDEBUG
 
   parser::symbol_kind_type
-  parser::yytranslate_ (int t)
+  parser::yytranslate_ (int t) YY_NOEXCEPT
   {
     // YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to
     // TOKEN-NUM as returned by yylex.
@@ -1480,20 +1514,22 @@ namespace yy {
     if (t <= 0)
       return symbol_kind::S_YYEOF;
     else if (t <= code_max)
-      return YY_CAST (symbol_kind_type, translate_table[t]);
+      return static_cast <symbol_kind_type> (translate_table[t]);
     else
       return symbol_kind::S_YYUNDEF;
   }
 
 } // yy
-#line 1490 "parser.cpp"
+#line 1524 "parser.cpp"
 
-#line 339 "parser.y"
+#line 363 "parser.y"
 
 
 
 void yy::parser::error(const location_type& loc, const std::string& msg)
 {
 	std::cerr << "ERROR: " << msg << " at " << loc << std::endl;
+	g_errorLine = loc.begin.line;
+	g_errorColumn = loc.begin.column;
 	Exit(ErrCodes::syntax_error);
 }
@@ -29,16 +29,32 @@
 {
 	#include <stdio.h>
 	#include "../lexer/lexer.h"
+	#include "../lexer/TokenStream.h"
 	#include "../AST/ASTNode.h"
 	#include "../AST/ASTAPI.h"
 	#include "../BongusTable.h"
 	#include "../Exit.h"
+	#include "../pipeline/FunctionPipeline.h"
 
 	#undef yylex
-	#define yylex lexer.lex  // Within bison's parse() we should invoke lexer.lex(), not the global yylex()
+	// Within bison's parse() we should invoke lexer.lex(), not the global yylex(). LexNextToken() does that, unless another token source is set.
+	#define yylex(value, loc) yy::LexNextToken(lexer, value, loc)
 
 	// Jank-ass temp global to store the head. TODO: Please fix.
 	extern AST::Node* g_nodeHead;
+
+	// When compiling pipelined, a completed global entry is handed straight over to the pipeline instead of being linked into the AST.
+	// Returns the node to link into the AST, which is nullptr once the pipeline has taken it.
+	static AST::Node* DispatchGlobalEntry(AST::Node* entry)
+	{
+		if (Pipeline::g_pipeline == nullptr)
+		{
+			return entry;
+		}
+
+		Pipeline::g_pipeline->Submit(entry);
+		return nullptr;
+	}
 }
 
 
@@ -137,16 +153,21 @@
 // AST construction with semantic actions on page 259.
 
 // Functions & Fwd Decl-----------------------------------------------------------------------
-program: globalEntries				{ g_nodeHead = AST::MakeNullNode(); g_nodeHead->AdoptChildren($1); }
+program: globalEntries				{ g_nodeHead = AST::MakeNullNode(); if ($1 != nullptr) { g_nodeHead->AdoptChildren($1); } }
 			 ;
 
-globalEntries: globalEntries globalEntry	{ $1->MakeSiblings($2); $$ = $1; }
+globalEntries: globalEntries globalEntry	{
+						// Either side is nullptr if the pipeline took the entries.
+						if ($1 == nullptr) { $$ = $2; }
+						else if ($2 == nullptr) { $$ = $1; }
+						else { $1->MakeSiblings($2); $$ = $1; }
+					}
 			 | globalEntry
 			 ;
 
 
-globalEntry: function
-					 | fwdDecl
+globalEntry: function					{ $$ = DispatchGlobalEntry($1); }
+					 | fwdDecl					{ $$ = DispatchGlobalEntry($1); }
 					 ;
 
 function: functionHead scope {
@@ -161,6 +182,7 @@ function: functionHead scope {
 			{
 				std::wstring* str = new std::wstring(arg->GetName());
 				AST::Node* declNode = AST::MakeDeclNode(str, arg->GetType(), arg->GetPointeeType());
+				declNode->SetLine($1->GetLine());
 
 				for (const AST::Node* n = arg->GetRightSibling(); n != nullptr; n = n->GetRightSibling())
 				{
@@ -170,7 +192,9 @@ function: functionHead scope {
 					std::wstring* str = new std::wstring(asArgNode->GetName());
 
 					// Create a new declnode and append it to the list by going through the head declNode.
-					declNode->MakeSiblings(AST::MakeDeclNode(str, asArgNode->GetType(), asArgNode->GetPointeeType()));
+					AST::Node* argDeclNode = AST::MakeDeclNode(str, asArgNode->GetType(), asArgNode->GetPointeeType());
+					argDeclNode->SetLine($1->GetLine());
+					declNode->MakeSiblings(argDeclNode);
 				}
 
 
@@ -184,7 +208,7 @@ function: functionHead scope {
 		}
 		;
 
-functionHead: type ID LPAREN paramList RPAREN		{ $$ = AST::MakeFunctionNode($1, $2, $4); }
+functionHead: type ID LPAREN paramList RPAREN		{ $$ = AST::MakeFunctionNode($1, $2, $4); $$->SetLine(@2.begin.line); }
 						;
 
 paramList: paramList COMMA param	{ $1->MakeSiblings($3); $$ = $1; }
@@ -218,8 +242,8 @@ scope: LCURLY stmts RCURLY			{ $$ = AST::MakeScopeNode(); $$->AdoptChildren($2);
 		 | LCURLY RCURLY						{ $$ = AST::MakeScopeNode(); $$->AdoptChildren(AST::MakeNullNode()); }
 		 ;
 
-stmts: stmts stmt SEMI				{ $$ = $1->MakeSiblings($2); }
-	 | stmt SEMI					{ $$ = $1; }
+stmts: stmts stmt SEMI				{ $2->SetLine(@2.begin.line); $$ = $1->MakeSiblings($2); }
+	 | stmt SEMI					{ $1->SetLine(@1.begin.line); $$ = $1; }
 	 ;
 
 stmt: expr							{ $$ = $1; }
@@ -342,5 +366,7 @@ rvalue: NUM_LIT	{ $$ = AST::MakeIntNode($1); }
 void yy::parser::error(const location_type& loc, const std::string& msg)
 {
 	std::cerr << "ERROR: " << msg << " at " << loc << std::endl;
+	g_errorLine = loc.begin.line;
+	g_errorColumn = loc.begin.column;
 	Exit(ErrCodes::syntax_error);
 }
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "FunctionPipeline.h"
+#include "../AST/ASTNode.h"
+#include "../AST/AST_Analysis_Pass.h"
+#include "../AST/AST_Folding_Pass.h"
+#include "../AST/AST_Propagation_Pass.h"
+#include "../symbol_table/symtable.h"
+#include "../code_generator/codegen.h"
+#include "../profiling/Profiler.h"
+
+Pipeline::FunctionPipeline::~FunctionPipeline()
+{
+	// Only the case when the compilation was aborted halfway, normally Finish() has joined the worker already.
+	if (worker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			retiredEntries.insert(retiredEntries.end(), queue.begin(), queue.end());
+			queue.clear();
+			parsingDone = true;
+		}
+
+		queueCondition.notify_one();
+		worker.join();
+	}
+
+	DeleteRetiredEntries();
+}
+
+void Pipeline::FunctionPipeline::Start(FILE* c_streamOutFile, const std::vector<std::string>& importedExternFunctions)
+{
+	streamOutFile = c_streamOutFile;
+	externFunctions = importedExternFunctions;
+
+	if (streamOutFile != nullptr)
+	{
+		// Only the imported part of the extern list is known yet, so in streaming mode the EXTERNs the source declares
+		// are written out as their declarations come by instead.
+		std::string header;
+		GenerateCodeHeader(externFunctions, header);
+		fwrite(header.c_str(), sizeof(header[0]), header.length(), streamOutFile);
+	}
+
+	worker = std::thread(&FunctionPipeline::WorkerMain, this);
+}
+
+void Pipeline::FunctionPipeline::Submit(AST::Node* globalEntry)
+{
+	// Piggyback on the parser handing us work to free whatever the worker has finished since last time.
+	DeleteRetiredEntries();
+
+	bool isAborted = false;
+
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		queueSpaceCondition.wait(lock, [this] { return queue.size() < s_maxQueuedEntries || aborted; });
+		isAborted = aborted;
+
+		if (isAborted)
+		{
+			retiredEntries.push_back(globalEntry);
+		}
+		else
+		{
+			queue.push_back(globalEntry);
+		}
+	}
+
+	if (isAborted)
+	{
+		RaiseAbort();
+	}
+
+	queueCondition.notify_one();
+}
+
+void Pipeline::FunctionPipeline::DeleteRetiredEntries(void)
+{
+	std::vector<AST::Node*> entries;
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		entries.swap(retiredEntries);
+	}
+
+	for (AST::Node* entry : entries)
+	{
+		delete entry;
+	}
+}
+
+void Pipeline::FunctionPipeline::Finish(std::string& outCode)
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		parsingDone = true;
+	}
+
+	queueCondition.notify_one();
+	worker.join();
+
+	if (aborted)
+	{
+		RaiseAbort();
+	}
+
+	wprintf(L"PIPELINE: Semantically legal program recognized.\n");
+
+	outCode.clear();
+
+	if (streamOutFile != nullptr)
+	{
+		std::string footer;
+		GenerateCodeFooter(footer);
+		fwrite(footer.c_str(), sizeof(footer[0]), footer.length(), streamOutFile);
+		return;
+	}
+
+	// Splice the header in front of the functions rather than copying them, as the functions make up nearly all of the code.
+	std::string header;
+	GenerateCodeHeader(externFunctions, header);
+	functionsCode.insert(0, header);
+	outCode = std::move(functionsCode);
+	GenerateCodeFooter(outCode);
+}
+
+void Pipeline::FunctionPipeline::RaiseAbort(void)
+{
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+
+	// The worker's Exit() has already reported the error.
+	if (g_exitThrows)
+	{
+		throw CompilationAborted{ abortCode };
+	}
+
+	exit((i32)abortCode);
+}
+
+void Pipeline::FunctionPipeline::WorkerMain(void)
+{
+	Profiling::SetThreadName("Pipeline worker");
+
+	// Errors are handed back to the parser's thread, so the process never ends while the parser is still running.
+	t_exitThrows = true;
+
+	for (;;)
+	{
+		AST::Node* entry = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this] { return !queue.empty() || parsingDone; });
+
+			if (queue.empty())
+			{
+				// Parsing is done and everything has been drained.
+				return;
+			}
+
+			entry = queue.front();
+			queue.pop_front();
+		}
+
+		queueSpaceCondition.notify_one();
+
+		try
+		{
+			ProcessEntry(entry);
+		}
+		catch (const CompilationAborted& abort)
+		{
+			// Nothing after a failed entry gets compiled, the parser finds out on its next Submit().
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				aborted = true;
+				abortCode = abort.errCode;
+				retiredEntries.push_back(entry);
+				retiredEntries.insert(retiredEntries.end(), queue.begin(), queue.end());
+				queue.clear();
+			}
+
+			queueSpaceCondition.notify_one();
+			return;
+		}
+	}
+}
+
+void Pipeline::FunctionPipeline::ProcessEntry(AST::Node* globalEntry)
+{
+	Profiling::Scope scope("Analysing and generating entry");
+
+	AST::AnalyseGlobalEntry(globalEntry);
+	AST::FoldConstants(globalEntry);
+	AST::PropagateConstants(globalEntry);
+
+	switch (globalEntry->GetNodeKind())
+	{
+		case Node_k::ExternFwdDeclNode:
+		{
+			AST::ExternFwdDeclNode* asExternFwdDeclNode = (AST::ExternFwdDeclNode*)globalEntry;
+			AST::FwdDeclNode* fwdDeclNode = (AST::FwdDeclNode*)asExternFwdDeclNode->GetFwdDeclNode();
+
+			// The name is narrowed in the harvest step.
+			externFunctions.push_back(fwdDeclNode->GetSymTabEntry()->functionName);
+
+			if (streamOutFile != nullptr)
+			{
+				functionsCode += "EXTERN " + externFunctions.back() + " : PROC\n";
+			}
+
+			break;
+		}
+
+		case Node_k::FunctionNode:
+		{
+			AST::FunctionNode* asFunctionNode = (AST::FunctionNode*)globalEntry;
+
+			GenerateFunctionCode(asFunctionNode, functionsCode);
+
+			if (streamOutFile != nullptr)
+			{
+				// Nothing refers to the locals of a function once its code is generated. Arguments have DeclNodes in the body too.
+				std::vector<std::wstring> localNames;
+				for (AST::Node* declNode : AST::GetAllChildNodesOfType(asFunctionNode, Node_k::DeclNode))
+				{
+					localNames.push_back(((AST::DeclNode*)declNode)->GetName());
+				}
+
+				g_symTable.DropFunctionLocals(asFunctionNode->GetName(), localNames);
+			}
+
+			break;
+		}
+	}
+
+	if (streamOutFile != nullptr)
+	{
+		fwrite(functionsCode.c_str(), sizeof(functionsCode[0]), functionsCode.length(), streamOutFile);
+
+		// Give the memory back too, a plain clear() would keep the largest function's buffer around.
+		std::string().swap(functionsCode);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		retiredEntries.push_back(globalEntry);
+	}
+}
\ No newline at end of file
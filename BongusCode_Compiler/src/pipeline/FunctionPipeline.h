@@ -0,0 +1,90 @@
+#pragma once
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "../Exit.h"
+
+namespace AST
+{
+	class Node;
+}
+
+/*
+	Function-at-a-time compilation.
+	Instead of building the whole AST before anything else runs, the parser hands every completed global entry
+	(a function or a forward declaration) to the pipeline, whose worker thread analyses it and generates its code
+	while the parser keeps on reading the rest of the file.
+
+	Entries are processed strictly in source order on a single worker, which keeps the symbol table single threaded,
+	and means a function sees exactly the declarations it would have seen in a serial compile.
+
+	Finished entries are freed while the parser is still going. In streaming mode every function's code is also written out
+	as soon as it has been generated, and the symbol table entries of its locals are dropped. Only the global signatures stay
+	resident, so peak memory follows the largest function rather than the size of the whole file.
+*/
+namespace Pipeline
+{
+	class FunctionPipeline
+	{
+	public:
+
+		FunctionPipeline() = default;
+		~FunctionPipeline();
+
+		// Passing streamOutFile makes the pipeline stream the generated code straight into that file.
+		void Start(FILE* streamOutFile = nullptr, const std::vector<std::string>& importedExternFunctions = {});
+
+		// Called from the parser. The pipeline takes ownership of the entry, which must not be linked into the AST.
+		// Blocks while the worker is too far behind.
+		// If the worker has aborted the compilation, the abort is raised here, on the parser's thread(see RaiseAbort).
+		void Submit(AST::Node* globalEntry);
+
+		// Waits for the worker to finish every submitted entry, and assembles the complete translation unit into outCode.
+		// When streaming, the code has already been written out, and outCode is left empty.
+		void Finish(std::string& outCode);
+
+	private:
+
+		void WorkerMain(void);
+		void ProcessEntry(AST::Node* globalEntry);
+
+		// Joins the worker and ends the process with the error it aborted on, or rethrows it while g_exitThrows is set.
+		// Only called from the thread that owns the pipeline, so nothing is still running when the process goes down.
+		[[noreturn]] void RaiseAbort(void);
+
+		// Deletes the entries the worker is done with. Runs on the parser's thread, so freeing them doesn't hold up the worker.
+		void DeleteRetiredEntries(void);
+
+		std::thread worker;
+
+		std::mutex queueMutex;
+		std::condition_variable queueCondition;
+		std::condition_variable queueSpaceCondition;
+		std::deque<AST::Node*> queue;
+		bool parsingDone = false;
+
+		// Set when Exit() threw on the worker. The error is raised on the parser's thread by Submit() or Finish().
+		bool aborted = false;
+		ErrCodes abortCode = ErrCodes::success;
+
+		// How far the parser may get ahead of the worker before Submit() blocks. Without a bound, a parser that is faster than
+		// code generation would end up holding most of the file's AST in the queue.
+		static constexpr size_t s_maxQueuedEntries = 64;
+
+		// Entries the worker is done with, waiting to be deleted. Guarded by queueMutex.
+		std::vector<AST::Node*> retiredEntries;
+
+		// Only touched by the worker until Finish() has joined it.
+		std::vector<std::string> externFunctions;
+		std::string functionsCode;
+
+		FILE* streamOutFile = nullptr;
+	};
+
+	// The pipeline the parser should hand global entries to, or nullptr when compiling the whole AST at once.
+	inline FunctionPipeline* g_pipeline = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "MemoryAccounting.h"
+#include "../Utils.h"
+#include "../AST/ASTNode.h"
+#include "../symbol_table/symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "Psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+// Sits right in front of every allocation. Its size keeps the allocation after it aligned the way operator new has to.
+struct alignas(16) AllocationHeader
+{
+	ui64 size;
+
+	// The recording the allocation was counted in, 0 if it wasn't.
+	ui32 recording;
+	Memory::Category category;
+};
+
+struct CategoryCounters
+{
+	std::atomic<ui64> allocations = 0;
+	std::atomic<ui64> bytesAllocated = 0;
+	std::atomic<i64> liveBytes = 0;
+	std::atomic<i64> peakLiveBytes = 0;
+};
+
+static constexpr const char* s_categoryNames[] = { "Other", "AST nodes", "Identifiers", "Symbol table", "Code generation" };
+static_assert(GetArraySize(s_categoryNames) == (ui64)Memory::Category::count);
+
+static constexpr const char* s_nodeKindNames[] =
+{
+	"Node", "IntNode", "SymNode", "OpNode", "AssNode", "ScopeNode", "DeclNode", "ReturnNode", "FunctionNode", "ArgNode",
+	"FunctionCallNode", "FwdDeclNode", "ExternFwdDeclNode", "AddrOfNode", "DerefNode", "ForLoopNode", "ForLoopHeadNode"
+};
+static_assert(GetArraySize(s_nodeKindNames) == (ui64)Node_k::ForLoopHeadNode + 1);
+
+// All of these are constant initialized, so they are good to go before the first allocation of any static constructor.
+static CategoryCounters s_categories[(ui64)Memory::Category::count];
+static std::atomic<ui64> s_allocations = 0;
+static std::atomic<ui64> s_bytesAllocated = 0;
+static std::atomic<i64> s_liveBytes = 0;
+static std::atomic<i64> s_peakLiveBytes = 0;
+static std::atomic<i64> s_phasePeakBytes = 0;
+static std::atomic<ui32> s_recording = 0;
+
+struct Census
+{
+	ui64 nodeCounts[GetArraySize(s_nodeKindNames)] = {};
+	ui64 nodeBytes[GetArraySize(s_nodeKindNames)] = {};
+	ui64 nodeCount = 0;
+	ui64 symbolCount = 0;
+	ui64 bucketCount = 0;
+};
+static Census s_census;
+
+static void RaisePeak(std::atomic<i64>& peak, const i64 value)
+{
+	i64 current = peak.load(std::memory_order_relaxed);
+	while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+	{
+	}
+}
+
+#if MEMORY_ACCOUNTING == 1
+static void* Allocate(const size_t size)
+{
+	AllocationHeader* header = (AllocationHeader*)malloc(sizeof(AllocationHeader) + size);
+	if (header == nullptr)
+	{
+		return nullptr;
+	}
+
+	header->size = size;
+	header->recording = 0;
+
+	if (Memory::g_isAccounting)
+	{
+		header->recording = s_recording.load(std::memory_order_relaxed);
+		header->category = Memory::t_category;
+
+		CategoryCounters& counters = s_categories[(ui64)header->category];
+		counters.allocations.fetch_add(1, std::memory_order_relaxed);
+		counters.bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+		RaisePeak(counters.peakLiveBytes, counters.liveBytes.fetch_add((i64)size, std::memory_order_relaxed) + (i64)size);
+
+		s_allocations.fetch_add(1, std::memory_order_relaxed);
+		s_bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+		const i64 liveBytes = s_liveBytes.fetch_add((i64)size, std::memory_order_relaxed) + (i64)size;
+		RaisePeak(s_peakLiveBytes, liveBytes);
+		RaisePeak(s_phasePeakBytes, liveBytes);
+	}
+
+	return header + 1;
+}
+
+static void Free(void* memory)
+{
+	if (memory == nullptr)
+	{
+		return;
+	}
+
+	AllocationHeader* header = (AllocationHeader*)memory - 1;
+	if (Memory::g_isAccounting && header->recording != 0 && header->recording == s_recording.load(std::memory_order_relaxed))
+	{
+		s_categories[(ui64)header->category].liveBytes.fetch_sub((i64)header->size, std::memory_order_relaxed);
+		s_liveBytes.fetch_sub((i64)header->size, std::memory_order_relaxed);
+	}
+
+	free(header);
+}
+
+void* operator new(const size_t size)
+{
+	void* memory = Allocate(size);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](const size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(const size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new[](const size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	Free(memory);
+}
+
+void operator delete(void* memory, const size_t) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory, const size_t) noexcept
+{
+	Free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	Free(memory);
+}
+#endif
+
+static ui64 GetPeakResidentBytes(void)
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+	return (ui64)counters.PeakWorkingSetSize;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0;
+	}
+
+	// In kilobytes.
+	return (ui64)usage.ru_maxrss * 1024;
+#endif
+}
+
+static void ClearCounters(void)
+{
+	for (CategoryCounters& counters : s_categories)
+	{
+		counters.allocations = 0;
+		counters.bytesAllocated = 0;
+		counters.liveBytes = 0;
+		counters.peakLiveBytes = 0;
+	}
+
+	s_allocations = 0;
+	s_bytesAllocated = 0;
+	s_liveBytes = 0;
+	s_peakLiveBytes = 0;
+	s_phasePeakBytes = 0;
+	s_census = Census();
+}
+
+static inline double ToMegabytes(const i64 bytes)
+{
+	return bytes / (1024.0 * 1024.0);
+}
+
+void Memory::Start(void)
+{
+#if MEMORY_ACCOUNTING == 1
+	ClearCounters();
+
+	// Skips 0, which marks the allocations that weren't counted.
+	if (++s_recording == 0)
+	{
+		++s_recording;
+	}
+
+	g_isAccounting = true;
+#else
+	wprintf(L"WARNING: The compiler was built without MEMORY_ACCOUNTING, --mem-report has nothing to report.\n");
+#endif
+}
+
+void Memory::Reset(void)
+{
+	g_isAccounting = false;
+	ClearCounters();
+}
+
+void Memory::Finish(void)
+{
+	if (!g_isAccounting)
+	{
+		return;
+	}
+	g_isAccounting = false;
+
+	wprintf(L"MEMORY: %-28S %12S %14S %10S %14S\n", "Category", "Allocations", "MB allocated", "MB live", "MB peak live");
+	for (ui64 i = 0; i < (ui64)Category::count; i++)
+	{
+		const CategoryCounters& counters = s_categories[i];
+		wprintf(L"MEMORY: %-28S %12llu %14.2f %10.2f %14.2f\n", s_categoryNames[i], counters.allocations.load(),
+			ToMegabytes((i64)counters.bytesAllocated.load()), ToMegabytes(counters.liveBytes.load()), ToMegabytes(counters.peakLiveBytes.load()));
+	}
+	wprintf(L"MEMORY: %-28S %12llu %14.2f %10.2f %14.2f\n", "Total", s_allocations.load(), ToMegabytes((i64)s_bytesAllocated.load()),
+		ToMegabytes(s_liveBytes.load()), ToMegabytes(s_peakLiveBytes.load()));
+
+	if (s_census.nodeCount != 0)
+	{
+		wprintf(L"MEMORY: %-28S %12S %14S\n", "AST node kind", "Nodes", "MB");
+		for (ui64 i = 0; i < GetArraySize(s_nodeKindNames); i++)
+		{
+			if (s_census.nodeCounts[i] != 0)
+			{
+				wprintf(L"MEMORY: %-28S %12llu %14.2f\n", s_nodeKindNames[i], s_census.nodeCounts[i], ToMegabytes((i64)s_census.nodeBytes[i]));
+			}
+		}
+		wprintf(L"MEMORY: Symbol table held %llu entries in %llu buckets.\n", s_census.symbolCount, s_census.bucketCount);
+	}
+
+	wprintf(L"MEMORY: Peak live %.2f MB, peak resident %.2f MB.\n", ToMegabytes(s_peakLiveBytes.load()), ToMegabytes((i64)GetPeakResidentBytes()));
+}
+
+Memory::Totals Memory::GetTotals(void)
+{
+	return { s_allocations.load(std::memory_order_relaxed), s_bytesAllocated.load(std::memory_order_relaxed), s_liveBytes.load(std::memory_order_relaxed) };
+}
+
+i64 Memory::GetPhasePeak(void)
+{
+	return s_phasePeakBytes.load(std::memory_order_relaxed);
+}
+
+void Memory::ResetPhasePeak(void)
+{
+	s_phasePeakBytes.store(s_liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void Memory::TakeCensus(void)
+{
+	if (!g_isAccounting || AST::g_disasterHandle.size() <= s_census.nodeCount)
+	{
+		return;
+	}
+
+	Census census;
+	for (AST::Node* node : AST::g_disasterHandle)
+	{
+		// The header is in front of the whole object, which a Node* needn't point to the start of.
+		const AllocationHeader* header = (const AllocationHeader*)dynamic_cast<void*>(node) - 1;
+		const ui64 kind = (ui64)node->GetNodeKind();
+
+		census.nodeCounts[kind]++;
+		census.nodeBytes[kind] += header->size;
+	}
+	census.nodeCount = AST::g_disasterHandle.size();
+	census.symbolCount = g_symTable.GetEntries().size();
+	census.bucketCount = g_symTable.GetEntries().bucket_count();
+
+	s_census = census;
+}
\ No newline at end of file
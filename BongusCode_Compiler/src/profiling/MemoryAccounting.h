@@ -0,0 +1,100 @@
+#pragma once
+#include "../Definitions.h"
+#include "../BuildSettings.h"
+
+/*
+	Memory accounting, for --mem-report.
+
+	The global operator new and delete are replaced, and every allocation carries a small header with its size and the category
+	it was made under, so a delete can be taken off the right category's live bytes. The category is whatever the allocating
+	thread is in at the time, see CategoryScope. Anything not under a scope is "other".
+
+	While accounting is off, an allocation costs the header and a single test of g_isAccounting. Allocations made while it was
+	off are never counted, not even when they are deleted while it's on, so the figures only ever cover one compilation.
+	Setting MEMORY_ACCOUNTING to 0 in BuildSettings.h leaves the allocator alone altogether.
+
+	AST nodes are counted by kind separately, by a census of the live nodes(see TakeCensus()) rather than as they come and go,
+	as a node's kind is only known once it has been constructed.
+*/
+namespace Memory
+{
+	enum class Category : ui8
+	{
+		other,
+
+		// The nodes themselves, not the strings they hold.
+		astNodes,
+
+		// Identifiers, from the lexer handing them to the parser to the copies the nodes keep.
+		identifiers,
+
+		// The symbol table's entries, buckets and keys.
+		symbolTable,
+
+		// Everything code generation allocates, most of which is the buffers the assembly is written to.
+		codegen,
+
+		count
+	};
+
+	// Set by Start(), cleared by Finish() and Reset().
+	inline bool g_isAccounting = false;
+
+	// Whatever the calling thread allocates now goes under the category it's in.
+	inline thread_local Category t_category = Category::other;
+
+	// Totals over every category.
+	struct Totals
+	{
+		ui64 allocations = 0;
+		ui64 bytesAllocated = 0;
+		i64 liveBytes = 0;
+	};
+
+	// Starts counting, from zero.
+	void Start(void);
+
+	// Stops counting and prints the report by category, the census and the peaks.
+	void Finish(void);
+
+	// Stops counting and throws the counts away, after an aborted compilation.
+	void Reset(void);
+
+	Totals GetTotals(void);
+
+	// The peak live bytes since the last ResetPhasePeak(). Phases are timed one after the other, so one peak does for all of them.
+	i64 GetPhasePeak(void);
+	void ResetPhasePeak(void);
+
+	// Counts the AST nodes alive right now by kind, and the symbol table's entries and buckets, for the report.
+	// Taken right before the AST is freed, when it's as large as it gets. Only the largest census taken is kept.
+	void TakeCensus(void);
+
+	// Puts the calling thread's allocations under a category until the scope ends.
+	class CategoryScope
+	{
+	public:
+
+		explicit CategoryScope(const Category category)
+		{
+#if MEMORY_ACCOUNTING == 1
+			previous = t_category;
+			t_category = category;
+#endif
+		}
+
+		~CategoryScope()
+		{
+#if MEMORY_ACCOUNTING == 1
+			t_category = previous;
+#endif
+		}
+
+		CategoryScope(const CategoryScope&) = delete;
+		CategoryScope& operator=(const CategoryScope&) = delete;
+
+	private:
+
+		Category previous = Category::other;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include "Profiler.h"
+#include "../Utils.h"
+#include "../lsp/Json.h"
+#include "MemoryAccounting.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+struct TraceEvent
+{
+	const char* name;
+	std::string detail;
+	i64 startMicroseconds;
+	i64 durationMicroseconds;
+};
+
+// Every thread records into its own buffer, so recording never takes a lock, only registering a new thread does.
+struct Profiling::ThreadBuffer
+{
+	ui32 threadIndex;
+	std::string threadName;
+	std::vector<TraceEvent> events;
+};
+
+struct ReportRow
+{
+	const char* name;
+	i64 startMicroseconds;
+	i64 wallMicroseconds;
+	i64 cpuStartMicroseconds;
+	i64 cpuMicroseconds;
+
+	ui32 throughputCount = 0;
+	ui64 counts[2] = {};
+	const char* units[2] = {};
+
+	// Only filled in under --mem-report. At the start of the phase until it ends, then how much they changed by.
+	Memory::Totals memory;
+	i64 peakLiveBytes = 0;
+};
+
+static std::mutex s_mutex;
+static std::vector<std::unique_ptr<Profiling::ThreadBuffer>> s_threadBuffers;
+static std::vector<ReportRow> s_reportRows;
+static std::chrono::steady_clock::time_point s_epoch;
+
+// Bumped by every Start(), so threads left over from an earlier recording(a compile server's, say) register again.
+static ui64 s_recording = 0;
+thread_local Profiling::ThreadBuffer* t_threadBuffer = nullptr;
+thread_local ui64 t_threadRecording = 0;
+thread_local const char* t_threadName = nullptr;
+
+static i64 GetMicroseconds(void)
+{
+	return (i64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+}
+
+// CPU time of the whole process, all threads together.
+static i64 GetCpuMicroseconds(void)
+{
+#ifdef _WIN32
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+	{
+		return 0;
+	}
+
+	// In 100 ns ticks.
+	const ui64 kernelTicks = ((ui64)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+	const ui64 userTicks = ((ui64)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+	return (i64)((kernelTicks + userTicks) / 10);
+#else
+	timespec time;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+	return (i64)time.tv_sec * 1000000 + time.tv_nsec / 1000;
+#endif
+}
+
+static Profiling::ThreadBuffer* GetThreadBuffer(void)
+{
+	if (t_threadBuffer == nullptr || t_threadRecording != s_recording)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+
+		std::unique_ptr<Profiling::ThreadBuffer> buffer = std::make_unique<Profiling::ThreadBuffer>();
+		buffer->threadIndex = (ui32)s_threadBuffers.size();
+		buffer->threadName = t_threadName != nullptr ? t_threadName : (s_threadBuffers.empty() ? "Main" : "Thread");
+
+		t_threadBuffer = buffer.get();
+		t_threadRecording = s_recording;
+		s_threadBuffers.push_back(std::move(buffer));
+	}
+
+	return t_threadBuffer;
+}
+
+void Profiling::Start(void)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	s_threadBuffers.clear();
+	s_reportRows.clear();
+	g_counters = Counters();
+	s_recording++;
+	s_epoch = std::chrono::steady_clock::now();
+
+	g_isEnabled = true;
+}
+
+void Profiling::Reset(void)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	g_isEnabled = false;
+	s_threadBuffers.clear();
+	s_reportRows.clear();
+	s_recording++;
+}
+
+void Profiling::SetThreadName(const char* name)
+{
+	t_threadName = name;
+
+	if (g_isEnabled)
+	{
+		GetThreadBuffer()->threadName = name;
+	}
+}
+
+void Profiling::Scope::Begin(const char* name, const std::string* detail)
+{
+	buffer = GetThreadBuffer();
+	eventIndex = buffer->events.size();
+	buffer->events.push_back({ name, detail != nullptr ? *detail : std::string(), GetMicroseconds(), 0 });
+}
+
+void Profiling::Scope::Close(void)
+{
+	TraceEvent& event = buffer->events[eventIndex];
+	event.durationMicroseconds = GetMicroseconds() - event.startMicroseconds;
+	buffer = nullptr;
+}
+
+void Profiling::Phase::Begin(const char* name)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	rowIndex = s_reportRows.size();
+	s_reportRows.push_back({ name, GetMicroseconds(), 0, GetCpuMicroseconds(), 0 });
+
+	if (Memory::g_isAccounting)
+	{
+		s_reportRows.back().memory = Memory::GetTotals();
+		Memory::ResetPhasePeak();
+	}
+}
+
+void Profiling::Phase::AddRowThroughput(const ui64 count, const char* unit)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	ReportRow& row = s_reportRows[rowIndex];
+	if (row.throughputCount < GetArraySize(row.counts))
+	{
+		row.counts[row.throughputCount] = count;
+		row.units[row.throughputCount] = unit;
+		row.throughputCount++;
+	}
+}
+
+void Profiling::Phase::Close(void)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	ReportRow& row = s_reportRows[rowIndex];
+	row.wallMicroseconds = GetMicroseconds() - row.startMicroseconds;
+	row.cpuMicroseconds = GetCpuMicroseconds() - row.cpuStartMicroseconds;
+
+	if (Memory::g_isAccounting)
+	{
+		const Memory::Totals memory = Memory::GetTotals();
+		row.memory.allocations = memory.allocations - row.memory.allocations;
+		row.memory.bytesAllocated = memory.bytesAllocated - row.memory.bytesAllocated;
+		row.memory.liveBytes = memory.liveBytes - row.memory.liveBytes;
+		row.peakLiveBytes = Memory::GetPhasePeak();
+	}
+
+	rowIndex = s_noRow;
+}
+
+static void PrintReport(void)
+{
+	// Phases can overlap(and nest), so the total is the span from the first start to the last end rather than a sum.
+	i64 firstStart = s_reportRows.empty() ? 0 : s_reportRows[0].startMicroseconds;
+	i64 lastEnd = firstStart;
+	i64 cpuStart = s_reportRows.empty() ? 0 : s_reportRows[0].cpuStartMicroseconds;
+	i64 cpuEnd = cpuStart;
+
+	wprintf(L"TIME: %-28S %10S %10S   %S\n", "Phase", "Wall ms", "CPU ms", "Throughput");
+	for (const ReportRow& row : s_reportRows)
+	{
+		std::string throughput;
+		for (ui32 i = 0; i < row.throughputCount; i++)
+		{
+			char figure[64];
+			const double perSecond = row.wallMicroseconds > 0 ? row.counts[i] * 1e6 / row.wallMicroseconds : 0.0;
+			snprintf(figure, sizeof(figure), "%s%.2f M %s/s", i == 0 ? "" : ", ", perSecond / 1e6, row.units[i]);
+			throughput += figure;
+		}
+
+		wprintf(L"TIME: %-28S %10.2f %10.2f   %S\n", row.name, row.wallMicroseconds / 1000.0, row.cpuMicroseconds / 1000.0, throughput.c_str());
+
+		firstStart = std::min(firstStart, row.startMicroseconds);
+		lastEnd = std::max(lastEnd, row.startMicroseconds + row.wallMicroseconds);
+		cpuStart = std::min(cpuStart, row.cpuStartMicroseconds);
+		cpuEnd = std::max(cpuEnd, row.cpuStartMicroseconds + row.cpuMicroseconds);
+	}
+
+	wprintf(L"TIME: %-28S %10.2f %10.2f\n", "Total", (lastEnd - firstStart) / 1000.0, (cpuEnd - cpuStart) / 1000.0);
+}
+
+static void PrintMemoryReport(void)
+{
+	wprintf(L"MEMORY: %-28S %12S %14S %14S %14S\n", "Phase", "Allocations", "MB allocated", "MB live change", "MB peak live");
+	for (const ReportRow& row : s_reportRows)
+	{
+		wprintf(L"MEMORY: %-28S %12llu %14.2f %14.2f %14.2f\n", row.name, row.memory.allocations, row.memory.bytesAllocated / (1024.0 * 1024.0),
+			row.memory.liveBytes / (1024.0 * 1024.0), row.peakLiveBytes / (1024.0 * 1024.0));
+	}
+}
+
+static bool WriteTrace(const std::string& tracePath)
+{
+	FILE* traceFile = fopen(tracePath.c_str(), "w");
+	if (traceFile == nullptr)
+	{
+		return false;
+	}
+
+	// Complete("X") events, which the viewer nests by time on each thread, and a metadata("M") event naming each thread.
+	std::string trace = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool isFirst = true;
+	for (const std::unique_ptr<Profiling::ThreadBuffer>& buffer : s_threadBuffers)
+	{
+		const std::string threadId = std::to_string(buffer->threadIndex);
+
+		trace += isFirst ? "" : ",\n";
+		trace += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + threadId + ",\"args\":{\"name\":";
+		Lsp::AppendJsonString(trace, buffer->threadName);
+		trace += "}}";
+		isFirst = false;
+
+		for (const TraceEvent& event : buffer->events)
+		{
+			trace += ",\n{\"name\":";
+			Lsp::AppendJsonString(trace, event.name);
+			trace += ",\"cat\":\"compiler\",\"ph\":\"X\",\"pid\":1,\"tid\":" + threadId;
+			trace += ",\"ts\":" + std::to_string(event.startMicroseconds) + ",\"dur\":" + std::to_string(event.durationMicroseconds);
+			if (!event.detail.empty())
+			{
+				trace += ",\"args\":{\"detail\":";
+				Lsp::AppendJsonString(trace, event.detail);
+				trace += "}";
+			}
+			trace += "}";
+		}
+
+		// Flushed per thread, so the whole trace is never held in memory twice.
+		fwrite(trace.data(), 1, trace.size(), traceFile);
+		trace.clear();
+	}
+	trace += "\n]}\n";
+
+	const bool isWritten = fwrite(trace.data(), 1, trace.size(), traceFile) == trace.size();
+	return (fclose(traceFile) == 0) && isWritten;
+}
+
+bool Profiling::Finish(const bool printTimeReport, const bool printMemoryReport, const std::string& tracePath)
+{
+	g_isEnabled = false;
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	if (printTimeReport)
+	{
+		PrintReport();
+	}
+
+	if (printMemoryReport && Memory::g_isAccounting)
+	{
+		PrintMemoryReport();
+	}
+
+	bool isTraceWritten = true;
+	if (!tracePath.empty())
+	{
+		isTraceWritten = WriteTrace(tracePath);
+	}
+
+	s_threadBuffers.clear();
+	s_reportRows.clear();
+	s_recording++;
+
+	return isTraceWritten;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+#include <string>
+#include "../Definitions.h"
+#include "../BuildSettings.h"
+
+/*
+	Phase timing and tracing, for --time-report and --trace.
+
+	Phases are the top level steps of a compilation(lexing and parsing, analysis, code generation, writing the output), and get
+	a row in the time report with their wall and CPU time and throughput, and one in the memory report under --mem-report. Scopes are anything finer that is worth seeing in a
+	trace: every function in code generation, every entry on the pipeline's worker, every shard on a distributed build.
+	Both end up in the trace as Chrome trace events, on the thread they ran on, nested by time.
+
+	While disabled, which is always unless one of the options is given, a phase or a scope costs a single test of g_isEnabled,
+	and never looks at the clock. Setting PROFILING to 0 in BuildSettings.h takes even that out.
+*/
+namespace Profiling
+{
+	struct ThreadBuffer;
+
+	// Set by Start(), cleared by Finish() and Reset().
+	inline bool g_isEnabled = false;
+
+	// What can't be had for free after the fact, for the throughput figures. Only counted while enabled.
+	struct Counters
+	{
+		// Handed to the parser, whichever token source they came from.
+		ui64 tokens = 0;
+	};
+	inline Counters g_counters;
+
+	// Starts recording, with the clock at zero.
+	void Start(void);
+
+	// Stops recording, then prints the time report and the per phase memory report if asked to, and writes the trace to tracePath
+	// unless it's empty. Returns false if the trace couldn't be written.
+	bool Finish(const bool printTimeReport, const bool printMemoryReport, const std::string& tracePath);
+
+	// Stops recording and throws away what has been recorded, after an aborted compilation.
+	void Reset(void);
+
+	// Names the calling thread in the trace.
+	void SetThreadName(const char* name);
+
+	class Scope
+	{
+	public:
+
+		// The name must outlive the recording(a literal), the detail, e.g. a function name, is copied.
+		explicit Scope(const char* c_name, const std::string* c_detail = nullptr)
+		{
+#if PROFILING == 1
+			if (g_isEnabled)
+			{
+				Begin(c_name, c_detail);
+			}
+#endif
+		}
+
+		~Scope()
+		{
+			End();
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		// Ends the scope before it goes out of scope. Does nothing the second time.
+		inline void End(void)
+		{
+#if PROFILING == 1
+			if (buffer != nullptr)
+			{
+				Close();
+			}
+#endif
+		}
+
+	private:
+
+		void Begin(const char* name, const std::string* detail);
+		void Close(void);
+
+		ThreadBuffer* buffer = nullptr;
+		ui64 eventIndex = 0;
+	};
+
+	// A scope that also gets a row in the time report.
+	class Phase
+	{
+	public:
+
+		explicit Phase(const char* c_name) : scope(c_name)
+		{
+#if PROFILING == 1
+			if (g_isEnabled)
+			{
+				Begin(c_name);
+			}
+#endif
+		}
+
+		~Phase()
+		{
+			End();
+		}
+
+		Phase(const Phase&) = delete;
+		Phase& operator=(const Phase&) = delete;
+
+		// Adds a throughput figure to the phase's row: count units over the phase's wall time. Up to two per phase.
+		inline void AddThroughput(const ui64 count, const char* unit)
+		{
+#if PROFILING == 1
+			if (rowIndex != s_noRow)
+			{
+				AddRowThroughput(count, unit);
+			}
+#endif
+		}
+
+		inline void End(void)
+		{
+#if PROFILING == 1
+			if (rowIndex != s_noRow)
+			{
+				Close();
+			}
+#endif
+			scope.End();
+		}
+
+	private:
+
+		static constexpr ui64 s_noRow = ~0ull;
+
+		void Begin(const char* name);
+		void AddRowThroughput(const ui64 count, const char* unit);
+		void Close(void);
+
+		Scope scope;
+		ui64 rowIndex = s_noRow;
+	};
+}
\ No newline at end of file
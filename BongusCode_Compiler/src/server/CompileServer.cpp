@@ -0,0 +1,224 @@
+#include "CompileServer.h"
+#include "LocalSocket.h"
+#include "StreamCapture.h"
+#include "../Exit.h"
+#include "../Options.h"
+#include "../Driver.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#define _write write
+#endif
+
+static constexpr char s_requestMagic[4] = { 'B', 'C', 'S', '1' };
+
+// Limits on what a request may contain, so a garbled request gets refused rather than allocated.
+static constexpr ui32 s_maxArguments = 256;
+static constexpr ui64 s_maxArgumentSize = 1 << 16;
+static constexpr ui64 s_maxSourceSize = 1ull << 32;
+
+// Runs a single compilation in this process. Returns the exit code the command line compiler would have exited with.
+static i32 CompileRequest(const std::vector<std::string>& arguments, const std::string* sourceBuffer)
+{
+	i32 exitCode = (i32)ErrCodes::success;
+
+	try
+	{
+		if (arguments.size() < 2)
+		{
+			wprintf(L"ERROR: No input source file or output filepath supplied.\n");
+			Exit(ErrCodes::malformed_cmd_line);
+		}
+
+		// Every request starts over from the default options, as they're given per request.
+		std::vector<char*> options;
+		for (ui64 i = 2; i < arguments.size(); i++)
+		{
+			options.push_back((char*)arguments[i].c_str());
+		}
+
+		g_options = CompilerOptions();
+		if (!ParseOptions((i32)options.size(), options.data(), 0, g_options))
+		{
+			wprintf(L"ERROR: Malformed command arguments.\n");
+			Exit(ErrCodes::malformed_cmd_line);
+		}
+
+		CompileTranslationUnit(arguments[0].c_str(), arguments[1].c_str(), sourceBuffer);
+	}
+	catch (const CompilationAborted& abort)
+	{
+		// Exit() has printed the reason already.
+		exitCode = (i32)abort.errCode;
+	}
+	catch (const std::exception& exception)
+	{
+		wprintf(L"ERROR: Internal compiler error: %S\n", exception.what());
+		exitCode = (i32)ErrCodes::internal_compiler_error;
+	}
+
+	ResetCompilerState();
+
+	return exitCode;
+}
+
+static void ServeClient(Server::LocalSocket& client)
+{
+	char magic[sizeof(s_requestMagic)];
+	ui32 argumentCount = 0;
+	if (!client.ReceiveAll(magic, sizeof(magic)) || memcmp(magic, s_requestMagic, sizeof(magic)) != 0 ||
+		!client.ReceiveU32(argumentCount) || argumentCount > s_maxArguments)
+	{
+		wprintf(L"SERVER: Dropped a malformed request.\n");
+		return;
+	}
+
+	std::vector<std::string> arguments(argumentCount);
+	for (std::string& argument : arguments)
+	{
+		if (!client.ReceiveString(argument, s_maxArgumentSize))
+		{
+			wprintf(L"SERVER: Dropped a malformed request.\n");
+			return;
+		}
+	}
+
+	ui8 hasSourceBuffer = 0;
+	std::string sourceBuffer;
+	if (!client.ReceiveAll(&hasSourceBuffer, sizeof(hasSourceBuffer)) || (hasSourceBuffer && !client.ReceiveString(sourceBuffer, s_maxSourceSize)))
+	{
+		wprintf(L"SERVER: Dropped a malformed request.\n");
+		return;
+	}
+
+	// Syntax errors are reported on stderr, everything else on stdout.
+	StreamCapture stdoutCapture(stdout, true);
+	StreamCapture stderrCapture(stderr, false);
+	stdoutCapture.Begin();
+	stderrCapture.Begin();
+
+	const auto compileStart = std::chrono::steady_clock::now();
+	const i32 exitCode = CompileRequest(arguments, hasSourceBuffer ? &sourceBuffer : nullptr);
+	const auto compileEnd = std::chrono::steady_clock::now();
+
+	std::cerr.flush();
+	const std::string errorDiagnostics = stderrCapture.End();
+	const std::string diagnostics = stdoutCapture.End();
+	const ui64 compileMicroseconds = (ui64)std::chrono::duration_cast<std::chrono::microseconds>(compileEnd - compileStart).count();
+
+	wprintf(L"SERVER: %S: exit code %i after %.2f ms.\n", arguments.empty() ? "" : arguments[0].c_str(), exitCode, compileMicroseconds / 1000.0);
+
+	if (!client.SendU32((ui32)exitCode) || !client.SendU64(compileMicroseconds) || !client.SendString(diagnostics) || !client.SendString(errorDiagnostics))
+	{
+		wprintf(L"SERVER: Client hung up before the response was sent.\n");
+	}
+}
+
+i32 Server::RunCompileServer(const std::string& socketPath)
+{
+	LocalSocket listener;
+	if (!listener.Listen(socketPath))
+	{
+		wprintf(L"ERROR: Unable to listen on %S.\n", socketPath.c_str());
+		return (i32)ErrCodes::malformed_cmd_line;
+	}
+
+	// From here on, a failed compilation must only end the request, not the server.
+	g_exitThrows = true;
+
+	wprintf(L"SERVER: Listening on %S.\n", socketPath.c_str());
+
+	for (;;)
+	{
+		LocalSocket client;
+		if (!listener.Accept(client))
+		{
+			continue;
+		}
+
+		ServeClient(client);
+	}
+}
+
+bool Server::CompileOnServer(const std::string& socketPath, const i32 argc, char** argv, i32& outExitCode)
+{
+	LocalSocket server;
+	if (!server.Connect(socketPath))
+	{
+		return false;
+	}
+
+	// The server has its own working directory, so the paths are made absolute, including the ones given to options.
+	// --connect itself is for us, not for the server.
+	static const char* const s_pathOptions[] = { "--cache=", "--emit-snapshot=", "--emit-interface=", "--import=", "--worker=", "--trace=", "--cost-report=" };
+
+	std::vector<std::string> arguments;
+	arguments.push_back(std::filesystem::absolute(argv[1]).string());
+	arguments.push_back(std::filesystem::absolute(argv[2]).string());
+	for (i32 i = 3; i < argc; i++)
+	{
+		if (strncmp(argv[i], "--connect", strlen("--connect")) == 0)
+		{
+			continue;
+		}
+
+		std::string argument = argv[i];
+		for (const char* pathOption : s_pathOptions)
+		{
+			const size_t prefixLength = strlen(pathOption);
+			if (argument.compare(0, prefixLength, pathOption) == 0 && argument.length() > prefixLength)
+			{
+				argument = pathOption + std::filesystem::absolute(argument.substr(prefixLength)).string();
+				break;
+			}
+		}
+
+		arguments.push_back(argument);
+	}
+
+	bool sent = server.SendAll(s_requestMagic, sizeof(s_requestMagic)) && server.SendU32((ui32)arguments.size());
+	for (const std::string& argument : arguments)
+	{
+		sent = sent && server.SendString(argument);
+	}
+
+	const ui8 hasSourceBuffer = 0;
+	sent = sent && server.SendAll(&hasSourceBuffer, sizeof(hasSourceBuffer));
+
+	ui32 exitCode = 0;
+	ui64 compileMicroseconds = 0;
+	std::string diagnostics, errorDiagnostics;
+	if (!sent || !server.ReceiveU32(exitCode) || !server.ReceiveU64(compileMicroseconds) ||
+		!server.ReceiveString(diagnostics, ~0ull) || !server.ReceiveString(errorDiagnostics, ~0ull))
+	{
+		// The server went away halfway. Nothing has been written that a local compile wouldn't overwrite.
+		return false;
+	}
+
+	// The diagnostics are in the same encoding our own streams are written in, so they're passed through untouched.
+	fflush(stdout);
+	if (!diagnostics.empty())
+	{
+		(void)_write(_fileno(stdout), diagnostics.data(), (ui32)diagnostics.size());
+	}
+
+	fflush(stderr);
+	if (!errorDiagnostics.empty())
+	{
+		(void)_write(_fileno(stderr), errorDiagnostics.data(), (ui32)errorDiagnostics.size());
+	}
+
+	wprintf(L"CLIENT: Compiled by the server in %.2f ms.\n", compileMicroseconds / 1000.0);
+
+	outExitCode = (i32)exitCode;
+	return true;
+}
\ No newline at end of file
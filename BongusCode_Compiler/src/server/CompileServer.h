@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include "../Definitions.h"
+
+/*
+	Compile server.
+	A compiler process that stays alive between compilations, so that process startup, the lexer's pattern tables and the
+	code generator's string tables are paid for once instead of on every build step.
+
+	Protocol, one request per connection, all integers in native byte order:
+		Request:  "BCS1", u32 argument count, the arguments as strings, u8 whether a source buffer follows, and the buffer as a string.
+		          The arguments are the ones the command line takes: source path, output path, options.
+		          With a source buffer, the buffer is compiled and the source path is only a name.
+		Response: i32 exit code, u64 compile time in microseconds, and everything the compilation printed to stdout and to stderr,
+		          as two strings.
+	Strings are a u64 length followed by the bytes.
+*/
+namespace Server
+{
+	// Serves compile requests on socketPath until the process is killed. Only returns if the socket couldn't be set up.
+	i32 RunCompileServer(const std::string& socketPath);
+
+	// Sends the compilation given by argv, laid out like the command line, to the server listening on socketPath.
+	// Returns false if there's no server to talk to, so the caller can compile locally instead.
+	// Otherwise, prints what the compilation printed on the server and stores its exit code in outExitCode.
+	bool CompileOnServer(const std::string& socketPath, const i32 argc, char** argv, i32& outExitCode);
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "LocalSocket.h"
+#include <string.h>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET NativeSocket;
+#define SEND_FLAGS 0
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int NativeSocket;
+// A client that hangs up early must not kill the server with SIGPIPE.
+#define SEND_FLAGS MSG_NOSIGNAL
+#endif
+
+#ifdef _WIN32
+// Winsock has to be started once before any socket call.
+static bool StartupSockets(void)
+{
+	static const bool s_started = []
+	{
+		WSADATA wsaData;
+		return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+	}();
+
+	return s_started;
+}
+
+#define CloseSocketHandle(handle) closesocket((NativeSocket)handle)
+#else
+inline static bool StartupSockets(void) { return true; }
+
+#define CloseSocketHandle(handle) close((NativeSocket)handle)
+#endif
+
+// Fills in a sockaddr_un for path. Returns false if the path is too long to fit.
+static bool MakeAddress(const std::string& path, sockaddr_un& outAddress)
+{
+	memset(&outAddress, 0, sizeof(outAddress));
+	outAddress.sun_family = AF_UNIX;
+
+	if (path.length() >= sizeof(outAddress.sun_path))
+	{
+		return false;
+	}
+
+	memcpy(outAddress.sun_path, path.c_str(), path.length());
+	return true;
+}
+
+Server::LocalSocket::~LocalSocket()
+{
+	Close();
+}
+
+bool Server::LocalSocket::Listen(const std::string& path)
+{
+	Close();
+
+	sockaddr_un address;
+	if (!StartupSockets() || !MakeAddress(path, address))
+	{
+		return false;
+	}
+
+	// A server that didn't shut down cleanly leaves its socket file behind, and binding to an existing path fails.
+	std::error_code ignored;
+	std::filesystem::remove(path, ignored);
+
+	handle = (i64)socket(AF_UNIX, SOCK_STREAM, 0);
+	if (handle == -1)
+	{
+		return false;
+	}
+
+	if (bind((NativeSocket)handle, (sockaddr*)&address, sizeof(address)) != 0 || listen((NativeSocket)handle, 16) != 0)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool Server::LocalSocket::Accept(LocalSocket& outClient)
+{
+	outClient.Close();
+	outClient.handle = (i64)accept((NativeSocket)handle, nullptr, nullptr);
+
+	return outClient.handle != -1;
+}
+
+bool Server::LocalSocket::Connect(const std::string& path)
+{
+	Close();
+
+	sockaddr_un address;
+	if (!StartupSockets() || !MakeAddress(path, address))
+	{
+		return false;
+	}
+
+	handle = (i64)socket(AF_UNIX, SOCK_STREAM, 0);
+	if (handle == -1)
+	{
+		return false;
+	}
+
+	if (connect((NativeSocket)handle, (sockaddr*)&address, sizeof(address)) != 0)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void Server::LocalSocket::Close(void)
+{
+	if (handle != -1)
+	{
+		CloseSocketHandle(handle);
+		handle = -1;
+	}
+}
+
+bool Server::LocalSocket::SendAll(const void* data, ui64 size)
+{
+	const char* bytes = (const char*)data;
+
+	while (size > 0)
+	{
+		// send() takes an int on Windows.
+		const i32 chunkSize = size > 0x40000000 ? 0x40000000 : (i32)size;
+		const i64 sent = (i64)send((NativeSocket)handle, bytes, chunkSize, SEND_FLAGS);
+		if (sent <= 0)
+		{
+			return false;
+		}
+
+		bytes += sent;
+		size -= (ui64)sent;
+	}
+
+	return true;
+}
+
+bool Server::LocalSocket::ReceiveAll(void* data, ui64 size)
+{
+	char* bytes = (char*)data;
+
+	while (size > 0)
+	{
+		const i32 chunkSize = size > 0x40000000 ? 0x40000000 : (i32)size;
+		const i64 received = (i64)recv((NativeSocket)handle, bytes, chunkSize, 0);
+		if (received <= 0)
+		{
+			return false;
+		}
+
+		bytes += received;
+		size -= (ui64)received;
+	}
+
+	return true;
+}
+
+// Both ends run on the same machine, so values are sent in its native byte order.
+bool Server::LocalSocket::SendU32(const ui32 value)
+{
+	return SendAll(&value, sizeof(value));
+}
+
+bool Server::LocalSocket::SendU64(const ui64 value)
+{
+	return SendAll(&value, sizeof(value));
+}
+
+bool Server::LocalSocket::SendString(const std::string& str)
+{
+	return SendU64(str.length()) && SendAll(str.data(), str.length());
+}
+
+bool Server::LocalSocket::ReceiveU32(ui32& outValue)
+{
+	return ReceiveAll(&outValue, sizeof(outValue));
+}
+
+bool Server::LocalSocket::ReceiveU64(ui64& outValue)
+{
+	return ReceiveAll(&outValue, sizeof(outValue));
+}
+
+bool Server::LocalSocket::ReceiveString(std::string& outStr, const ui64 maxSize)
+{
+	ui64 size = 0;
+	if (!ReceiveU64(size) || size > maxSize)
+	{
+		return false;
+	}
+
+	outStr.resize(size);
+	return ReceiveAll(outStr.data(), size);
+}
+
+std::string Server::GetDefaultSocketPath(void)
+{
+	std::error_code error;
+	std::filesystem::path tempDirectory = std::filesystem::temp_directory_path(error);
+	if (error)
+	{
+		tempDirectory = ".";
+	}
+
+	return (tempDirectory / "BongusCodeCompiler.sock").string();
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include "../Definitions.h"
+
+namespace Server
+{
+	// A stream socket on a local(AF_UNIX) address, which on Windows 10 and onward is a path in the file system just like on POSIX.
+	// Blocking, and owns its handle.
+	class LocalSocket
+	{
+	public:
+
+		LocalSocket() = default;
+		~LocalSocket();
+
+		LocalSocket(const LocalSocket&) = delete;
+		LocalSocket& operator=(const LocalSocket&) = delete;
+
+		// Binds to path, replacing any stale socket file left there, and starts listening.
+		bool Listen(const std::string& path);
+
+		// Blocks until a client connects.
+		bool Accept(LocalSocket& outClient);
+
+		bool Connect(const std::string& path);
+
+		void Close(void);
+
+		// Both return false if the connection broke before all of size was transferred.
+		bool SendAll(const void* data, ui64 size);
+		bool ReceiveAll(void* data, ui64 size);
+
+		// Length-prefixed messages on top of the above.
+		bool SendU32(const ui32 value);
+		bool SendU64(const ui64 value);
+		bool SendString(const std::string& str);
+		bool ReceiveU32(ui32& outValue);
+		bool ReceiveU64(ui64& outValue);
+
+		// Fails for strings longer than maxSize, so a garbled length can't make us allocate the world.
+		bool ReceiveString(std::string& outStr, const ui64 maxSize);
+
+	private:
+
+		// A SOCKET on Windows, a file descriptor elsewhere.
+		i64 handle = -1;
+	};
+
+	// Where the compile server listens unless told otherwise: a fixed name in the temp directory.
+	std::string GetDefaultSocketPath(void);
+}
\ No newline at end of file
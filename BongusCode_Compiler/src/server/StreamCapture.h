@@ -0,0 +1,72 @@
+#pragma once
+#include <stdio.h>
+#include <string>
+#include "../Definitions.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#define _dup dup
+#define _dup2 dup2
+#define _close close
+#endif
+
+// Redirects a standard stream into a temporary file, so everything a compilation prints can be handed on,
+// see the compile server and the language server.
+class StreamCapture
+{
+public:
+
+	// main() puts stdout in wide text mode, the capture keeps the stream in that mode so the text comes out exactly as it
+	// would have on the client.
+	StreamCapture(FILE* c_stream, const bool c_wideText) : stream(c_stream), wideText(c_wideText) {}
+
+	void Begin(void)
+	{
+		fflush(stream);
+
+		captureFile = tmpfile();
+		savedDescriptor = _dup(_fileno(stream));
+		_dup2(_fileno(captureFile), _fileno(stream));
+
+		if (wideText)
+		{
+			(void)_setmode(_fileno(stream), _O_U16TEXT);
+		}
+	}
+
+	std::string End(void)
+	{
+		fflush(stream);
+		_dup2(savedDescriptor, _fileno(stream));
+		_close(savedDescriptor);
+
+		if (wideText)
+		{
+			(void)_setmode(_fileno(stream), _O_U16TEXT);
+		}
+
+		std::string captured;
+		fseek(captureFile, 0, SEEK_SET);
+
+		char buffer[4096];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), captureFile)) > 0)
+		{
+			captured.append(buffer, read);
+		}
+
+		fclose(captureFile);
+		return captured;
+	}
+
+private:
+
+	FILE* stream;
+	const bool wideText;
+
+	FILE* captureFile = nullptr;
+	i32 savedDescriptor = -1;
+};
\ No newline at end of file
@@ -0,0 +1,797 @@
+#include "Snapshot.h"
+#include "../BuildSettings.h"
+#include "../Exit.h"
+#include "../Utils.h"
+#include "../AST/ASTNode.h"
+#include "../symbol_table/symtable.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+// Nodes that carry a symbol table entry, as the accessor, or nullptr for the ones that don't.
+static AST::SymTableAccessor* GetSymTableAccessor(AST::Node* n)
+{
+	switch (n->GetNodeKind())
+	{
+		case Node_k::SymNode:			return (AST::SymNode*)n;
+		case Node_k::DeclNode:			return (AST::DeclNode*)n;
+		case Node_k::FunctionNode:		return (AST::FunctionNode*)n;
+		case Node_k::ArgNode:			return (AST::ArgNode*)n;
+		case Node_k::FunctionCallNode:	return (AST::FunctionCallNode*)n;
+		case Node_k::FwdDeclNode:		return (AST::FwdDeclNode*)n;
+		case Node_k::AddrOfNode:		return (AST::AddrOfNode*)n;
+		default:						return nullptr;
+	}
+}
+
+// Builds the snapshot in memory, numbering the nodes in pre-order.
+class SnapshotWriter
+{
+public:
+
+	void AddSymbols(const SymTable& symTable)
+	{
+		// Sorted, so the same translation unit always gives the same snapshot, byte for byte.
+		std::vector<const std::pair<const std::wstring, SymTabEntry>*> sortedEntries;
+		for (const auto& keyAndEntry : symTable.GetEntries())
+		{
+			sortedEntries.push_back(&keyAndEntry);
+		}
+		std::sort(sortedEntries.begin(), sortedEntries.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+		for (const auto* keyAndEntry : sortedEntries)
+		{
+			AddSymbol(keyAndEntry->first, keyAndEntry->second);
+		}
+	}
+
+	void AddSymbol(const std::wstring& key, const SymTabEntry& entry)
+	{
+		if (symbolIndices.contains(&entry))
+		{
+			return;
+		}
+
+		Snapshot::SymbolRecord record = {};
+		record.key = AddString(key);
+		record.name = AddString(entry.name);
+		record.functionName = AddString(std::wstring(entry.functionName.begin(), entry.functionName.end()));
+		record.isFunction = entry.isFunction;
+
+		if (entry.isFunction)
+		{
+			record.type = (ui16)entry.asFunction.retType;
+			record.isExtern = entry.asFunction.isExtern;
+		}
+		else
+		{
+			record.type = (ui16)entry.asVar.type;
+			record.pointeeType = (ui16)entry.asVar.pointeeType;
+			record.size = entry.asVar.size;
+			record.adress = entry.asVar.adress;
+		}
+
+		symbolIndices[&entry] = (ui32)symbols.size();
+		symbols.push_back(record);
+	}
+
+	void AddImportedExternFunctions(const std::vector<std::string>& importedExternFunctions)
+	{
+		for (const std::string& functionName : importedExternFunctions)
+		{
+			importedExterns.push_back(AddString(std::wstring(functionName.begin(), functionName.end())));
+		}
+	}
+
+	// Adds head and all of its right siblings. Returns the index of head.
+	ui32 AddChain(AST::Node* head)
+	{
+		ui32 first = Snapshot::s_none;
+		ui32 previous = Snapshot::s_none;
+
+		for (AST::Node* n = head; n != nullptr; n = n->GetRightSibling())
+		{
+			const ui32 index = AddNode(n);
+
+			if (previous == Snapshot::s_none)
+			{
+				first = index;
+			}
+			else
+			{
+				nodes[previous].rSibling = index;
+			}
+
+			previous = index;
+		}
+
+		return first;
+	}
+
+	// Adds each of the nodes along with its subtree, chained up as siblings in the given order, whatever their siblings are
+	// in the AST. Returns the index of the first one.
+	ui32 AddList(const std::vector<AST::Node*>& list)
+	{
+		ui32 first = Snapshot::s_none;
+		ui32 previous = Snapshot::s_none;
+
+		for (AST::Node* n : list)
+		{
+			const ui32 index = AddNode(n);
+
+			if (previous == Snapshot::s_none)
+			{
+				first = index;
+			}
+			else
+			{
+				nodes[previous].rSibling = index;
+			}
+
+			previous = index;
+		}
+
+		return first;
+	}
+
+	void SerializeTo(std::string& outBuffer, const ui32 rootNode) const
+	{
+		Snapshot::FileHeader header = {};
+		memcpy(header.magic, Snapshot::s_magic, sizeof(header.magic));
+		header.formatVersion = Snapshot::s_formatVersion;
+		strncpy(header.compilerVersion, COMPILER_VERSION, sizeof(header.compilerVersion) - 1);
+		header.nodeCount = (ui32)nodes.size();
+		header.symbolCount = (ui32)symbols.size();
+		header.stringUnitCount = (ui32)strings.size();
+		header.rootNode = rootNode;
+		header.importedExternCount = (ui32)importedExterns.size();
+
+		// Every section is 8 byte aligned, the header and the node records are multiples of 8 bytes already.
+		header.nodesOffset = sizeof(header);
+		header.symbolsOffset = header.nodesOffset + nodes.size() * sizeof(nodes[0]);
+		const ui64 symbolsPadding = (8 - (symbols.size() * sizeof(symbols[0])) % 8) % 8;
+		header.importedExternsOffset = header.symbolsOffset + symbols.size() * sizeof(symbols[0]) + symbolsPadding;
+		const ui64 importedExternsPadding = (8 - (importedExterns.size() * sizeof(importedExterns[0])) % 8) % 8;
+		header.stringsOffset = header.importedExternsOffset + importedExterns.size() * sizeof(importedExterns[0]) + importedExternsPadding;
+
+		// Sized up front, the padding is left zeroed.
+		outBuffer.assign(header.stringsOffset + strings.size() * sizeof(strings[0]), '\0');
+		memcpy(outBuffer.data(), &header, sizeof(header));
+		memcpy(outBuffer.data() + header.nodesOffset, nodes.data(), nodes.size() * sizeof(nodes[0]));
+		memcpy(outBuffer.data() + header.symbolsOffset, symbols.data(), symbols.size() * sizeof(symbols[0]));
+		memcpy(outBuffer.data() + header.importedExternsOffset, importedExterns.data(), importedExterns.size() * sizeof(importedExterns[0]));
+		memcpy(outBuffer.data() + header.stringsOffset, strings.data(), strings.size() * sizeof(strings[0]));
+	}
+
+	bool WriteTo(const char* path, const ui32 rootNode) const
+	{
+		std::string buffer;
+		SerializeTo(buffer, rootNode);
+
+		FILE* file = fopen(path, "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		const bool isWritten = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+		return (fclose(file) == 0) && isWritten;
+	}
+
+	inline ui64 GetNodeCount(void) const { return nodes.size(); }
+	inline ui64 GetSymbolCount(void) const { return symbols.size(); }
+
+private:
+
+	ui32 AddNode(AST::Node* n)
+	{
+		const ui32 index = (ui32)nodes.size();
+		nodes.emplace_back();
+
+		Snapshot::NodeRecord record = {};
+		record.kind = (ui16)n->GetNodeKind();
+		record.line = n->GetLine();
+		record.name = Snapshot::s_none;
+		record.symbol = Snapshot::s_none;
+		record.rSibling = Snapshot::s_none;
+
+		AST::Node* extraChildren[2] = { nullptr, nullptr };
+
+		switch (n->GetNodeKind())
+		{
+			case Node_k::IntNode:
+			{
+				record.value = ((AST::IntNode*)n)->Get();
+				break;
+			}
+			case Node_k::SymNode:
+			{
+				record.name = AddString(((AST::SymNode*)n)->GetName());
+				break;
+			}
+			case Node_k::OpNode:
+			{
+				AST::OpNode* asOpNode = (AST::OpNode*)n;
+				record.type = (ui16)asOpNode->GetOp();
+				extraChildren[0] = asOpNode->GetLHS();
+				extraChildren[1] = asOpNode->GetRHS();
+				break;
+			}
+			case Node_k::AssNode:
+			{
+				AST::AssNode* asAssNode = (AST::AssNode*)n;
+				extraChildren[0] = asAssNode->GetVar();
+				extraChildren[1] = asAssNode->GetExpr();
+				break;
+			}
+			case Node_k::DeclNode:
+			{
+				AST::DeclNode* asDeclNode = (AST::DeclNode*)n;
+				record.name = AddString(asDeclNode->GetName());
+				record.type = (ui16)asDeclNode->GetType();
+				record.pointeeType = (ui16)asDeclNode->GetPointeeType();
+				break;
+			}
+			case Node_k::ReturnNode:
+			{
+				extraChildren[0] = ((AST::ReturnNode*)n)->GetRetExpr();
+				break;
+			}
+			case Node_k::FunctionNode:
+			{
+				AST::FunctionNode* asFunctionNode = (AST::FunctionNode*)n;
+				record.name = AddString(asFunctionNode->GetName());
+				record.type = (ui16)asFunctionNode->GetRetType();
+				extraChildren[0] = asFunctionNode->GetArgsList();
+				break;
+			}
+			case Node_k::ArgNode:
+			{
+				AST::ArgNode* asArgNode = (AST::ArgNode*)n;
+				record.name = AddString(asArgNode->GetName());
+				record.type = (ui16)asArgNode->GetType();
+				record.pointeeType = (ui16)asArgNode->GetPointeeType();
+				break;
+			}
+			case Node_k::FunctionCallNode:
+			{
+				AST::FunctionCallNode* asFunctionCallNode = (AST::FunctionCallNode*)n;
+				record.name = AddString(asFunctionCallNode->GetName());
+				extraChildren[0] = asFunctionCallNode->GetArgs();
+				break;
+			}
+			case Node_k::FwdDeclNode:
+			{
+				AST::FwdDeclNode* asFwdDeclNode = (AST::FwdDeclNode*)n;
+				record.name = AddString(asFwdDeclNode->GetName());
+				record.type = (ui16)asFwdDeclNode->GetRetType();
+				extraChildren[0] = asFwdDeclNode->GetArgsList();
+				break;
+			}
+			case Node_k::ExternFwdDeclNode:
+			{
+				extraChildren[0] = ((AST::ExternFwdDeclNode*)n)->GetFwdDeclNode();
+				break;
+			}
+			case Node_k::AddrOfNode:
+			{
+				record.name = AddString(((AST::AddrOfNode*)n)->GetName());
+				break;
+			}
+			case Node_k::DerefNode:
+			{
+				extraChildren[0] = ((AST::DerefNode*)n)->GetExpr();
+				break;
+			}
+			case Node_k::ForLoopNode:
+			{
+				AST::ForLoopNode* asForLoopNode = (AST::ForLoopNode*)n;
+				extraChildren[0] = asForLoopNode->GetHead();
+				extraChildren[1] = asForLoopNode->GetBody();
+				break;
+			}
+			case Node_k::ForLoopHeadNode:
+			{
+				AST::ForLoopHeadNode* asForLoopHeadNode = (AST::ForLoopHeadNode*)n;
+				extraChildren[0] = asForLoopHeadNode->GetUpperBound();
+				extraChildren[1] = asForLoopHeadNode->GetLowerBound();
+				break;
+			}
+		}
+
+		AST::SymTableAccessor* accessor = GetSymTableAccessor(n);
+		if (accessor != nullptr && accessor->GetSymTabEntry() != nullptr)
+		{
+			auto symbolIndex = symbolIndices.find(accessor->GetSymTabEntry());
+			if (symbolIndex != symbolIndices.end())
+			{
+				record.symbol = symbolIndex->second;
+			}
+		}
+
+		record.extraChildren[0] = AddChain(extraChildren[0]);
+		record.extraChildren[1] = AddChain(extraChildren[1]);
+		record.lmostChild = AddChain(n->GetLeftmostChild());
+
+		nodes[index] = record;
+		return index;
+	}
+
+	// Strings are stored as their length followed by their characters, all in 32-bit units.
+	ui32 AddString(const std::wstring& string)
+	{
+		const ui32 offset = (ui32)strings.size();
+
+		strings.push_back((ui32)string.length());
+		for (const wchar_t c : string)
+		{
+			strings.push_back((ui32)c);
+		}
+
+		return offset;
+	}
+
+	std::vector<Snapshot::NodeRecord> nodes;
+	std::vector<Snapshot::SymbolRecord> symbols;
+	std::vector<ui32> importedExterns;
+	std::vector<ui32> strings;
+	std::unordered_map<const SymTabEntry*, ui32> symbolIndices;
+};
+
+bool Snapshot::Write(const char* path, AST::Node* nodeHead, const SymTable& symTable, const std::vector<std::string>& importedExternFunctions, ui64& outNodeCount)
+{
+	SnapshotWriter writer;
+	writer.AddSymbols(symTable);
+	writer.AddImportedExternFunctions(importedExternFunctions);
+	const ui32 rootNode = writer.AddChain(nodeHead);
+
+	outNodeCount = writer.GetNodeCount();
+	return writer.WriteTo(path, rootNode);
+}
+
+bool Snapshot::WriteInterface(const char* path, AST::Node* nodeHead, const SymTable& symTable, ui64& outFunctionCount)
+{
+	// In the order the functions are declared, so importing the interface lists the external ones in the same order
+	// as the declarations themselves would.
+	SnapshotWriter writer;
+	for (AST::Node* globalEntry : nodeHead->GetChildren())
+	{
+		if (globalEntry->GetNodeKind() == Node_k::ExternFwdDeclNode)
+		{
+			globalEntry = ((AST::ExternFwdDeclNode*)globalEntry)->GetFwdDeclNode();
+		}
+
+		AST::SymTableAccessor* accessor = GetSymTableAccessor(globalEntry);
+		if (accessor != nullptr && accessor->GetSymTabEntry() != nullptr)
+		{
+			const SymTabEntry* entry = accessor->GetSymTabEntry();
+			writer.AddSymbol(symTable.ComposeGlobalKey(entry->name), *entry);
+		}
+	}
+
+	outFunctionCount = writer.GetSymbolCount();
+	return writer.WriteTo(path, s_none);
+}
+
+void Snapshot::WriteFunctions(const std::vector<AST::Node*>& functions, const SymTable& symTable, std::string& outBuffer)
+{
+	// Only the symbols the functions refer to, their own locals and arguments and the functions they call, go in.
+	std::unordered_map<const SymTabEntry*, const std::wstring*> keys;
+	for (const auto& keyAndEntry : symTable.GetEntries())
+	{
+		keys[&keyAndEntry.second] = &keyAndEntry.first;
+	}
+
+	SnapshotWriter writer;
+	for (AST::Node* function : functions)
+	{
+		for (AST::Node* n : AST::GetAllChildrenRecursively(function))
+		{
+			AST::SymTableAccessor* accessor = GetSymTableAccessor(n);
+			if (accessor == nullptr || accessor->GetSymTabEntry() == nullptr)
+			{
+				continue;
+			}
+
+			auto key = keys.find(accessor->GetSymTabEntry());
+			if (key != keys.end())
+			{
+				writer.AddSymbol(*key->second, *key->first);
+			}
+		}
+	}
+
+	writer.SerializeTo(outBuffer, writer.AddList(functions));
+}
+
+// Rebuilds the AST straight from the mapped records, checking every index before following it.
+class SnapshotLoader
+{
+public:
+
+	SnapshotLoader(const char* data, const ui64 size, SymTable& c_symTable) : symTable(c_symTable)
+	{
+		if (size < sizeof(Snapshot::FileHeader))
+		{
+			Fail();
+		}
+
+		header = (const Snapshot::FileHeader*)data;
+		if (memcmp(header->magic, Snapshot::s_magic, sizeof(header->magic)) != 0)
+		{
+			Fail();
+		}
+
+		if (header->formatVersion != Snapshot::s_formatVersion || strncmp(header->compilerVersion, COMPILER_VERSION, sizeof(header->compilerVersion)) != 0)
+		{
+			wprintf(L"ERROR: The snapshot was written by a different version of the compiler, compile from source instead.\n");
+			Exit(ErrCodes::malformed_snapshot);
+		}
+
+		if (!IsSectionInFile(header->nodesOffset, header->nodeCount, sizeof(Snapshot::NodeRecord), size) ||
+			!IsSectionInFile(header->symbolsOffset, header->symbolCount, sizeof(Snapshot::SymbolRecord), size) ||
+			!IsSectionInFile(header->importedExternsOffset, header->importedExternCount, sizeof(ui32), size) ||
+			!IsSectionInFile(header->stringsOffset, header->stringUnitCount, sizeof(ui32), size))
+		{
+			Fail();
+		}
+
+		nodes = (const Snapshot::NodeRecord*)(data + header->nodesOffset);
+		symbols = (const Snapshot::SymbolRecord*)(data + header->symbolsOffset);
+		importedExterns = (const ui32*)(data + header->importedExternsOffset);
+		strings = (const ui32*)(data + header->stringsOffset);
+		isNodeBuilt.resize(header->nodeCount, false);
+	}
+
+	// Enters the saved symbols into the symbol table, or only the functions, leaving a gap for each of the others.
+	void LoadSymbols(const bool functionsOnly)
+	{
+		for (ui32 i = 0; i < header->symbolCount; i++)
+		{
+			const Snapshot::SymbolRecord& record = symbols[i];
+
+			if (functionsOnly && record.isFunction == 0)
+			{
+				symbolEntries.push_back(nullptr);
+				continue;
+			}
+
+			SymTabEntry entry;
+			entry.name = ReadString(record.name);
+			const std::wstring functionName = ReadString(record.functionName);
+			entry.functionName.assign(functionName.begin(), functionName.end());
+			entry.isFunction = record.isFunction != 0;
+
+			if (entry.isFunction)
+			{
+				entry.asFunction.retType = ReadType(record.type);
+				entry.asFunction.isExtern = record.isExtern != 0;
+			}
+			else
+			{
+				entry.asVar.type = ReadType(record.type);
+				entry.asVar.pointeeType = ReadType(record.pointeeType);
+				entry.asVar.size = record.size;
+				entry.asVar.adress = record.adress;
+			}
+
+			symbolEntries.push_back(symTable.RestoreSymbol(ReadString(record.key), entry));
+		}
+	}
+
+	void LoadImportedExternFunctions(std::vector<std::string>& outImportedExternFunctions) const
+	{
+		for (ui32 i = 0; i < header->importedExternCount; i++)
+		{
+			const std::wstring functionName = ReadString(importedExterns[i]);
+			outImportedExternFunctions.emplace_back(functionName.begin(), functionName.end());
+		}
+	}
+
+	AST::Node* LoadTree(ui64& outNodeCount)
+	{
+		if (header->rootNode >= header->nodeCount)
+		{
+			Fail();
+		}
+
+		// Every node registers itself at the disaster handle, which would otherwise rehash its way up to the final size.
+		AST::g_disasterHandle.reserve(AST::g_disasterHandle.size() + header->nodeCount);
+
+		AST::Node* root = BuildNode(header->rootNode);
+
+		outNodeCount = builtNodeCount;
+		return root;
+	}
+
+	// Like LoadTree(), for a snapshot whose root is the head of a sibling list rather than a single node.
+	AST::Node* LoadList(ui64& outNodeCount)
+	{
+		if (header->rootNode >= header->nodeCount)
+		{
+			Fail();
+		}
+
+		AST::g_disasterHandle.reserve(AST::g_disasterHandle.size() + header->nodeCount);
+
+		AST::Node* head = BuildChain(header->rootNode);
+
+		outNodeCount = builtNodeCount;
+		return head;
+	}
+
+	inline const std::vector<SymTabEntry*>& GetSymbols(void) const { return symbolEntries; }
+
+private:
+
+	[[noreturn]] static void Fail(void)
+	{
+		wprintf(L"ERROR: The snapshot is damaged, or not a snapshot at all.\n");
+		Exit(ErrCodes::malformed_snapshot);
+	}
+
+	static bool IsSectionInFile(const ui64 offset, const ui32 count, const ui64 elementSize, const ui64 fileSize)
+	{
+		return offset % 8 == 0 && offset <= fileSize && count * elementSize <= fileSize - offset;
+	}
+
+	std::wstring ReadString(const ui32 offset) const
+	{
+		if (offset >= header->stringUnitCount || strings[offset] > header->stringUnitCount - offset - 1)
+		{
+			Fail();
+		}
+
+		std::wstring string(strings[offset], L'\0');
+		for (ui32 i = 0; i < strings[offset]; i++)
+		{
+			string[i] = (wchar_t)strings[offset + 1 + i];
+		}
+
+		return string;
+	}
+
+	static PrimitiveType ReadType(const ui16 type)
+	{
+		if (type >= GetArraySize(PrimitiveTypeReflectionNarrow))
+		{
+			Fail();
+		}
+
+		return (PrimitiveType)type;
+	}
+
+	// A node may only refer to nodes after itself, and each node may only be built once, so there's no way to loop.
+	void CheckReference(const ui32 from, const ui32 to) const
+	{
+		if (to != Snapshot::s_none && (to <= from || to >= header->nodeCount))
+		{
+			Fail();
+		}
+	}
+
+	AST::Node* BuildChain(const ui32 head)
+	{
+		if (head == Snapshot::s_none)
+		{
+			return nullptr;
+		}
+
+		AST::Node* first = BuildNode(head);
+		AST::Node* last = first;
+
+		for (ui32 next = nodes[head].rSibling; next != Snapshot::s_none; next = nodes[next].rSibling)
+		{
+			AST::Node* n = BuildNode(next);
+
+			// Appending to the last node keeps MakeSiblings from walking the whole list every time.
+			last->MakeSiblings(n);
+			last = n;
+		}
+
+		return first;
+	}
+
+	AST::Node* BuildNode(const ui32 index)
+	{
+		if (isNodeBuilt[index])
+		{
+			Fail();
+		}
+		isNodeBuilt[index] = true;
+		builtNodeCount++;
+
+		const Snapshot::NodeRecord& record = nodes[index];
+		CheckReference(index, record.lmostChild);
+		CheckReference(index, record.rSibling);
+		CheckReference(index, record.extraChildren[0]);
+		CheckReference(index, record.extraChildren[1]);
+
+		AST::Node* extra0 = BuildChain(record.extraChildren[0]);
+		AST::Node* extra1 = BuildChain(record.extraChildren[1]);
+
+		AST::Node* n = nullptr;
+		switch ((Node_k)record.kind)
+		{
+			case Node_k::Node:				n = AST::MakeNullNode(); break;
+			case Node_k::IntNode:			n = AST::MakeIntNode((i64)record.value); break;
+			case Node_k::SymNode:			n = AST::MakeSymNode(new std::wstring(ReadString(record.name))); break;
+			case Node_k::AssNode:			n = AST::MakeAssNode(extra0, extra1); break;
+			case Node_k::ScopeNode:			n = AST::MakeScopeNode(); break;
+			case Node_k::ReturnNode:		n = AST::MakeReturnNode(extra0); break;
+			case Node_k::FunctionCallNode:	n = AST::MakeFunctionCallNode(new std::wstring(ReadString(record.name)), extra0); break;
+			case Node_k::ExternFwdDeclNode:	n = AST::MakeExternFwdDeclNode(extra0); break;
+			case Node_k::AddrOfNode:		n = AST::MakeAddrOfNode(new std::wstring(ReadString(record.name))); break;
+			case Node_k::DerefNode:			n = AST::MakeDerefNode(extra0); break;
+			case Node_k::ForLoopNode:		n = AST::MakeForLoopNode(extra0, extra1); break;
+			case Node_k::ForLoopHeadNode:	n = AST::MakeForLoopHeadNode(extra0, extra1); break;
+
+			case Node_k::OpNode:
+			{
+				if (record.type > (ui16)Op_k::OR)
+				{
+					Fail();
+				}
+
+				n = AST::MakeOpNode((Op_k)record.type, extra0, extra1);
+				break;
+			}
+			case Node_k::DeclNode:
+			{
+				n = AST::MakeDeclNode(new std::wstring(ReadString(record.name)), ReadType(record.type), ReadType(record.pointeeType));
+				break;
+			}
+			case Node_k::FunctionNode:
+			{
+				n = AST::MakeFunctionNode(ReadType(record.type), new std::wstring(ReadString(record.name)), extra0);
+				break;
+			}
+			case Node_k::ArgNode:
+			{
+				n = AST::MakeArgNode(new std::wstring(ReadString(record.name)), ReadType(record.type), ReadType(record.pointeeType));
+				break;
+			}
+			case Node_k::FwdDeclNode:
+			{
+				n = AST::MakeFwdDeclNode(ReadType(record.type), new std::wstring(ReadString(record.name)), extra0);
+				break;
+			}
+			default:
+			{
+				Fail();
+			}
+		}
+
+		n->SetLine(record.line);
+
+		AST::SymTableAccessor* accessor = GetSymTableAccessor(n);
+		if (accessor != nullptr)
+		{
+			if (record.symbol != Snapshot::s_none && record.symbol >= symbolEntries.size())
+			{
+				Fail();
+			}
+
+			accessor->SetSymTabEntry(record.symbol != Snapshot::s_none ? symbolEntries[record.symbol] : nullptr);
+		}
+
+		AST::Node* children = BuildChain(record.lmostChild);
+		if (children != nullptr)
+		{
+			n->AdoptChildren(children);
+		}
+
+		return n;
+	}
+
+	SymTable& symTable;
+
+	const Snapshot::FileHeader* header = nullptr;
+	const Snapshot::NodeRecord* nodes = nullptr;
+	const Snapshot::SymbolRecord* symbols = nullptr;
+	const ui32* importedExterns = nullptr;
+	const ui32* strings = nullptr;
+
+	std::vector<SymTabEntry*> symbolEntries;
+	std::vector<bool> isNodeBuilt;
+	ui64 builtNodeCount = 0;
+};
+
+AST::Node* Snapshot::Load(const char* path, SymTable& symTable, std::vector<std::string>& outImportedExternFunctions, ui64& outNodeCount)
+{
+	Utils::MappedFile file;
+	if (!file.Open(path))
+	{
+		wprintf(L"ERROR: Unable to open snapshot file.\n");
+		Exit(ErrCodes::malformed_cmd_line);
+	}
+
+	SnapshotLoader loader(file.GetData(), file.GetSize(), symTable);
+	loader.LoadSymbols(false);
+	loader.LoadImportedExternFunctions(outImportedExternFunctions);
+	return loader.LoadTree(outNodeCount);
+}
+
+AST::Node* Snapshot::LoadFunctions(const std::string& buffer, SymTable& symTable, ui64& outNodeCount)
+{
+	SnapshotLoader loader(buffer.data(), buffer.size(), symTable);
+	loader.LoadSymbols(false);
+	return loader.LoadList(outNodeCount);
+}
+
+void Snapshot::LoadInterface(const char* path, SymTable& symTable, std::vector<std::string>& outExternFunctions)
+{
+	Utils::MappedFile file;
+	if (!file.Open(path))
+	{
+		wprintf(L"ERROR: Unable to open module interface file.\n");
+		Exit(ErrCodes::malformed_cmd_line);
+	}
+
+	SnapshotLoader loader(file.GetData(), file.GetSize(), symTable);
+	loader.LoadSymbols(true);
+
+	for (const SymTabEntry* entry : loader.GetSymbols())
+	{
+		if (entry != nullptr && entry->asFunction.isExtern)
+		{
+			outExternFunctions.push_back(entry->functionName);
+		}
+	}
+}
+
+static bool IsSameSymbol(const SymTabEntry* a, const SymTabEntry* b)
+{
+	if (a == nullptr || b == nullptr)
+	{
+		return a == b;
+	}
+
+	if (a->name != b->name || a->functionName != b->functionName || a->isFunction != b->isFunction)
+	{
+		return false;
+	}
+
+	if (a->isFunction)
+	{
+		return a->asFunction.retType == b->asFunction.retType && a->asFunction.isExtern == b->asFunction.isExtern;
+	}
+
+	return a->asVar.type == b->asVar.type && a->asVar.pointeeType == b->asVar.pointeeType &&
+		a->asVar.size == b->asVar.size && a->asVar.adress == b->asVar.adress;
+}
+
+bool Snapshot::VerifyRoundTrip(AST::Node* original, AST::Node* loaded)
+{
+	// The hash covers the structure and every name, type, constant and operator.
+	if (AST::HashSubtree(original) != AST::HashSubtree(loaded))
+	{
+		return false;
+	}
+
+	// Which leaves the symbols, compared node for node.
+	const std::vector<AST::Node*> originalNodes = AST::GetAllChildrenRecursively(original);
+	const std::vector<AST::Node*> loadedNodes = AST::GetAllChildrenRecursively(loaded);
+	if (originalNodes.size() != loadedNodes.size())
+	{
+		return false;
+	}
+
+	for (ui64 i = 0; i < originalNodes.size(); i++)
+	{
+		if (originalNodes[i]->GetNodeKind() != loadedNodes[i]->GetNodeKind())
+		{
+			return false;
+		}
+
+		AST::SymTableAccessor* originalAccessor = GetSymTableAccessor(originalNodes[i]);
+		if (originalAccessor != nullptr && !IsSameSymbol(originalAccessor->GetSymTabEntry(), GetSymTableAccessor(loadedNodes[i])->GetSymTabEntry()))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../Definitions.h"
+
+namespace AST
+{
+	class Node;
+}
+
+class SymTable;
+
+/*
+	Binary snapshot of an analysed translation unit: its AST and its symbol table, as they are after the semantics pass.
+	Compiling from a snapshot skips the whole front end, lexing, parsing and analysis, and goes straight to code generation.
+
+	The file is laid out to be used straight out of a memory mapping, so there isn't a single pointer in it:
+	- A header, then the node records, the symbol records, the imported external C functions and the string pool,
+	  each at the offset the header gives.
+	- Nodes refer to each other and to symbols by index, and to strings by their offset in the pool, in 32-bit units.
+	- Nodes are numbered in pre-order, so a node only ever refers to nodes with a higher index, which makes it impossible
+	  for a damaged snapshot to send the loader around in circles.
+	- Everything is little endian and naturally aligned.
+	Snapshots are versioned by their format and by the compiler that wrote them, and any other version is refused.
+
+	Distributed code generation sends functions to the workers as snapshots too, in memory, holding only those functions and the
+	symbols they refer to.
+
+	A module interface is a snapshot without an AST, holding only the declarations of functions in the order they were written,
+	see --emit-interface and --import.
+	A file of shared declarations can be compiled into one once, and every file that imports it gets the declarations entered
+	into its symbol table straight away, instead of lexing, parsing and harvesting them all over again.
+*/
+namespace Snapshot
+{
+	constexpr char s_magic[4] = { 'B', 'C', 'A', 'S' };
+
+	// Bump whenever the layout below changes.
+	constexpr ui32 s_formatVersion = 2;
+
+	// Stands in for a missing node, symbol or string.
+	constexpr ui32 s_none = 0xFFFFFFFF;
+
+	struct FileHeader
+	{
+		char magic[4];
+		ui32 formatVersion;
+
+		// COMPILER_VERSION of the compiler that wrote the snapshot, zero padded.
+		char compilerVersion[16];
+
+		ui32 nodeCount;
+		ui32 symbolCount;
+		ui32 stringUnitCount;
+		ui32 rootNode;
+
+		// The external C functions the translation unit imported, which have no declaration in the AST, as string offsets.
+		ui32 importedExternCount;
+		ui32 padding;
+
+		ui64 nodesOffset;
+		ui64 symbolsOffset;
+		ui64 importedExternsOffset;
+		ui64 stringsOffset;
+	};
+
+	struct NodeRecord
+	{
+		// Node_k.
+		ui16 kind;
+
+		// Op_k for OpNodes, the return type for functions and forward declarations, and the type for declarations and arguments.
+		ui16 type;
+		ui16 pointeeType;
+		ui16 padding;
+
+		ui32 name;
+		ui32 symbol;
+
+		ui32 lmostChild;
+		ui32 rSibling;
+
+		// The children a node keeps outside of its child list, e.g. an OpNode's lhs and rhs, in the order the node declares them.
+		ui32 extraChildren[2];
+
+		// The constant of an IntNode.
+		ui64 value;
+
+		// The node's source line, see Node::GetLine().
+		ui32 line;
+		ui32 linePadding;
+	};
+
+	struct SymbolRecord
+	{
+		ui32 key;
+		ui32 name;
+		ui32 functionName;
+
+		// The variable's type, or the function's return type.
+		ui16 type;
+		ui16 pointeeType;
+		ui32 size;
+		i32 adress;
+
+		ui8 isFunction;
+		ui8 isExtern;
+		ui16 padding;
+	};
+
+	static_assert(sizeof(FileHeader) == 80, "Snapshot file header layout changed, bump s_formatVersion.");
+	static_assert(sizeof(NodeRecord) == 48, "Snapshot node record layout changed, bump s_formatVersion.");
+	static_assert(sizeof(SymbolRecord) == 28, "Snapshot symbol record layout changed, bump s_formatVersion.");
+
+	// Writes the AST under nodeHead, every entry of symTable, and the external C functions imported from module interfaces to path.
+	// Returns false if the file can't be written.
+	bool Write(const char* path, AST::Node* nodeHead, const SymTable& symTable, const std::vector<std::string>& importedExternFunctions, ui64& outNodeCount);
+
+	// Rebuilds the AST and the symbol table saved in the snapshot at path, entering the symbols into symTable, and hands back the
+	// imported external C functions. Returns the root of the AST.
+	// A snapshot that can't be read, or doesn't hold up, is an error, and goes through Exit().
+	AST::Node* Load(const char* path, SymTable& symTable, std::vector<std::string>& outImportedExternFunctions, ui64& outNodeCount);
+
+	// Writes the declarations of the functions declared or defined in the AST under nodeHead to path, as a module interface.
+	bool WriteInterface(const char* path, AST::Node* nodeHead, const SymTable& symTable, ui64& outFunctionCount);
+
+	// Enters the function declarations of the module interface(or any snapshot) at path into symTable, and appends the names of the
+	// external C functions among them to outExternFunctions. Errors go through Exit(), like with Load().
+	void LoadInterface(const char* path, SymTable& symTable, std::vector<std::string>& outExternFunctions);
+
+	// Serializes the given functions, and the symbols they refer to, into outBuffer, for handing them to another process to
+	// generate code for(see distributed/CodegenWorker.h). The functions are chained up as siblings in the given order.
+	void WriteFunctions(const std::vector<AST::Node*>& functions, const SymTable& symTable, std::string& outBuffer);
+
+	// Rebuilds the functions written by WriteFunctions(), entering their symbols into symTable. Returns the first of them,
+	// which owns the rest as its right siblings. Errors go through Exit(), like with Load().
+	AST::Node* LoadFunctions(const std::string& buffer, SymTable& symTable, ui64& outNodeCount);
+
+	// Checks that original and loaded are the same AST, node for node, down to the symbols they are bound to.
+	bool VerifyRoundTrip(AST::Node* original, AST::Node* loaded);
+}
\ No newline at end of file
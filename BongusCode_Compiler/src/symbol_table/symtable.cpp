@@ -1,4 +1,5 @@
 #include "symtable.h"
+#include "../profiling/MemoryAccounting.h"
 
 const std::wstring SymTable::s_globalNamespace = std::wstring(L"");
 
@@ -31,16 +32,20 @@ void SymTable::CloseFunction(void)
 
 std::wstring SymTable::ComposeKey(const std::wstring& name)
 {
+	Memory::CategoryScope symbolTableScope(Memory::Category::symbolTable);
 	return currentFunction + L"." + name;
 }
 
-std::wstring SymTable::ComposeGlobalKey(const std::wstring& name)
+std::wstring SymTable::ComposeGlobalKey(const std::wstring& name) const
 {
+	Memory::CategoryScope symbolTableScope(Memory::Category::symbolTable);
 	return s_globalNamespace + L"." + name;
 }
 
 SymTabEntry* SymTable::EnterSymbol(const std::wstring& name, const PrimitiveType type, const PrimitiveType pointeeType, ui32 size, const bool isFunction, const bool isExtern)
 {
+	Memory::CategoryScope symbolTableScope(Memory::Category::symbolTable);
+
 	SymTabEntry entry;
 	entry.name = name;
 	entry.isFunction = isFunction;
@@ -68,3 +73,29 @@ SymTabEntry* SymTable::RetrieveSymbol(const std::wstring& composedKey)
 {
 	return table.contains(composedKey) ? &table.at(composedKey) : nullptr;
 }
+
+void SymTable::DropFunctionLocals(const std::wstring& functionName, const std::vector<std::wstring>& localNames)
+{
+	// Locals are keyed ".Foo.bar", the same way ComposeKey() does it while Foo is open.
+	const std::wstring localsPrefix = ComposeGlobalKey(functionName) + L".";
+
+	for (const std::wstring& localName : localNames)
+	{
+		table.erase(localsPrefix + localName);
+	}
+}
+
+void SymTable::Clear(void)
+{
+	table.clear();
+	depth = 0;
+	currentFunction = s_globalNamespace;
+}
+
+SymTabEntry* SymTable::RestoreSymbol(const std::wstring& composedKey, const SymTabEntry& entry)
+{
+	Memory::CategoryScope symbolTableScope(Memory::Category::symbolTable);
+	table.insert_or_assign(composedKey, entry);
+
+	return RetrieveSymbol(composedKey);
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include "../BongusTable.h"
 
 struct SymTabEntry
@@ -58,13 +59,25 @@ public:
 	void CloseFunction(void);
 
 	std::wstring ComposeKey(const std::wstring& name);
-	std::wstring ComposeGlobalKey(const std::wstring& name);
+	std::wstring ComposeGlobalKey(const std::wstring& name) const;
 
 	SymTabEntry* EnterSymbol(const std::wstring& name, const PrimitiveType type, const PrimitiveType pointeeType, ui32 size, const bool isFunction, const bool isExtern);
 
 	// The key here should be composed with ComposeKey already.
 	SymTabEntry* RetrieveSymbol(const std::wstring& composedKey);
 
+	// Removes the entries of the named locals of the function named functionName. Pointers to any other entry stay valid.
+	void DropFunctionLocals(const std::wstring& functionName, const std::vector<std::wstring>& localNames);
+
+	// Removes every entry, but keeps the table's buckets allocated for the next translation unit.
+	void Clear(void);
+
+	// Enters a copy of an entry under an already composed key, the way it was saved in an AST snapshot.
+	SymTabEntry* RestoreSymbol(const std::wstring& composedKey, const SymTabEntry& entry);
+
+	// Every entry, by composed key.
+	inline const std::unordered_map<std::wstring, SymTabEntry>& GetEntries(void) const { return table; }
+
 
 private:
 
@@ -0,0 +1,90 @@
+#include "FileWatcher.h"
+#include <filesystem>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <limits.h>
+#endif
+
+Watch::FileWatcher::~FileWatcher()
+{
+#ifdef _WIN32
+	if (changeHandle != nullptr)
+	{
+		FindCloseChangeNotification(changeHandle);
+	}
+#else
+	if (inotifyDescriptor != -1)
+	{
+		close(inotifyDescriptor);
+	}
+#endif
+}
+
+bool Watch::FileWatcher::Open(const char* path)
+{
+	const std::filesystem::path absolutePath = std::filesystem::absolute(path);
+	const std::string directory = absolutePath.parent_path().string();
+
+#ifdef _WIN32
+	// Windows has no per-file notifications, any write or rename in the directory wakes us up.
+	HANDLE handle = FindFirstChangeNotificationA(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	changeHandle = handle;
+	return true;
+#else
+	inotifyDescriptor = inotify_init1(IN_CLOEXEC);
+	if (inotifyDescriptor == -1)
+	{
+		return false;
+	}
+
+	// Closing after a write covers editors that save in place, moving covers the ones that write a new file and rename it.
+	fileName = absolutePath.filename().string();
+	return inotify_add_watch(inotifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) != -1;
+#endif
+}
+
+bool Watch::FileWatcher::WaitForChange(void)
+{
+#ifdef _WIN32
+	if (WaitForSingleObject(changeHandle, INFINITE) != WAIT_OBJECT_0)
+	{
+		return false;
+	}
+
+	return FindNextChangeNotification(changeHandle) != FALSE;
+#else
+	alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+
+	for (;;)
+	{
+		const ssize_t length = read(inotifyDescriptor, buffer, sizeof(buffer));
+		if (length <= 0)
+		{
+			return false;
+		}
+
+		// Other files in the same directory are none of our business.
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event* event = (const inotify_event*)(buffer + offset);
+			if (event->len != 0 && strcmp(event->name, fileName.c_str()) == 0)
+			{
+				return true;
+			}
+
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include "../Definitions.h"
+
+namespace Watch
+{
+	// Waits for a file to be written to.
+	// Watches the file's directory rather than the file itself, as many editors save by writing a new file and renaming it over the old one.
+	// Wake ups may be spurious, so whoever waits should check whether the contents really changed.
+	class FileWatcher
+	{
+	public:
+
+		FileWatcher() = default;
+		~FileWatcher();
+
+		bool Open(const char* path);
+
+		// Blocks until the file may have changed. Returns false if watching has failed.
+		bool WaitForChange(void);
+
+	private:
+
+#ifdef _WIN32
+		// A change notification handle(HANDLE) for the directory.
+		void* changeHandle = nullptr;
+#else
+		// An inotify instance watching the directory.
+		i32 inotifyDescriptor = -1;
+		std::string fileName;
+#endif
+	};
+}
\ No newline at end of file
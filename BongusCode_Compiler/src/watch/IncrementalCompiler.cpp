@@ -0,0 +1,430 @@
+#include "IncrementalCompiler.h"
+#include "FileWatcher.h"
+#include "../Exit.h"
+#include "../Utils.h"
+#include "../Driver.h"
+#include "../parser/parser.hpp"
+#include "../lexer/lexer.h"
+#include "../lexer/TokenStream.h"
+#include "../AST/ASTNode.h"
+#include "../AST/AST_Harvest_Pass.h"
+#include "../AST/AST_Analysis_Pass.h"
+#include "../AST/AST_Folding_Pass.h"
+#include "../AST/AST_Propagation_Pass.h"
+#include "../symbol_table/symtable.h"
+#include "../code_generator/codegen.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <unordered_set>
+
+// Where a global entry lies in the source.
+struct SourceChunk
+{
+	const char* begin;
+	ui64 size;
+	ui32 firstLine;
+};
+
+// Cuts the source into its global entries. A function ends with the '}' that closes its body, a forward declaration with a '.',
+// both at the top level. Whatever can't be told apart this way ends up in one chunk, for the parser to complain about.
+static void SplitGlobalEntries(const std::string& source, std::vector<SourceChunk>& outChunks)
+{
+	const char* text = source.c_str();
+	const ui64 size = source.size();
+
+	ui64 i = (size >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0) ? 3 : 0;
+	ui32 line = 1;
+
+	while (i < size)
+	{
+		// Skip whatever lies between entries.
+		if (text[i] == '\n')
+		{
+			line++;
+			i++;
+			continue;
+		}
+
+		if (text[i] == ' ' || text[i] == '\t' || text[i] == '\r')
+		{
+			i++;
+			continue;
+		}
+
+		if (text[i] == '|' && i + 1 < size && text[i + 1] == '|')
+		{
+			while (i < size && text[i] != '\n')
+			{
+				i++;
+			}
+			continue;
+		}
+
+		SourceChunk chunk = { text + i, 0, line };
+		i32 depth = 0;
+
+		for (; i < size; i++)
+		{
+			const char c = text[i];
+
+			if (c == '\n')
+			{
+				line++;
+			}
+			else if (c == '|' && i + 1 < size && text[i + 1] == '|')
+			{
+				// Comments run to the end of the line, and may contain anything.
+				while (i + 1 < size && text[i + 1] != '\n')
+				{
+					i++;
+				}
+			}
+			else if (c == '{')
+			{
+				depth++;
+			}
+			else if ((c == '}' && --depth <= 0) || (c == '.' && depth == 0))
+			{
+				i++;
+				break;
+			}
+		}
+
+		chunk.size = (ui64)(text + i - chunk.begin);
+		outChunks.push_back(chunk);
+	}
+}
+
+// What codegen reads from the declaration of a function it calls.
+static ui64 HashSignature(const SymTabEntry* entry)
+{
+	if (entry == nullptr)
+	{
+		return 0;
+	}
+
+	ui64 hash = Utils::HashFNV1a(entry->functionName.c_str(), entry->functionName.length() + 1);
+	hash = Utils::HashFNV1a(&entry->asFunction.retType, sizeof(entry->asFunction.retType), hash);
+	hash = Utils::HashFNV1a(&entry->asFunction.isExtern, sizeof(entry->asFunction.isExtern), hash);
+
+	return hash;
+}
+
+Watch::IncrementalCompiler::~IncrementalCompiler()
+{
+	for (ParsedEntry& entry : entries)
+	{
+		delete entry.root;
+	}
+}
+
+Watch::IncrementalCompiler::ParsedEntry Watch::IncrementalCompiler::ParseEntry(const char* text, const ui64 size, const ui32 firstLine, const ui64 textHash)
+{
+	// Parse against an empty disaster handle, so that if the parse is aborted, exactly the nodes it made can be freed,
+	// without touching the entries that are still in use.
+	std::unordered_set<AST::Node*> otherNodes;
+	otherNodes.swap(AST::g_disasterHandle);
+
+	yy::Lexer lexer(reflex::Input(text, size));
+	yy::parser parser(lexer);
+	yy::OffsetTokenSource offsetTokenSource(lexer, firstLine - 1);
+	yy::g_tokenSource = &offsetTokenSource;
+
+	try
+	{
+		parser.parse();
+	}
+	catch (const CompilationAborted&)
+	{
+		yy::g_tokenSource = nullptr;
+		g_nodeHead = nullptr;
+		AST::FreeAllNodes();
+		AST::g_disasterHandle.swap(otherNodes);
+		throw;
+	}
+
+	yy::g_tokenSource = nullptr;
+	otherNodes.insert(AST::g_disasterHandle.begin(), AST::g_disasterHandle.end());
+	AST::g_disasterHandle.swap(otherNodes);
+
+	ParsedEntry entry;
+	entry.textHash = textHash;
+	entry.root = g_nodeHead;
+	g_nodeHead = nullptr;
+
+	for (AST::Node* globalEntry : entry.root->GetChildren())
+	{
+		if (globalEntry->GetNodeKind() != Node_k::FunctionNode)
+		{
+			continue;
+		}
+
+		entry.subtreeHashes.push_back(AST::HashSubtree(globalEntry));
+
+		std::vector<std::wstring> callees;
+		for (AST::Node* callNode : AST::GetAllChildNodesOfType(globalEntry, Node_k::FunctionCallNode))
+		{
+			callees.push_back(((AST::FunctionCallNode*)callNode)->GetName());
+		}
+		entry.callees.push_back(std::move(callees));
+	}
+
+	return entry;
+}
+
+void Watch::IncrementalCompiler::Recompile(const char* sourcePath, const char* outputPath)
+{
+	const auto buildStart = std::chrono::steady_clock::now();
+
+	std::string source;
+	FILE* sourceFile = fopen(sourcePath, "rb");
+	if (sourceFile == nullptr)
+	{
+		wprintf(L"ERROR: Unable to open source file.\n");
+		Exit(ErrCodes::malformed_cmd_line);
+	}
+
+	char buffer[1 << 16];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), sourceFile)) > 0)
+	{
+		source.append(buffer, read);
+	}
+	fclose(sourceFile);
+
+	const ui64 sourceHash = Utils::HashFNV1a(source.data(), source.size());
+	if (sourceHash == lastSourceHash)
+	{
+		return;
+	}
+	lastSourceHash = sourceHash;
+
+	const ui64 reparsedCount = UpdateEntries(source);
+
+	BuildResult result;
+	AnalyseEntries(true, result);
+
+	std::string header, footer;
+	GenerateCodeHeader(result.externFunctions, header);
+	GenerateCodeFooter(footer);
+
+	FILE* outFile = fopen(outputPath, "w");
+	if (outFile == nullptr)
+	{
+		wprintf(L"ERROR: Unable to open output file.\n");
+		Exit(ErrCodes::malformed_cmd_line);
+	}
+
+	fwrite(header.c_str(), sizeof(header[0]), header.length(), outFile);
+	for (const std::string* code : result.functionsCode)
+	{
+		fwrite(code->c_str(), sizeof((*code)[0]), code->length(), outFile);
+	}
+	fwrite(footer.c_str(), sizeof(footer[0]), footer.length(), outFile);
+	fclose(outFile);
+
+	const auto buildEnd = std::chrono::steady_clock::now();
+	wprintf(L"WATCH: Rebuilt in %.2f ms. Reparsed %llu of %llu global entries, regenerated %llu of %llu functions(%llu for changed callees).\n",
+		std::chrono::duration<double, std::milli>(buildEnd - buildStart).count(), reparsedCount, (ui64)entries.size(),
+		result.updatedCount, result.functionCount, result.updatedForCalleesCount);
+}
+
+ui64 Watch::IncrementalCompiler::Analyse(const std::string& source)
+{
+	const ui64 reparsedCount = UpdateEntries(source);
+
+	BuildResult result;
+	AnalyseEntries(false, result);
+	return reparsedCount;
+}
+
+ui64 Watch::IncrementalCompiler::UpdateEntries(const std::string& source)
+{
+	// Parse the entries whose text is new, and take the rest over from the previous build.
+	std::vector<SourceChunk> chunks;
+	SplitGlobalEntries(source, chunks);
+
+	std::unordered_multimap<ui64, ui64> previousEntries;
+	for (ui64 i = 0; i < entries.size(); i++)
+	{
+		previousEntries.emplace(entries[i].textHash, i);
+	}
+
+	std::vector<ParsedEntry> newEntries;
+	std::vector<bool> reusedPreviousEntry(entries.size(), false);
+	std::vector<bool> isNewlyParsed;
+	ui64 reparsedCount = 0;
+
+	try
+	{
+		for (const SourceChunk& chunk : chunks)
+		{
+			const ui64 textHash = Utils::HashFNV1a(chunk.begin, chunk.size);
+
+			auto previous = previousEntries.find(textHash);
+			if (previous != previousEntries.end())
+			{
+				reusedPreviousEntry[previous->second] = true;
+				newEntries.push_back(entries[previous->second]);
+				isNewlyParsed.push_back(false);
+				previousEntries.erase(previous);
+				continue;
+			}
+
+			failedRange = { (ui64)(chunk.begin - source.c_str()), (ui64)(chunk.begin - source.c_str()) + chunk.size };
+			newEntries.push_back(ParseEntry(chunk.begin, chunk.size, chunk.firstLine, textHash));
+			isNewlyParsed.push_back(true);
+			reparsedCount++;
+		}
+	}
+	catch (const CompilationAborted&)
+	{
+		// Keep the previous build's entries, so the next build can still reuse them.
+		for (ui64 i = 0; i < newEntries.size(); i++)
+		{
+			if (isNewlyParsed[i])
+			{
+				delete newEntries[i].root;
+			}
+		}
+		throw;
+	}
+
+	for (ui64 i = 0; i < entries.size(); i++)
+	{
+		if (!reusedPreviousEntry[i])
+		{
+			delete entries[i].root;
+		}
+	}
+	entries = std::move(newEntries);
+
+	entryRanges.clear();
+	for (const SourceChunk& chunk : chunks)
+	{
+		entryRanges.push_back({ (ui64)(chunk.begin - source.c_str()), (ui64)(chunk.begin - source.c_str()) + chunk.size });
+	}
+
+	return reparsedCount;
+}
+
+void Watch::IncrementalCompiler::AnalyseEntries(const bool generateCode, BuildResult& outResult)
+{
+	// The symbol table is built up from scratch, in source order, so every reference is resolved against the current declarations.
+	// A function's body is only analysed if it is out of date, for the rest declaring the function itself is enough:
+	// their locals are never looked at, and whatever their analysis depends on from outside, the declarations of their callees,
+	// is part of what decides whether they are out of date. A callee that is gone, or now declared after its caller, has no
+	// declaration yet when the caller is reached, so the caller is analysed again and runs into the same error as a full compile would.
+	g_symTable.Clear();
+	LoadImportedInterfaces(outResult.externFunctions);
+
+	std::unordered_set<std::wstring> seenFunctions;
+
+	for (ui64 entryIndex = 0; entryIndex < entries.size(); entryIndex++)
+	{
+		const ParsedEntry& entry = entries[entryIndex];
+		failedRange = entryRanges[entryIndex];
+
+		ui64 functionIndex = 0;
+		for (AST::Node* globalEntry : entry.root->GetChildren())
+		{
+			if (globalEntry->GetNodeKind() != Node_k::FunctionNode)
+			{
+				AST::AnalyseGlobalEntry(globalEntry);
+				AST::FoldConstants(globalEntry);
+				AST::PropagateConstants(globalEntry);
+
+				if (globalEntry->GetNodeKind() == Node_k::ExternFwdDeclNode)
+				{
+					AST::FwdDeclNode* fwdDeclNode = (AST::FwdDeclNode*)((AST::ExternFwdDeclNode*)globalEntry)->GetFwdDeclNode();
+					outResult.externFunctions.push_back(fwdDeclNode->GetSymTabEntry()->functionName);
+				}
+				continue;
+			}
+
+			AST::FunctionNode* functionNode = (AST::FunctionNode*)globalEntry;
+			AST::HarvestNode(functionNode);
+			AST::LeaveHarvestedNode(functionNode);
+
+			const ui64 subtreeHash = entry.subtreeHashes[functionIndex];
+			const ui64 signatureHash = HashSignature(functionNode->GetSymTabEntry());
+
+			std::vector<ui64> calleeSignatureHashes;
+			for (const std::wstring& callee : entry.callees[functionIndex])
+			{
+				calleeSignatureHashes.push_back(HashSignature(g_symTable.RetrieveSymbol(g_symTable.ComposeGlobalKey(callee))));
+			}
+			functionIndex++;
+
+			outResult.functionCount++;
+			seenFunctions.insert(functionNode->GetName());
+
+			FunctionState& state = functionStates[functionNode->GetName()];
+			const bool isBodyUnchanged = state.isUpToDate && state.subtreeHash == subtreeHash && state.signatureHash == signatureHash;
+			if (!isBodyUnchanged || state.calleeSignatureHashes != calleeSignatureHashes)
+			{
+				// Only marked up to date again once it has made it all the way through, so a function that failed is retried next time.
+				state.isUpToDate = false;
+
+				// Declaring the function again here finds the entry made above, as it would for a forward declared function.
+				AST::AnalyseGlobalEntry(functionNode);
+				AST::FoldConstants(functionNode);
+				AST::PropagateConstants(functionNode);
+
+				outResult.updatedCount++;
+				outResult.updatedForCalleesCount += isBodyUnchanged ? 1 : 0;
+
+				state.subtreeHash = subtreeHash;
+				state.signatureHash = signatureHash;
+				state.calleeSignatureHashes = std::move(calleeSignatureHashes);
+				state.code.clear();
+				if (generateCode)
+				{
+					GenerateFunctionCode(functionNode, state.code);
+				}
+				state.isUpToDate = true;
+			}
+
+			outResult.functionsCode.push_back(&state.code);
+		}
+	}
+
+	// Forget the functions that are gone.
+	for (auto function = functionStates.begin(); function != functionStates.end();)
+	{
+		function = seenFunctions.contains(function->first) ? std::next(function) : functionStates.erase(function);
+	}
+}
+
+i32 Watch::RunWatchMode(const char* sourcePath, const char* outputPath)
+{
+	FileWatcher watcher;
+	if (!watcher.Open(sourcePath))
+	{
+		wprintf(L"ERROR: Unable to watch the source file.\n");
+		return (i32)ErrCodes::malformed_cmd_line;
+	}
+
+	// A broken edit must only fail the build, not end the watch.
+	g_exitThrows = true;
+
+	IncrementalCompiler compiler;
+	do
+	{
+		try
+		{
+			compiler.Recompile(sourcePath, outputPath);
+		}
+		catch (const CompilationAborted&)
+		{
+			// Exit() has printed the reason already. Whatever was half done for this build is thrown away.
+			g_symTable.Clear();
+			ResetCodegenState();
+			wprintf(L"WATCH: Build failed, the previous output was kept. Waiting for the next change.\n");
+		}
+	} while (watcher.WaitForChange());
+
+	wprintf(L"ERROR: Watching the source file failed.\n");
+	return (i32)ErrCodes::malformed_cmd_line;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../Definitions.h"
+
+namespace AST
+{
+	class Node;
+}
+
+/*
+	Function-granular incremental recompilation, for watch mode.
+
+	The source is cut into its global entries(functions and forward declarations) by scanning for the '}' or '.' that ends each
+	of them at the top level, and only the entries whose text has changed since the last build are parsed again.
+	The symbol table is then built up again in source order, but only the functions that are generated again have their bodies
+	analysed, which keeps all diagnostics exactly as in a full compile.
+
+	Code is only generated(and the body only analysed) again for a function if it would come out differently:
+	- Its AST has changed, judged by a hash of the whole subtree, so edits to comments and whitespace don't count.
+	- Its own declaration has changed.
+	- The declaration of a function it calls has changed. The callees of every function, taken from its FunctionCallNodes,
+	  make up the dependency graph that carries a changed declaration over to its callers.
+	Everything else is spliced in from the previous build.
+*/
+namespace Watch
+{
+	class IncrementalCompiler
+	{
+	public:
+
+		IncrementalCompiler() = default;
+		~IncrementalCompiler();
+
+		// A part of the source, as byte offsets.
+		struct SourceRange
+		{
+			ui64 begin;
+			ui64 end;
+		};
+
+		// Brings outputPath up to date with sourcePath. Does nothing if the source hasn't changed since the last call.
+		// Errors go through Exit(), so g_exitThrows must be set for the compiler to survive them.
+		void Recompile(const char* sourcePath, const char* outputPath);
+
+		// Brings the analysis up to date with source, without generating any code. For the language server, which is only after
+		// the diagnostics. A compiler is meant to be used either for this, or for Recompile(), never both.
+		// Returns how many global entries had to be parsed again.
+		ui64 Analyse(const std::string& source);
+
+		// After an error, the global entry that was being parsed or analysed when it was raised.
+		inline SourceRange GetFailedRange(void) const { return failedRange; }
+
+	private:
+
+		// A global entry's text, and what was parsed from it.
+		struct ParsedEntry
+		{
+			ui64 textHash;
+
+			// The program node the entry was parsed into, which owns it.
+			AST::Node* root;
+
+			// For each function in the entry(normally one): its subtree hash, and the names of the functions it calls.
+			std::vector<ui64> subtreeHashes;
+			std::vector<std::vector<std::wstring>> callees;
+		};
+
+		// What a function was last analysed(and generated) from.
+		struct FunctionState
+		{
+			ui64 subtreeHash = 0;
+			ui64 signatureHash = 0;
+			std::vector<ui64> calleeSignatureHashes;
+			bool isUpToDate = false;
+			std::string code;
+		};
+
+		struct BuildResult
+		{
+			std::vector<std::string> externFunctions;
+			std::vector<const std::string*> functionsCode;
+			ui64 functionCount = 0;
+			ui64 updatedCount = 0;
+			ui64 updatedForCalleesCount = 0;
+		};
+
+		static ParsedEntry ParseEntry(const char* text, const ui64 size, const ui32 firstLine, const ui64 textHash);
+
+		// Splits the source into its global entries and parses the ones that are new. Returns how many were parsed.
+		ui64 UpdateEntries(const std::string& source);
+
+		// Analyses the entries in source order, and generates code for the functions that are out of date if generateCode is set.
+		void AnalyseEntries(const bool generateCode, BuildResult& outResult);
+
+		// In source order, along with where each of them lies in the source.
+		std::vector<ParsedEntry> entries;
+		std::vector<SourceRange> entryRanges;
+
+		// By function name.
+		std::unordered_map<std::wstring, FunctionState> functionStates;
+
+		ui64 lastSourceHash = 0;
+		SourceRange failedRange = {};
+	};
+
+	// Compiles sourcePath, then recompiles it whenever it changes. Returns only if watching the file fails.
+	i32 RunWatchMode(const char* sourcePath, const char* outputPath);
+}
\ No newline at end of file
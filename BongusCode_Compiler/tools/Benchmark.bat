@@ -0,0 +1,54 @@
+@echo off
+setlocal
+
+rem End to end throughput benchmark of the compiler.
+rem Generates programs of 1 KB up to maxSize with ProgramGenerator, and compiles each of them with --time-report and
+rem --mem-report, leaving a report per size in the output directory. The sizes grow 4x a step, so anything that scales
+rem quadratically shows up as its phase taking 16x longer a step instead of 4x.
+rem
+rem USAGE: Benchmark.bat "compilerPath" "generatorPath" "outputDirectory" [maxSize] [generator options]
+rem   maxSize is one of the sizes below, 64M by default. The generator options shape the programs, see ProgramGenerator.cpp.
+rem   E.g. Benchmark.bat BongusCodeCompiler.exe ProgramGenerator.exe bench 1G --statements=200 --unicode-ratio=0.2
+
+set COMPILER=%~1
+set GENERATOR=%~2
+set OUTDIR=%~3
+set MAXSIZE=%~4
+if "%OUTDIR%"=="" (
+	echo USAGE: Benchmark.bat "compilerPath" "generatorPath" "outputDirectory" [maxSize] [generator options]
+	exit /b 1
+)
+if "%MAXSIZE%"=="" set MAXSIZE=64M
+
+set GENERATOR_OPTIONS=
+:collectOptions
+if "%~5"=="" goto optionsCollected
+set GENERATOR_OPTIONS=%GENERATOR_OPTIONS% %5
+shift /5
+goto collectOptions
+:optionsCollected
+
+if not exist "%OUTDIR%" mkdir "%OUTDIR%"
+
+for %%S in (1K 4K 16K 64K 256K 1M 4M 16M 64M 256M 1G) do (
+	echo Benchmarking %%S...
+
+	"%GENERATOR%" "%OUTDIR%\bench_%%S.bcl" --size=%%S %GENERATOR_OPTIONS%
+	if errorlevel 1 exit /b 1
+
+	rem The compiler writes UTF-16 to a redirected stdout, so each report gets a file of its own.
+	"%COMPILER%" "%OUTDIR%\bench_%%S.bcl" "%OUTDIR%\bench_%%S.asm" --time-report --mem-report > "%OUTDIR%\report_%%S.txt"
+	if errorlevel 1 (
+		echo Compiling the %%S program failed, see %OUTDIR%\report_%%S.txt.
+		exit /b 1
+	)
+
+	rem The larger programs take up gigabytes between them, so they are only kept until they've been compiled.
+	del "%OUTDIR%\bench_%%S.bcl" "%OUTDIR%\bench_%%S.asm"
+
+	if "%%S"=="%MAXSIZE%" goto done
+)
+
+:done
+echo Reports written to %OUTDIR%\report_*.txt.
+endlocal
\ No newline at end of file
@@ -0,0 +1,45 @@
+@echo off
+setlocal
+
+rem Codegen regression check.
+rem Compiles every example with --cost-report against the baseline checked in next to it(Examples\name.cost), and fails
+rem if any function or loop in any of them got more expensive. A missing baseline fails too, as the compiler would
+rem silently write a new one instead of checking anything.
+rem When a change makes the code cheaper, delete the affected baselines, run this again to write new ones and check them in,
+rem so the improvement is held on to as well.
+rem
+rem USAGE: CostCheck.bat "compilerPath" "examplesDirectory" "outputDirectory"
+rem   E.g. CostCheck.bat BongusCodeCompiler.exe ..\..\Examples cost
+
+set COMPILER=%~1
+set EXAMPLES=%~2
+set OUTDIR=%~3
+if "%OUTDIR%"=="" (
+	echo USAGE: CostCheck.bat "compilerPath" "examplesDirectory" "outputDirectory"
+	exit /b 1
+)
+
+if not exist "%OUTDIR%" mkdir "%OUTDIR%"
+
+set FAILED=0
+
+for %%F in ("%EXAMPLES%\*.bcl") do (
+	if not exist "%%~dpnF.cost" (
+		echo %%~nF has no cost baseline, write one with --cost-report="%%~dpnF.cost" and check it in.
+		set FAILED=1
+	) else (
+		rem The compiler writes UTF-16 to a redirected stdout, so each report gets a file of its own.
+		"%COMPILER%" "%%F" "%OUTDIR%\%%~nF.asm" --cost-report="%%~dpnF.cost" > "%OUTDIR%\cost_%%~nF.txt"
+		if errorlevel 1 (
+			echo %%~nF failed to compile or costs more than its baseline, see %OUTDIR%\cost_%%~nF.txt.
+			set FAILED=1
+		) else (
+			echo %%~nF: nothing costs more than its baseline.
+		)
+	)
+)
+
+if "%FAILED%"=="1" exit /b 1
+
+echo Every example is within its baseline.
+endlocal
\ No newline at end of file
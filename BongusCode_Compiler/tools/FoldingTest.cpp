@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/Definitions.h"
+#include "../src/AST/ASTNode.h"
+#include "../src/AST/ASTAPI.h"
+#include "../src/AST/AST_Folding_Pass.h"
+
+/*
+	Checks that constant folding(see AST/AST_Folding_Pass.h) never changes what an expression computes. Built from this file and
+	every source file of the compiler except main.cpp, like Microbenchmarks.cpp.
+
+	USAGE: FoldingTest.exe [--seed=N] [--count=N]
+		--seed=N              Seeds the random expressions, 1 by default.
+		--count=N             How many random expressions to check, 1000000 by default.
+
+	Every expression is evaluated the way the generated code evaluates it, before and after folding it. The regressions below
+	come first, then the random expressions over locals of every width. Each one whose result changed is printed, and the exit
+	code is 1 if there were any.
+*/
+
+struct Local
+{
+	SymTabEntry entry;
+	ui64 value;
+};
+
+static ui64 GetTypeMask(const PrimitiveType type)
+{
+	switch (type)
+	{
+		case PrimitiveType::ui32:
+		case PrimitiveType::i32: return 0xFFFFFFFFull;
+		case PrimitiveType::ui16:
+		case PrimitiveType::i16: return 0xFFFFull;
+		default: return ~0ull;
+	}
+}
+
+static Local MakeLocal(const wchar_t* name, const PrimitiveType type, const ui64 value)
+{
+	Local local = {};
+	local.entry.name = name;
+	local.entry.isFunction = false;
+	local.entry.asVar.type = type;
+	local.entry.asVar.pointeeType = PrimitiveType::invalid;
+
+	// Locals are loaded zero extended, whatever their signedness.
+	local.value = value & GetTypeMask(type);
+	return local;
+}
+
+static AST::Node* Sym(Local& local)
+{
+	AST::SymNode* node = (AST::SymNode*)AST::MakeSymNode(new std::wstring(local.entry.name));
+	node->SetSymTabEntry(&local.entry);
+	return node;
+}
+
+static AST::Node* Lit(const ui64 value)
+{
+	return AST::MakeIntNode((i64)value);
+}
+
+static AST::Node* Op(const Op_k op, AST::Node* lhs, AST::Node* rhs)
+{
+	return AST::MakeOpNode(op, lhs, rhs);
+}
+
+// Evaluates n the way the code generator's output does: 64 bits wide, with every operation used as an operand truncated
+// to its type, see TruncateOperand() in codegen.cpp. Returns false for a division by 0, which is left for the program.
+static bool Evaluate(AST::Node* n, const std::vector<Local*>& locals, ui64& outValue)
+{
+	switch (n->GetNodeKind())
+	{
+		case Node_k::IntNode:
+		{
+			outValue = ((AST::IntNode*)n)->Get();
+			return true;
+		}
+		case Node_k::SymNode:
+		{
+			for (const Local* local : locals)
+			{
+				if (&local->entry == ((AST::SymNode*)n)->GetSymTabEntry())
+				{
+					outValue = local->value;
+					return true;
+				}
+			}
+			return false;
+		}
+		case Node_k::OpNode:
+		{
+			AST::OpNode* asOpNode = (AST::OpNode*)n;
+			ui64 lhs = 0;
+			ui64 rhs = 0;
+			if (!Evaluate(asOpNode->GetLHS(), locals, lhs) || !Evaluate(asOpNode->GetRHS(), locals, rhs))
+			{
+				return false;
+			}
+			if (asOpNode->GetLHS()->GetNodeKind() == Node_k::OpNode)
+			{
+				lhs &= GetTypeMask(AST::GetExpressionType(asOpNode->GetLHS()));
+			}
+			if (asOpNode->GetRHS()->GetNodeKind() == Node_k::OpNode)
+			{
+				rhs &= GetTypeMask(AST::GetExpressionType(asOpNode->GetRHS()));
+			}
+
+			switch (asOpNode->GetOp())
+			{
+				case Op_k::ADD: outValue = lhs + rhs; return true;
+				case Op_k::SUB: outValue = lhs - rhs; return true;
+				case Op_k::MUL: outValue = lhs * rhs; return true;
+				case Op_k::DIV: if (rhs == 0) { return false; } outValue = lhs / rhs; return true;
+				case Op_k::SHL: outValue = lhs << (rhs & 63); return true;
+				case Op_k::SHR: outValue = lhs >> (rhs & 63); return true;
+				case Op_k::AND: outValue = lhs & rhs; return true;
+				case Op_k::OR: outValue = lhs | rhs; return true;
+				default: return false;
+			}
+		}
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+static ui64 CountOpNodes(AST::Node* n)
+{
+	if (n->GetNodeKind() != Node_k::OpNode)
+	{
+		return 0;
+	}
+	return 1 + CountOpNodes(((AST::OpNode*)n)->GetLHS()) + CountOpNodes(((AST::OpNode*)n)->GetRHS());
+}
+
+// Folds expression and compares its result with the unfolded one's. Takes ownership of the expression.
+// maxOpNodesAfter, if not -1, also checks the folding went as far as it should have.
+static bool Check(const char* description, AST::Node* expression, const std::vector<Local*>& locals, const i64 maxOpNodesAfter = -1)
+{
+	ui64 before = 0;
+	const bool isDefined = Evaluate(expression, locals, before);
+
+	AST::Node* folded = AST::FoldExpression(expression);
+
+	ui64 after = 0;
+	bool isPassing = !isDefined || (Evaluate(folded, locals, after) && after == before);
+	if (!isPassing)
+	{
+		printf("FAIL: %s is %llu before folding, %llu after.\n", description, before, after);
+	}
+
+	const ui64 opNodesAfter = CountOpNodes(folded);
+	if (maxOpNodesAfter != -1 && opNodesAfter > (ui64)maxOpNodesAfter)
+	{
+		printf("FAIL: %s has %llu operations left after folding, expected at most %lld.\n", description, opNodesAfter, maxOpNodesAfter);
+		isPassing = false;
+	}
+
+	delete folded;
+	return isPassing;
+}
+
+static ui64 CheckRegressions(void)
+{
+	Local x = MakeLocal(L"x", PrimitiveType::ui32, 4294967295);
+	Local h = MakeLocal(L"h", PrimitiveType::ui16, 65535);
+	Local w = MakeLocal(L"w", PrimitiveType::i64, 0xFFFFFFFFFFFFFFFFull);
+	Local z = MakeLocal(L"z", PrimitiveType::i64, 0);
+	const std::vector<Local*> locals = { &x, &h, &w, &z };
+
+	ui64 failures = 0;
+
+	// Narrow chains truncate after every step, so nothing in them may move.
+	failures += !Check("ui32 x + 1 - z", Op(Op_k::SUB, Op(Op_k::ADD, Sym(x), Lit(1)), Sym(z)), locals);
+	failures += !Check("ui32 x + 1 + 0", Op(Op_k::ADD, Op(Op_k::ADD, Sym(x), Lit(1)), Lit(0)), locals);
+	failures += !Check("ui32 x * 2 * 3", Op(Op_k::MUL, Op(Op_k::MUL, Sym(x), Lit(2)), Lit(3)), locals);
+	failures += !Check("ui16 h + 1 - 1", Op(Op_k::SUB, Op(Op_k::ADD, Sym(h), Lit(1)), Lit(1)), locals);
+	failures += !Check("ui32 x + 1 - z + 2", Op(Op_k::ADD, Op(Op_k::SUB, Op(Op_k::ADD, Sym(x), Lit(1)), Sym(z)), Lit(2)), locals);
+
+	// 64 bit chains still have their constants gathered and combined.
+	failures += !Check("i64 w + 1 - z + 2", Op(Op_k::ADD, Op(Op_k::SUB, Op(Op_k::ADD, Sym(w), Lit(1)), Sym(z)), Lit(2)), locals, 2);
+	failures += !Check("i64 w * 2 * 3", Op(Op_k::MUL, Op(Op_k::MUL, Sym(w), Lit(2)), Lit(3)), locals, 1);
+	failures += !Check("i64 w + 1 - 1", Op(Op_k::SUB, Op(Op_k::ADD, Sym(w), Lit(1)), Lit(1)), locals, 0);
+
+	return failures;
+}
+
+class RandomExpressions
+{
+public:
+
+	RandomExpressions(const ui64 seed) : random(seed) {}
+
+	AST::Node* Make(std::vector<Local>& locals, const ui32 depth)
+	{
+		if (depth == 0 || Pick(4) == 0)
+		{
+			if (Pick(2) == 0)
+			{
+				return Sym(locals[Pick((ui32)locals.size())]);
+			}
+			return Lit(MakeValue());
+		}
+
+		// Mostly the operators that chain, so there are chains to rearrange.
+		static const Op_k s_ops[] = { Op_k::ADD, Op_k::SUB, Op_k::MUL, Op_k::AND, Op_k::OR, Op_k::ADD, Op_k::SUB, Op_k::MUL, Op_k::DIV, Op_k::SHL, Op_k::SHR };
+		const Op_k op = s_ops[Pick(sizeof(s_ops) / sizeof(s_ops[0]))];
+		AST::Node* lhs = Make(locals, depth - 1);
+		return Op(op, lhs, Make(locals, Pick(2) == 0 ? 0 : depth - 1));
+	}
+
+	ui64 MakeValue(void)
+	{
+		static const ui64 s_edgeValues[] = { 0, 1, 2, 3, 31, 32, 63, 64, 255, 65535, 65536, 4294967295ull, 4294967296ull, 0x7FFFFFFFFFFFFFFFull, 0x8000000000000000ull, ~0ull };
+		switch (Pick(3))
+		{
+			case 0: return s_edgeValues[Pick(sizeof(s_edgeValues) / sizeof(s_edgeValues[0]))];
+			case 1: return Pick(16);
+			default: return random();
+		}
+	}
+
+	ui32 Pick(const ui32 count)
+	{
+		return (ui32)(random() % count);
+	}
+
+private:
+
+	std::mt19937_64 random;
+};
+
+static ui64 CheckRandomExpressions(const ui64 seed, const ui64 count)
+{
+	static const PrimitiveType s_types[] = { PrimitiveType::i64, PrimitiveType::ui64, PrimitiveType::i32, PrimitiveType::ui32, PrimitiveType::i16, PrimitiveType::ui16 };
+	RandomExpressions expressions(seed);
+	ui64 failures = 0;
+
+	for (ui64 i = 0; i < count; i++)
+	{
+		std::vector<Local> locals;
+		for (ui32 j = 0; j < 4; j++)
+		{
+			locals.push_back(MakeLocal((L"l" + std::to_wstring(j)).c_str(), s_types[expressions.Pick(sizeof(s_types) / sizeof(s_types[0]))], expressions.MakeValue()));
+		}
+		std::vector<Local*> localPointers;
+		for (Local& local : locals)
+		{
+			localPointers.push_back(&local);
+		}
+
+		const std::string description = "random expression " + std::to_string(i) + " of seed " + std::to_string(seed);
+		if (!Check(description.c_str(), expressions.Make(locals, 4), localPointers))
+		{
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+static void PrintUsage(void)
+{
+	printf("USAGE: FoldingTest.exe [--seed=N] [--count=N]\n");
+}
+
+int main(int argc, char** argv)
+{
+	ui64 seed = 1;
+	ui64 count = 1000000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		if (strncmp(option, "--seed=", strlen("--seed=")) == 0)
+		{
+			seed = strtoull(option + strlen("--seed="), nullptr, 10);
+		}
+		else if (strncmp(option, "--count=", strlen("--count=")) == 0)
+		{
+			count = strtoull(option + strlen("--count="), nullptr, 10);
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	const ui64 failures = CheckRegressions() + CheckRandomExpressions(seed, count);
+	if (failures != 0)
+	{
+		printf("%llu expressions changed their result when folded.\n", failures);
+		return 1;
+	}
+
+	printf("Folding kept the result of every expression.\n");
+	return 0;
+}
\ No newline at end of file
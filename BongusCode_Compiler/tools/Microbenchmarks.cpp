@@ -0,0 +1,396 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../src/Definitions.h"
+#include "../src/CStrLib.h"
+#include "../src/AST/ASTNode.h"
+#include "../src/AST/ASTAPI.h"
+#include "../src/symbol_table/symtable.h"
+#include "../src/lexer/lexer.h"
+
+/*
+	Microbenchmarks of the compiler's front end data structures, to pin a regression the end to end benchmark shows down to the
+	code that caused it. Built from this file and every source file of the compiler except main.cpp.
+
+	USAGE: Microbenchmarks.exe [--filter=TEXT] [--sizes=N,N,...] [--min-time=MS] [--list]
+		--filter=TEXT         Only runs the benchmarks whose name contains TEXT.
+		--sizes=N,N,...       Runs every benchmark at these sizes instead of its own.
+		--min-time=MS         How long to keep repeating each benchmark at each size, 200 ms by default.
+		--list                Prints the benchmarks and what their size means, and exits.
+
+	The results go to stdout as CSV, one row per benchmark and size, under a header row:
+		benchmark,size,repetitions,operations,ns_per_operation,best_ns_per_operation
+	ns_per_operation is the mean over all the repetitions, best_ns_per_operation that of the fastest one. The rows come out in
+	the same order every time, and the columns only ever get added to at the end, so the output can be diffed and tracked.
+*/
+
+// Times only the part of a repetition the benchmark wants timed, leaving its setup and teardown out.
+class Timer
+{
+public:
+
+	inline void Start(void) { start = std::chrono::steady_clock::now(); }
+	inline void Stop(void) { nanoseconds += (ui64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(); }
+	inline ui64 GetNanoseconds(void) const { return nanoseconds; }
+
+private:
+
+	std::chrono::steady_clock::time_point start;
+	ui64 nanoseconds = 0;
+};
+
+// Runs one repetition at the given size, and returns how many operations it timed.
+typedef ui64(*BenchmarkFunction)(const ui64 size, Timer& timer);
+
+struct Benchmark
+{
+	const char* name;
+	const char* sizeMeaning;
+	BenchmarkFunction function;
+	std::vector<ui64> sizes;
+};
+
+// Keeps results the compiler could otherwise optimize away alive.
+static volatile ui64 s_sink = 0;
+
+static std::vector<std::wstring> MakeNames(const ui64 count)
+{
+	std::vector<std::wstring> names;
+	names.reserve(count);
+	for (ui64 i = 0; i < count; i++)
+	{
+		names.push_back(L"local" + std::to_wstring(i));
+	}
+	return names;
+}
+
+static ui64 BenchmarkEnterSymbol(const ui64 size, Timer& timer)
+{
+	const std::vector<std::wstring> names = MakeNames(size);
+	g_symTable.OpenFunction(L"Benchmark");
+
+	timer.Start();
+	for (const std::wstring& name : names)
+	{
+		g_symTable.EnterSymbol(name, PrimitiveType::i64, PrimitiveType::invalid, 8, false, false);
+	}
+	timer.Stop();
+
+	g_symTable.Clear();
+	return size;
+}
+
+static ui64 BenchmarkRetrieveSymbol(const ui64 size, Timer& timer)
+{
+	const std::vector<std::wstring> names = MakeNames(size);
+	std::vector<std::wstring> keys;
+	g_symTable.OpenFunction(L"Benchmark");
+	for (const std::wstring& name : names)
+	{
+		g_symTable.EnterSymbol(name, PrimitiveType::i64, PrimitiveType::invalid, 8, false, false);
+		keys.push_back(g_symTable.ComposeKey(name));
+	}
+
+	timer.Start();
+	for (const std::wstring& key : keys)
+	{
+		s_sink += (ui64)g_symTable.RetrieveSymbol(key);
+	}
+	timer.Stop();
+
+	g_symTable.Clear();
+	return size;
+}
+
+static ui64 BenchmarkComposeKey(const ui64 size, Timer& timer)
+{
+	const std::vector<std::wstring> names = MakeNames(size);
+	g_symTable.OpenFunction(L"Benchmark");
+
+	timer.Start();
+	for (const std::wstring& name : names)
+	{
+		s_sink += g_symTable.ComposeKey(name).size();
+	}
+	timer.Stop();
+
+	g_symTable.Clear();
+	return size;
+}
+
+static ui64 BenchmarkMangle(const std::wstring& name, Timer& timer)
+{
+	constexpr ui64 callCount = 1000;
+
+	timer.Start();
+	for (ui64 i = 0; i < callCount; i++)
+	{
+		s_sink += MangleFunctionName(name.c_str()).size();
+	}
+	timer.Stop();
+
+	return callCount;
+}
+
+static ui64 BenchmarkMangleAscii(const ui64 size, Timer& timer)
+{
+	return BenchmarkMangle(std::wstring(size, L'a'), timer);
+}
+
+static ui64 BenchmarkMangleUnicode(const ui64 size, Timer& timer)
+{
+	// Every other character expands to its hex value.
+	std::wstring name;
+	for (ui64 i = 0; i < size; i++)
+	{
+		name += i % 2 == 0 ? L'\x3BE' : L'a';
+	}
+	return BenchmarkMangle(name, timer);
+}
+
+static std::vector<AST::Node*> MakeNodes(const ui64 count)
+{
+	std::vector<AST::Node*> nodes;
+	nodes.reserve(count);
+	for (ui64 i = 0; i < count; i++)
+	{
+		nodes.push_back(AST::MakeIntNode((i64)i));
+	}
+	return nodes;
+}
+
+// Links the nodes into a list by always appending to the last one, which doesn't have to walk the list.
+static AST::Node* MakeList(const ui64 count)
+{
+	const std::vector<AST::Node*> nodes = MakeNodes(count);
+	AST::Node* last = nodes[0];
+	for (ui64 i = 1; i < count; i++)
+	{
+		last = last->MakeSiblings(nodes[i]);
+	}
+	return nodes[0];
+}
+
+// The way the parser builds statement and entry lists, appending to the head of the list every time.
+static ui64 BenchmarkMakeSiblings(const ui64 size, Timer& timer)
+{
+	const std::vector<AST::Node*> nodes = MakeNodes(size);
+
+	timer.Start();
+	for (ui64 i = 1; i < size; i++)
+	{
+		nodes[0]->MakeSiblings(nodes[i]);
+	}
+	timer.Stop();
+
+	delete nodes[0];
+	return size;
+}
+
+static ui64 BenchmarkAdoptChildren(const ui64 size, Timer& timer)
+{
+	AST::Node* parent = AST::MakeNullNode();
+	AST::Node* children = MakeList(size);
+
+	timer.Start();
+	parent->AdoptChildren(children);
+	timer.Stop();
+
+	delete parent;
+	return size;
+}
+
+static ui64 BenchmarkGetChildren(const ui64 size, Timer& timer)
+{
+	AST::Node* parent = AST::MakeNullNode();
+	parent->AdoptChildren(MakeList(size));
+
+	// Enough calls that the small sizes still take long enough to time.
+	const ui64 callCount = std::max((ui64)1, 100000 / size);
+
+	timer.Start();
+	for (ui64 i = 0; i < callCount; i++)
+	{
+		s_sink += parent->GetChildren().size();
+	}
+	timer.Stop();
+
+	delete parent;
+	return callCount * size;
+}
+
+// A tree of count nodes, each with up to 8 children, so it stays shallow and wide like a real AST.
+static AST::Node* MakeTree(const ui64 count)
+{
+	std::vector<AST::Node*> nodes = MakeNodes(count);
+	for (ui64 i = count - 1; i > 0; i--)
+	{
+		nodes[(i - 1) / 8]->AdoptChildren(nodes[i]);
+	}
+	return nodes[0];
+}
+
+static ui64 BenchmarkGetAllChildrenRecursively(const ui64 size, Timer& timer)
+{
+	AST::Node* root = MakeTree(size);
+
+	timer.Start();
+	s_sink += AST::GetAllChildrenRecursively(root).size();
+	timer.Stop();
+
+	delete root;
+	return size;
+}
+
+static ui64 BenchmarkLexer(const ui64 size, Timer& timer)
+{
+	std::string source;
+	for (ui64 i = 0; i < size; i++)
+	{
+		source += "\tlocal" + std::to_string(i) + " = local" + std::to_string(i / 2) + " + 42 \xE2\x88\xA7 (\xCE\xBE" + std::to_string(i) + " \xE2\xAA\xA6 3).\n";
+	}
+
+	yy::Lexer lexer(reflex::Input(source.data(), source.size()));
+	yy::parser::semantic_type value;
+	yy::location location;
+	ui64 tokenCount = 0;
+
+	timer.Start();
+	for (i32 kind = lexer.lex(value, location); kind != yy::parser::token::YYEOF; kind = lexer.lex(value, location))
+	{
+		// The lexer hands every identifier over on the heap, for the parser to free.
+		if (kind == yy::parser::token::ID)
+		{
+			delete value.str;
+		}
+		tokenCount++;
+	}
+	timer.Stop();
+
+	return tokenCount;
+}
+
+static std::vector<Benchmark> GetBenchmarks(void)
+{
+	return
+	{
+		{ "symtable_enter_symbol",         "symbols",           BenchmarkEnterSymbol,               { 1000, 10000, 100000 } },
+		{ "symtable_retrieve_symbol",      "symbols",           BenchmarkRetrieveSymbol,            { 1000, 10000, 100000 } },
+		{ "symtable_compose_key",          "keys",              BenchmarkComposeKey,                { 1000, 10000, 100000 } },
+		{ "mangle_ascii",                  "name length",       BenchmarkMangleAscii,               { 8, 64, 1024 } },
+		{ "mangle_unicode",                "name length",       BenchmarkMangleUnicode,             { 8, 64, 1024 } },
+		{ "node_make_siblings",            "list length",       BenchmarkMakeSiblings,              { 16, 256, 4096 } },
+		{ "node_adopt_children",           "children",          BenchmarkAdoptChildren,             { 16, 256, 4096 } },
+		{ "node_get_children",             "children",          BenchmarkGetChildren,               { 16, 256, 4096 } },
+		{ "ast_get_all_children_recursively", "nodes",          BenchmarkGetAllChildrenRecursively, { 1000, 10000, 100000 } },
+		{ "lexer_lex",                     "source lines",      BenchmarkLexer,                     { 100, 1000, 10000 } },
+	};
+}
+
+static bool ParseSizes(const char* text, std::vector<ui64>& outSizes)
+{
+	outSizes.clear();
+	while (*text != '\0')
+	{
+		char* end;
+		const ui64 size = strtoull(text, &end, 10);
+		if (end == text || size == 0 || (*end != ',' && *end != '\0'))
+		{
+			return false;
+		}
+		outSizes.push_back(size);
+		text = *end == ',' ? end + 1 : end;
+	}
+	return !outSizes.empty();
+}
+
+static void PrintUsage(void)
+{
+	printf("USAGE: Microbenchmarks.exe [--filter=TEXT] [--sizes=N,N,...] [--min-time=MS] [--list]\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<Benchmark> benchmarks = GetBenchmarks();
+	const char* filter = "";
+	std::vector<ui64> sizes;
+	ui64 minNanoseconds = 200000000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		if (strncmp(option, "--filter=", strlen("--filter=")) == 0)
+		{
+			filter = option + strlen("--filter=");
+		}
+		else if (strncmp(option, "--sizes=", strlen("--sizes=")) == 0)
+		{
+			if (!ParseSizes(option + strlen("--sizes="), sizes))
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (strncmp(option, "--min-time=", strlen("--min-time=")) == 0)
+		{
+			minNanoseconds = strtoull(option + strlen("--min-time="), nullptr, 10) * 1000000;
+		}
+		else if (strcmp(option, "--list") == 0)
+		{
+			for (const Benchmark& benchmark : benchmarks)
+			{
+				printf("%-36s size is the number of %s\n", benchmark.name, benchmark.sizeMeaning);
+			}
+			return 0;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	printf("benchmark,size,repetitions,operations,ns_per_operation,best_ns_per_operation\n");
+
+	for (const Benchmark& benchmark : benchmarks)
+	{
+		if (strstr(benchmark.name, filter) == nullptr)
+		{
+			continue;
+		}
+
+		for (const ui64 size : sizes.empty() ? benchmark.sizes : sizes)
+		{
+			ui64 repetitions = 0;
+			ui64 operations = 0;
+			ui64 nanoseconds = 0;
+			double bestNanosecondsPerOperation = 0.0;
+
+			// At least a few repetitions, so the best one means something even when one takes longer than the minimum time.
+			while (repetitions < 3 || nanoseconds < minNanoseconds)
+			{
+				Timer timer;
+				const ui64 repetitionOperations = benchmark.function(size, timer);
+				const double nanosecondsPerOperation = (double)timer.GetNanoseconds() / repetitionOperations;
+
+				if (repetitions == 0 || nanosecondsPerOperation < bestNanosecondsPerOperation)
+				{
+					bestNanosecondsPerOperation = nanosecondsPerOperation;
+				}
+				repetitions++;
+				operations += repetitionOperations;
+				nanoseconds += timer.GetNanoseconds();
+			}
+
+			printf("%s,%llu,%llu,%llu,%.3f,%.3f\n", benchmark.name, size, repetitions, operations, (double)nanoseconds / operations, bestNanosecondsPerOperation);
+			fflush(stdout);
+		}
+	}
+
+	return 0;
+}
\ No newline at end of file
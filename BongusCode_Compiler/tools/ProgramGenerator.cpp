@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/Definitions.h"
+
+/*
+	Synthetic BC:PL program generator, for benchmarking the compiler on inputs of any size and shape.
+
+	USAGE: ProgramGenerator.exe "outFilePath" [options]
+		--size=BYTES          Keep adding functions until the program is at least this large. K, M and G suffixes are understood.
+		--functions=N         Generate exactly N functions instead. Ignored if --size is given.
+		--statements=N        Statements per function, loop bodies included.
+		--expr-depth=N        How deep parenthesized subexpressions nest.
+		--expr-width=N        Operands per(sub)expression.
+		--loop-depth=N        How deep For loops nest.
+		--id-length=N         Characters per identifier, the shortest ones get padded up to it.
+		--unicode-ratio=R     The share of local variables, between 0 and 1, whose names are written in Greek letters.
+		--seed=N              The same seed and options always generate the same program.
+
+	Every program is valid: each function only calls the functions before it, variables are declared before they are used,
+	and the last one is Viviscere, which calls a few of the others. Function names stay ASCII, since they end up as labels in
+	the assembly, so only locals get Unicode names.
+*/
+
+struct GeneratorSettings
+{
+	ui64 targetSize = 0;
+	ui64 functionCount = 100;
+	ui32 statementsPerFunction = 20;
+	ui32 expressionDepth = 2;
+	ui32 expressionWidth = 3;
+	ui32 loopDepth = 1;
+	ui32 identifierLength = 8;
+	double unicodeRatio = 0.0;
+	ui64 seed = 1;
+};
+
+class ProgramGenerator
+{
+public:
+
+	explicit ProgramGenerator(const GeneratorSettings& c_settings) : settings(c_settings), random(c_settings.seed) {}
+
+	// Appends function number functionIndex to outSource.
+	void GenerateFunction(const ui64 functionIndex, std::string& outSource);
+
+	// Appends Viviscere, which calls up to the first few of the functionCount functions.
+	void GenerateEntryPoint(const ui64 functionCount, std::string& outSource);
+
+private:
+
+	std::string MakeFunctionName(const ui64 functionIndex) const;
+	std::string MakeVariableName(const ui64 variableIndex);
+	void PadIdentifier(std::string& name, ui32 length) const;
+
+	void GenerateStatements(const ui32 statementCount, const ui32 loopDepth, const ui32 indentation, std::string& outSource);
+	void GenerateExpression(const ui32 depth, std::string& outSource);
+	void GenerateOperand(const ui32 depth, std::string& outSource);
+	void GenerateCall(const ui32 depth, std::string& outSource);
+	void GenerateArgument(const ui32 depth, std::string& outSource);
+
+	const std::string& PickVariable(void);
+	inline bool Chance(const double probability) { return std::uniform_real_distribution<double>(0.0, 1.0)(random) < probability; }
+	inline ui64 Pick(const ui64 count) { return std::uniform_int_distribution<ui64>(0, count - 1)(random); }
+
+	const GeneratorSettings& settings;
+	std::mt19937_64 random;
+
+	// Of the function being generated. Innermost scope last, each one remembering how many variables there were before it.
+	std::vector<std::string> variables;
+	std::vector<ui64> scopeStarts;
+	ui64 variablesDeclared = 0;
+	ui64 currentFunction = 0;
+};
+
+static constexpr const char* s_operators[] = { "+", "-", "*", "\xE2\x88\xA7" /* ∧ */, "\xE2\x88\xA8" /* ∨ */, "\xE2\xAA\xA6" /* ⪦ */, "\xE2\xAA\xA7" /* ⪧ */ };
+
+// Greek small letters alpha to omega, skipping final sigma, in UTF-8.
+static constexpr const char* s_greekLetters[] =
+{
+	"\xCE\xB1", "\xCE\xB2", "\xCE\xB3", "\xCE\xB4", "\xCE\xB5", "\xCE\xB6", "\xCE\xB7", "\xCE\xB8", "\xCE\xB9", "\xCE\xBA", "\xCE\xBB", "\xCE\xBC",
+	"\xCE\xBD", "\xCE\xBE", "\xCE\xBF", "\xCF\x80", "\xCF\x81", "\xCF\x83", "\xCF\x84", "\xCF\x85", "\xCF\x86", "\xCF\x87", "\xCF\x88", "\xCF\x89"
+};
+
+static void Indent(const ui32 indentation, std::string& outSource)
+{
+	outSource.append(indentation, '\t');
+}
+
+void ProgramGenerator::PadIdentifier(std::string& name, ui32 length) const
+{
+	// The name so far is ASCII, so its length in bytes is its length in characters.
+	for (ui64 i = name.size(); i < length; i++)
+	{
+		name += (char)('a' + i % 26);
+	}
+}
+
+std::string ProgramGenerator::MakeFunctionName(const ui64 functionIndex) const
+{
+	std::string name = "Fn" + std::to_string(functionIndex) + "_";
+	PadIdentifier(name, settings.identifierLength);
+	return name;
+}
+
+std::string ProgramGenerator::MakeVariableName(const ui64 variableIndex)
+{
+	if (!Chance(settings.unicodeRatio))
+	{
+		std::string name = "v" + std::to_string(variableIndex) + "_";
+		PadIdentifier(name, settings.identifierLength);
+		return name;
+	}
+
+	// The index in base 24, one Greek letter per digit, keeps the names unique.
+	std::string name;
+	ui32 length = 0;
+	ui64 index = variableIndex;
+	do
+	{
+		name += s_greekLetters[index % std::size(s_greekLetters)];
+		index /= std::size(s_greekLetters);
+		length++;
+	} while (index != 0);
+
+	name += "_";
+	for (length++; length < settings.identifierLength; length++)
+	{
+		name += s_greekLetters[length % std::size(s_greekLetters)];
+	}
+
+	return name;
+}
+
+const std::string& ProgramGenerator::PickVariable(void)
+{
+	return variables[Pick(variables.size())];
+}
+
+void ProgramGenerator::GenerateArgument(const ui32 depth, std::string& outSource)
+{
+	// Code generation only takes literals, variables and calls as arguments, not arithmetic.
+	if (depth > 0 && Chance(0.2))
+	{
+		GenerateCall(depth - 1, outSource);
+	}
+	else if (Chance(0.6))
+	{
+		outSource += PickVariable();
+	}
+	else
+	{
+		outSource += std::to_string(1 + Pick(1000));
+	}
+}
+
+void ProgramGenerator::GenerateCall(const ui32 depth, std::string& outSource)
+{
+	outSource += MakeFunctionName(Pick(currentFunction));
+	outSource += "(";
+	GenerateArgument(depth, outSource);
+	outSource += ", ";
+	GenerateArgument(depth, outSource);
+	outSource += ")";
+}
+
+void ProgramGenerator::GenerateOperand(const ui32 depth, std::string& outSource)
+{
+	if (depth > 0 && Chance(0.5))
+	{
+		outSource += "(";
+		GenerateExpression(depth - 1, outSource);
+		outSource += ")";
+	}
+	else if (currentFunction > 0 && depth > 0 && Chance(0.1))
+	{
+		GenerateCall(depth - 1, outSource);
+	}
+	else if (Chance(0.6))
+	{
+		outSource += PickVariable();
+	}
+	else
+	{
+		outSource += std::to_string(1 + Pick(1000));
+	}
+}
+
+void ProgramGenerator::GenerateExpression(const ui32 depth, std::string& outSource)
+{
+	GenerateOperand(depth, outSource);
+
+	for (ui32 i = 1; i < settings.expressionWidth; i++)
+	{
+		outSource += " ";
+		outSource += s_operators[Pick(std::size(s_operators))];
+		outSource += " ";
+		GenerateOperand(depth, outSource);
+	}
+}
+
+void ProgramGenerator::GenerateStatements(const ui32 statementCount, const ui32 loopDepth, const ui32 indentation, std::string& outSource)
+{
+	for (ui32 i = 0; i < statementCount; i++)
+	{
+		Indent(indentation, outSource);
+
+		const ui32 statementsLeft = statementCount - i;
+		if (loopDepth < settings.loopDepth && statementsLeft > 2 && Chance(0.15))
+		{
+			// The loop's body takes up part of the statements that are left.
+			const ui32 bodyStatementCount = 1 + (ui32)Pick(std::min(statementsLeft - 1, 8u));
+
+			outSource += "For (0 \xE2\x87\xA2 " /* ⇢ */ + std::to_string(1 + Pick(100)) + ")\n";
+			Indent(indentation, outSource);
+			outSource += "{\n";
+
+			scopeStarts.push_back(variables.size());
+			GenerateStatements(bodyStatementCount, loopDepth + 1, indentation + 1, outSource);
+			variables.resize(scopeStarts.back());
+			scopeStarts.pop_back();
+
+			Indent(indentation, outSource);
+			outSource += "}.\n";
+
+			i += bodyStatementCount;
+		}
+		else if (Chance(0.3))
+		{
+			// A declaration always comes with an assignment, so no variable is ever read before it's written.
+			const std::string name = MakeVariableName(variablesDeclared++);
+			outSource += "i64 " + name + ".\n";
+			Indent(indentation, outSource);
+			outSource += name + " = ";
+			GenerateExpression(settings.expressionDepth, outSource);
+			outSource += ".\n";
+
+			variables.push_back(name);
+			i++;
+		}
+		else if (currentFunction > 0 && Chance(0.1))
+		{
+			GenerateCall(settings.expressionDepth > 0 ? settings.expressionDepth - 1 : 0, outSource);
+			outSource += ".\n";
+		}
+		else
+		{
+			outSource += PickVariable() + " = ";
+			GenerateExpression(settings.expressionDepth, outSource);
+			outSource += ".\n";
+		}
+	}
+}
+
+void ProgramGenerator::GenerateFunction(const ui64 functionIndex, std::string& outSource)
+{
+	currentFunction = functionIndex;
+	variables.clear();
+	variablesDeclared = 0;
+
+	// The arguments are the variables every function starts out with.
+	variables.push_back(MakeVariableName(variablesDeclared++));
+	variables.push_back(MakeVariableName(variablesDeclared++));
+
+	outSource += "i64 " + MakeFunctionName(functionIndex) + "(i64 " + variables[0] + ", i64 " + variables[1] + ")\n{\n";
+
+	GenerateStatements(settings.statementsPerFunction, 0, 1, outSource);
+
+	outSource += "\tClaudere ";
+	GenerateExpression(settings.expressionDepth, outSource);
+	outSource += ".\n}\n\n";
+}
+
+void ProgramGenerator::GenerateEntryPoint(const ui64 functionCount, std::string& outSource)
+{
+	outSource += "i32 Viviscere(nihil)\n{\n\ti64 result.\n\tresult = 0.\n";
+
+	for (ui64 i = 0; i < std::min(functionCount, (ui64)16); i++)
+	{
+		outSource += "\tresult = result + " + MakeFunctionName(i) + "(result, " + std::to_string(i) + ").\n";
+	}
+
+	outSource += "\tClaudere 0.\n}\n";
+}
+
+// Parses a count with an optional K, M or G suffix. Returns false if it isn't one.
+static bool ParseSize(const char* text, ui64& outSize)
+{
+	char* end;
+	outSize = strtoull(text, &end, 10);
+	if (end == text)
+	{
+		return false;
+	}
+
+	switch (*end)
+	{
+	case 'K': outSize <<= 10; end++; break;
+	case 'M': outSize <<= 20; end++; break;
+	case 'G': outSize <<= 30; end++; break;
+	default: break;
+	}
+
+	return *end == '\0';
+}
+
+static bool ParseSettings(const int argc, char** argv, GeneratorSettings& outSettings)
+{
+	for (int i = 2; i < argc; i++)
+	{
+		const char* option = argv[i];
+		const char* value = strchr(option, '=');
+		if (value == nullptr)
+		{
+			return false;
+		}
+		value++;
+
+		const std::string name(option, value - 1);
+		ui64 number = 0;
+		if (name == "--unicode-ratio")
+		{
+			outSettings.unicodeRatio = atof(value);
+			continue;
+		}
+		if (!ParseSize(value, number))
+		{
+			return false;
+		}
+
+		if (name == "--size") { outSettings.targetSize = number; }
+		else if (name == "--functions") { outSettings.functionCount = number; }
+		else if (name == "--statements") { outSettings.statementsPerFunction = (ui32)number; }
+		else if (name == "--expr-depth") { outSettings.expressionDepth = (ui32)number; }
+		else if (name == "--expr-width") { outSettings.expressionWidth = (ui32)std::max(number, (ui64)1); }
+		else if (name == "--loop-depth") { outSettings.loopDepth = (ui32)number; }
+		else if (name == "--id-length") { outSettings.identifierLength = (ui32)number; }
+		else if (name == "--seed") { outSettings.seed = number; }
+		else { return false; }
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	GeneratorSettings settings;
+	if (argc < 2 || !ParseSettings(argc, argv, settings))
+	{
+		printf("USAGE: ProgramGenerator.exe \"outFilePath\" [--size=BYTES | --functions=N] [--statements=N] [--expr-depth=N] [--expr-width=N]\n");
+		printf("                            [--loop-depth=N] [--id-length=N] [--unicode-ratio=R] [--seed=N]\n");
+		return 1;
+	}
+
+	FILE* outFile = fopen(argv[1], "wb");
+	if (outFile == nullptr)
+	{
+		printf("ERROR: Unable to open %s for writing.\n", argv[1]);
+		return 1;
+	}
+
+	ProgramGenerator generator(settings);
+	std::string source = "|| Generated by ProgramGenerator, seed " + std::to_string(settings.seed) + ".\n\n";
+
+	// Written out a function at a time, so a program of gigabytes never has to fit in memory.
+	ui64 bytesWritten = 0;
+	ui64 functionCount = 0;
+	while (settings.targetSize != 0 ? bytesWritten + source.size() < settings.targetSize : functionCount < settings.functionCount)
+	{
+		generator.GenerateFunction(functionCount++, source);
+
+		if (source.size() >= (1 << 20))
+		{
+			bytesWritten += fwrite(source.data(), 1, source.size(), outFile);
+			source.clear();
+		}
+	}
+	generator.GenerateEntryPoint(functionCount, source);
+	bytesWritten += fwrite(source.data(), 1, source.size(), outFile);
+
+	if (fclose(outFile) != 0)
+	{
+		printf("ERROR: Unable to write %s.\n", argv[1]);
+		return 1;
+	}
+
+	printf("GENERATOR: Wrote %llu functions, %.2f MB, to %s.\n", functionCount, bytesWritten / (1024.0 * 1024.0), argv[1]);
+	return 0;
+}
\ No newline at end of file
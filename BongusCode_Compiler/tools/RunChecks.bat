@@ -0,0 +1,42 @@
+@echo off
+setlocal
+
+rem Runs the compiler's self checks, and fails if any of them does.
+rem FoldingTest checks that constant folding never changes what an expression computes, StrengthReductionTest that the
+rem instructions replacing div and imul by constants compute what they would. Both are built from their .cpp file in this
+rem directory and every source file of the compiler except main.cpp. StrengthReductionTest goes through every 16 bit
+rem dividend of every 16 bit divisor, which takes a minute or two.
+rem
+rem USAGE: RunChecks.bat "toolsDirectory" [check options]
+rem   The check options, like --seed=N, are passed to both checks, see FoldingTest.cpp and StrengthReductionTest.cpp.
+rem   E.g. RunChecks.bat x64\Release --seed=7
+
+set TOOLS=%~1
+if "%TOOLS%"=="" (
+	echo USAGE: RunChecks.bat "toolsDirectory" [check options]
+	exit /b 1
+)
+
+set CHECK_OPTIONS=
+:collectOptions
+if "%~2"=="" goto optionsCollected
+set CHECK_OPTIONS=%CHECK_OPTIONS% %2
+shift /2
+goto collectOptions
+:optionsCollected
+
+set FAILED=0
+
+for %%C in (FoldingTest StrengthReductionTest) do (
+	echo Running %%C...
+	"%TOOLS%\%%C.exe" %CHECK_OPTIONS%
+	if errorlevel 1 (
+		echo %%C failed.
+		set FAILED=1
+	)
+)
+
+if "%FAILED%"=="1" exit /b 1
+
+echo Every check passed.
+endlocal
\ No newline at end of file
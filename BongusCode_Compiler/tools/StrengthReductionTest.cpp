@@ -0,0 +1,408 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/Definitions.h"
+#include "../src/code_generator/StrengthReduction.h"
+
+/*
+	Checks that the instructions strength reduction(see code_generator/StrengthReduction.h) replaces div and imul with compute
+	the same results. Built from this file and every source file of the compiler except main.cpp, like FoldingTest.cpp.
+
+	USAGE: StrengthReductionTest.exe [--seed=N] [--count=N]
+		--seed=N              Seeds the sampled divisors, dividends and multiplicands, 1 by default.
+		--count=N             How many 32 bit and how many 64 bit divisors to sample, 100000 of each by default.
+
+	The instructions are run on a simulated x86, with just the registers they use. Every 16 bit divisor is checked against every
+	16 bit dividend, both its magic number(GetUnsignedDivision) and the instructions made from it(DivideInPlace). The edge values
+	and the sampled 32 and 64 bit divisors are checked against the edge dividends of each and random ones. The multiplications
+	are checked in every form MultiplyInPlace makes out of leas, shifts and negations, against a plain multiplication. Each
+	failure is printed, and the exit code is 1 if there were any.
+*/
+
+// DivideInPlace can't be given RAX or RDX, which it writes too.
+static const std::string s_reg = "R8";
+
+enum class Register : ui8
+{
+	RAX,
+	RDX,
+	reg,
+	size
+};
+
+enum class Operation : ui8
+{
+	mov,
+	mul,
+	shl,
+	shr,
+	add,
+	sub,
+	neg,
+	lea,
+	size
+};
+
+static const char* s_mnemonics[] = { "mov", "mul", "shl", "shr", "add", "sub", "neg", "lea" };
+
+// An instruction parsed from the text strength reduction emits, so the dividends don't each parse it again.
+struct Instruction
+{
+	std::string mnemonic;
+	Operation operation = Operation::size;
+	Register dest = Register::size;
+	Register source = Register::size;
+	ui64 immediate = 0;
+};
+
+static Register ParseRegister(const std::string& name)
+{
+	if (name == "RAX") { return Register::RAX; }
+	if (name == "RDX") { return Register::RDX; }
+	if (name == s_reg) { return Register::reg; }
+	return Register::size;
+}
+
+// Exits on anything the simulation doesn't know, a new instruction has to be added to it before it can be checked.
+static Instruction Parse(const std::string& text)
+{
+	Instruction instruction;
+	const ui64 space = text.find(' ');
+	const ui64 comma = text.find(", ");
+	instruction.mnemonic = text.substr(0, space);
+	instruction.dest = ParseRegister(text.substr(space + 1, comma == std::string::npos ? std::string::npos : comma - space - 1));
+
+	if (comma != std::string::npos)
+	{
+		const std::string source = text.substr(comma + 2);
+		if (instruction.mnemonic == s_mnemonics[(ui64)Operation::lea])
+		{
+			// [reg+reg*scale], the scale is the immediate.
+			instruction.source = ParseRegister(source.substr(1, source.find('+') - 1));
+			instruction.immediate = strtoull(source.c_str() + source.find('*') + 1, nullptr, 10);
+		}
+		else
+		{
+			instruction.source = ParseRegister(source);
+			if (instruction.source == Register::size)
+			{
+				instruction.immediate = (ui64)strtoll(source.c_str(), nullptr, 10);
+			}
+		}
+	}
+
+	for (ui64 i = 0; i < (ui64)Operation::size; i++)
+	{
+		if (instruction.mnemonic == s_mnemonics[i])
+		{
+			instruction.operation = (Operation)i;
+		}
+	}
+	// lea only scales by 2, 4 or 8.
+	const bool isBadLea = instruction.operation == Operation::lea &&
+		(instruction.source == Register::size || (instruction.immediate != 2 && instruction.immediate != 4 && instruction.immediate != 8));
+	if (instruction.operation == Operation::size || instruction.dest == Register::size || isBadLea)
+	{
+		printf("Can't simulate \"%s\".\n", text.c_str());
+		exit(1);
+	}
+	return instruction;
+}
+
+static std::vector<Instruction> Parse(const std::vector<std::string>& texts)
+{
+	std::vector<Instruction> instructions;
+	for (const std::string& text : texts)
+	{
+		instructions.push_back(Parse(text));
+	}
+	return instructions;
+}
+
+// The high 64 bits of the 128 bit product, put together from 32 bit halves.
+static ui64 MultiplyHigh(const ui64 a, const ui64 b)
+{
+	const ui64 aLow = a & 0xFFFFFFFFull;
+	const ui64 aHigh = a >> 32;
+	const ui64 bLow = b & 0xFFFFFFFFull;
+	const ui64 bHigh = b >> 32;
+
+	const ui64 low = aLow * bLow;
+	const ui64 middle = aHigh * bLow + (low >> 32);
+	const ui64 otherMiddle = aLow * bHigh + (middle & 0xFFFFFFFFull);
+	return aHigh * bHigh + (middle >> 32) + (otherMiddle >> 32);
+}
+
+// Runs the instructions with value in the register, and returns what's left in it. RAX and RDX start out with garbage in them.
+static ui64 Run(const std::vector<Instruction>& instructions, const ui64 value)
+{
+	ui64 registers[(ui64)Register::size] = { 0xBAADF00DBAADF00Dull, 0xDEADBEEFDEADBEEFull, value };
+	for (const Instruction& instruction : instructions)
+	{
+		ui64& dest = registers[(ui64)instruction.dest];
+		const ui64 source = instruction.source == Register::size ? instruction.immediate : registers[(ui64)instruction.source];
+		switch (instruction.operation)
+		{
+			case Operation::mov: dest = source; break;
+			case Operation::mul:
+			{
+				// mul reg: RDX:RAX = RAX * reg.
+				const ui64 rax = registers[(ui64)Register::RAX];
+				registers[(ui64)Register::RDX] = MultiplyHigh(rax, dest);
+				registers[(ui64)Register::RAX] = rax * dest;
+				break;
+			}
+			case Operation::shl: dest <<= (source & 63); break;
+			case Operation::shr: dest >>= (source & 63); break;
+			case Operation::add: dest += source; break;
+			case Operation::sub: dest -= source; break;
+			case Operation::neg: dest = 0 - dest; break;
+			case Operation::lea: dest = source + source * instruction.immediate; break;
+			default: break;
+		}
+	}
+	return registers[(ui64)Register::reg];
+}
+
+static bool IsPowerOfTwo(const ui64 value)
+{
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+// The quotient as the comment on UnsignedDivision describes it.
+static ui64 DivideByMagicNumber(const StrengthReduction::UnsignedDivision& division, const ui64 dividend)
+{
+	const ui64 high = MultiplyHigh(dividend, division.multiplier);
+	if (!division.isAdd)
+	{
+		return high >> division.shift;
+	}
+	return (((dividend - high) >> 1) + high) >> (division.shift - 1);
+}
+
+static std::vector<Instruction> GetDivision(const ui64 divisor)
+{
+	std::vector<std::string> texts;
+	if (!StrengthReduction::DivideInPlace(divisor, s_reg, texts))
+	{
+		printf("FAIL: There are no instructions for the division by %llu.\n", divisor);
+		exit(1);
+	}
+	return Parse(texts);
+}
+
+// Every 16 bit dividend by every 16 bit divisor.
+static ui64 CheckSmallDivisors(void)
+{
+	ui64 failures = 0;
+	for (ui64 divisor = 1; divisor <= 0xFFFF; divisor++)
+	{
+		const std::vector<Instruction> instructions = GetDivision(divisor);
+		const bool hasMagicNumber = !IsPowerOfTwo(divisor);
+		const StrengthReduction::UnsignedDivision division = hasMagicNumber ? StrengthReduction::GetUnsignedDivision(divisor) : StrengthReduction::UnsignedDivision();
+
+		for (ui64 dividend = 0; dividend <= 0xFFFF; dividend++)
+		{
+			const ui64 quotient = dividend / divisor;
+			if (hasMagicNumber && DivideByMagicNumber(division, dividend) != quotient)
+			{
+				printf("FAIL: The magic number for %llu divides %llu into %llu.\n", divisor, dividend, DivideByMagicNumber(division, dividend));
+				failures++;
+				break;
+			}
+			if (Run(instructions, dividend) != quotient)
+			{
+				printf("FAIL: The division by %llu divides %llu into %llu.\n", divisor, dividend, Run(instructions, dividend));
+				failures++;
+				break;
+			}
+		}
+	}
+	return failures;
+}
+
+// The edge dividends of divisor: around it and its first multiple, the largest multiples that fit, and the bits' edges.
+static std::vector<ui64> GetEdgeDividends(const ui64 divisor, const ui64 mask)
+{
+	return {
+		0, 1, divisor - 1, divisor, divisor + 1, 2 * divisor - 1, 2 * divisor,
+		mask / divisor * divisor, mask / divisor * divisor - 1, mask, mask - 1, mask >> 1, (mask >> 1) + 1,
+		0xFFFF, 0x10000, 0xFFFFFFFFull, 0x100000000ull
+	};
+}
+
+static ui64 CheckDivisor(const ui64 divisor, const ui64 mask, std::mt19937_64& random)
+{
+	std::vector<ui64> dividends = GetEdgeDividends(divisor, mask);
+	for (ui32 i = 0; i < 32; i++)
+	{
+		dividends.push_back(random());
+		dividends.push_back(random() >> (random() % 64));
+	}
+
+	const std::vector<Instruction> instructions = GetDivision(divisor);
+	const bool hasMagicNumber = !IsPowerOfTwo(divisor);
+	const StrengthReduction::UnsignedDivision division = hasMagicNumber ? StrengthReduction::GetUnsignedDivision(divisor) : StrengthReduction::UnsignedDivision();
+
+	for (ui64 dividend : dividends)
+	{
+		dividend &= mask;
+		const ui64 quotient = dividend / divisor;
+		if (hasMagicNumber && DivideByMagicNumber(division, dividend) != quotient)
+		{
+			printf("FAIL: The magic number for %llu divides %llu into %llu.\n", divisor, dividend, DivideByMagicNumber(division, dividend));
+			return 1;
+		}
+		if (Run(instructions, dividend) != quotient)
+		{
+			printf("FAIL: The division by %llu divides %llu into %llu.\n", divisor, dividend, Run(instructions, dividend));
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static ui64 CheckLargeDivisors(const ui64 seed, const ui64 count)
+{
+	std::mt19937_64 random(seed);
+	ui64 failures = 0;
+
+	static const ui64 s_edgeDivisors32[] = { 3, 7, 641, 65535, 65537, 1000000007, 0x7FFFFFFF, 0x80000000, 0x80000001, 0xFFFFFFFE, 0xFFFFFFFF };
+	for (const ui64 divisor : s_edgeDivisors32)
+	{
+		failures += CheckDivisor(divisor, 0xFFFFFFFFull, random);
+	}
+	static const ui64 s_edgeDivisors64[] = {
+		3, 7, 0xFFFFFFFF, 0x100000000ull, 0x100000001ull, 6700417, 0x7FFFFFFFFFFFFFFFull, 0x8000000000000000ull, 0x8000000000000001ull,
+		~0ull / 3, ~0ull - 1, ~0ull
+	};
+	for (const ui64 divisor : s_edgeDivisors64)
+	{
+		failures += CheckDivisor(divisor, ~0ull, random);
+	}
+
+	// Small divisors are more common than large ones, so half of them are cut short.
+	for (ui64 i = 0; i < count; i++)
+	{
+		const ui64 divisor32 = (random() & 0xFFFFFFFFull) >> (i % 2 == 0 ? 0 : random() % 32);
+		const ui64 divisor64 = random() >> (i % 2 == 0 ? 0 : random() % 64);
+		failures += divisor32 == 0 ? 0 : CheckDivisor(divisor32, 0xFFFFFFFFull, random);
+		failures += divisor64 == 0 ? 0 : CheckDivisor(divisor64, ~0ull, random);
+	}
+	return failures;
+}
+
+// Every constant made of a lea factor or two and a power of 2, either sign, and every small one, against a plain multiplication.
+// Each of the forms MultiplyInPlace knows has to turn up.
+static ui64 CheckMultiplications(const ui64 seed)
+{
+	std::mt19937_64 random(seed);
+	std::vector<i64> constants;
+	for (i64 constant = -4096; constant <= 4096; constant++)
+	{
+		constants.push_back(constant);
+	}
+	static const ui64 s_oddParts[] = { 1, 3, 5, 7, 9, 15, 25, 27, 45, 81 };
+	for (const ui64 oddPart : s_oddParts)
+	{
+		for (ui32 shift = 0; shift < 64; shift++)
+		{
+			constants.push_back((i64)(oddPart << shift));
+			constants.push_back((i64)(0 - (oddPart << shift)));
+		}
+	}
+
+	std::map<std::string, ui64> forms;
+	ui64 failures = 0;
+	for (const i64 constant : constants)
+	{
+		std::vector<std::string> texts;
+		if (!StrengthReduction::MultiplyInPlace(constant, s_reg, texts))
+		{
+			if (!texts.empty())
+			{
+				printf("FAIL: The multiplication by %lld isn't reduced, but left instructions behind.\n", constant);
+				failures++;
+			}
+			continue;
+		}
+
+		const std::vector<Instruction> instructions = Parse(texts);
+		std::string form;
+		for (const Instruction& instruction : instructions)
+		{
+			form += (form.empty() ? "" : " ") + instruction.mnemonic;
+		}
+		forms[form]++;
+
+		std::vector<ui64> multiplicands = { 0, 1, 2, 3, 0x7FFFFFFFFFFFFFFFull, 0x8000000000000000ull, ~0ull, 0xFFFFFFFFull, 0x100000000ull };
+		for (ui32 i = 0; i < 16; i++)
+		{
+			multiplicands.push_back(random());
+		}
+		for (const ui64 multiplicand : multiplicands)
+		{
+			if (Run(instructions, multiplicand) != multiplicand * (ui64)constant)
+			{
+				printf("FAIL: The multiplication by %lld(%s) multiplies %llu into %llu.\n", constant, form.c_str(), multiplicand, Run(instructions, multiplicand));
+				failures++;
+				break;
+			}
+		}
+	}
+
+	static const char* s_forms[] = { "shl", "lea", "lea lea", "lea shl", "neg", "shl neg", "lea neg" };
+	for (const char* form : s_forms)
+	{
+		if (forms.count(form) == 0)
+		{
+			printf("FAIL: No constant was multiplied by with %s.\n", form);
+			failures++;
+		}
+	}
+	return failures;
+}
+
+static void PrintUsage(void)
+{
+	printf("USAGE: StrengthReductionTest.exe [--seed=N] [--count=N]\n");
+}
+
+int main(int argc, char** argv)
+{
+	ui64 seed = 1;
+	ui64 count = 100000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		if (strncmp(option, "--seed=", strlen("--seed=")) == 0)
+		{
+			seed = strtoull(option + strlen("--seed="), nullptr, 10);
+		}
+		else if (strncmp(option, "--count=", strlen("--count=")) == 0)
+		{
+			count = strtoull(option + strlen("--count="), nullptr, 10);
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	const ui64 failures = CheckSmallDivisors() + CheckLargeDivisors(seed, count) + CheckMultiplications(seed);
+	if (failures != 0)
+	{
+		printf("%llu divisions and multiplications by constants computed something else.\n", failures);
+		return 1;
+	}
+
+	printf("Every division and multiplication by a constant computed what div and imul would.\n");
+	return 0;
+}
\ No newline at end of file